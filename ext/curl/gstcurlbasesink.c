@@ -36,6 +36,14 @@
  *     use-content-length=false
  * ]|
  * </refsect2>
+ *
+ * By default the render function blocks until the transfer thread has handed
+ * the whole buffer over to libcurl. Setting #GstCurlBaseSink:max-queue-bytes
+ * decouples the two: buffers are copied into a bounded ring that libcurl
+ * drains on its own, so short network stalls do not stall the pipeline.
+ * #GstCurlBaseSink:max-queue-time additionally bounds the queued duration,
+ * and the #GstCurlBaseSink:stats property reports the queue fill level,
+ * render stalls and the achieved throughput.
  */
 
 #ifdef HAVE_CONFIG_H
@@ -70,6 +78,8 @@
 #define DEFAULT_URL                    "localhost:5555"
 #define DEFAULT_TIMEOUT                30
 #define DEFAULT_QOS_DSCP               0
+#define DEFAULT_MAX_QUEUE_BYTES        0
+#define DEFAULT_MAX_QUEUE_TIME         0
 
 #define DSCP_MIN                       0
 #define DSCP_MAX                       63
@@ -91,7 +101,10 @@ enum
   PROP_USER_PASSWD,
   PROP_FILE_NAME,
   PROP_TIMEOUT,
-  PROP_QOS_DSCP
+  PROP_QOS_DSCP,
+  PROP_MAX_QUEUE_BYTES,
+  PROP_MAX_QUEUE_TIME,
+  PROP_STATS
 };
 
 /* Object class function declarations */
@@ -139,18 +152,46 @@ static void gst_curl_base_sink_wait_for_transfer_thread_to_send_unlocked
 static void gst_curl_base_sink_data_sent_notify (GstCurlBaseSink * sink);
 static void gst_curl_base_sink_wait_for_response (GstCurlBaseSink * sink);
 static void gst_curl_base_sink_got_response_notify (GstCurlBaseSink * sink);
+static GstFlowReturn gst_curl_base_sink_queue_data_unlocked
+    (GstCurlBaseSink * sink, const guint8 * data, gsize size,
+    GstClockTime duration);
+static void gst_curl_base_sink_wait_for_queue_drain_unlocked
+    (GstCurlBaseSink * sink);
+static GstStructure *gst_curl_base_sink_create_stats (GstCurlBaseSink * sink);
+
+static void transfer_queue_clear (TransferQueue * queue);
+static gsize transfer_queue_pop (TransferQueue * queue, guint8 * dest,
+    gsize max_bytes);
 
 static void handle_transfer (GstCurlBaseSink * sink);
 static size_t transfer_data_buffer (void *curl_ptr, TransferBuffer * buf,
     size_t max_bytes_to_send, guint * last_chunk);
 
+typedef struct
+{
+  gsize len;
+  GstClockTime duration;
+} TransferQueueChunk;
+
 #define parent_class gst_curl_base_sink_parent_class
 G_DEFINE_TYPE (GstCurlBaseSink, gst_curl_base_sink, GST_TYPE_BASE_SINK);
 
 static gboolean
 gst_curl_base_sink_default_has_buffered_data_unlocked (GstCurlBaseSink * sink)
 {
-  return sink->transfer_buf->len > 0;
+  return sink->transfer_buf->len > 0 || sink->transfer_queue->len > 0;
+}
+
+/* queueing copies the rendered data into the transfer queue and lets the
+ * read callback drain it across buffer boundaries, which is only possible
+ * when the subclass does not need to see every buffer on its own */
+static gboolean
+gst_curl_base_sink_default_supports_queueing_unlocked (GstCurlBaseSink * sink)
+{
+  GstCurlBaseSinkClass *klass = GST_CURL_BASE_SINK_GET_CLASS (sink);
+
+  return klass->transfer_data_buffer == gst_curl_base_sink_transfer_data_buffer
+      && klass->flush_data_unlocked == NULL;
 }
 
 static gboolean
@@ -201,6 +242,8 @@ gst_curl_base_sink_class_init (GstCurlBaseSinkClass * klass)
   klass->transfer_data_buffer = gst_curl_base_sink_transfer_data_buffer;
   klass->has_buffered_data_unlocked =
       gst_curl_base_sink_default_has_buffered_data_unlocked;
+  klass->supports_queueing_unlocked =
+      gst_curl_base_sink_default_supports_queueing_unlocked;
 
   /* FIXME: check against souphttpsrc and use same names for same properties */
   g_object_class_install_property (gobject_class, PROP_LOCATION,
@@ -230,6 +273,22 @@ gst_curl_base_sink_class_init (GstCurlBaseSinkClass * klass)
           "Quality of Service, differentiated services code point (0 default)",
           DSCP_MIN, DSCP_MAX, DEFAULT_QOS_DSCP,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_MAX_QUEUE_BYTES,
+      g_param_spec_uint ("max-queue-bytes", "Max queue bytes",
+          "Maximum number of bytes queued for the transfer thread "
+          "(0 = render blocks until each buffer is sent)",
+          0, G_MAXUINT, DEFAULT_MAX_QUEUE_BYTES,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_MAX_QUEUE_TIME,
+      g_param_spec_uint64 ("max-queue-time", "Max queue time",
+          "Maximum duration of data queued for the transfer thread in ns "
+          "(0 = unlimited, only bounded by max-queue-bytes)",
+          0, G_MAXUINT64, DEFAULT_MAX_QUEUE_TIME,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_STATS,
+      g_param_spec_boxed ("stats", "Statistics",
+          "Transfer queue and throughput statistics", GST_TYPE_STRUCTURE,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
 
   gst_element_class_add_pad_template (element_class,
       gst_static_pad_template_get (&sinktemplate));
@@ -240,6 +299,8 @@ gst_curl_base_sink_init (GstCurlBaseSink * sink)
 {
   sink->transfer_buf = g_malloc (sizeof (TransferBuffer));
   sink->transfer_cond = g_malloc (sizeof (TransferCondition));
+  sink->transfer_queue = g_malloc0 (sizeof (TransferQueue));
+  g_queue_init (&sink->transfer_queue->chunks);
   g_cond_init (&sink->transfer_cond->cond);
   sink->transfer_cond->data_sent = FALSE;
   sink->transfer_cond->data_available = FALSE;
@@ -251,6 +312,10 @@ gst_curl_base_sink_init (GstCurlBaseSink * sink)
   sink->new_file = TRUE;
   sink->flow_ret = GST_FLOW_OK;
   sink->is_live = FALSE;
+  sink->max_queue_bytes = DEFAULT_MAX_QUEUE_BYTES;
+  sink->max_queue_time = DEFAULT_MAX_QUEUE_TIME;
+  sink->use_queue = FALSE;
+  sink->flushing = FALSE;
 }
 
 static void
@@ -267,6 +332,9 @@ gst_curl_base_sink_finalize (GObject * gobject)
   g_cond_clear (&this->transfer_cond->cond);
   g_free (this->transfer_cond);
   g_free (this->transfer_buf);
+  transfer_queue_clear (this->transfer_queue);
+  g_free (this->transfer_queue->data);
+  g_free (this->transfer_queue);
 
   g_free (this->url);
   g_free (this->user);
@@ -334,6 +402,7 @@ static GstFlowReturn
 gst_curl_base_sink_render (GstBaseSink * bsink, GstBuffer * buf)
 {
   GstCurlBaseSink *sink;
+  GstCurlBaseSinkClass *klass;
   GstMapInfo map;
   guint8 *data;
   size_t size;
@@ -342,6 +411,7 @@ gst_curl_base_sink_render (GstBaseSink * bsink, GstBuffer * buf)
   GST_LOG ("enter render");
 
   sink = GST_CURL_BASE_SINK (bsink);
+  klass = GST_CURL_BASE_SINK_GET_CLASS (sink);
   gst_buffer_map (buf, &map, GST_MAP_READ);
   data = map.data;
   size = map.size;
@@ -354,16 +424,35 @@ gst_curl_base_sink_render (GstBaseSink * bsink, GstBuffer * buf)
     goto done;
   }
 
-  g_assert (sink->transfer_cond->data_available == FALSE);
-
   /* if there is no transfer thread created, lets create one */
   if (sink->transfer_thread == NULL) {
+    sink->use_queue = sink->max_queue_bytes > 0 &&
+        klass->supports_queueing_unlocked &&
+        klass->supports_queueing_unlocked (sink);
+    GST_DEBUG_OBJECT (sink, "transfer queue %s",
+        sink->use_queue ? "enabled" : "disabled");
+
     if (!gst_curl_base_sink_transfer_start_unlocked (sink)) {
       sink->flow_ret = GST_FLOW_ERROR;
       goto done;
     }
   }
 
+  /* copy the data into the transfer queue, only blocking while the queue is
+   * full. The transfer thread drains it at its own pace. */
+  if (sink->use_queue) {
+    ret = gst_curl_base_sink_queue_data_unlocked (sink, data, size,
+        GST_BUFFER_DURATION (buf));
+    GST_OBJECT_UNLOCK (sink);
+    gst_buffer_unmap (buf, &map);
+
+    GST_LOG ("exit render");
+
+    return ret;
+  }
+
+  g_assert (sink->transfer_cond->data_available == FALSE);
+
   /* make data available for the transfer thread and notify */
   sink->transfer_buf->ptr = data;
   sink->transfer_buf->len = size;
@@ -394,6 +483,9 @@ gst_curl_base_sink_event (GstBaseSink * bsink, GstEvent * event)
   switch (event->type) {
     case GST_EVENT_EOS:
       GST_DEBUG_OBJECT (sink, "received EOS");
+      GST_OBJECT_LOCK (sink);
+      gst_curl_base_sink_wait_for_queue_drain_unlocked (sink);
+      GST_OBJECT_UNLOCK (sink);
       gst_curl_base_sink_transfer_thread_close (sink);
       gst_curl_base_sink_wait_for_response (sink);
       break;
@@ -425,6 +517,14 @@ gst_curl_base_sink_start (GstBaseSink * bsink)
   sink->transfer_thread_close = FALSE;
   sink->new_file = TRUE;
   sink->flow_ret = GST_FLOW_OK;
+  sink->flushing = FALSE;
+
+  /* reset statistics */
+  sink->bytes_sent = 0;
+  sink->max_queued_bytes = 0;
+  sink->stalls = 0;
+  sink->stall_time = 0;
+  sink->transfer_start_time = 0;
 
   if ((sink->fdset = gst_poll_new (TRUE)) == NULL) {
     GST_ELEMENT_ERROR (sink, RESOURCE, OPEN_READ_WRITE,
@@ -446,6 +546,13 @@ gst_curl_base_sink_stop (GstBaseSink * bsink)
     sink->fdset = NULL;
   }
 
+  GST_OBJECT_LOCK (sink);
+  transfer_queue_clear (sink->transfer_queue);
+  g_free (sink->transfer_queue->data);
+  sink->transfer_queue->data = NULL;
+  sink->transfer_queue->size = 0;
+  GST_OBJECT_UNLOCK (sink);
+
   return TRUE;
 }
 
@@ -459,6 +566,12 @@ gst_curl_base_sink_unlock (GstBaseSink * bsink)
   GST_LOG_OBJECT (sink, "Flushing");
   gst_poll_set_flushing (sink->fdset, TRUE);
 
+  /* wake up the render function if it is waiting for queue space */
+  GST_OBJECT_LOCK (sink);
+  sink->flushing = TRUE;
+  g_cond_broadcast (&sink->transfer_cond->cond);
+  GST_OBJECT_UNLOCK (sink);
+
   return TRUE;
 }
 
@@ -472,6 +585,15 @@ gst_curl_base_sink_unlock_stop (GstBaseSink * bsink)
   GST_LOG_OBJECT (sink, "No longer flushing");
   gst_poll_set_flushing (sink->fdset, FALSE);
 
+  /* queued data was discarded by the flush */
+  GST_OBJECT_LOCK (sink);
+  sink->flushing = FALSE;
+  if (sink->use_queue) {
+    transfer_queue_clear (sink->transfer_queue);
+    sink->transfer_cond->data_available = FALSE;
+  }
+  GST_OBJECT_UNLOCK (sink);
+
   return TRUE;
 }
 
@@ -519,6 +641,16 @@ gst_curl_base_sink_set_property (GObject * object, guint prop_id,
         gst_curl_base_sink_setup_dscp_unlocked (sink);
         GST_DEBUG_OBJECT (sink, "dscp set to %d", sink->qos_dscp);
         break;
+      case PROP_MAX_QUEUE_BYTES:
+        sink->max_queue_bytes = g_value_get_uint (value);
+        GST_DEBUG_OBJECT (sink, "max queue bytes set to %u",
+            sink->max_queue_bytes);
+        break;
+      case PROP_MAX_QUEUE_TIME:
+        sink->max_queue_time = g_value_get_uint64 (value);
+        GST_DEBUG_OBJECT (sink, "max queue time set to %" GST_TIME_FORMAT,
+            GST_TIME_ARGS (sink->max_queue_time));
+        break;
       default:
         GST_DEBUG_OBJECT (sink, "invalid property id %d", prop_id);
         break;
@@ -584,6 +716,15 @@ gst_curl_base_sink_get_property (GObject * object, guint prop_id,
     case PROP_QOS_DSCP:
       g_value_set_int (value, sink->qos_dscp);
       break;
+    case PROP_MAX_QUEUE_BYTES:
+      g_value_set_uint (value, sink->max_queue_bytes);
+      break;
+    case PROP_MAX_QUEUE_TIME:
+      g_value_set_uint64 (value, sink->max_queue_time);
+      break;
+    case PROP_STATS:
+      g_value_take_boxed (value, gst_curl_base_sink_create_stats (sink));
+      break;
     default:
       GST_DEBUG_OBJECT (sink, "invalid property id");
       break;
@@ -732,11 +873,36 @@ gst_curl_base_sink_transfer_read_cb (void *curl_ptr, size_t size, size_t nmemb,
     return 0;
   }
 
+  if (sink->transfer_start_time == 0)
+    sink->transfer_start_time = g_get_monotonic_time ();
+
+  /* drain the transfer queue, possibly spanning several rendered buffers */
+  if (sink->use_queue) {
+    bytes_to_send = transfer_queue_pop (sink->transfer_queue,
+        (guint8 *) curl_ptr, max_bytes_to_send);
+    sink->bytes_sent += bytes_to_send;
+
+    if (sink->transfer_queue->len == 0)
+      sink->transfer_cond->data_available = FALSE;
+
+    /* wake up the render function if it is waiting for queue space */
+    g_cond_broadcast (&sink->transfer_cond->cond);
+    GST_OBJECT_UNLOCK (sink);
+
+    GST_LOG ("sent from queue: %" G_GSIZE_FORMAT, bytes_to_send);
+
+    return bytes_to_send;
+  }
+
   GST_OBJECT_UNLOCK (sink);
 
   bytes_to_send = klass->transfer_data_buffer (sink, curl_ptr,
       max_bytes_to_send, &last_chunk);
 
+  GST_OBJECT_LOCK (sink);
+  sink->bytes_sent += bytes_to_send;
+  GST_OBJECT_UNLOCK (sink);
+
   /* the last data chunk */
   if (last_chunk) {
     gst_curl_base_sink_data_sent_notify (sink);
@@ -1121,6 +1287,9 @@ gst_curl_base_sink_wait_for_data_unlocked (GstCurlBaseSink * sink)
 static void
 gst_curl_base_sink_new_file_notify_unlocked (GstCurlBaseSink * sink)
 {
+  /* queued data still belongs to the previous file */
+  gst_curl_base_sink_wait_for_queue_drain_unlocked (sink);
+
   GST_LOG ("new file name");
   sink->new_file = TRUE;
   g_cond_signal (&sink->transfer_cond->cond);
@@ -1149,7 +1318,8 @@ gst_curl_base_sink_data_sent_notify (GstCurlBaseSink * sink)
   GST_OBJECT_LOCK (sink);
   sink->transfer_cond->data_available = FALSE;
   sink->transfer_cond->data_sent = TRUE;
-  g_cond_signal (&sink->transfer_cond->cond);
+  /* the render function might also be waiting for queue space */
+  g_cond_broadcast (&sink->transfer_cond->cond);
   GST_OBJECT_UNLOCK (sink);
 }
 
@@ -1178,6 +1348,216 @@ gst_curl_base_sink_got_response_notify (GstCurlBaseSink * sink)
   GST_OBJECT_UNLOCK (sink);
 }
 
+static void
+transfer_queue_clear (TransferQueue * queue)
+{
+  TransferQueueChunk *chunk;
+
+  while ((chunk = g_queue_pop_head (&queue->chunks)))
+    g_slice_free (TransferQueueChunk, chunk);
+
+  queue->offset = 0;
+  queue->len = 0;
+  queue->duration = 0;
+}
+
+static void
+transfer_queue_push_chunk (TransferQueue * queue, gsize size,
+    GstClockTime duration)
+{
+  TransferQueueChunk *chunk = g_slice_new (TransferQueueChunk);
+
+  chunk->len = size;
+  chunk->duration = duration;
+  g_queue_push_tail (&queue->chunks, chunk);
+
+  if (GST_CLOCK_TIME_IS_VALID (duration))
+    queue->duration += duration;
+}
+
+/* copies up to @max_bytes from the head of the ring into @dest and releases
+ * the duration of every buffer that has been completely consumed */
+static gsize
+transfer_queue_pop (TransferQueue * queue, guint8 * dest, gsize max_bytes)
+{
+  gsize to_copy = MIN (max_bytes, queue->len);
+  gsize first = MIN (to_copy, queue->size - queue->offset);
+  gsize left = to_copy;
+
+  memcpy (dest, queue->data + queue->offset, first);
+  if (first < to_copy)
+    memcpy (dest + first, queue->data, to_copy - first);
+
+  queue->offset = (queue->offset + to_copy) % queue->size;
+  queue->len -= to_copy;
+
+  while (left > 0) {
+    TransferQueueChunk *chunk = g_queue_peek_head (&queue->chunks);
+    gsize consumed;
+
+    g_assert (chunk != NULL);
+
+    consumed = MIN (left, chunk->len);
+    chunk->len -= consumed;
+    left -= consumed;
+
+    if (chunk->len == 0) {
+      if (GST_CLOCK_TIME_IS_VALID (chunk->duration))
+        queue->duration -= chunk->duration;
+      g_queue_pop_head (&queue->chunks);
+      g_slice_free (TransferQueueChunk, chunk);
+    }
+  }
+
+  if (queue->len == 0)
+    queue->offset = 0;
+
+  return to_copy;
+}
+
+static gboolean
+gst_curl_base_sink_queue_full_unlocked (GstCurlBaseSink * sink,
+    gboolean check_time)
+{
+  TransferQueue *queue = sink->transfer_queue;
+
+  if (queue->len == queue->size)
+    return TRUE;
+
+  return check_time && sink->max_queue_time > 0 && queue->len > 0 &&
+      queue->duration >= sink->max_queue_time;
+}
+
+static GstFlowReturn
+gst_curl_base_sink_wait_for_queue_space_unlocked (GstCurlBaseSink * sink,
+    gboolean check_time)
+{
+  gint64 stall_start;
+
+  if (!gst_curl_base_sink_queue_full_unlocked (sink, check_time))
+    return GST_FLOW_OK;
+
+  GST_DEBUG_OBJECT (sink, "transfer queue full (%" G_GSIZE_FORMAT " bytes, %"
+      GST_TIME_FORMAT "), waiting", sink->transfer_queue->len,
+      GST_TIME_ARGS (sink->transfer_queue->duration));
+
+  sink->stalls++;
+  stall_start = g_get_monotonic_time ();
+
+  while (gst_curl_base_sink_queue_full_unlocked (sink, check_time) &&
+      sink->flow_ret == GST_FLOW_OK && !sink->flushing) {
+    g_cond_wait (&sink->transfer_cond->cond, GST_OBJECT_GET_LOCK (sink));
+  }
+
+  sink->stall_time += (g_get_monotonic_time () - stall_start) * GST_USECOND;
+
+  if (sink->flushing)
+    return GST_FLOW_FLUSHING;
+
+  return sink->flow_ret;
+}
+
+static GstFlowReturn
+gst_curl_base_sink_queue_data_unlocked (GstCurlBaseSink * sink,
+    const guint8 * data, gsize size, GstClockTime duration)
+{
+  TransferQueue *queue = sink->transfer_queue;
+  GstFlowReturn ret;
+
+  if (size == 0)
+    return GST_FLOW_OK;
+
+  if (queue->data == NULL) {
+    queue->size = sink->max_queue_bytes;
+    queue->data = g_malloc (queue->size);
+    transfer_queue_clear (queue);
+  }
+
+  /* the time limit is only checked once per buffer, buffers bigger than the
+   * queue are then written in pieces as space becomes available */
+  ret = gst_curl_base_sink_wait_for_queue_space_unlocked (sink, TRUE);
+  if (ret != GST_FLOW_OK)
+    return ret;
+
+  transfer_queue_push_chunk (queue, size, duration);
+
+  while (size > 0) {
+    gsize pos;
+    gsize to_copy;
+
+    ret = gst_curl_base_sink_wait_for_queue_space_unlocked (sink, FALSE);
+    if (ret != GST_FLOW_OK)
+      return ret;
+
+    pos = (queue->offset + queue->len) % queue->size;
+    to_copy = MIN (size, queue->size - queue->len);
+    to_copy = MIN (to_copy, queue->size - pos);
+
+    memcpy (queue->data + pos, data, to_copy);
+    queue->len += to_copy;
+    data += to_copy;
+    size -= to_copy;
+
+    sink->max_queued_bytes = MAX (sink->max_queued_bytes, queue->len);
+
+    GST_LOG ("queued %" G_GSIZE_FORMAT " bytes, queue level %" G_GSIZE_FORMAT,
+        to_copy, queue->len);
+
+    /* make data available for the transfer thread and notify */
+    sink->transfer_cond->data_available = TRUE;
+    sink->transfer_cond->wait_for_response = TRUE;
+    g_cond_broadcast (&sink->transfer_cond->cond);
+  }
+
+  return GST_FLOW_OK;
+}
+
+static void
+gst_curl_base_sink_wait_for_queue_drain_unlocked (GstCurlBaseSink * sink)
+{
+  if (!sink->use_queue)
+    return;
+
+  GST_LOG ("waiting for transfer queue to drain");
+
+  while (sink->transfer_queue->len > 0 && sink->transfer_thread != NULL &&
+      sink->flow_ret == GST_FLOW_OK && !sink->flushing) {
+    g_cond_wait (&sink->transfer_cond->cond, GST_OBJECT_GET_LOCK (sink));
+  }
+
+  GST_LOG ("transfer queue drained");
+}
+
+static GstStructure *
+gst_curl_base_sink_create_stats (GstCurlBaseSink * sink)
+{
+  GstStructure *s;
+  guint64 bitrate = 0;
+  gint64 elapsed;
+
+  GST_OBJECT_LOCK (sink);
+
+  if (sink->transfer_start_time > 0) {
+    elapsed = g_get_monotonic_time () - sink->transfer_start_time;
+    if (elapsed > 0)
+      bitrate = gst_util_uint64_scale (sink->bytes_sent * 8, G_USEC_PER_SEC,
+          elapsed);
+  }
+
+  s = gst_structure_new ("application/x-curl-sink-stats",
+      "queued-bytes", G_TYPE_UINT64, (guint64) sink->transfer_queue->len,
+      "queued-time", G_TYPE_UINT64, (guint64) sink->transfer_queue->duration,
+      "max-queued-bytes", G_TYPE_UINT64, (guint64) sink->max_queued_bytes,
+      "stalls", G_TYPE_UINT, sink->stalls,
+      "stall-time", G_TYPE_UINT64, (guint64) sink->stall_time,
+      "bytes-sent", G_TYPE_UINT64, sink->bytes_sent,
+      "bitrate", G_TYPE_UINT64, bitrate, NULL);
+
+  GST_OBJECT_UNLOCK (sink);
+
+  return s;
+}
+
 static gint
 gst_curl_base_sink_setup_dscp_unlocked (GstCurlBaseSink * sink)
 {
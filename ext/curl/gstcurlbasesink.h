@@ -42,6 +42,7 @@ typedef struct _GstCurlBaseSinkClass GstCurlBaseSinkClass;
 
 typedef struct _TransferBuffer TransferBuffer;
 typedef struct _TransferCondition TransferCondition;
+typedef struct _TransferQueue TransferQueue;
 
 struct _TransferBuffer
 {
@@ -58,6 +59,19 @@ struct _TransferCondition
   gboolean wait_for_response;
 };
 
+/* bounded byte ring between the render function and the transfer thread,
+ * only used when max-queue-bytes is set */
+struct _TransferQueue
+{
+  guint8 *data;
+  gsize size;
+  gsize offset;
+  gsize len;
+  /* one entry per queued buffer, used to track the queued duration */
+  GQueue chunks;
+  GstClockTime duration;
+};
+
 struct _GstCurlBaseSink
 {
   GstBaseSink parent;
@@ -71,6 +85,7 @@ struct _GstCurlBaseSink
   GstFlowReturn flow_ret;
   TransferBuffer *transfer_buf;
   TransferCondition *transfer_cond;
+  TransferQueue *transfer_queue;
   gint num_buffers_per_packet;
   gint timeout;
   gchar *url;
@@ -81,6 +96,17 @@ struct _GstCurlBaseSink
   gboolean transfer_thread_close;
   gboolean new_file;
   gboolean is_live;
+  guint max_queue_bytes;
+  guint64 max_queue_time;
+  gboolean use_queue;
+  gboolean flushing;
+
+  /* statistics */
+  guint64 bytes_sent;
+  gsize max_queued_bytes;
+  guint stalls;
+  GstClockTime stall_time;
+  gint64 transfer_start_time;
 };
 
 struct _GstCurlBaseSinkClass
@@ -103,6 +129,7 @@ struct _GstCurlBaseSinkClass
     size_t (*flush_data_unlocked) (GstCurlBaseSink * sink, void *curl_ptr,
       size_t block_size, gboolean new_file, gboolean close_transfer);
   gboolean (*has_buffered_data_unlocked) (GstCurlBaseSink * sink);
+  gboolean (*supports_queueing_unlocked) (GstCurlBaseSink * sink);
 };
 
 GType gst_curl_base_sink_get_type (void);
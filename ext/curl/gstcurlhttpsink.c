@@ -107,6 +107,8 @@ static gboolean gst_curl_http_sink_transfer_verify_response_code
     (GstCurlBaseSink * bcsink);
 static void gst_curl_http_sink_transfer_prepare_poll_wait
     (GstCurlBaseSink * bcsink);
+static gboolean gst_curl_http_sink_supports_queueing_unlocked
+    (GstCurlBaseSink * bcsink);
 
 #define gst_curl_http_sink_parent_class parent_class
 G_DEFINE_TYPE (GstCurlHttpSink, gst_curl_http_sink, GST_TYPE_CURL_TLS_SINK);
@@ -141,6 +143,8 @@ gst_curl_http_sink_class_init (GstCurlHttpSinkClass * klass)
       gst_curl_http_sink_transfer_verify_response_code;
   gstcurlbasesink_class->transfer_prepare_poll_wait =
       gst_curl_http_sink_transfer_prepare_poll_wait;
+  gstcurlbasesink_class->supports_queueing_unlocked =
+      gst_curl_http_sink_supports_queueing_unlocked;
 
   gobject_class->finalize = GST_DEBUG_FUNCPTR (gst_curl_http_sink_finalize);
 
@@ -387,6 +391,20 @@ gst_curl_http_sink_set_options_unlocked (GstCurlBaseSink * bcsink)
   return TRUE;
 }
 
+static gboolean
+gst_curl_http_sink_supports_queueing_unlocked (GstCurlBaseSink * bcsink)
+{
+  GstCurlHttpSink *sink = GST_CURL_HTTP_SINK (bcsink);
+  GstCurlBaseSinkClass *base_class = GST_CURL_BASE_SINK_CLASS (parent_class);
+
+  /* the Content-Length header is taken from the size of the rendered buffer,
+   * so every buffer has to be transferred on its own */
+  if (sink->use_content_length)
+    return FALSE;
+
+  return base_class->supports_queueing_unlocked (bcsink);
+}
+
 static gboolean
 gst_curl_http_sink_transfer_verify_response_code (GstCurlBaseSink * bcsink)
 {
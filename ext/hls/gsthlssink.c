@@ -28,6 +28,22 @@
  * gst-launch-1.0 videotestsrc is-live=true ! x264enc ! mpegtsmux ! hlssink max-files=5
  * ]|
  * </refsect2>
+ *
+ * When #GstHlsSink:in-memory is set, fragments are not written to disk.
+ * The last #GstHlsSink:max-files fragments are kept in memory as buffer
+ * lists referencing the original buffers and the playlist text is kept next
+ * to them. As memory is not reclaimed by anybody else, a
+ * #GstHlsSink:max-files of 0 keeps the fragments of the playlist and the one
+ * that just left it instead of all of them. Applications can fetch both with
+ * the #GstHlsSink::get-playlist and #GstHlsSink::get-fragment action
+ * signals, or let the sink serve them itself over HTTP by setting
+ * #GstHlsSink:http-port.
+ * <refsect2>
+ * <title>Example launch line</title>
+ * |[
+ * gst-launch-1.0 videotestsrc is-live=true ! x264enc ! mpegtsmux ! hlssink in-memory=true http-port=8080
+ * ]|
+ * </refsect2>
  */
 #ifdef HAVE_CONFIG_H
 #include "config.h"
@@ -39,6 +55,7 @@
 #include <gio/gio.h>
 #include <glib/gstdio.h>
 #include <memory.h>
+#include <string.h>
 
 
 GST_DEBUG_CATEGORY_STATIC (gst_hls_sink_debug);
@@ -50,6 +67,14 @@ GST_DEBUG_CATEGORY_STATIC (gst_hls_sink_debug);
 #define DEFAULT_MAX_FILES 10
 #define DEFAULT_TARGET_DURATION 15
 #define DEFAULT_PLAYLIST_LENGTH 5
+#define DEFAULT_IN_MEMORY FALSE
+#define DEFAULT_HTTP_PORT 0
+
+/* maximum number of concurrently served HTTP requests */
+#define HTTP_MAX_THREADS 10
+/* seconds a client may stall a read or write before it is dropped, so slow
+ * clients cannot keep all the threads busy */
+#define HTTP_TIMEOUT 10
 
 enum
 {
@@ -59,9 +84,35 @@ enum
   PROP_PLAYLIST_ROOT,
   PROP_MAX_FILES,
   PROP_TARGET_DURATION,
-  PROP_PLAYLIST_LENGTH
+  PROP_PLAYLIST_LENGTH,
+  PROP_IN_MEMORY,
+  PROP_HTTP_PORT
+};
+
+enum
+{
+  SIGNAL_GET_PLAYLIST,
+  SIGNAL_GET_FRAGMENT,
+  LAST_SIGNAL
 };
 
+static guint gst_hls_sink_signals[LAST_SIGNAL] = { 0 };
+
+typedef struct
+{
+  gchar *name;
+  GstBufferList *data;
+  gsize size;
+} GstHlsFragment;
+
+/* data of the HTTP handler threads, which can outlive the state the service
+ * was started in */
+typedef struct
+{
+  GstHlsSink *sink;
+  gchar *playlist_name;
+} GstHlsHttpContext;
+
 static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
     GST_PAD_SINK,
     GST_PAD_ALWAYS,
@@ -83,6 +134,31 @@ static void gst_hls_sink_reset (GstHlsSink * sink);
 static GstStateChangeReturn
 gst_hls_sink_change_state (GstElement * element, GstStateChange trans);
 static gboolean schedule_next_key_unit (GstHlsSink * sink);
+static void gst_hls_sink_fragment_closed (GstHlsSink * sink,
+    const gchar * filename, GstClockTime running_time);
+static void gst_hls_sink_close_memory_fragment (GstHlsSink * sink,
+    GstClockTime running_time);
+static gchar *gst_hls_sink_get_playlist (GstHlsSink * sink);
+static GstBufferList *gst_hls_sink_get_fragment (GstHlsSink * sink,
+    const gchar * name);
+static gboolean gst_hls_sink_start_http_service (GstHlsSink * sink);
+static void gst_hls_sink_stop_http_service (GstHlsSink * sink);
+
+static void
+gst_hls_fragment_free (GstHlsFragment * fragment)
+{
+  g_free (fragment->name);
+  gst_buffer_list_unref (fragment->data);
+  g_slice_free (GstHlsFragment, fragment);
+}
+
+static void
+gst_hls_http_context_free (GstHlsHttpContext * context, GClosure * closure)
+{
+  gst_object_unref (context->sink);
+  g_free (context->playlist_name);
+  g_slice_free (GstHlsHttpContext, context);
+}
 
 static void
 gst_hls_sink_dispose (GObject * object)
@@ -100,6 +176,14 @@ gst_hls_sink_finalize (GObject * object)
   g_free (sink->location);
   g_free (sink->playlist_location);
   g_free (sink->playlist_root);
+  if (sink->playlist)
+    gst_m3u8_playlist_free (sink->playlist);
+  if (sink->fragment_data)
+    gst_buffer_list_unref (sink->fragment_data);
+  g_queue_foreach (&sink->fragments, (GFunc) gst_hls_fragment_free, NULL);
+  g_queue_clear (&sink->fragments);
+  g_free (sink->playlist_content);
+  g_mutex_clear (&sink->store_lock);
 
   G_OBJECT_CLASS (parent_class)->finalize ((GObject *) sink);
 }
@@ -146,7 +230,8 @@ gst_hls_sink_class_init (GstHlsSinkClass * klass)
   g_object_class_install_property (gobject_class, PROP_MAX_FILES,
       g_param_spec_uint ("max-files", "Max files",
           "Maximum number of files to keep on disk. Once the maximum is reached,"
-          "old files start to be deleted to make room for new ones.",
+          "old files start to be deleted to make room for new ones. In memory, "
+          "0 keeps the fragments of the playlist.",
           0, G_MAXUINT, DEFAULT_MAX_FILES,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
   g_object_class_install_property (gobject_class, PROP_TARGET_DURATION,
@@ -162,6 +247,50 @@ gst_hls_sink_class_init (GstHlsSinkClass * klass)
           "of the HLS specification, this should be at least 3.",
           1, G_MAXUINT, DEFAULT_PLAYLIST_LENGTH,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_IN_MEMORY,
+      g_param_spec_boolean ("in-memory", "In memory",
+          "Keep the last max-files fragments and the playlist in memory "
+          "instead of writing them to files",
+          DEFAULT_IN_MEMORY, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_HTTP_PORT,
+      g_param_spec_uint ("http-port", "HTTP port",
+          "Port to serve the in-memory playlist and fragments on "
+          "(0 - disabled)", 0, G_MAXUINT16, DEFAULT_HTTP_PORT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstHlsSink::get-playlist:
+   * @sink: the #GstHlsSink
+   *
+   * Get the current playlist text in in-memory mode.
+   *
+   * Returns: the playlist, or %NULL if none was rendered yet. g_free() after
+   * usage.
+   */
+  gst_hls_sink_signals[SIGNAL_GET_PLAYLIST] =
+      g_signal_new ("get-playlist", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION,
+      G_STRUCT_OFFSET (GstHlsSinkClass, get_playlist), NULL, NULL,
+      g_cclosure_marshal_generic, G_TYPE_STRING, 0, G_TYPE_NONE);
+
+  /**
+   * GstHlsSink::get-fragment:
+   * @sink: the #GstHlsSink
+   * @name: the file name of the fragment, as used in the playlist
+   *
+   * Get a fragment kept in memory in in-memory mode.
+   *
+   * Returns: the fragment data, or %NULL if no such fragment is kept.
+   * Unref after usage.
+   */
+  gst_hls_sink_signals[SIGNAL_GET_FRAGMENT] =
+      g_signal_new ("get-fragment", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION,
+      G_STRUCT_OFFSET (GstHlsSinkClass, get_fragment), NULL, NULL,
+      g_cclosure_marshal_generic, GST_TYPE_BUFFER_LIST, 1, G_TYPE_STRING);
+
+  klass->get_playlist = gst_hls_sink_get_playlist;
+  klass->get_fragment = gst_hls_sink_get_fragment;
 }
 
 static void
@@ -182,6 +311,10 @@ gst_hls_sink_init (GstHlsSink * sink)
   sink->playlist_length = DEFAULT_PLAYLIST_LENGTH;
   sink->max_files = DEFAULT_MAX_FILES;
   sink->target_duration = DEFAULT_TARGET_DURATION;
+  sink->in_memory = DEFAULT_IN_MEMORY;
+  sink->http_port = DEFAULT_HTTP_PORT;
+  g_mutex_init (&sink->store_lock);
+  g_queue_init (&sink->fragments);
 
   /* haven't added a sink yet, make it is detected as a sink meanwhile */
   GST_OBJECT_FLAG_SET (sink, GST_ELEMENT_FLAG_SINK);
@@ -203,6 +336,20 @@ gst_hls_sink_reset (GstHlsSink * sink)
   if (sink->playlist)
     gst_m3u8_playlist_free (sink->playlist);
   sink->playlist = gst_m3u8_playlist_new (6, sink->playlist_length, FALSE);
+
+  sink->fragment_index = 0;
+  sink->fragment_end_time = GST_CLOCK_TIME_NONE;
+  if (sink->fragment_data) {
+    gst_buffer_list_unref (sink->fragment_data);
+    sink->fragment_data = NULL;
+  }
+
+  g_mutex_lock (&sink->store_lock);
+  g_queue_foreach (&sink->fragments, (GFunc) gst_hls_fragment_free, NULL);
+  g_queue_clear (&sink->fragments);
+  g_free (sink->playlist_content);
+  sink->playlist_content = NULL;
+  g_mutex_unlock (&sink->store_lock);
 }
 
 static gboolean
@@ -215,6 +362,24 @@ gst_hls_sink_create_elements (GstHlsSink * sink)
   if (sink->elements_created)
     return TRUE;
 
+  /* in memory the fragments are collected in the ghost pad buffer probe, the
+   * data only has to be consumed */
+  if (sink->in_memory) {
+    sink->memorysink = gst_element_factory_make ("fakesink", NULL);
+    if (sink->memorysink == NULL)
+      goto missing_fakesink;
+
+    g_object_set (sink->memorysink, "sync", FALSE, "async", FALSE, NULL);
+    gst_bin_add (GST_BIN_CAST (sink), sink->memorysink);
+
+    pad = gst_element_get_static_pad (sink->memorysink, "sink");
+    gst_ghost_pad_set_target (GST_GHOST_PAD (sink->ghostpad), pad);
+    gst_object_unref (pad);
+
+    sink->elements_created = TRUE;
+    return TRUE;
+  }
+
   sink->multifilesink = gst_element_factory_make ("multifilesink", NULL);
   if (sink->multifilesink == NULL)
     goto missing_element;
@@ -240,6 +405,312 @@ missing_element:
       (("Missing element '%s' - check your GStreamer installation."),
           "multifilesink"), (NULL));
   return FALSE;
+
+missing_fakesink:
+  gst_element_post_message (GST_ELEMENT_CAST (sink),
+      gst_missing_element_message_new (GST_ELEMENT_CAST (sink), "fakesink"));
+  GST_ELEMENT_ERROR (sink, CORE, MISSING_PLUGIN,
+      (("Missing element '%s' - check your GStreamer installation."),
+          "fakesink"), (NULL));
+  return FALSE;
+}
+
+static void
+gst_hls_sink_fragment_closed (GstHlsSink * sink, const gchar * filename,
+    GstClockTime running_time)
+{
+  GFile *file = NULL;
+  const char *title;
+  char *playlist_content;
+  GstClockTime duration;
+  gboolean discont = FALSE;
+  GError *error = NULL;
+  gchar *entry_location;
+
+  duration = running_time - sink->last_running_time;
+  sink->last_running_time = running_time;
+
+  if (!sink->in_memory)
+    file = g_file_new_for_path (filename);
+  title = "ciao";
+  GST_INFO_OBJECT (sink, "COUNT %d", sink->index);
+  if (sink->playlist_root == NULL)
+    entry_location = g_path_get_basename (filename);
+  else {
+    gchar *name = g_path_get_basename (filename);
+    entry_location = g_build_filename (sink->playlist_root, name, NULL);
+    g_free (name);
+  }
+
+  gst_m3u8_playlist_add_entry (sink->playlist, entry_location, file,
+      title, duration, sink->index, discont);
+  g_free (entry_location);
+  playlist_content = gst_m3u8_playlist_render (sink->playlist);
+
+  if (sink->in_memory) {
+    g_mutex_lock (&sink->store_lock);
+    g_free (sink->playlist_content);
+    sink->playlist_content = playlist_content;
+    g_mutex_unlock (&sink->store_lock);
+  } else {
+    if (!g_file_set_contents (sink->playlist_location,
+            playlist_content, -1, &error)) {
+      GST_ERROR ("Failed to write playlist: %s", error->message);
+      GST_ELEMENT_ERROR (sink, RESOURCE, OPEN_WRITE,
+          (("Failed to write playlist '%s'."), error->message), (NULL));
+      g_error_free (error);
+      error = NULL;
+    }
+    g_free (playlist_content);
+  }
+
+  /* a new fragment is started. It means that upstream sent a key unit and
+   * we can schedule the next key unit now.
+   */
+  sink->waiting_fku = FALSE;
+  schedule_next_key_unit (sink);
+}
+
+/* stores the fragment collected so far, mirroring what multifilesink does
+ * when it closes a file */
+static void
+gst_hls_sink_close_memory_fragment (GstHlsSink * sink,
+    GstClockTime running_time)
+{
+  GstHlsFragment *fragment;
+  gchar *filename;
+  guint i, len, max_files;
+
+  if (sink->fragment_data == NULL)
+    return;
+
+  filename = g_strdup_printf (sink->location, sink->fragment_index);
+  sink->fragment_index++;
+
+  fragment = g_slice_new (GstHlsFragment);
+  fragment->name = g_path_get_basename (filename);
+  fragment->data = sink->fragment_data;
+  fragment->size = 0;
+  sink->fragment_data = NULL;
+
+  len = gst_buffer_list_length (fragment->data);
+  for (i = 0; i < len; i++)
+    fragment->size += gst_buffer_get_size (gst_buffer_list_get (fragment->data,
+            i));
+
+  GST_DEBUG_OBJECT (sink, "fragment %s closed, %u buffers, %" G_GSIZE_FORMAT
+      " bytes", fragment->name, len, fragment->size);
+
+  /* unlike on disk, the store always needs a bound */
+  max_files = sink->max_files;
+  if (max_files == 0)
+    max_files = sink->playlist_length + 1;
+
+  g_mutex_lock (&sink->store_lock);
+  g_queue_push_tail (&sink->fragments, fragment);
+  while (sink->fragments.length > max_files)
+    gst_hls_fragment_free (g_queue_pop_head (&sink->fragments));
+  g_mutex_unlock (&sink->store_lock);
+
+  gst_hls_sink_fragment_closed (sink, filename, running_time);
+  g_free (filename);
+}
+
+static gchar *
+gst_hls_sink_get_playlist (GstHlsSink * sink)
+{
+  gchar *playlist;
+
+  g_mutex_lock (&sink->store_lock);
+  playlist = g_strdup (sink->playlist_content);
+  g_mutex_unlock (&sink->store_lock);
+
+  return playlist;
+}
+
+static GstBufferList *
+gst_hls_sink_get_fragment (GstHlsSink * sink, const gchar * name)
+{
+  GstBufferList *data = NULL;
+  GList *walk;
+
+  g_return_val_if_fail (name != NULL, NULL);
+
+  g_mutex_lock (&sink->store_lock);
+  for (walk = sink->fragments.tail; walk; walk = walk->prev) {
+    GstHlsFragment *fragment = walk->data;
+
+    if (strcmp (fragment->name, name) == 0) {
+      data = gst_buffer_list_ref (fragment->data);
+      break;
+    }
+  }
+  g_mutex_unlock (&sink->store_lock);
+
+  return data;
+}
+
+static gboolean
+gst_hls_sink_http_write_response (GOutputStream * out, const gchar * status,
+    const gchar * content_type, gsize content_length)
+{
+  gchar *header;
+  gboolean res;
+
+  header = g_strdup_printf ("HTTP/1.0 %s\r\n"
+      "Content-Type: %s\r\n"
+      "Content-Length: %" G_GSIZE_FORMAT "\r\n"
+      "Cache-Control: no-cache\r\n"
+      "Connection: close\r\n\r\n", status, content_type, content_length);
+  res = g_output_stream_write_all (out, header, strlen (header), NULL, NULL,
+      NULL);
+  g_free (header);
+
+  return res;
+}
+
+static gboolean
+gst_hls_sink_http_run (GThreadedSocketService * service,
+    GSocketConnection * connection, GObject * source_object, gpointer data)
+{
+  GstHlsHttpContext *context = data;
+  GstHlsSink *sink = context->sink;
+  GInputStream *in = g_io_stream_get_input_stream (G_IO_STREAM (connection));
+  GOutputStream *out =
+      g_io_stream_get_output_stream (G_IO_STREAM (connection));
+  GDataInputStream *data_in;
+  gchar *request, *line, *name = NULL;
+  gchar **parts = NULL;
+
+  g_socket_set_timeout (g_socket_connection_get_socket (connection),
+      HTTP_TIMEOUT);
+
+  data_in = g_data_input_stream_new (in);
+  g_data_input_stream_set_newline_type (data_in,
+      G_DATA_STREAM_NEWLINE_TYPE_ANY);
+
+  request = g_data_input_stream_read_line (data_in, NULL, NULL, NULL);
+  if (request == NULL)
+    goto done;
+
+  /* the request headers are not needed */
+  while ((line = g_data_input_stream_read_line (data_in, NULL, NULL, NULL))) {
+    gboolean end = (line[0] == '\0');
+
+    g_free (line);
+    if (end)
+      break;
+  }
+
+  parts = g_strsplit (request, " ", 3);
+  if (g_strv_length (parts) < 2 || strcmp (parts[0], "GET") != 0) {
+    gst_hls_sink_http_write_response (out, "400 Bad Request", "text/plain", 0);
+    goto done;
+  }
+
+  GST_LOG_OBJECT (sink, "serving %s", parts[1]);
+
+  name = g_path_get_basename (parts[1]);
+
+  if (strcmp (name, context->playlist_name) == 0) {
+    gchar *playlist = gst_hls_sink_get_playlist (sink);
+
+    if (playlist == NULL) {
+      gst_hls_sink_http_write_response (out, "404 Not Found", "text/plain", 0);
+    } else if (gst_hls_sink_http_write_response (out, "200 OK",
+            "application/vnd.apple.mpegurl", strlen (playlist))) {
+      g_output_stream_write_all (out, playlist, strlen (playlist), NULL, NULL,
+          NULL);
+    }
+    g_free (playlist);
+  } else {
+    GstBufferList *fragment = gst_hls_sink_get_fragment (sink, name);
+    gsize size = 0;
+    guint i, len;
+
+    if (fragment == NULL) {
+      gst_hls_sink_http_write_response (out, "404 Not Found", "text/plain", 0);
+      goto done;
+    }
+
+    len = gst_buffer_list_length (fragment);
+    for (i = 0; i < len; i++)
+      size += gst_buffer_get_size (gst_buffer_list_get (fragment, i));
+
+    if (gst_hls_sink_http_write_response (out, "200 OK", "video/mp2t", size)) {
+      for (i = 0; i < len; i++) {
+        GstMapInfo map;
+        gboolean res;
+
+        gst_buffer_map (gst_buffer_list_get (fragment, i), &map, GST_MAP_READ);
+        res = g_output_stream_write_all (out, map.data, map.size, NULL, NULL,
+            NULL);
+        gst_buffer_unmap (gst_buffer_list_get (fragment, i), &map);
+        if (!res)
+          break;
+      }
+    }
+    gst_buffer_list_unref (fragment);
+  }
+
+done:
+  g_free (name);
+  g_strfreev (parts);
+  g_free (request);
+  g_object_unref (data_in);
+
+  return TRUE;
+}
+
+static gboolean
+gst_hls_sink_start_http_service (GstHlsSink * sink)
+{
+  GstHlsHttpContext *context;
+  GError *error = NULL;
+
+  if (!sink->in_memory || sink->http_port == 0 || sink->http_service)
+    return TRUE;
+
+  sink->http_service = g_threaded_socket_service_new (HTTP_MAX_THREADS);
+  if (!g_socket_listener_add_inet_port (G_SOCKET_LISTENER (sink->http_service),
+          sink->http_port, NULL, &error)) {
+    GST_ELEMENT_ERROR (sink, RESOURCE, OPEN_READ_WRITE,
+        ("Failed to listen on port %u: %s", sink->http_port, error->message),
+        (NULL));
+    g_error_free (error);
+    g_object_unref (sink->http_service);
+    sink->http_service = NULL;
+    return FALSE;
+  }
+
+  /* the service keeps a reference to the sink and a copy of the playlist
+   * name until it is destroyed, the properties may change meanwhile */
+  context = g_slice_new (GstHlsHttpContext);
+  context->sink = gst_object_ref (sink);
+  GST_OBJECT_LOCK (sink);
+  context->playlist_name = g_path_get_basename (sink->playlist_location);
+  GST_OBJECT_UNLOCK (sink);
+  g_signal_connect_data (sink->http_service, "run",
+      G_CALLBACK (gst_hls_sink_http_run), context,
+      (GClosureNotify) gst_hls_http_context_free, 0);
+  g_socket_service_start (sink->http_service);
+
+  GST_INFO_OBJECT (sink, "serving playlist and fragments on port %u",
+      sink->http_port);
+
+  return TRUE;
+}
+
+static void
+gst_hls_sink_stop_http_service (GstHlsSink * sink)
+{
+  if (sink->http_service == NULL)
+    return;
+
+  g_socket_service_stop (sink->http_service);
+  g_socket_listener_close (G_SOCKET_LISTENER (sink->http_service));
+  g_object_unref (sink->http_service);
+  sink->http_service = NULL;
 }
 
 static void
@@ -250,13 +721,8 @@ gst_hls_sink_handle_message (GstBin * bin, GstMessage * message)
   switch (message->type) {
     case GST_MESSAGE_ELEMENT:
     {
-      GFile *file;
-      const char *filename, *title;
-      char *playlist_content;
-      GstClockTime running_time, duration;
-      gboolean discont = FALSE;
-      GError *error = NULL;
-      gchar *entry_location;
+      const char *filename;
+      GstClockTime running_time;
       const GstStructure *structure;
 
       structure = gst_message_get_structure (message);
@@ -265,39 +731,9 @@ gst_hls_sink_handle_message (GstBin * bin, GstMessage * message)
 
       filename = gst_structure_get_string (structure, "filename");
       gst_structure_get_clock_time (structure, "running-time", &running_time);
-      duration = running_time - sink->last_running_time;
-      sink->last_running_time = running_time;
-
-      file = g_file_new_for_path (filename);
-      title = "ciao";
-      GST_INFO_OBJECT (sink, "COUNT %d", sink->index);
-      if (sink->playlist_root == NULL)
-        entry_location = g_path_get_basename (filename);
-      else {
-        gchar *name = g_path_get_basename (filename);
-        entry_location = g_build_filename (sink->playlist_root, name, NULL);
-        g_free (name);
-      }
-
-      gst_m3u8_playlist_add_entry (sink->playlist, entry_location, file,
-          title, duration, sink->index, discont);
-      g_free (entry_location);
-      playlist_content = gst_m3u8_playlist_render (sink->playlist);
-      if (!g_file_set_contents (sink->playlist_location,
-              playlist_content, -1, &error)) {
-        GST_ERROR ("Failed to write playlist: %s", error->message);
-        GST_ELEMENT_ERROR (sink, RESOURCE, OPEN_WRITE,
-            (("Failed to write playlist '%s'."), error->message), (NULL));
-        g_error_free (error);
-        error = NULL;
-      }
-      g_free (playlist_content);
 
-      /* multifilesink is starting a new file. It means that upstream sent a key
-       * unit and we can schedule the next key unit now.
-       */
-      sink->waiting_fku = FALSE;
-      schedule_next_key_unit (sink);
+      /* multifilesink is starting a new file */
+      gst_hls_sink_fragment_closed (sink, filename, running_time);
 
       /* multifilesink is an internal implementation detail. If applications
        * need a notification, we should probably do our own message */
@@ -326,6 +762,11 @@ gst_hls_sink_change_state (GstElement * element, GstStateChange trans)
         return GST_STATE_CHANGE_FAILURE;
       }
       break;
+    case GST_STATE_CHANGE_READY_TO_PAUSED:
+      if (!gst_hls_sink_start_http_service (sink)) {
+        return GST_STATE_CHANGE_FAILURE;
+      }
+      break;
     case GST_STATE_CHANGE_PAUSED_TO_PLAYING:
       break;
     default:
@@ -338,6 +779,7 @@ gst_hls_sink_change_state (GstElement * element, GstStateChange trans)
     case GST_STATE_CHANGE_PLAYING_TO_PAUSED:
       break;
     case GST_STATE_CHANGE_PAUSED_TO_READY:
+      gst_hls_sink_stop_http_service (sink);
       gst_hls_sink_reset (sink);
       break;
     case GST_STATE_CHANGE_READY_TO_NULL:
@@ -364,8 +806,10 @@ gst_hls_sink_set_property (GObject * object, guint prop_id,
         g_object_set (sink->multifilesink, "location", sink->location, NULL);
       break;
     case PROP_PLAYLIST_LOCATION:
+      GST_OBJECT_LOCK (sink);
       g_free (sink->playlist_location);
       sink->playlist_location = g_value_dup_string (value);
+      GST_OBJECT_UNLOCK (sink);
       break;
     case PROP_PLAYLIST_ROOT:
       g_free (sink->playlist_root);
@@ -386,6 +830,16 @@ gst_hls_sink_set_property (GObject * object, guint prop_id,
       sink->playlist_length = g_value_get_uint (value);
       sink->playlist->window_size = sink->playlist_length;
       break;
+    case PROP_IN_MEMORY:
+      if (sink->elements_created) {
+        GST_WARNING_OBJECT (sink, "in-memory can only be changed in NULL state");
+        break;
+      }
+      sink->in_memory = g_value_get_boolean (value);
+      break;
+    case PROP_HTTP_PORT:
+      sink->http_port = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -403,7 +857,9 @@ gst_hls_sink_get_property (GObject * object, guint prop_id,
       g_value_set_string (value, sink->location);
       break;
     case PROP_PLAYLIST_LOCATION:
+      GST_OBJECT_LOCK (sink);
       g_value_set_string (value, sink->playlist_location);
+      GST_OBJECT_UNLOCK (sink);
       break;
     case PROP_PLAYLIST_ROOT:
       g_value_set_string (value, sink->playlist_root);
@@ -417,6 +873,12 @@ gst_hls_sink_get_property (GObject * object, guint prop_id,
     case PROP_PLAYLIST_LENGTH:
       g_value_set_uint (value, sink->playlist_length);
       break;
+    case PROP_IN_MEMORY:
+      g_value_set_boolean (value, sink->in_memory);
+      break;
+    case PROP_HTTP_PORT:
+      g_value_set_uint (value, sink->http_port);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -453,9 +915,18 @@ gst_hls_sink_ghost_event_probe (GstPad * pad, GstPadProbeInfo * info,
       gst_video_event_parse_downstream_force_key_unit (event,
           &timestamp, &stream_time, &running_time, &all_headers, &count);
       GST_INFO_OBJECT (sink, "setting index %d", count);
+
+      /* the key unit starts a new fragment, like multifilesink with
+       * next-file=key-unit-event does */
+      if (sink->in_memory)
+        gst_hls_sink_close_memory_fragment (sink, running_time);
       sink->index = count;
       break;
     }
+    case GST_EVENT_EOS:
+      if (sink->in_memory && GST_CLOCK_TIME_IS_VALID (sink->fragment_end_time))
+        gst_hls_sink_close_memory_fragment (sink, sink->fragment_end_time);
+      break;
     default:
       break;
   }
@@ -505,6 +976,24 @@ gst_hls_sink_ghost_buffer_probe (GstPad * pad, GstPadProbeInfo * info,
   GstClockTime timestamp;
 
   timestamp = GST_BUFFER_TIMESTAMP (buffer);
+
+  /* keep a reference to the data instead of writing it out */
+  if (sink->in_memory) {
+    if (sink->fragment_data == NULL)
+      sink->fragment_data = gst_buffer_list_new ();
+    gst_buffer_list_add (sink->fragment_data, gst_buffer_ref (buffer));
+
+    if (GST_CLOCK_TIME_IS_VALID (timestamp) &&
+        sink->segment.format == GST_FORMAT_TIME) {
+      GstClockTime end = timestamp;
+
+      if (GST_BUFFER_DURATION_IS_VALID (buffer))
+        end += GST_BUFFER_DURATION (buffer);
+      sink->fragment_end_time = gst_segment_to_running_time (&sink->segment,
+          GST_FORMAT_TIME, end);
+    }
+  }
+
   if (sink->target_duration == 0 || !GST_CLOCK_TIME_IS_VALID (timestamp)
       || sink->waiting_fku)
     return GST_PAD_PROBE_OK;
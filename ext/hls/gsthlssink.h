@@ -21,6 +21,7 @@
 
 #include "gstm3u8playlist.h"
 #include <gst/gst.h>
+#include <gio/gio.h>
 
 G_BEGIN_DECLS
 
@@ -56,11 +57,27 @@ struct _GstHlsSink
   GstSegment segment;
   gboolean waiting_fku;
   GstClockTime last_running_time;
+
+  /* in-memory mode */
+  gboolean in_memory;
+  guint http_port;
+  GstElement *memorysink;
+  GstBufferList *fragment_data;
+  guint fragment_index;
+  GstClockTime fragment_end_time;
+  GMutex store_lock;
+  GQueue fragments;
+  gchar *playlist_content;
+  GSocketService *http_service;
 };
 
 struct _GstHlsSinkClass
 {
   GstBinClass bin_class;
+
+  /* actions */
+  gchar * (*get_playlist) (GstHlsSink * sink);
+  GstBufferList * (*get_fragment) (GstHlsSink * sink, const gchar * name);
 };
 
 GType gst_hls_sink_get_type (void);
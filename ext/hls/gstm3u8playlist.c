@@ -20,6 +20,7 @@
  */
 
 #include <glib.h>
+#include <string.h>
 
 #include "gstfragmented.h"
 #include "gstm3u8playlist.h"
@@ -103,6 +104,7 @@ gst_m3u8_playlist_new (guint version, guint window_size, gboolean allow_cache)
   playlist->type = GST_M3U8_PLAYLIST_TYPE_EVENT;
   playlist->end_list = FALSE;
   playlist->entries = g_queue_new ();
+  playlist->entries_str = g_string_new ("");
 
   return playlist;
 }
@@ -114,6 +116,7 @@ gst_m3u8_playlist_free (GstM3U8Playlist * playlist)
 
   g_queue_foreach (playlist->entries, (GFunc) gst_m3u8_entry_free, NULL);
   g_queue_free (playlist->entries);
+  g_string_free (playlist->entries_str, TRUE);
   g_free (playlist);
 }
 
@@ -124,6 +127,7 @@ gst_m3u8_playlist_add_entry (GstM3U8Playlist * playlist,
     gfloat duration, guint index, gboolean discontinuous)
 {
   GstM3U8Entry *entry;
+  gchar *entry_str;
 
   g_return_val_if_fail (playlist != NULL, FALSE);
   g_return_val_if_fail (url != NULL, FALSE);
@@ -140,10 +144,17 @@ gst_m3u8_playlist_add_entry (GstM3U8Playlist * playlist,
       GstM3U8Entry *old_entry;
 
       old_entry = g_queue_pop_head (playlist->entries);
+      g_string_erase (playlist->entries_str, 0, old_entry->rendered_len);
       gst_m3u8_entry_free (old_entry);
     }
   }
 
+  /* entries never change once added, so they are only rendered once */
+  entry_str = gst_m3u8_entry_render (entry, playlist->version);
+  entry->rendered_len = strlen (entry_str);
+  g_string_append_len (playlist->entries_str, entry_str, entry->rendered_len);
+  g_free (entry_str);
+
   playlist->sequence_number = index + 1;
   g_queue_push_tail (playlist->entries, entry);
 
@@ -166,16 +177,6 @@ gst_m3u8_playlist_target_duration (GstM3U8Playlist * playlist)
   return (guint) ((target_duration + 500 * GST_MSECOND) / GST_SECOND);
 }
 
-static void
-render_entry (GstM3U8Entry * entry, GstM3U8Playlist * playlist)
-{
-  gchar *entry_str;
-
-  entry_str = gst_m3u8_entry_render (entry, playlist->version);
-  g_string_append_printf (playlist->playlist_str, "%s", entry_str);
-  g_free (entry_str);
-}
-
 gchar *
 gst_m3u8_playlist_render (GstM3U8Playlist * playlist)
 {
@@ -183,7 +184,8 @@ gst_m3u8_playlist_render (GstM3U8Playlist * playlist)
 
   g_return_val_if_fail (playlist != NULL, NULL);
 
-  playlist->playlist_str = g_string_new ("");
+  playlist->playlist_str = g_string_sized_new (playlist->entries_str->len +
+      256);
 
   /* #EXTM3U */
   g_string_append_printf (playlist->playlist_str, M3U8_HEADER_TAG);
@@ -202,7 +204,8 @@ gst_m3u8_playlist_render (GstM3U8Playlist * playlist)
   g_string_append_printf (playlist->playlist_str, "\n");
 
   /* Entries */
-  g_queue_foreach (playlist->entries, (GFunc) render_entry, playlist);
+  g_string_append_len (playlist->playlist_str, playlist->entries_str->str,
+      playlist->entries_str->len);
 
   if (playlist->end_list)
     g_string_append_printf (playlist->playlist_str, M3U8_ENDLIST_TAG);
@@ -219,6 +222,7 @@ gst_m3u8_playlist_clear (GstM3U8Playlist * playlist)
 
   g_queue_foreach (playlist->entries, (GFunc) gst_m3u8_entry_free, NULL);
   g_queue_clear (playlist->entries);
+  g_string_truncate (playlist->entries_str, 0);
 }
 
 guint
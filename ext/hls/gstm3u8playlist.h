@@ -38,6 +38,9 @@ struct _GstM3U8Entry
   gchar *url;
   GFile *file;
   gboolean discontinuous;
+
+  /*< Private >*/
+  gsize rendered_len;
 };
 
 struct _GstM3U8Playlist
@@ -52,6 +55,8 @@ struct _GstM3U8Playlist
   /*< Private >*/
   GQueue *entries;
   GString *playlist_str;
+  /* rendered entries, updated incrementally when entries are added/removed */
+  GString *entries_str;
 };
 
 
@@ -190,6 +190,10 @@ static GstFlowReturn gst_srtp_dec_chain_rtp (GstPad * pad,
     GstObject * parent, GstBuffer * buf);
 static GstFlowReturn gst_srtp_dec_chain_rtcp (GstPad * pad,
     GstObject * parent, GstBuffer * buf);
+static GstFlowReturn gst_srtp_dec_chain_list_rtp (GstPad * pad,
+    GstObject * parent, GstBufferList * buf_list);
+static GstFlowReturn gst_srtp_dec_chain_list_rtcp (GstPad * pad,
+    GstObject * parent, GstBufferList * buf_list);
 
 static GstStateChangeReturn gst_srtp_dec_change_state (GstElement * element,
     GstStateChange transition);
@@ -317,6 +321,8 @@ gst_srtp_dec_init (GstSrtpDec * filter)
       GST_DEBUG_FUNCPTR (gst_srtp_dec_iterate_internal_links_rtp));
   gst_pad_set_chain_function (filter->rtp_sinkpad,
       GST_DEBUG_FUNCPTR (gst_srtp_dec_chain_rtp));
+  gst_pad_set_chain_list_function (filter->rtp_sinkpad,
+      GST_DEBUG_FUNCPTR (gst_srtp_dec_chain_list_rtp));
 
   filter->rtp_srcpad =
       gst_pad_new_from_static_template (&rtp_src_template, "rtp_src");
@@ -340,6 +346,8 @@ gst_srtp_dec_init (GstSrtpDec * filter)
       GST_DEBUG_FUNCPTR (gst_srtp_dec_iterate_internal_links_rtcp));
   gst_pad_set_chain_function (filter->rtcp_sinkpad,
       GST_DEBUG_FUNCPTR (gst_srtp_dec_chain_rtcp));
+  gst_pad_set_chain_list_function (filter->rtcp_sinkpad,
+      GST_DEBUG_FUNCPTR (gst_srtp_dec_chain_list_rtcp));
 
   filter->rtcp_srcpad =
       gst_pad_new_from_static_template (&rtcp_src_template, "rtcp_src");
@@ -927,15 +935,15 @@ gst_srtp_dec_push_early_events (GstSrtpDec * filter, GstPad * pad,
 
 }
 
-static GstFlowReturn
-gst_srtp_dec_chain (GstPad * pad, GstObject * parent, GstBuffer * buf,
-    gboolean is_rtcp)
+/* Unprotect @buf in place. Returns %NULL if the buffer was dropped.
+ * @is_rtcp is updated if a RTCP packet is received on the RTP pad.
+ */
+static GstBuffer *
+gst_srtp_dec_decode_buffer (GstSrtpDec * filter, GstPad * pad, GstBuffer * buf,
+    gboolean * is_rtcp)
 {
-  GstSrtpDec *filter = GST_SRTP_DEC (parent);
-  GstPad *otherpad;
   err_status_t err = err_status_ok;
   GstSrtpDecSsrcStream *stream = NULL;
-  GstFlowReturn ret = GST_FLOW_OK;
   gint size;
   guint32 ssrc = 0;
   GstMapInfo map;
@@ -944,7 +952,7 @@ gst_srtp_dec_chain (GstPad * pad, GstObject * parent, GstBuffer * buf,
 
   /* Check if this stream exists, if not create a new stream */
 
-  if (!(stream = validate_buffer (filter, buf, &ssrc, &is_rtcp))) {
+  if (!(stream = validate_buffer (filter, buf, &ssrc, is_rtcp))) {
     GST_OBJECT_UNLOCK (filter);
     GST_WARNING_OBJECT (filter, "Invalid buffer, dropping");
     goto drop_buffer;
@@ -952,11 +960,11 @@ gst_srtp_dec_chain (GstPad * pad, GstObject * parent, GstBuffer * buf,
 
   if (!STREAM_HAS_CRYPTO (stream)) {
     GST_OBJECT_UNLOCK (filter);
-    goto push_out;
+    return buf;
   }
 
   GST_LOG_OBJECT (pad, "Received %s buffer of size %" G_GSIZE_FORMAT
-      " with SSRC = %u", is_rtcp ? "RTCP" : "RTP", gst_buffer_get_size (buf),
+      " with SSRC = %u", *is_rtcp ? "RTCP" : "RTP", gst_buffer_get_size (buf),
       ssrc);
 
   /* Change buffer to remove protection */
@@ -969,7 +977,7 @@ unprotect:
 
   gst_srtp_init_event_reporter ();
 
-  if (is_rtcp)
+  if (*is_rtcp)
     err = srtp_unprotect_rtcp (filter->session, map.data, &size);
   else
     err = srtp_unprotect (filter->session, map.data, &size);
@@ -1022,27 +1030,120 @@ unprotect:
   if (gst_srtp_get_soft_limit_reached ())
     request_key_with_signal (filter, ssrc, SIGNAL_SOFT_LIMIT);
 
-push_out:
-  /* Push buffer to source pad */
+  return buf;
+
+drop_buffer:
+  gst_buffer_unref (buf);
+
+  return NULL;
+}
+
+/* Return the source pad for RTP or RTCP packets, making sure the early
+ * events were sent on it
+ */
+static GstPad *
+gst_srtp_dec_get_src_pad (GstSrtpDec * filter, gboolean is_rtcp)
+{
   if (is_rtcp) {
-    otherpad = filter->rtcp_srcpad;
     if (!filter->rtcp_has_segment)
       gst_srtp_dec_push_early_events (filter, filter->rtcp_srcpad,
           filter->rtp_srcpad, TRUE);
+    return filter->rtcp_srcpad;
   } else {
-    otherpad = filter->rtp_srcpad;
     if (!filter->rtp_has_segment)
       gst_srtp_dec_push_early_events (filter, filter->rtp_srcpad,
           filter->rtcp_srcpad, FALSE);
+    return filter->rtp_srcpad;
   }
-  ret = gst_pad_push (otherpad, buf);
+}
 
-  return ret;
+static GstFlowReturn
+gst_srtp_dec_chain (GstPad * pad, GstObject * parent, GstBuffer * buf,
+    gboolean is_rtcp)
+{
+  GstSrtpDec *filter = GST_SRTP_DEC (parent);
+  GstPad *otherpad;
 
-drop_buffer:
-  /* Drop buffer, except if gst_pad_push returned OK or an error */
+  buf = gst_srtp_dec_decode_buffer (filter, pad, buf, &is_rtcp);
 
-  gst_buffer_unref (buf);
+  /* Dropped buffers are not an error */
+  if (!buf)
+    return GST_FLOW_OK;
+
+  /* Push buffer to source pad */
+  otherpad = gst_srtp_dec_get_src_pad (filter, is_rtcp);
+
+  return gst_pad_push (otherpad, buf);
+}
+
+typedef struct
+{
+  GstSrtpDec *filter;
+  GstPad *pad;
+  gboolean is_rtcp;
+  GstBufferList *rtp_list;
+  GstBufferList *rtcp_list;
+  guint len;
+} DecodeBufferItData;
+
+static gboolean
+decode_buffer_it (GstBuffer ** buffer, guint idx, gpointer user_data)
+{
+  DecodeBufferItData *data = user_data;
+  GstBufferList **list;
+  gboolean is_rtcp = data->is_rtcp;
+  GstBuffer *buf;
+
+  /* Steal the buffer from the list so it can be unprotected in place */
+  buf = gst_srtp_dec_decode_buffer (data->filter, data->pad, *buffer,
+      &is_rtcp);
+  *buffer = NULL;
+
+  if (!buf)
+    return TRUE;
+
+  list = is_rtcp ? &data->rtcp_list : &data->rtp_list;
+  if (*list == NULL)
+    *list = gst_buffer_list_sized_new (data->len);
+  gst_buffer_list_add (*list, buf);
+
+  return TRUE;
+}
+
+static GstFlowReturn
+gst_srtp_dec_chain_list (GstPad * pad, GstObject * parent,
+    GstBufferList * buf_list, gboolean is_rtcp)
+{
+  GstSrtpDec *filter = GST_SRTP_DEC (parent);
+  GstFlowReturn ret = GST_FLOW_OK;
+  DecodeBufferItData data;
+  GstPad *otherpad;
+
+  data.filter = filter;
+  data.pad = pad;
+  data.is_rtcp = is_rtcp;
+  data.rtp_list = NULL;
+  data.rtcp_list = NULL;
+  data.len = gst_buffer_list_length (buf_list);
+
+  buf_list = gst_buffer_list_make_writable (buf_list);
+  gst_buffer_list_foreach (buf_list, decode_buffer_it, &data);
+  gst_buffer_list_unref (buf_list);
+
+  /* RTCP packets can be muxed on the RTP pad, push each kind to its pad */
+  if (data.rtp_list) {
+    otherpad = gst_srtp_dec_get_src_pad (filter, FALSE);
+    ret = gst_pad_push_list (otherpad, data.rtp_list);
+  }
+
+  if (data.rtcp_list) {
+    GstFlowReturn rtcp_ret;
+
+    otherpad = gst_srtp_dec_get_src_pad (filter, TRUE);
+    rtcp_ret = gst_pad_push_list (otherpad, data.rtcp_list);
+    if (!data.rtp_list)
+      ret = rtcp_ret;
+  }
 
   return ret;
 }
@@ -1059,6 +1160,20 @@ gst_srtp_dec_chain_rtcp (GstPad * pad, GstObject * parent, GstBuffer * buf)
   return gst_srtp_dec_chain (pad, parent, buf, TRUE);
 }
 
+static GstFlowReturn
+gst_srtp_dec_chain_list_rtp (GstPad * pad, GstObject * parent,
+    GstBufferList * buf_list)
+{
+  return gst_srtp_dec_chain_list (pad, parent, buf_list, FALSE);
+}
+
+static GstFlowReturn
+gst_srtp_dec_chain_list_rtcp (GstPad * pad, GstObject * parent,
+    GstBufferList * buf_list)
+{
+  return gst_srtp_dec_chain_list (pad, parent, buf_list, TRUE);
+}
+
 static GstStateChangeReturn
 gst_srtp_dec_change_state (GstElement * element, GstStateChange transition)
 {
@@ -125,6 +125,12 @@ GST_DEBUG_CATEGORY_STATIC (gst_srtp_enc_debug);
 #define DEFAULT_RTCP_AUTH       DEFAULT_RTP_AUTH
 #define DEFAULT_RANDOM_KEY      FALSE
 
+/* Room left after the packet for the authentication tag and MKI */
+#define SRTP_TRAILER_ROOM (SRTP_MAX_TRAILER_LEN + 10)
+
+/* Output buffers fit a typical MTU sized packet with its trailer */
+#define DEFAULT_OUTPUT_BUFFER_SIZE (1500 + SRTP_TRAILER_ROOM)
+
 #define HAS_CRYPTO(filter) (filter->rtp_cipher != GST_SRTP_CIPHER_NULL || \
       filter->rtcp_cipher != GST_SRTP_CIPHER_NULL ||                      \
       filter->rtp_auth != GST_SRTP_AUTH_NULL ||                           \
@@ -205,6 +211,10 @@ static GstFlowReturn gst_srtp_enc_chain_rtp (GstPad * pad, GstObject * parent,
     GstBuffer * buf);
 static GstFlowReturn gst_srtp_enc_chain_rtcp (GstPad * pad, GstObject * parent,
     GstBuffer * buf);
+static GstFlowReturn gst_srtp_enc_chain_list_rtp (GstPad * pad,
+    GstObject * parent, GstBufferList * buf_list);
+static GstFlowReturn gst_srtp_enc_chain_list_rtcp (GstPad * pad,
+    GstObject * parent, GstBufferList * buf_list);
 
 static gboolean gst_srtp_enc_sink_event_rtp (GstPad * pad, GstObject * parent,
     GstEvent * event);
@@ -218,6 +228,7 @@ static GstPad *gst_srtp_enc_request_new_pad (GstElement * element,
     GstPadTemplate * templ, const gchar * name, const GstCaps * caps);
 
 static void gst_srtp_enc_release_pad (GstElement * element, GstPad * pad);
+static void gst_srtp_enc_clear_pool (GstSrtpEnc * filter);
 
 struct GstSrtpEncPads
 {
@@ -468,6 +479,8 @@ create_rtp_sink (GstSrtpEnc * filter, const gchar * name)
       GST_DEBUG_FUNCPTR (gst_srtp_enc_iterate_internal_links_rtp));
   gst_pad_set_chain_function (priv->sinkpad,
       GST_DEBUG_FUNCPTR (gst_srtp_enc_chain_rtp));
+  gst_pad_set_chain_list_function (priv->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_srtp_enc_chain_list_rtp));
   gst_pad_set_event_function (priv->sinkpad,
       GST_DEBUG_FUNCPTR (gst_srtp_enc_sink_event_rtp));
   gst_pad_set_active (priv->sinkpad, TRUE);
@@ -515,6 +528,8 @@ create_rtcp_sink (GstSrtpEnc * filter, const gchar * name)
       GST_DEBUG_FUNCPTR (gst_srtp_enc_iterate_internal_links_rtcp));
   gst_pad_set_chain_function (priv->sinkpad,
       GST_DEBUG_FUNCPTR (gst_srtp_enc_chain_rtcp));
+  gst_pad_set_chain_list_function (priv->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_srtp_enc_chain_list_rtcp));
   gst_pad_set_event_function (priv->sinkpad,
       GST_DEBUG_FUNCPTR (gst_srtp_enc_sink_event_rtcp));
   gst_pad_set_active (priv->sinkpad, TRUE);
@@ -580,6 +595,8 @@ gst_srtp_enc_dispose (GObject * object)
     g_hash_table_unref (filter->ssrcs_set);
   filter->ssrcs_set = NULL;
 
+  gst_srtp_enc_clear_pool (filter);
+
   G_OBJECT_CLASS (gst_srtp_enc_parent_class)->dispose (object);
 }
 
@@ -915,20 +932,100 @@ gst_srtp_enc_replace_random_key (GstSrtpEnc * filter)
   filter->key_changed = TRUE;
 }
 
+/* (Re)create the pool used for output buffers so that it can hold packets
+ * of @size bytes including the SRTP trailer
+ */
+static void
+gst_srtp_enc_update_pool_locked (GstSrtpEnc * filter, guint size)
+{
+  GstStructure *config;
+
+  if (filter->pool) {
+    gst_buffer_pool_set_active (filter->pool, FALSE);
+    gst_object_unref (filter->pool);
+  }
+
+  filter->pool_size = MAX (size, DEFAULT_OUTPUT_BUFFER_SIZE);
+
+  GST_DEBUG_OBJECT (filter, "Using output buffers of %u bytes",
+      filter->pool_size);
+
+  filter->pool = gst_buffer_pool_new ();
+  config = gst_buffer_pool_get_config (filter->pool);
+  gst_buffer_pool_config_set_params (config, NULL, filter->pool_size, 0, 0);
+  gst_buffer_pool_set_config (filter->pool, config);
+  gst_buffer_pool_set_active (filter->pool, TRUE);
+}
+
+static void
+gst_srtp_enc_clear_pool (GstSrtpEnc * filter)
+{
+  GST_OBJECT_LOCK (filter);
+  if (filter->pool) {
+    gst_buffer_pool_set_active (filter->pool, FALSE);
+    gst_object_unref (filter->pool);
+    filter->pool = NULL;
+  }
+  filter->pool_size = 0;
+  GST_OBJECT_UNLOCK (filter);
+}
+
+/* Return a buffer holding the data of @buf with room for the SRTP trailer.
+ * If @buf is writable and its memory has enough room, it is protected in
+ * place, otherwise its data is copied once into a buffer from the pool.
+ * Takes ownership of @buf.
+ */
+static GstBuffer *
+gst_srtp_enc_get_output_buffer_locked (GstSrtpEnc * filter, GstBuffer * buf)
+{
+  GstBuffer *bufout = NULL;
+  GstMapInfo map;
+  gsize size, offset, maxsize;
+
+  size = gst_buffer_get_sizes (buf, &offset, &maxsize);
+
+  if (gst_buffer_is_writable (buf) && gst_buffer_n_memory (buf) == 1 &&
+      maxsize - offset - size >= SRTP_TRAILER_ROOM) {
+    gst_buffer_set_size (buf, size + SRTP_TRAILER_ROOM);
+    return buf;
+  }
+
+  if (filter->pool == NULL || filter->pool_size < size + SRTP_TRAILER_ROOM)
+    gst_srtp_enc_update_pool_locked (filter, size + SRTP_TRAILER_ROOM);
+
+  if (gst_buffer_pool_acquire_buffer (filter->pool, &bufout,
+          NULL) != GST_FLOW_OK)
+    bufout = gst_buffer_new_allocate (NULL, filter->pool_size, NULL);
+
+  gst_buffer_set_size (bufout, size + SRTP_TRAILER_ROOM);
+
+  gst_buffer_map (bufout, &map, GST_MAP_WRITE);
+  gst_buffer_extract (buf, 0, map.data, size);
+  gst_buffer_unmap (bufout, &map);
+
+  gst_buffer_copy_into (bufout, buf, GST_BUFFER_COPY_METADATA, 0, -1);
+  gst_buffer_unref (buf);
+
+  return bufout;
+}
+
+/* Protect @buf and return the buffer to push in @outbuf.
+ * Takes ownership of @buf.
+ */
 static GstFlowReturn
-gst_srtp_enc_chain (GstPad * pad, GstObject * parent, GstBuffer * buf,
-    gboolean is_rtcp)
+gst_srtp_enc_process_buffer (GstSrtpEnc * filter, GstPad * pad,
+    GstBuffer * buf, gboolean is_rtcp, GstBuffer ** outbuf)
 {
-  GstSrtpEnc *filter = GST_SRTP_ENC (parent);
   GstFlowReturn ret = GST_FLOW_OK;
-  GstPad *otherpad = NULL;
   err_status_t err = err_status_ok;
-  gint size_max, size;
+  gint size;
   GstBuffer *bufout = NULL;
   struct GstSrtpEncPads *priv = gst_pad_get_element_private (pad);
   guint32 ssrc;
   gboolean do_setcaps = FALSE;
-  GstMapInfo mapin, mapout;
+  GstMapInfo map;
+
+  *outbuf = NULL;
 
   if (!priv)
     goto fail;
@@ -986,50 +1083,38 @@ gst_srtp_enc_chain (GstPad * pad, GstObject * parent, GstBuffer * buf,
 
   if (!HAS_CRYPTO (filter)) {
     GST_OBJECT_UNLOCK (filter);
-    otherpad = get_rtp_other_pad (pad);
-    return gst_pad_push (otherpad, buf);
+    *outbuf = buf;
+    return GST_FLOW_OK;
   }
 
+  size = gst_buffer_get_size (buf);
 
-  /* Create a bigger buffer to add protection */
-  size_max = gst_buffer_get_size (buf) + SRTP_MAX_TRAILER_LEN + 10;
-  bufout = gst_buffer_new_allocate (NULL, size_max, NULL);
-
-  gst_buffer_map (buf, &mapin, GST_MAP_READ);
-  gst_buffer_map (bufout, &mapout, GST_MAP_READWRITE);
+  bufout = gst_srtp_enc_get_output_buffer_locked (filter, buf);
+  buf = NULL;
 
-  size = mapin.size;
-  memcpy (mapout.data, mapin.data, mapin.size);
-
-  gst_buffer_unmap (buf, &mapin);
+  gst_buffer_map (bufout, &map, GST_MAP_READWRITE);
 
   gst_srtp_init_event_reporter ();
 
   if (is_rtcp)
-    err = srtp_protect_rtcp (filter->session, mapout.data, &size);
+    err = srtp_protect_rtcp (filter->session, map.data, &size);
   else
-    err = srtp_protect (filter->session, mapout.data, &size);
+    err = srtp_protect (filter->session, map.data, &size);
 
-  gst_buffer_unmap (bufout, &mapout);
+  gst_buffer_unmap (bufout, &map);
 
   GST_OBJECT_UNLOCK (filter);
 
   if (err == err_status_ok) {
     /* Buffer protected */
     gst_buffer_set_size (bufout, size);
-    gst_buffer_copy_into (bufout, buf, GST_BUFFER_COPY_METADATA, 0, -1);
 
     GST_LOG_OBJECT (pad, "Encing %s buffer of size %d",
         is_rtcp ? "RTCP" : "RTP", size);
 
-    /* Push buffer to source pad */
-    otherpad = get_rtp_other_pad (pad);
-    ret = gst_pad_push (otherpad, bufout);
+    *outbuf = bufout;
     bufout = NULL;
 
-    if (ret != GST_FLOW_OK)
-      goto out;
-
   } else if (err == err_status_key_expired) {
 
     GST_ELEMENT_ERROR (GST_ELEMENT_CAST (filter), STREAM, ENCODE,
@@ -1054,7 +1139,8 @@ gst_srtp_enc_chain (GstPad * pad, GstObject * parent, GstBuffer * buf,
 
 out:
 
-  gst_buffer_unref (buf);
+  if (buf)
+    gst_buffer_unref (buf);
 
   return ret;
 
@@ -1063,6 +1149,80 @@ fail:
   goto out;
 }
 
+static GstFlowReturn
+gst_srtp_enc_chain (GstPad * pad, GstObject * parent, GstBuffer * buf,
+    gboolean is_rtcp)
+{
+  GstSrtpEnc *filter = GST_SRTP_ENC (parent);
+  GstFlowReturn ret;
+  GstBuffer *bufout;
+
+  ret = gst_srtp_enc_process_buffer (filter, pad, buf, is_rtcp, &bufout);
+  if (ret != GST_FLOW_OK)
+    return ret;
+
+  /* Push buffer to source pad */
+  return gst_pad_push (get_rtp_other_pad (pad), bufout);
+}
+
+typedef struct
+{
+  GstSrtpEnc *filter;
+  GstPad *pad;
+  gboolean is_rtcp;
+  GstBufferList *out_list;
+  GstFlowReturn ret;
+} ProcessBufferItData;
+
+static gboolean
+process_buffer_it (GstBuffer ** buffer, guint idx, gpointer user_data)
+{
+  ProcessBufferItData *data = user_data;
+  GstBuffer *bufout;
+
+  /* Steal the buffer from the list so it can be protected in place */
+  data->ret = gst_srtp_enc_process_buffer (data->filter, data->pad, *buffer,
+      data->is_rtcp, &bufout);
+  *buffer = NULL;
+
+  if (data->ret != GST_FLOW_OK)
+    return FALSE;
+
+  gst_buffer_list_add (data->out_list, bufout);
+
+  return TRUE;
+}
+
+static GstFlowReturn
+gst_srtp_enc_chain_list (GstPad * pad, GstObject * parent,
+    GstBufferList * buf_list, gboolean is_rtcp)
+{
+  ProcessBufferItData data;
+
+  data.filter = GST_SRTP_ENC (parent);
+  data.pad = pad;
+  data.is_rtcp = is_rtcp;
+  data.out_list = gst_buffer_list_sized_new (gst_buffer_list_length (buf_list));
+  data.ret = GST_FLOW_OK;
+
+  buf_list = gst_buffer_list_make_writable (buf_list);
+  gst_buffer_list_foreach (buf_list, process_buffer_it, &data);
+  gst_buffer_list_unref (buf_list);
+
+  if (data.ret != GST_FLOW_OK) {
+    gst_buffer_list_unref (data.out_list);
+    return data.ret;
+  }
+
+  if (gst_buffer_list_length (data.out_list) == 0) {
+    gst_buffer_list_unref (data.out_list);
+    return GST_FLOW_OK;
+  }
+
+  /* Push the whole list to source pad */
+  return gst_pad_push_list (get_rtp_other_pad (pad), data.out_list);
+}
+
 static GstFlowReturn
 gst_srtp_enc_chain_rtp (GstPad * pad, GstObject * parent, GstBuffer * buf)
 {
@@ -1075,6 +1235,20 @@ gst_srtp_enc_chain_rtcp (GstPad * pad, GstObject * parent, GstBuffer * buf)
   return gst_srtp_enc_chain (pad, parent, buf, TRUE);
 }
 
+static GstFlowReturn
+gst_srtp_enc_chain_list_rtp (GstPad * pad, GstObject * parent,
+    GstBufferList * buf_list)
+{
+  return gst_srtp_enc_chain_list (pad, parent, buf_list, FALSE);
+}
+
+static GstFlowReturn
+gst_srtp_enc_chain_list_rtcp (GstPad * pad, GstObject * parent,
+    GstBufferList * buf_list)
+{
+  return gst_srtp_enc_chain_list (pad, parent, buf_list, TRUE);
+}
+
 
 /* Change state
  */
@@ -1126,6 +1300,7 @@ gst_srtp_enc_change_state (GstElement * element, GstStateChange transition)
       break;
     case GST_STATE_CHANGE_PAUSED_TO_READY:
       gst_srtp_enc_reset (filter);
+      gst_srtp_enc_clear_pool (filter);
       break;
     case GST_STATE_CHANGE_READY_TO_NULL:
       break;
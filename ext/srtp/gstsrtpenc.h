@@ -87,6 +87,10 @@ struct _GstSrtpEnc
 
   GHashTable *ssrcs_set;
 
+  /* pool for output buffers that can't be protected in place */
+  GstBufferPool *pool;
+  guint pool_size;
+
   GType key_type;
 };
 
@@ -1449,15 +1449,20 @@ gst_asf_mux_flush_payloads (GstAsfMux * asfmux)
   guint32 payload_size;
   guint offset;
   GstMapInfo map;
+  GstFlowReturn ret;
 
   if (asfmux->payloads == NULL)
     return GST_FLOW_OK;         /* nothing to send is ok */
 
   GST_LOG_OBJECT (asfmux, "Flushing payloads");
 
-  buf = gst_buffer_new_and_alloc (asfmux->packet_size);
+  ret = gst_buffer_pool_acquire_buffer (asfmux->packet_pool, &buf, NULL);
+  if (G_UNLIKELY (ret != GST_FLOW_OK)) {
+    GST_DEBUG_OBJECT (asfmux, "failed to acquire packet: %s",
+        gst_flow_get_name (ret));
+    return ret;
+  }
   gst_buffer_map (buf, &map, GST_MAP_WRITE);
-  memset (map.data, 0, asfmux->packet_size);
 
   /* 1 for the multiple payload flags */
   data = map.data + asfmux->payload_parsing_info_size + 1;
@@ -1477,8 +1482,9 @@ gst_asf_mux_flush_payloads (GstAsfMux * asfmux)
       send_ts = GST_BUFFER_TIMESTAMP (payload->data);
     }
 
-    /* adding new simple index entry (if needed) */
-    if (!pad->is_audio
+    /* adding new simple index entry (if needed), the index is never
+     * written when streaming */
+    if (!pad->is_audio && !asfmux->prop_streamable
         && GST_CLOCK_TIME_IS_VALID (GST_BUFFER_TIMESTAMP (payload->data))) {
       GstAsfVideoPad *videopad = (GstAsfVideoPad *) pad;
       if (videopad->has_keyframe) {
@@ -1579,6 +1585,10 @@ gst_asf_mux_flush_payloads (GstAsfMux * asfmux)
   GST_LOG_OBJECT (asfmux, "Payload data size: %" G_GUINT32_FORMAT,
       asfmux->payload_data_size);
 
+  /* packets are reused, so only the padding needs clearing as everything
+   * before it is written below */
+  memset (map.data + asfmux->packet_size - size_left, 0, size_left);
+
   /* fill payload parsing info */
   data = map.data;
   size = map.size;
@@ -1624,6 +1634,8 @@ gst_asf_mux_flush_payloads (GstAsfMux * asfmux)
   if (GST_CLOCK_TIME_IS_VALID (send_ts)) {
     GST_WRITE_UINT32_LE (data + offset, (send_ts / GST_MSECOND));
     GST_BUFFER_TIMESTAMP (buf) = send_ts;
+  } else {
+    GST_WRITE_UINT32_LE (data + offset, 0);
   }
   offset += 4;
 
@@ -2383,6 +2395,35 @@ gst_asf_mux_set_property (GObject * object,
   }
 }
 
+static gboolean
+gst_asf_mux_start_packet_pool (GstAsfMux * asfmux)
+{
+  GstStructure *config;
+
+  asfmux->packet_pool = gst_buffer_pool_new ();
+  config = gst_buffer_pool_get_config (asfmux->packet_pool);
+  gst_buffer_pool_config_set_params (config, NULL, asfmux->packet_size, 0, 0);
+  if (!gst_buffer_pool_set_config (asfmux->packet_pool, config) ||
+      !gst_buffer_pool_set_active (asfmux->packet_pool, TRUE)) {
+    GST_ERROR_OBJECT (asfmux, "failed to activate packet pool");
+    gst_object_unref (asfmux->packet_pool);
+    asfmux->packet_pool = NULL;
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+static void
+gst_asf_mux_stop_packet_pool (GstAsfMux * asfmux)
+{
+  if (asfmux->packet_pool) {
+    gst_buffer_pool_set_active (asfmux->packet_pool, FALSE);
+    gst_object_unref (asfmux->packet_pool);
+    asfmux->packet_pool = NULL;
+  }
+}
+
 static GstStateChangeReturn
 gst_asf_mux_change_state (GstElement * element, GstStateChange transition)
 {
@@ -2400,6 +2441,8 @@ gst_asf_mux_change_state (GstElement * element, GstStateChange transition)
       asfmux->packet_size = asfmux->prop_packet_size;
       asfmux->preroll = asfmux->prop_preroll;
       asfmux->merge_stream_tags = asfmux->prop_merge_stream_tags;
+      if (!gst_asf_mux_start_packet_pool (asfmux))
+        return GST_STATE_CHANGE_FAILURE;
       gst_collect_pads_start (asfmux->collect);
       break;
     case GST_STATE_CHANGE_PAUSED_TO_PLAYING:
@@ -2420,6 +2463,7 @@ gst_asf_mux_change_state (GstElement * element, GstStateChange transition)
     case GST_STATE_CHANGE_PLAYING_TO_PAUSED:
       break;
     case GST_STATE_CHANGE_PAUSED_TO_READY:
+      gst_asf_mux_stop_packet_pool (asfmux);
       break;
     case GST_STATE_CHANGE_READY_TO_NULL:
       break;
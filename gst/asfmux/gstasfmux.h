@@ -138,6 +138,9 @@ struct _GstAsfMux
   guint64 preroll;              /* milisecs */
   gboolean merge_stream_tags;
 
+  /* fixed size data packets are taken from here */
+  GstBufferPool *packet_pool;
+
   GstClockTime first_ts;
 
   /* pads */
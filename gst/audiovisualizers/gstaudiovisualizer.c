@@ -133,36 +133,38 @@ gst_audio_visualizer_shader_get_type (void)
 }
 
 /* we're only supporting GST_VIDEO_FORMAT_xRGB right now) */
-#if G_BYTE_ORDER == G_LITTLE_ENDIAN
-
-#define SHADE(_d, _s, _i, _r, _g, _b)                     \
-G_STMT_START {                                            \
-    _d[_i * 4 + 0] = (_s[_i * 4 + 0] > _b) ? _s[_i * 4 + 0] - _b : 0; \
-    _d[_i * 4 + 1] = (_s[_i * 4 + 1] > _g) ? _s[_i * 4 + 1] - _g : 0; \
-    _d[_i * 4 + 2] = (_s[_i * 4 + 2] > _r) ? _s[_i * 4 + 2] - _r : 0; \
-    _d[_i * 4 + 3] = 0;                                       \
-} G_STMT_END
-
-#else /* G_BYTE_ORDER == G_LITTLE_ENDIAN */
-
-#define SHADE(_d, _s, _i, _r, _g, _b)                     \
-G_STMT_START {                                            \
-    _d[_i * 4 + 0] = 0;                                       \
-    _d[_i * 4 + 1] = (_s[_i * 4 + 1] > _r) ? _s[_i * 4 + 1] - _r : 0; \
-    _d[_i * 4 + 2] = (_s[_i * 4 + 2] > _g) ? _s[_i * 4 + 2] - _g : 0; \
-    _d[_i * 4 + 3] = (_s[_i * 4 + 3] > _b) ? _s[_i * 4 + 3] - _b : 0; \
-} G_STMT_END
 
-#endif
+/* Subtracts the shade amount from the red, green and blue components of @n
+ * pixels, clamping at 0 and clearing the unused component. In a native endian
+ * 32 bit word xRGB has blue in the low byte for both byte orders. Red and blue
+ * are handled together in two 16 bit lanes, green in a second word, bit 8 of
+ * each lane tells whether the subtraction did not underflow. */
+static void
+shade_pixels (guint32 * d, const guint32 * s, guint n, guint32 shade_amount)
+{
+  guint32 rb_amount = shade_amount & 0x00ff00ff;
+  guint32 g_amount = (shade_amount >> 8) & 0xff;
+  guint i;
+
+  for (i = 0; i < n; i++) {
+    guint32 rb = ((s[i] & 0x00ff00ff) | 0x01000100) - rb_amount;
+    guint32 g = (((s[i] >> 8) & 0xff) | 0x100) - g_amount;
+
+    rb &= ((rb >> 8) & 0x00010001) * 0xff;
+    g &= ((g >> 8) & 0x1) * 0xff;
+    d[i] = rb | (g << 8);
+  }
+}
+
+#define SHADE_ROW(_d, _s, _n) \
+    shade_pixels ((guint32 *) (_d), (const guint32 *) (_s), _n, \
+        scope->shade_amount)
 
 static void
 shader_fade (GstAudioVisualizer * scope, const GstVideoFrame * sframe,
     GstVideoFrame * dframe)
 {
-  guint i, j;
-  guint r = (scope->shade_amount >> 16) & 0xff;
-  guint g = (scope->shade_amount >> 8) & 0xff;
-  guint b = (scope->shade_amount >> 0) & 0xff;
+  guint j;
   guint8 *s, *d;
   gint ss, ds, width, height;
 
@@ -174,10 +176,14 @@ shader_fade (GstAudioVisualizer * scope, const GstVideoFrame * sframe,
   width = GST_VIDEO_FRAME_WIDTH (sframe);
   height = GST_VIDEO_FRAME_HEIGHT (sframe);
 
+  /* without padding the frame can be done in one go */
+  if (ss == width * 4 && ds == width * 4) {
+    SHADE_ROW (d, s, width * height);
+    return;
+  }
+
   for (j = 0; j < height; j++) {
-    for (i = 0; i < width; i++) {
-      SHADE (d, s, i, r, g, b);
-    }
+    SHADE_ROW (d, s, width);
     s += ss;
     d += ds;
   }
@@ -187,10 +193,7 @@ static void
 shader_fade_and_move_up (GstAudioVisualizer * scope,
     const GstVideoFrame * sframe, GstVideoFrame * dframe)
 {
-  guint i, j;
-  guint r = (scope->shade_amount >> 16) & 0xff;
-  guint g = (scope->shade_amount >> 8) & 0xff;
-  guint b = (scope->shade_amount >> 0) & 0xff;
+  guint j;
   guint8 *s, *d;
   gint ss, ds, width, height;
 
@@ -204,9 +207,7 @@ shader_fade_and_move_up (GstAudioVisualizer * scope,
 
   for (j = 1; j < height; j++) {
     s += ss;
-    for (i = 0; i < width; i++) {
-      SHADE (d, s, i, r, g, b);
-    }
+    SHADE_ROW (d, s, width);
     d += ds;
   }
 }
@@ -215,10 +216,7 @@ static void
 shader_fade_and_move_down (GstAudioVisualizer * scope,
     const GstVideoFrame * sframe, GstVideoFrame * dframe)
 {
-  guint i, j;
-  guint r = (scope->shade_amount >> 16) & 0xff;
-  guint g = (scope->shade_amount >> 8) & 0xff;
-  guint b = (scope->shade_amount >> 0) & 0xff;
+  guint j;
   guint8 *s, *d;
   gint ss, ds, width, height;
 
@@ -232,9 +230,7 @@ shader_fade_and_move_down (GstAudioVisualizer * scope,
 
   for (j = 1; j < height; j++) {
     d += ds;
-    for (i = 0; i < width; i++) {
-      SHADE (d, s, i, r, g, b);
-    }
+    SHADE_ROW (d, s, width);
     s += ss;
   }
 }
@@ -243,10 +239,7 @@ static void
 shader_fade_and_move_left (GstAudioVisualizer * scope,
     const GstVideoFrame * sframe, GstVideoFrame * dframe)
 {
-  guint i, j;
-  guint r = (scope->shade_amount >> 16) & 0xff;
-  guint g = (scope->shade_amount >> 8) & 0xff;
-  guint b = (scope->shade_amount >> 0) & 0xff;
+  guint j;
   guint8 *s, *d;
   gint ss, ds, width, height;
 
@@ -263,9 +256,7 @@ shader_fade_and_move_left (GstAudioVisualizer * scope,
 
   /* move to the left */
   for (j = 0; j < height; j++) {
-    for (i = 0; i < width; i++) {
-      SHADE (d, s, i, r, g, b);
-    }
+    SHADE_ROW (d, s, width);
     d += ds;
     s += ss;
   }
@@ -275,10 +266,7 @@ static void
 shader_fade_and_move_right (GstAudioVisualizer * scope,
     const GstVideoFrame * sframe, GstVideoFrame * dframe)
 {
-  guint i, j;
-  guint r = (scope->shade_amount >> 16) & 0xff;
-  guint g = (scope->shade_amount >> 8) & 0xff;
-  guint b = (scope->shade_amount >> 0) & 0xff;
+  guint j;
   guint8 *s, *d;
   gint ss, ds, width, height;
 
@@ -295,9 +283,7 @@ shader_fade_and_move_right (GstAudioVisualizer * scope,
 
   /* move to the right */
   for (j = 0; j < height; j++) {
-    for (i = 0; i < width; i++) {
-      SHADE (d, s, i, r, g, b);
-    }
+    SHADE_ROW (d, s, width);
     d += ds;
     s += ss;
   }
@@ -307,10 +293,7 @@ static void
 shader_fade_and_move_horiz_out (GstAudioVisualizer * scope,
     const GstVideoFrame * sframe, GstVideoFrame * dframe)
 {
-  guint i, j;
-  guint r = (scope->shade_amount >> 16) & 0xff;
-  guint g = (scope->shade_amount >> 8) & 0xff;
-  guint b = (scope->shade_amount >> 0) & 0xff;
+  guint j;
   guint8 *s, *d;
   gint ss, ds, width, height;
 
@@ -325,17 +308,13 @@ shader_fade_and_move_horiz_out (GstAudioVisualizer * scope,
   /* move upper half up */
   for (j = 0; j < height / 2; j++) {
     s += ss;
-    for (i = 0; i < width; i++) {
-      SHADE (d, s, i, r, g, b);
-    }
+    SHADE_ROW (d, s, width);
     d += ds;
   }
-  /* move lower half down */
-  for (j = 0; j < height / 2; j++) {
+  /* move lower half down, the row after the upper half stays free */
+  for (j = 0; j < height - 1 - height / 2; j++) {
     d += ds;
-    for (i = 0; i < width; i++) {
-      SHADE (d, s, i, r, g, b);
-    }
+    SHADE_ROW (d, s, width);
     s += ss;
   }
 }
@@ -344,10 +323,7 @@ static void
 shader_fade_and_move_horiz_in (GstAudioVisualizer * scope,
     const GstVideoFrame * sframe, GstVideoFrame * dframe)
 {
-  guint i, j;
-  guint r = (scope->shade_amount >> 16) & 0xff;
-  guint g = (scope->shade_amount >> 8) & 0xff;
-  guint b = (scope->shade_amount >> 0) & 0xff;
+  guint j;
   guint8 *s, *d;
   gint ss, ds, width, height;
 
@@ -362,17 +338,13 @@ shader_fade_and_move_horiz_in (GstAudioVisualizer * scope,
   /* move upper half down */
   for (j = 0; j < height / 2; j++) {
     d += ds;
-    for (i = 0; i < width; i++) {
-      SHADE (d, s, i, r, g, b);
-    }
+    SHADE_ROW (d, s, width);
     s += ss;
   }
-  /* move lower half up */
-  for (j = 0; j < height / 2; j++) {
+  /* move lower half up, from the row after the upper half on */
+  for (j = 0; j < height - 1 - height / 2; j++) {
     s += ss;
-    for (i = 0; i < width; i++) {
-      SHADE (d, s, i, r, g, b);
-    }
+    SHADE_ROW (d, s, width);
     d += ds;
   }
 }
@@ -381,11 +353,8 @@ static void
 shader_fade_and_move_vert_out (GstAudioVisualizer * scope,
     const GstVideoFrame * sframe, GstVideoFrame * dframe)
 {
-  guint i, j;
-  guint r = (scope->shade_amount >> 16) & 0xff;
-  guint g = (scope->shade_amount >> 8) & 0xff;
-  guint b = (scope->shade_amount >> 0) & 0xff;
-  guint8 *s, *s1, *d, *d1;
+  guint j;
+  guint8 *s, *d;
   gint ss, ds, width, height;
 
   s = GST_VIDEO_FRAME_PLANE_DATA (sframe, 0);
@@ -398,15 +367,10 @@ shader_fade_and_move_vert_out (GstAudioVisualizer * scope,
 
   for (j = 0; j < height; j++) {
     /* move left half to the left */
-    s1 = s + 1;
-    for (i = 0; i < width / 2; i++) {
-      SHADE (d, s1, i, r, g, b);
-    }
+    SHADE_ROW (d, s + 4, width / 2);
     /* move right half to the right */
-    d1 = d + 1;
-    for (; i < width - 1; i++) {
-      SHADE (d1, s, i, r, g, b);
-    }
+    SHADE_ROW (d + (width / 2 + 1) * 4, s + (width / 2) * 4,
+        width - 1 - width / 2);
     s += ss;
     d += ds;
   }
@@ -416,11 +380,8 @@ static void
 shader_fade_and_move_vert_in (GstAudioVisualizer * scope,
     const GstVideoFrame * sframe, GstVideoFrame * dframe)
 {
-  guint i, j;
-  guint r = (scope->shade_amount >> 16) & 0xff;
-  guint g = (scope->shade_amount >> 8) & 0xff;
-  guint b = (scope->shade_amount >> 0) & 0xff;
-  guint8 *s, *s1, *d, *d1;
+  guint j;
+  guint8 *s, *d;
   gint ss, ds, width, height;
 
   s = GST_VIDEO_FRAME_PLANE_DATA (sframe, 0);
@@ -433,15 +394,10 @@ shader_fade_and_move_vert_in (GstAudioVisualizer * scope,
 
   for (j = 0; j < height; j++) {
     /* move left half to the right */
-    d1 = d + 1;
-    for (i = 0; i < width / 2; i++) {
-      SHADE (d1, s, i, r, g, b);
-    }
+    SHADE_ROW (d + 4, s, width / 2);
     /* move right half to the left */
-    s1 = s + 1;
-    for (; i < width - 1; i++) {
-      SHADE (d, s1, i, r, g, b);
-    }
+    SHADE_ROW (d + (width / 2) * 4, s + (width / 2 + 1) * 4,
+        width - 1 - width / 2);
     s += ss;
     d += ds;
   }
@@ -28,59 +28,73 @@
   _vd[(_y * _st) + _x] |= _c;                                                  \
 } G_STMT_END
 
+/* _f is the coverage of the pixel, from 0 to 256 */
 #define draw_dot_aa(_vd, _x, _y, _st, _c, _f)  G_STMT_START {                  \
   guint32 _oc, _c1, _c2, _c3;                                                  \
                                                                                \
   _oc = _vd[(_y * _st) + _x];                                                  \
-  _c3 = (_oc & 0xff) + ((_c & 0xff) * _f);                                     \
+  _c3 = (_oc & 0xff) + (((_c & 0xff) * (_f)) >> 8);                            \
   _c3 = MIN(_c3, 255);                                                         \
-  _c2 = ((_oc & 0xff00) >> 8) + (((_c & 0xff00) >> 8) * _f);                   \
+  _c2 = ((_oc & 0xff00) >> 8) + ((((_c & 0xff00) >> 8) * (_f)) >> 8);          \
   _c2 = MIN(_c2, 255);                                                         \
-  _c1 = ((_oc & 0xff0000) >> 16) + (((_c & 0xff0000) >> 16) * _f);             \
+  _c1 = ((_oc & 0xff0000) >> 16) + ((((_c & 0xff0000) >> 16) * (_f)) >> 8);    \
   _c1 = MIN(_c1, 255);                                                         \
   _vd[(_y * _st) + _x] = (_c1 << 16) | (_c2 << 8) | _c3;                       \
 } G_STMT_END
 
+/* the lines are stepped in 16.16 fixed point */
 #define draw_line(_vd, _x1, _x2, _y1, _y2, _st, _c) G_STMT_START {             \
   guint _i, _j, _x, _y;                                                        \
   gint _dx = _x2 - _x1, _dy = _y2 - _y1;                                       \
-  gfloat _f;                                                                   \
+  gint _rx, _ry, _sx, _sy;                                                     \
                                                                                \
   _j = abs (_dx) > abs (_dy) ? abs (_dx) : abs (_dy);                          \
-  for (_i = 0; _i < _j; _i++) {                                                \
-    _f = (gfloat) _i / (gfloat) _j;                                            \
-    _x = _x1 + _dx * _f;                                                       \
-    _y = _y1 + _dy * _f;                                                       \
-    draw_dot (_vd, _x, _y, _st, _c);                                           \
+  if (_j > 0) {                                                                \
+    _sx = (_dx * 65536) / (gint) _j;                                           \
+    _sy = (_dy * 65536) / (gint) _j;                                           \
+    _rx = (_x1) * 65536;                                                       \
+    _ry = (_y1) * 65536;                                                       \
+    for (_i = 0; _i < _j; _i++) {                                              \
+      _x = _rx >> 16;                                                          \
+      _y = _ry >> 16;                                                          \
+      draw_dot (_vd, _x, _y, _st, _c);                                         \
+      _rx += _sx;                                                              \
+      _ry += _sy;                                                              \
+    }                                                                          \
   }                                                                            \
 } G_STMT_END
 
-#define draw_line_aa(_vd, _x1, _x2, _y1, _y2, _st, _c) G_STMT_START {          \
+/* the neighbour dots that carry the coverage are clipped to the _st x _h
+ * frame, so that lines ending on the last column or row stay inside */
+#define draw_line_aa(_vd, _x1, _x2, _y1, _y2, _st, _h, _c) G_STMT_START {      \
   guint _i, _j, _x, _y;                                                        \
   gint _dx = _x2 - _x1, _dy = _y2 - _y1;                                       \
-  gfloat _f, _rx, _ry, _fx, _fy;                                               \
+  gint _rx, _ry, _sx, _sy;                                                     \
+  guint _fx, _fy;                                                              \
                                                                                \
   _j = abs (_dx) > abs (_dy) ? abs (_dx) : abs (_dy);                          \
-  for (_i = 0; _i < _j; _i++) {                                                \
-    _f = (gfloat) _i / (gfloat) _j;                                            \
-    _rx = _x1 + _dx * _f;                                                      \
-    _ry = _y1 + _dy * _f;                                                      \
-    _x = (guint)_rx;                                                           \
-    _y = (guint)_ry;                                                           \
-    _fx = _rx - (gfloat)_x;                                                    \
-    _fy = _ry - (gfloat)_y;                                                    \
+  if (_j > 0) {                                                                \
+    _sx = (_dx * 65536) / (gint) _j;                                           \
+    _sy = (_dy * 65536) / (gint) _j;                                           \
+    _rx = (_x1) * 65536;                                                       \
+    _ry = (_y1) * 65536;                                                       \
+    for (_i = 0; _i < _j; _i++) {                                              \
+      _x = _rx >> 16;                                                          \
+      _y = _ry >> 16;                                                          \
+      _fx = (_rx >> 8) & 0xff;                                                 \
+      _fy = (_ry >> 8) & 0xff;                                                 \
                                                                                \
-    _f = ((1.0 - _fx) + (1.0 - _fy)) / 2.0;                                    \
-    draw_dot_aa (_vd, _x, _y, _st, _c, _f);                                    \
+      draw_dot_aa (_vd, _x, _y, _st, _c, ((256 - _fx) + (256 - _fy)) / 2);     \
+      if (_x + 1 < (guint) (_st))                                              \
+        draw_dot_aa (_vd, (_x + 1), _y, _st, _c, (_fx + (256 - _fy)) / 2);     \
+      if (_y + 1 < (guint) (_h)) {                                             \
+        draw_dot_aa (_vd, _x, (_y + 1), _st, _c, ((256 - _fx) + _fy) / 2);     \
+        if (_x + 1 < (guint) (_st))                                            \
+          draw_dot_aa (_vd, (_x + 1), (_y + 1), _st, _c, (_fx + _fy) / 2);     \
+      }                                                                        \
                                                                                \
-    _f = (_fx + (1.0 - _fy)) / 2.0;                                            \
-    draw_dot_aa (_vd, (_x + 1), _y, _st, _c, _f);                              \
-                                                                               \
-    _f = ((1.0 - _fx) + _fy) / 2.0;                                            \
-    draw_dot_aa (_vd, _x, (_y + 1), _st, _c, _f);                              \
-                                                                               \
-    _f = (_fx + _fy) / 2.0;                                                    \
-    draw_dot_aa (_vd, (_x + 1), (_y + 1), _st, _c, _f);                        \
+      _rx += _sx;                                                              \
+      _ry += _sy;                                                              \
+    }                                                                          \
   }                                                                            \
 } G_STMT_END
-
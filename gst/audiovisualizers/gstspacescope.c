@@ -244,7 +244,7 @@ render_lines (GstAudioVisualizer * base, guint32 * vdata, gint16 * adata,
   for (i = 1; i < num_samples; i++) {
     x = (guint) (ox + (gfloat) adata[s++] * dx);
     y = (guint) (oy + (gfloat) adata[s++] * dy);
-    draw_line_aa (vdata, x2, x, y2, y, w, 0x00FFFFFF);
+    draw_line_aa (vdata, x2, x, y2, y, w, h, 0x00FFFFFF);
     x2 = x;
     y2 = y;
   }
@@ -388,7 +388,7 @@ render_color_lines (GstAudioVisualizer * base, guint32 * vdata,
     y = (gint) (oy + f1r_l * dy);
     x = CLAMP (x, 0, w1);
     y = CLAMP (y, 0, h1);
-    draw_line_aa (vdata, x2, x, y2, y, w, 0x00FF0000);
+    draw_line_aa (vdata, x2, x, y2, y, w, h, 0x00FF0000);
     x2 = x;
     y2 = y;
 
@@ -396,7 +396,7 @@ render_color_lines (GstAudioVisualizer * base, guint32 * vdata,
     y = (gint) (oy + f2r_l * dy);
     x = CLAMP (x, 0, w1);
     y = CLAMP (y, 0, h1);
-    draw_line_aa (vdata, x3, x, y3, y, w, 0x0000FF00);
+    draw_line_aa (vdata, x3, x, y3, y, w, h, 0x0000FF00);
     x3 = x;
     y3 = y;
 
@@ -404,7 +404,7 @@ render_color_lines (GstAudioVisualizer * base, guint32 * vdata,
     y = (gint) (oy + (f2r_m + f2r_h) * dy);
     x = CLAMP (x, 0, w1);
     y = CLAMP (y, 0, h1);
-    draw_line_aa (vdata, x4, x, y4, y, w, 0x000000FF);
+    draw_line_aa (vdata, x4, x, y4, y, w, h, 0x000000FF);
     x4 = x;
     y4 = y;
   }
@@ -281,7 +281,7 @@ render_lines (GstAudioVisualizer * base, guint32 * vdata, gint16 * adata,
       x = (guint) ((gfloat) i * dx);
       y = (guint) (oy + (gfloat) adata[s] * dy);
       s += channels;
-      draw_line_aa (vdata, x2, x, y2, y, w, 0x00FFFFFF);
+      draw_line_aa (vdata, x2, x, y2, y, w, h, 0x00FFFFFF);
       x2 = x;
       y2 = y;
     }
@@ -381,17 +381,17 @@ render_color_lines (GstAudioVisualizer * base, guint32 * vdata,
 
       y = (guint) (oy + flt[0] * dy);
       y = CLAMP (y, 0, h1);
-      draw_line_aa (vdata, x2, x, y2, y, w, 0x00FF0000);
+      draw_line_aa (vdata, x2, x, y2, y, w, h, 0x00FF0000);
       y2 = y;
 
       y = (guint) (oy + flt[3] * dy);
       y = CLAMP (y, 0, h1);
-      draw_line_aa (vdata, x2, x, y3, y, w, 0x0000FF00);
+      draw_line_aa (vdata, x2, x, y3, y, w, h, 0x0000FF00);
       y3 = y;
 
       y = (guint) (oy + (flt[4] + flt[5]) * dy);
       y = CLAMP (y, 0, h1);
-      draw_line_aa (vdata, x2, x, y4, y, w, 0x000000FF);
+      draw_line_aa (vdata, x2, x, y4, y, w, h, 0x000000FF);
       y4 = y;
 
       x2 = x;
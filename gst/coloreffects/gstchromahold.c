@@ -106,6 +106,7 @@ static void gst_chroma_hold_before_transform (GstBaseTransform * btrans,
     GstBuffer * buf);
 
 static void gst_chroma_hold_init_params (GstChromaHold * self);
+static void init_hue_table (void);
 static gboolean gst_chroma_hold_set_process_function (GstChromaHold * self);
 
 static void gst_chroma_hold_set_property (GObject * object, guint prop_id,
@@ -166,6 +167,8 @@ gst_chroma_hold_class_init (GstChromaHoldClass * klass)
 
   GST_DEBUG_CATEGORY_INIT (gst_chroma_hold_debug, "chromahold", 0,
       "chromahold - Removes all color information except for one color");
+
+  init_hue_table ();
 }
 
 static void
@@ -211,6 +214,7 @@ gst_chroma_hold_set_property (GObject * object, guint prop_id,
       break;
     case PROP_TOLERANCE:
       self->tolerance = g_value_get_uint (value);
+      gst_chroma_hold_init_params (self);
       break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
@@ -271,6 +275,21 @@ gst_chroma_hold_set_info (GstVideoFilter * vfilter, GstCaps * incaps,
   return TRUE;
 }
 
+/* hue offsets of all colors, by chroma and by difference of the two
+ * smaller components, see rgb_to_hue() */
+static gint8 hue_table[256][511];
+
+static void
+init_hue_table (void)
+{
+  gint C, d;
+
+  for (C = 1; C < 256; C++) {
+    for (d = -C; d <= C; d++)
+      hue_table[C][d + 255] = ((256 * 60 * d + (C >> 1)) / C) >> 8;
+  }
+}
+
 static inline gint
 rgb_to_hue (gint r, gint g, gint b)
 {
@@ -323,11 +342,10 @@ gst_chroma_hold_process_xrgb (GstVideoFrame * frame, gint width,
 {
   gint i, j;
   gint r, g, b;
+  gint m, M, C, h;
   gint grey;
-  gint h1, h2;
-  gint tolerance = self->tolerance;
+  const guint8 *keep = self->keep;
   gint p[4];
-  gint diff;
   gint row_wrap;
   guint8 *dest;
 
@@ -338,17 +356,34 @@ gst_chroma_hold_process_xrgb (GstVideoFrame * frame, gint width,
   p[3] = GST_VIDEO_FRAME_COMP_POFFSET (frame, 2);
   row_wrap = GST_VIDEO_FRAME_PLANE_STRIDE (frame, 0) - 4 * width;
 
-  h1 = self->hue;
-
   for (i = 0; i < height; i++) {
     for (j = 0; j < width; j++) {
       r = dest[p[1]];
       g = dest[p[2]];
       b = dest[p[3]];
 
-      h2 = rgb_to_hue (r, g, b);
-      diff = hue_dist (h1, h2);
-      if (h1 == G_MAXUINT || diff > tolerance) {
+      /* same as rgb_to_hue() but with the divisions looked up */
+      m = MIN (MIN (r, g), b);
+      M = MAX (MAX (r, g), b);
+      C = M - m;
+
+      if (C == 0) {
+        h = 360;
+      } else {
+        if (M == r)
+          h = hue_table[C][g - b + 255];
+        else if (M == g)
+          h = hue_table[C][b - r + 255] + 120;
+        else
+          h = hue_table[C][r - g + 255] + 240;
+
+        if (h >= 360)
+          h -= 360;
+        else if (h < 0)
+          h += 360;
+      }
+
+      if (!keep[h]) {
         grey = (13938 * r + 46869 * g + 4730 * b) >> 16;
         grey = CLAMP (grey, 0, 255);
         dest[p[1]] = grey;
@@ -366,7 +401,17 @@ gst_chroma_hold_process_xrgb (GstVideoFrame * frame, gint width,
 static void
 gst_chroma_hold_init_params (GstChromaHold * self)
 {
+  gint h, tolerance = self->tolerance;
+
   self->hue = rgb_to_hue (self->target_r, self->target_g, self->target_b);
+
+  /* colorless pixels are compared with hue -1 */
+  for (h = 0; h <= 360; h++) {
+    gint h2 = h < 360 ? h : -1;
+
+    self->keep[h] = self->hue != G_MAXUINT &&
+        hue_dist (self->hue, h2) <= tolerance;
+  }
 }
 
 /* Protected with the chroma hold lock */
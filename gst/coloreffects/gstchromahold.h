@@ -66,6 +66,9 @@ struct _GstChromaHold
 
   /* pre-calculated values */
   gint hue;
+  /* whether to keep the color of pixels, by hue and with the last entry
+   * for pixels without hue */
+  guint8 keep[361];
 };
 
 struct _GstChromaHoldClass
@@ -22,6 +22,10 @@
  *
  * Map colors of the video input to a lookup table
  *
+ * Instead of one of the presets, a 3D lookup table can be loaded from a
+ * .cube file with the #GstColorEffects:lut-file property.  It is applied
+ * with tetrahedral interpolation on #GstColorEffects:n-threads threads.
+ *
  * <refsect2>
  * <title>Example launch line</title>
  * |[
@@ -39,6 +43,10 @@
 #include "gstcoloreffects.h"
 
 #define DEFAULT_PROP_PRESET GST_COLOR_EFFECTS_PRESET_NONE
+#define DEFAULT_PROP_LUT_FILE NULL
+#define DEFAULT_PROP_N_THREADS 1
+
+#define MAX_THREADS 64
 
 GST_DEBUG_CATEGORY_STATIC (coloreffects_debug);
 #define GST_CAT_DEFAULT (coloreffects_debug)
@@ -46,7 +54,9 @@ GST_DEBUG_CATEGORY_STATIC (coloreffects_debug);
 enum
 {
   PROP_0,
-  PROP_PRESET
+  PROP_PRESET,
+  PROP_LUT_FILE,
+  PROP_N_THREADS
 };
 
 #define gst_color_effects_parent_class parent_class
@@ -94,9 +104,8 @@ gst_color_effects_preset_get_type (void)
 }
 
 /*
- * Currently hardcoded tables, in the future may be nice to load them
- * from a file or just leave these as default presets and add a
- * property to load a custom one from file
+ * Hardcoded tables for the presets, arbitrary grading can be loaded
+ * from a .cube file with the lut-file property
  */
 
 /*
@@ -432,6 +441,68 @@ gst_color_effects_transform_ayuv (GstColorEffects * filter,
   }
 }
 
+static gint
+gst_color_effects_get_n_threads (GstColorEffects * filter)
+{
+  gint n_threads;
+
+  GST_OBJECT_LOCK (filter);
+  n_threads = filter->n_threads;
+  GST_OBJECT_UNLOCK (filter);
+
+  if (n_threads == 0) {
+#if GLIB_CHECK_VERSION (2, 36, 0)
+    n_threads = g_get_num_processors ();
+#else
+    n_threads = 1;
+#endif
+  }
+
+  return CLAMP (n_threads, 1, MAX_THREADS);
+}
+
+/* Called with the object lock, releases it while reading the file */
+static gboolean
+gst_color_effects_update_lut (GstColorEffects * filter)
+{
+  GstColorLut *lut = NULL;
+  gchar *filename;
+  GError *err = NULL;
+
+  filename = g_strdup (filter->lut_file);
+  filter->lut_changed = FALSE;
+  GST_OBJECT_UNLOCK (filter);
+
+  if (filename) {
+    GST_DEBUG_OBJECT (filter, "loading %s", filename);
+    lut = gst_color_lut_new_from_cube_file (filename, &err);
+  }
+
+  GST_OBJECT_LOCK (filter);
+
+  if (filter->lut)
+    gst_color_lut_free (filter->lut);
+  filter->lut = lut;
+  if (filter->ycbcr_lut)
+    gst_color_lut_free (filter->ycbcr_lut);
+  filter->ycbcr_lut = NULL;
+
+  if (err) {
+    GST_OBJECT_UNLOCK (filter);
+    GST_ELEMENT_ERROR (filter, RESOURCE, OPEN_READ,
+        ("Could not load lookup table \"%s\".", filename), ("%s",
+            err->message));
+    g_error_free (err);
+    g_free (filename);
+    GST_OBJECT_LOCK (filter);
+    return FALSE;
+  }
+
+  g_free (filename);
+
+  return TRUE;
+}
+
 static gboolean
 gst_color_effects_set_info (GstVideoFilter * vfilter, GstCaps * incaps,
     GstVideoInfo * in_info, GstCaps * outcaps, GstVideoInfo * out_info)
@@ -479,16 +550,37 @@ gst_color_effects_transform_frame_ip (GstVideoFilter * vfilter,
     GstVideoFrame * out)
 {
   GstColorEffects *filter = GST_COLOR_EFFECTS (vfilter);
+  gint n_threads;
 
   if (!filter->process)
     goto not_negotiated;
 
-  /* do nothing if there is no table ("none" preset) */
-  if (filter->table == NULL)
-    return GST_FLOW_OK;
+  n_threads = gst_color_effects_get_n_threads (filter);
 
   GST_OBJECT_LOCK (filter);
-  filter->process (filter, out);
+
+  if (filter->lut_changed && !gst_color_effects_update_lut (filter)) {
+    GST_OBJECT_UNLOCK (filter);
+    return GST_FLOW_ERROR;
+  }
+
+  if (filter->lut) {
+    GstColorLut *lut = filter->lut;
+
+    if (filter->format == GST_VIDEO_FORMAT_AYUV) {
+      if (!filter->ycbcr_lut)
+        filter->ycbcr_lut = gst_color_lut_new_ycbcr (filter->lut,
+            cog_ycbcr_to_rgb_matrix_8bit_sdtv,
+            cog_rgb_to_ycbcr_matrix_8bit_sdtv);
+      lut = filter->ycbcr_lut;
+    }
+
+    gst_color_lut_apply (lut, out, n_threads);
+  } else if (filter->table != NULL) {
+    /* there is no table for the "none" preset */
+    filter->process (filter, out);
+  }
+
   GST_OBJECT_UNLOCK (filter);
 
   return GST_FLOW_OK;
@@ -539,6 +631,18 @@ gst_color_effects_set_property (GObject * object, guint prop_id,
       }
       GST_OBJECT_UNLOCK (filter);
       break;
+    case PROP_LUT_FILE:
+      GST_OBJECT_LOCK (filter);
+      g_free (filter->lut_file);
+      filter->lut_file = g_value_dup_string (value);
+      filter->lut_changed = TRUE;
+      GST_OBJECT_UNLOCK (filter);
+      break;
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (filter);
+      filter->n_threads = g_value_get_int (value);
+      GST_OBJECT_UNLOCK (filter);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -557,12 +661,39 @@ gst_color_effects_get_property (GObject * object, guint prop_id, GValue * value,
       g_value_set_enum (value, filter->preset);
       GST_OBJECT_UNLOCK (filter);
       break;
+    case PROP_LUT_FILE:
+      GST_OBJECT_LOCK (filter);
+      g_value_set_string (value, filter->lut_file);
+      GST_OBJECT_UNLOCK (filter);
+      break;
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (filter);
+      g_value_set_int (value, filter->n_threads);
+      GST_OBJECT_UNLOCK (filter);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
   }
 }
 
+static void
+gst_color_effects_finalize (GObject * object)
+{
+  GstColorEffects *filter = GST_COLOR_EFFECTS (object);
+
+  g_free (filter->lut_file);
+  filter->lut_file = NULL;
+  if (filter->lut)
+    gst_color_lut_free (filter->lut);
+  filter->lut = NULL;
+  if (filter->ycbcr_lut)
+    gst_color_lut_free (filter->ycbcr_lut);
+  filter->ycbcr_lut = NULL;
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
 static void
 gst_color_effects_class_init (GstColorEffectsClass * klass)
 {
@@ -575,11 +706,21 @@ gst_color_effects_class_init (GstColorEffectsClass * klass)
 
   gobject_class->set_property = gst_color_effects_set_property;
   gobject_class->get_property = gst_color_effects_get_property;
+  gobject_class->finalize = gst_color_effects_finalize;
 
   g_object_class_install_property (gobject_class, PROP_PRESET,
       g_param_spec_enum ("preset", "Preset", "Color effect preset to use",
           GST_TYPE_COLOR_EFFECTS_PRESET, DEFAULT_PROP_PRESET,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_LUT_FILE,
+      g_param_spec_string ("lut-file", "LUT file",
+          "Path of a .cube 3D lookup table to use instead of the preset",
+          DEFAULT_PROP_LUT_FILE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      g_param_spec_int ("n-threads", "Number of Threads",
+          "Number of threads used to apply the lut-file table "
+          "(0 == number of processors)", 0, MAX_THREADS,
+          DEFAULT_PROP_N_THREADS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   vfilter_class->set_info = GST_DEBUG_FUNCPTR (gst_color_effects_set_info);
   vfilter_class->transform_frame_ip =
@@ -602,4 +743,5 @@ gst_color_effects_init (GstColorEffects * filter)
   filter->preset = GST_COLOR_EFFECTS_PRESET_NONE;
   filter->table = NULL;
   filter->map_luma = TRUE;
+  filter->n_threads = DEFAULT_PROP_N_THREADS;
 }
@@ -24,6 +24,8 @@
 #include <gst/video/video.h>
 #include <gst/video/gstvideofilter.h>
 
+#include "gstcolorlut.h"
+
 G_BEGIN_DECLS
 #define GST_TYPE_COLOR_EFFECTS \
   (gst_color_effects_get_type())
@@ -73,6 +75,13 @@ struct _GstColorEffects
   const guint8 *table;
   gboolean map_luma;
 
+  /* table loaded from lut-file, and its Y'CbCr version for AYUV */
+  gchar *lut_file;
+  gboolean lut_changed;
+  GstColorLut *lut;
+  GstColorLut *ycbcr_lut;
+  gint n_threads;
+
   /* video format */
   GstVideoFormat format;
   gint width;
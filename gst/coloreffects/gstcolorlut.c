@@ -0,0 +1,435 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "gstcolorlut.h"
+
+#define MAX_THREADS 64
+/* at least this many rows per band */
+#define MIN_BAND_LINES 16
+
+#define ENTRY_MAX (255 << 4)
+
+static GstColorLut *
+gst_color_lut_new (gint size)
+{
+  GstColorLut *lut = g_slice_new0 (GstColorLut);
+
+  lut->size = size;
+  lut->data = g_new (guint16, size * size * size * 3);
+  g_mutex_init (&lut->lock);
+  g_cond_init (&lut->cond);
+
+  return lut;
+}
+
+void
+gst_color_lut_free (GstColorLut * lut)
+{
+  if (lut->pool)
+    g_thread_pool_free (lut->pool, FALSE, TRUE);
+  g_mutex_clear (&lut->lock);
+  g_cond_clear (&lut->cond);
+  g_free (lut->data);
+  g_slice_free (GstColorLut, lut);
+}
+
+/* Maps the 8 bit input values of every component to grid cells, where
+ * @domain_min and @domain_max are the input values at the first and the
+ * last grid point, with 1.0 being 255 */
+static void
+gst_color_lut_init_tables (GstColorLut * lut, const gdouble * domain_min,
+    const gdouble * domain_max)
+{
+  gint c, v;
+  guint32 stride = 3;
+
+  for (c = 0; c < 3; c++) {
+    for (v = 0; v < 256; v++) {
+      gdouble x, pos;
+      gint idx;
+
+      x = (v / 255.0 - domain_min[c]) / (domain_max[c] - domain_min[c]);
+      pos = CLAMP (x, 0.0, 1.0) * (lut->size - 1);
+      idx = MIN ((gint) pos, lut->size - 2);
+
+      lut->offset[c][v] = idx * stride;
+      lut->frac[c][v] = (pos - idx) * 256 + 0.5;
+    }
+    stride *= lut->size;
+  }
+}
+
+/* Tetrahedral interpolation of the grid cell of @in, the result is 12.4
+ * fixed point */
+static inline void
+gst_color_lut_lookup (const GstColorLut * lut, guint8 in0, guint8 in1,
+    guint8 in2, gint * out)
+{
+  const guint16 *c0, *c1, *c2, *c3;
+  gint f0, f1, f2;
+  gint s0, s1, s2;
+  gint fa, fb, fc;
+  gint sa, sb;
+  gint w0, w1, w2, w3;
+  gint k;
+
+  s0 = 3;
+  s1 = 3 * lut->size;
+  s2 = s1 * lut->size;
+
+  c0 = lut->data + lut->offset[0][in0] + lut->offset[1][in1] +
+      lut->offset[2][in2];
+  f0 = lut->frac[0][in0];
+  f1 = lut->frac[1][in1];
+  f2 = lut->frac[2][in2];
+
+  /* walk from the cell origin to its far corner along the axes in order
+   * of decreasing fraction */
+  if (f0 >= f1) {
+    if (f1 >= f2) {
+      fa = f0, fb = f1, fc = f2, sa = s0, sb = s1;
+    } else if (f0 >= f2) {
+      fa = f0, fb = f2, fc = f1, sa = s0, sb = s2;
+    } else {
+      fa = f2, fb = f0, fc = f1, sa = s2, sb = s0;
+    }
+  } else {
+    if (f0 >= f2) {
+      fa = f1, fb = f0, fc = f2, sa = s1, sb = s0;
+    } else if (f1 >= f2) {
+      fa = f1, fb = f2, fc = f0, sa = s1, sb = s2;
+    } else {
+      fa = f2, fb = f1, fc = f0, sa = s2, sb = s1;
+    }
+  }
+
+  c1 = c0 + sa;
+  c2 = c1 + sb;
+  c3 = c0 + s0 + s1 + s2;
+
+  w0 = 256 - fa;
+  w1 = fa - fb;
+  w2 = fb - fc;
+  w3 = fc;
+
+  for (k = 0; k < 3; k++)
+    out[k] = (w0 * c0[k] + w1 * c1[k] + w2 * c2[k] + w3 * c3[k] + 128) >> 8;
+}
+
+/* Parses three numbers, and nothing else, from @str */
+static gboolean
+parse_triplet (const gchar * str, gdouble * values)
+{
+  gchar *end;
+  gint i;
+
+  for (i = 0; i < 3; i++) {
+    values[i] = g_ascii_strtod (str, &end);
+    if (end == str)
+      return FALSE;
+    str = end;
+  }
+
+  while (g_ascii_isspace (*str))
+    str++;
+
+  return *str == '\0';
+}
+
+/* Parses the contents of a .cube file as written by Resolve and most
+ * other grading tools.  Only 3D tables are supported. */
+GstColorLut *
+gst_color_lut_new_from_cube_data (const gchar * data, GError ** error)
+{
+  GstColorLut *lut = NULL;
+  gchar **lines;
+  gdouble domain_min[3] = { 0.0, 0.0, 0.0 };
+  gdouble domain_max[3] = { 1.0, 1.0, 1.0 };
+  gint n_entries = 0, n = 0;
+  gint i, c;
+
+  lines = g_strsplit (data, "\n", -1);
+
+  for (i = 0; lines[i]; i++) {
+    gchar *line = g_strstrip (lines[i]);
+    gdouble v[3];
+
+    if (*line == '\0' || *line == '#')
+      continue;
+
+    if (g_str_has_prefix (line, "LUT_3D_SIZE")) {
+      gint size = atoi (line + strlen ("LUT_3D_SIZE"));
+
+      if (lut) {
+        g_set_error (error, GST_STREAM_ERROR, GST_STREAM_ERROR_FORMAT,
+            "Line %d: LUT_3D_SIZE given twice", i + 1);
+        goto error;
+      }
+      if (size < GST_COLOR_LUT_MIN_SIZE || size > GST_COLOR_LUT_MAX_SIZE) {
+        g_set_error (error, GST_STREAM_ERROR, GST_STREAM_ERROR_FORMAT,
+            "Line %d: unsupported LUT_3D_SIZE %d", i + 1, size);
+        goto error;
+      }
+      lut = gst_color_lut_new (size);
+      n_entries = size * size * size;
+    } else if (g_str_has_prefix (line, "LUT_1D_SIZE")) {
+      g_set_error (error, GST_STREAM_ERROR, GST_STREAM_ERROR_FORMAT,
+          "Line %d: 1D tables are not supported", i + 1);
+      goto error;
+    } else if (g_str_has_prefix (line, "DOMAIN_MIN")) {
+      if (!parse_triplet (line + strlen ("DOMAIN_MIN"), domain_min))
+        goto parse_error;
+    } else if (g_str_has_prefix (line, "DOMAIN_MAX")) {
+      if (!parse_triplet (line + strlen ("DOMAIN_MAX"), domain_max))
+        goto parse_error;
+    } else if (g_str_has_prefix (line, "LUT_3D_INPUT_RANGE")) {
+      gchar *str = line + strlen ("LUT_3D_INPUT_RANGE"), *end;
+
+      domain_min[0] = g_ascii_strtod (str, &end);
+      if (end == str)
+        goto parse_error;
+      str = end;
+      domain_max[0] = g_ascii_strtod (str, &end);
+      if (end == str)
+        goto parse_error;
+      for (c = 1; c < 3; c++) {
+        domain_min[c] = domain_min[0];
+        domain_max[c] = domain_max[0];
+      }
+    } else if (g_ascii_isalpha (*line)) {
+      /* TITLE and vendor specific keywords */
+      continue;
+    } else {
+      if (!lut || n == n_entries || !parse_triplet (line, v))
+        goto parse_error;
+
+      for (c = 0; c < 3; c++)
+        lut->data[n * 3 + c] = CLAMP (v[c] * ENTRY_MAX + 0.5, 0, ENTRY_MAX);
+      n++;
+    }
+  }
+
+  if (!lut) {
+    g_set_error (error, GST_STREAM_ERROR, GST_STREAM_ERROR_FORMAT,
+        "No LUT_3D_SIZE given");
+    goto error;
+  }
+  if (n != n_entries) {
+    g_set_error (error, GST_STREAM_ERROR, GST_STREAM_ERROR_FORMAT,
+        "Expected %d table entries but got %d", n_entries, n);
+    goto error;
+  }
+
+  for (c = 0; c < 3; c++) {
+    if (domain_max[c] <= domain_min[c]) {
+      g_set_error (error, GST_STREAM_ERROR, GST_STREAM_ERROR_FORMAT,
+          "Empty input domain");
+      goto error;
+    }
+  }
+
+  gst_color_lut_init_tables (lut, domain_min, domain_max);
+  g_strfreev (lines);
+
+  return lut;
+
+parse_error:
+  g_set_error (error, GST_STREAM_ERROR, GST_STREAM_ERROR_FORMAT,
+      "Line %d: could not parse \"%s\"", i + 1, lines[i]);
+error:
+  if (lut)
+    gst_color_lut_free (lut);
+  g_strfreev (lines);
+  return NULL;
+}
+
+GstColorLut *
+gst_color_lut_new_from_cube_file (const gchar * filename, GError ** error)
+{
+  GstColorLut *lut;
+  gchar *data;
+
+  if (!g_file_get_contents (filename, &data, NULL, error))
+    return NULL;
+
+  lut = gst_color_lut_new_from_cube_data (data, error);
+  g_free (data);
+
+  return lut;
+}
+
+#define APPLY_MATRIX(m,o,v1,v2,v3) ((m[o*4] * v1 + m[o*4+1] * v2 + \
+    m[o*4+2] * v3 + m[o*4+3]) >> 8)
+
+/* Creates a table of the same size as @rgb_lut that maps Y'CbCr to
+ * Y'CbCr, so it can be applied to Y'CbCr frames without converting every
+ * pixel.  The matrices take and give 8 bit values, like the ones used by
+ * coloreffects. */
+GstColorLut *
+gst_color_lut_new_ycbcr (const GstColorLut * rgb_lut,
+    const gint * ycbcr_to_rgb, const gint * rgb_to_ycbcr)
+{
+  static const gdouble domain_min[3] = { 0.0, 0.0, 0.0 };
+  static const gdouble domain_max[3] = { 1.0, 1.0, 1.0 };
+  GstColorLut *lut;
+  gint size = rgb_lut->size;
+  gint i, j, k;
+  guint16 *entry;
+
+  lut = gst_color_lut_new (size);
+  gst_color_lut_init_tables (lut, domain_min, domain_max);
+
+  entry = lut->data;
+  for (k = 0; k < size; k++) {
+    gint v = (k * 255 + (size - 1) / 2) / (size - 1);
+
+    for (j = 0; j < size; j++) {
+      gint u = (j * 255 + (size - 1) / 2) / (size - 1);
+
+      for (i = 0; i < size; i++) {
+        gint y = (i * 255 + (size - 1) / 2) / (size - 1);
+        gint r, g, b;
+        gint rgb[3], yuv[3], c;
+
+        r = APPLY_MATRIX (ycbcr_to_rgb, 0, y, u, v);
+        g = APPLY_MATRIX (ycbcr_to_rgb, 1, y, u, v);
+        b = APPLY_MATRIX (ycbcr_to_rgb, 2, y, u, v);
+
+        gst_color_lut_lookup (rgb_lut, CLAMP (r, 0, 255), CLAMP (g, 0, 255),
+            CLAMP (b, 0, 255), rgb);
+
+        /* the looked up values have 4 fractional bits, so the constant
+         * terms have to be scaled */
+        for (c = 0; c < 3; c++) {
+          yuv[c] = (rgb_to_ycbcr[c * 4] * rgb[0] +
+              rgb_to_ycbcr[c * 4 + 1] * rgb[1] +
+              rgb_to_ycbcr[c * 4 + 2] * rgb[2] +
+              (rgb_to_ycbcr[c * 4 + 3] << 4)) >> 8;
+          entry[c] = CLAMP (yuv[c], 0, ENTRY_MAX);
+        }
+        entry += 3;
+      }
+    }
+  }
+
+  return lut;
+}
+
+static void
+gst_color_lut_apply_lines (GstColorLut * lut, GstVideoFrame * frame,
+    gint start, gint end)
+{
+  gint i, j;
+  gint width, pixel_stride, row_stride;
+  gint offsets[3];
+  guint8 *data;
+
+  data = GST_VIDEO_FRAME_PLANE_DATA (frame, 0);
+  offsets[0] = GST_VIDEO_FRAME_COMP_POFFSET (frame, 0);
+  offsets[1] = GST_VIDEO_FRAME_COMP_POFFSET (frame, 1);
+  offsets[2] = GST_VIDEO_FRAME_COMP_POFFSET (frame, 2);
+
+  width = GST_VIDEO_FRAME_WIDTH (frame);
+  row_stride = GST_VIDEO_FRAME_PLANE_STRIDE (frame, 0);
+  pixel_stride = GST_VIDEO_FRAME_COMP_PSTRIDE (frame, 0);
+
+  for (i = start; i < end; i++) {
+    guint8 *p = data + i * row_stride;
+
+    for (j = 0; j < width; j++) {
+      gint out[3];
+
+      gst_color_lut_lookup (lut, p[offsets[0]], p[offsets[1]], p[offsets[2]],
+          out);
+      p[offsets[0]] = (out[0] + 8) >> 4;
+      p[offsets[1]] = (out[1] + 8) >> 4;
+      p[offsets[2]] = (out[2] + 8) >> 4;
+
+      p += pixel_stride;
+    }
+  }
+}
+
+typedef struct
+{
+  GstVideoFrame *frame;
+  gint start, end;
+} GstColorLutBand;
+
+static void
+gst_color_lut_band_func (gpointer data, gpointer user_data)
+{
+  GstColorLutBand *band = data;
+  GstColorLut *lut = user_data;
+
+  gst_color_lut_apply_lines (lut, band->frame, band->start, band->end);
+
+  g_mutex_lock (&lut->lock);
+  if (--lut->pending_bands == 0)
+    g_cond_signal (&lut->cond);
+  g_mutex_unlock (&lut->lock);
+}
+
+/* Maps the first three components of the pixels of the packed 8 bit
+ * @frame through @lut in place, splitting the frame in up to @n_threads
+ * bands of rows */
+void
+gst_color_lut_apply (GstColorLut * lut, GstVideoFrame * frame, gint n_threads)
+{
+  GstColorLutBand bands[MAX_THREADS];
+  gint height = GST_VIDEO_FRAME_HEIGHT (frame);
+  gint n_bands, i;
+
+  n_bands = CLAMP (n_threads, 1, MAX_THREADS);
+  n_bands = MAX (MIN (n_bands, height / MIN_BAND_LINES), 1);
+
+  if (n_bands == 1) {
+    gst_color_lut_apply_lines (lut, frame, 0, height);
+    return;
+  }
+
+  if (!lut->pool) {
+    lut->pool = g_thread_pool_new (gst_color_lut_band_func, lut, n_bands,
+        FALSE, NULL);
+  } else if (g_thread_pool_get_max_threads (lut->pool) < n_bands) {
+    g_thread_pool_set_max_threads (lut->pool, n_bands, NULL);
+  }
+
+  g_mutex_lock (&lut->lock);
+  lut->pending_bands = n_bands;
+  g_mutex_unlock (&lut->lock);
+
+  for (i = 0; i < n_bands; i++) {
+    bands[i].frame = frame;
+    bands[i].start = height * i / n_bands;
+    bands[i].end = height * (i + 1) / n_bands;
+    g_thread_pool_push (lut->pool, &bands[i], NULL);
+  }
+
+  g_mutex_lock (&lut->lock);
+  while (lut->pending_bands > 0)
+    g_cond_wait (&lut->cond, &lut->lock);
+  g_mutex_unlock (&lut->lock);
+}
@@ -0,0 +1,67 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_COLOR_LUT_H__
+#define __GST_COLOR_LUT_H__
+
+#include <gst/gst.h>
+#include <gst/video/video.h>
+
+G_BEGIN_DECLS
+
+/* grid sizes accepted from .cube files, 17 and 33 are the usual ones */
+#define GST_COLOR_LUT_MIN_SIZE 2
+#define GST_COLOR_LUT_MAX_SIZE 65
+
+typedef struct _GstColorLut GstColorLut;
+
+/* 3D colour lookup table applied with tetrahedral interpolation to the
+ * first three components of 8 bit packed video frames */
+struct _GstColorLut
+{
+  gint size;
+
+  /* size^3 entries of 3 components, 12.4 fixed point, with the first
+   * component changing fastest */
+  guint16 *data;
+
+  /* per component and input value: offset of the grid cell in data and
+   * position inside of it, 0-256 */
+  guint32 offset[3][256];
+  guint16 frac[3][256];
+
+  /* row band processing */
+  GThreadPool *pool;
+  GMutex lock;
+  GCond cond;
+  gint pending_bands;
+};
+
+GstColorLut *gst_color_lut_new_from_cube_file (const gchar * filename,
+    GError ** error);
+GstColorLut *gst_color_lut_new_from_cube_data (const gchar * data,
+    GError ** error);
+GstColorLut *gst_color_lut_new_ycbcr (const GstColorLut * rgb_lut,
+    const gint * ycbcr_to_rgb, const gint * rgb_to_ycbcr);
+void gst_color_lut_free (GstColorLut * lut);
+
+void gst_color_lut_apply (GstColorLut * lut, GstVideoFrame * frame,
+    gint n_threads);
+
+G_END_DECLS
+#endif /* __GST_COLOR_LUT_H__ */
@@ -29,8 +29,24 @@
  * gst-launch videotestsrc ! fpsdisplaysink text-overlay=false
  * gst-launch filesrc location=video.avi ! decodebin2 name=d ! queue ! fpsdisplaysink d. ! queue ! fakesink sync=true
  * gst-launch playbin uri=file:///path/to/video.avi video-sink="fpsdisplaysink" audio-sink=fakesink
+ * gst-launch -m videotestsrc ! fpsdisplaysink stats-only=true
  * ]|
  * </refsect2>
+ *
+ * With #GstFPSDisplaySink:stats-only, no text is rendered or formatted.
+ * Instead an element message named <classname>&quot;GstFPSDisplaySink&quot;</classname>
+ * is posted every #GstFPSDisplaySink:fps-update-interval with the fields
+ * <classname>&quot;frames-rendered&quot;</classname> and
+ * <classname>&quot;frames-dropped&quot;</classname> (#guint),
+ * <classname>&quot;current-fps&quot;</classname>,
+ * <classname>&quot;drop-rate&quot;</classname> and
+ * <classname>&quot;average-fps&quot;</classname> (#gdouble), and the
+ * #GST_TYPE_ARRAY of #guint fields
+ * <classname>&quot;jitter-histogram&quot;</classname> and
+ * <classname>&quot;latency-histogram&quot;</classname>.  The histograms count
+ * the frames by how far they were off their deadline and by how long after
+ * their running time they reached the sink.  The first bin holds times below
+ * 1 ms, bin i times from 2^(i-1) to 2^i ms and the last bin everything longer.
  */
 /* FIXME:
  * - can we avoid plugging the textoverlay?
@@ -50,11 +66,14 @@
 #include "debugutils-marshal.h"
 #include "fpsdisplaysink.h"
 
+#include <string.h>
+
 #define DEFAULT_SIGNAL_FPS_MEASUREMENTS FALSE
 #define DEFAULT_FPS_UPDATE_INTERVAL_MS 500      /* 500 ms */
 #define DEFAULT_FONT "Sans 15"
 #define DEFAULT_SILENT FALSE
 #define DEFAULT_LAST_MESSAGE NULL
+#define DEFAULT_STATS_ONLY FALSE
 
 /* generic templates */
 static GstStaticPadTemplate fps_display_sink_template =
@@ -88,7 +107,8 @@ enum
   PROP_FRAMES_DROPPED,
   PROP_FRAMES_RENDERED,
   PROP_SILENT,
-  PROP_LAST_MESSAGE
+  PROP_LAST_MESSAGE,
+  PROP_STATS_ONLY
       /* FILL ME */
 };
 
@@ -179,6 +199,12 @@ fps_display_sink_class_init (GstFPSDisplaySinkClass * klass)
           DEFAULT_SIGNAL_FPS_MEASUREMENTS,
           G_PARAM_STATIC_STRINGS | G_PARAM_READWRITE));
 
+  g_object_class_install_property (gobject_klass, PROP_STATS_ONLY,
+      g_param_spec_boolean ("stats-only", "Stats only",
+          "Don't render or format any text, only post the statistics as "
+          "element messages. Should be set on NULL state", DEFAULT_STATS_ONLY,
+          G_PARAM_STATIC_STRINGS | G_PARAM_READWRITE));
+
   pspec_last_message = g_param_spec_string ("last-message", "Last Message",
       "The message describing current status", DEFAULT_LAST_MESSAGE,
       G_PARAM_READABLE | G_PARAM_STATIC_STRINGS);
@@ -213,6 +239,51 @@ fps_display_sink_class_init (GstFPSDisplaySinkClass * klass)
       "Zeeshan Ali <zeeshan.ali@nokia.com>, Stefan Kost <stefan.kost@nokia.com>");
 }
 
+static gint
+histogram_bin (GstClockTime time)
+{
+  guint64 ms = time / GST_MSECOND;
+  gint bin = 0;
+
+  while (ms > 0 && bin < GST_FPS_DISPLAY_SINK_HISTOGRAM_BINS - 1) {
+    ms >>= 1;
+    bin++;
+  }
+
+  return bin;
+}
+
+/* Sorts the frame of a QoS event into the histograms, @diff is its jitter
+ * and @timestamp its running time */
+static void
+update_histograms (GstFPSDisplaySink * self, GstClockTimeDiff diff,
+    GstClockTime timestamp)
+{
+  GstClock *clock;
+  GstClockTime base_time, now;
+
+  g_atomic_int_inc (&self->jitter_histogram[histogram_bin (ABS (diff))]);
+
+  if (!GST_CLOCK_TIME_IS_VALID (timestamp))
+    return;
+
+  GST_OBJECT_LOCK (self);
+  clock = GST_ELEMENT_CLOCK (self);
+  if (clock)
+    gst_object_ref (clock);
+  base_time = GST_ELEMENT_CAST (self)->base_time;
+  GST_OBJECT_UNLOCK (self);
+
+  if (clock == NULL)
+    return;
+
+  now = gst_clock_get_time (clock) - base_time;
+  gst_object_unref (clock);
+
+  g_atomic_int_inc (&self->latency_histogram[histogram_bin (now > timestamp ?
+              now - timestamp : 0)]);
+}
+
 static GstPadProbeReturn
 on_video_sink_data_flow (GstPad * pad, GstPadProbeInfo * info,
     gpointer user_data)
@@ -253,6 +324,9 @@ on_video_sink_data_flow (GstPad * pad, GstPadProbeInfo * info,
         g_atomic_int_inc (&self->frames_dropped);
       }
 
+      if (self->stats_only_active)
+        update_histograms (self, diff, ts);
+
       ts = gst_util_get_timestamp ();
       if (G_UNLIKELY (!GST_CLOCK_TIME_IS_VALID (self->start_ts))) {
         self->interval_ts = self->last_ts = self->start_ts = ts;
@@ -360,11 +434,49 @@ fps_display_sink_init (GstFPSDisplaySink * self,
   self->min_fps = -1;
   self->silent = DEFAULT_SILENT;
   self->last_message = g_strdup (DEFAULT_LAST_MESSAGE);
+  self->stats_only = DEFAULT_STATS_ONLY;
 
   self->ghost_pad = gst_ghost_pad_new_no_target ("sink", GST_PAD_SINK);
   gst_element_add_pad (GST_ELEMENT (self), self->ghost_pad);
 }
 
+static void
+take_histogram (GstStructure * s, const gchar * fieldname, gint * histogram)
+{
+  GValue array = G_VALUE_INIT;
+  GValue value = G_VALUE_INIT;
+  gint i;
+
+  g_value_init (&array, GST_TYPE_ARRAY);
+  g_value_init (&value, G_TYPE_UINT);
+  for (i = 0; i < GST_FPS_DISPLAY_SINK_HISTOGRAM_BINS; i++) {
+    g_value_set_uint (&value, g_atomic_int_get (&histogram[i]));
+    gst_value_array_append_value (&array, &value);
+  }
+  g_value_unset (&value);
+
+  gst_structure_take_value (s, fieldname, &array);
+}
+
+static void
+post_stats_message (GstFPSDisplaySink * self, guint64 frames_rendered,
+    guint64 frames_dropped, gdouble rr, gdouble dr, gdouble average_fps)
+{
+  GstStructure *s;
+
+  s = gst_structure_new ("GstFPSDisplaySink",
+      "frames-rendered", G_TYPE_UINT, (guint) frames_rendered,
+      "frames-dropped", G_TYPE_UINT, (guint) frames_dropped,
+      "current-fps", G_TYPE_DOUBLE, rr,
+      "drop-rate", G_TYPE_DOUBLE, dr,
+      "average-fps", G_TYPE_DOUBLE, average_fps, NULL);
+  take_histogram (s, "jitter-histogram", self->jitter_histogram);
+  take_histogram (s, "latency-histogram", self->latency_histogram);
+
+  gst_element_post_message (GST_ELEMENT_CAST (self),
+      gst_message_new_element (GST_OBJECT_CAST (self), s));
+}
+
 static gboolean
 display_current_fps (gpointer data)
 {
@@ -408,6 +520,12 @@ display_current_fps (gpointer data)
         average_fps);
   }
 
+  if (self->stats_only_active) {
+    post_stats_message (self, frames_rendered, frames_dropped, rr, dr,
+        average_fps);
+    goto done;
+  }
+
   /* Display on a single line to make it easier to read and import
    * into, for example, excel..  note: it would be nice to show
    * timestamp too.. need to check if there is a sane way to log
@@ -426,7 +544,7 @@ display_current_fps (gpointer data)
         dr);
   }
 
-  if (self->use_text_overlay) {
+  if (self->use_text_overlay && self->text_overlay) {
     g_object_set (self->text_overlay, "text", fps_message, NULL);
   }
 
@@ -442,6 +560,7 @@ display_current_fps (gpointer data)
 #endif
   }
 
+done:
   self->last_frames_rendered = frames_rendered;
   self->last_frames_dropped = frames_dropped;
   self->last_ts = current_ts;
@@ -453,10 +572,13 @@ static void
 fps_display_sink_start (GstFPSDisplaySink * self)
 {
   GstPad *target_pad = NULL;
+  gboolean use_text_overlay;
 
   /* Init counters */
   self->frames_rendered = 0;
   self->frames_dropped = 0;
+  memset (self->jitter_histogram, 0, sizeof (self->jitter_histogram));
+  memset (self->latency_histogram, 0, sizeof (self->latency_histogram));
   self->last_frames_rendered = G_GUINT64_CONSTANT (0);
   self->last_frames_dropped = G_GUINT64_CONSTANT (0);
   self->max_fps = -1;
@@ -465,15 +587,21 @@ fps_display_sink_start (GstFPSDisplaySink * self)
   /* init time stamps */
   self->last_ts = self->start_ts = self->interval_ts = GST_CLOCK_TIME_NONE;
 
-  GST_DEBUG_OBJECT (self, "Use text-overlay? %d", self->use_text_overlay);
+  GST_OBJECT_LOCK (self);
+  self->stats_only_active = self->stats_only;
+  GST_OBJECT_UNLOCK (self);
+
+  use_text_overlay = self->use_text_overlay && !self->stats_only_active;
+
+  GST_DEBUG_OBJECT (self, "Use text-overlay? %d", use_text_overlay);
 
-  if (self->use_text_overlay) {
+  if (use_text_overlay) {
     if (!self->text_overlay) {
       self->text_overlay =
           gst_element_factory_make ("textoverlay", "fps-display-text-overlay");
       if (!self->text_overlay) {
         GST_WARNING_OBJECT (self, "text-overlay element could not be created");
-        self->use_text_overlay = FALSE;
+        self->use_text_overlay = use_text_overlay = FALSE;
         goto no_text_overlay;
       }
       gst_object_ref (self->text_overlay);
@@ -488,10 +616,11 @@ fps_display_sink_start (GstFPSDisplaySink * self)
     target_pad = gst_element_get_static_pad (self->text_overlay, "video_sink");
   }
 no_text_overlay:
-  if (!self->use_text_overlay) {
+  if (!use_text_overlay) {
     if (self->text_overlay) {
       gst_element_unlink (self->text_overlay, self->video_sink);
       gst_bin_remove (GST_BIN (self), self->text_overlay);
+      gst_object_unref (self->text_overlay);
       self->text_overlay = NULL;
     }
     target_pad = gst_element_get_static_pad (self->video_sink, "sink");
@@ -510,7 +639,7 @@ fps_display_sink_stop (GstFPSDisplaySink * self)
     self->text_overlay = NULL;
   }
 
-  if (!self->silent) {
+  if (!self->silent && !self->stats_only_active) {
     gchar *str;
 
     /* print the max and minimum fps values */
@@ -602,6 +731,11 @@ fps_display_sink_set_property (GObject * object, guint prop_id,
     case PROP_SILENT:
       self->silent = g_value_get_boolean (value);
       break;
+    case PROP_STATS_ONLY:
+      GST_OBJECT_LOCK (self);
+      self->stats_only = g_value_get_boolean (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -645,6 +779,11 @@ fps_display_sink_get_property (GObject * object, guint prop_id,
     case PROP_SILENT:
       g_value_set_boolean (value, self->silent);
       break;
+    case PROP_STATS_ONLY:
+      GST_OBJECT_LOCK (self);
+      g_value_set_boolean (value, self->stats_only);
+      GST_OBJECT_UNLOCK (self);
+      break;
     case PROP_LAST_MESSAGE:
       GST_OBJECT_LOCK (self);
       g_value_set_string (value, self->last_message);
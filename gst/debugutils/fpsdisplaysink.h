@@ -37,6 +37,10 @@ G_BEGIN_DECLS
 
 GType fps_display_sink_get_type (void);
 
+/* histogram bin 0 counts times below 1 ms, bin i times in
+ * [2^(i-1), 2^i) ms and the last bin everything above */
+#define GST_FPS_DISPLAY_SINK_HISTOGRAM_BINS 12
+
 typedef struct _GstFPSDisplaySink GstFPSDisplaySink;
 typedef struct _GstFPSDisplaySinkClass GstFPSDisplaySinkClass;
 
@@ -52,12 +56,16 @@ struct _GstFPSDisplaySink
 
   /* statistics */
   gint frames_rendered, frames_dropped;  /* ATOMIC */
+  gint jitter_histogram[GST_FPS_DISPLAY_SINK_HISTOGRAM_BINS];  /* ATOMIC */
+  gint latency_histogram[GST_FPS_DISPLAY_SINK_HISTOGRAM_BINS]; /* ATOMIC */
   guint64 last_frames_rendered, last_frames_dropped;
 
   GstClockTime start_ts;
   GstClockTime last_ts;
   GstClockTime interval_ts;
   guint data_probe_id;
+  /* stats-only of the running stream, latched when starting */
+  gboolean stats_only_active;
 
   /* properties */
   gboolean sync;
@@ -67,6 +75,7 @@ struct _GstFPSDisplaySink
   gdouble max_fps;
   gdouble min_fps;
   gboolean silent;
+  gboolean stats_only;
   gchar *last_message;
 };
 
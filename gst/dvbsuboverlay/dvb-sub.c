@@ -122,6 +122,9 @@ typedef struct DVBSubRegion
   guint8 *pbuf;
   int buf_size;
 
+  /* Changes whenever the pixels or the palette of the region change */
+  guint32 version;
+
   DVBSubObjectDisplay *display_list;
 
   struct DVBSubRegion *next;
@@ -141,6 +144,9 @@ struct _DvbSub
   DVBSubRegionDisplay *display_list;
   GString *pes_buffer;
   DVBSubtitleWindow display_def;
+
+  /* last version given to a changed region */
+  guint32 region_version;
 };
 
 typedef enum
@@ -219,6 +225,12 @@ get_region (DvbSub * dvb_sub, guint8 region_id)
   return ptr;
 }
 
+static void
+region_changed (DvbSub * dvb_sub, DVBSubRegion * region)
+{
+  region->version = ++dvb_sub->region_version;
+}
+
 static void
 delete_region_display_list (DvbSub * dvb_sub, DVBSubRegion * region)
 {
@@ -449,6 +461,7 @@ _dvb_sub_parse_region_segment (DvbSub * dvb_sub, guint16 page_id, guint8 * buf,
   DVBSubObject *object;
   DVBSubObjectDisplay *object_display;
   gboolean fill;
+  guint8 old_depth, old_clut;
 
   if (buf_size < 10)
     return;
@@ -464,6 +477,9 @@ _dvb_sub_parse_region_segment (DvbSub * dvb_sub, guint16 page_id, guint8 * buf,
     dvb_sub->region_list = region;
   }
 
+  old_depth = region->depth;
+  old_clut = region->clut;
+
   fill = ((*buf++) >> 3) & 1;
 
   region->width = GST_READ_UINT16_BE (buf);
@@ -505,6 +521,11 @@ _dvb_sub_parse_region_segment (DvbSub * dvb_sub, guint16 page_id, guint8 * buf,
   GST_DEBUG ("REGION: id = %u, (%ux%u)@%u-bit", region_id, region->width,
       region->height, region->depth);
 
+  /* Only a fill or a different palette changes the look of the region,
+   * regions are often sent again unchanged with every page */
+  if (fill || region->depth != old_depth || region->clut != old_clut)
+    region_changed (dvb_sub, region);
+
   if (fill) {
     memset (region->pbuf, region->bgcolor, region->buf_size);
     GST_DEBUG ("REGION: filling region (%u) with bgcolor = %u", region->id,
@@ -569,8 +590,11 @@ _dvb_sub_parse_clut_segment (DvbSub * dvb_sub, guint16 page_id, guint8 * buf,
   const guint8 *buf_end = buf + buf_size;
   guint8 clut_id;
   DVBSubCLUT *clut;
+  DVBSubRegion *region;
   int entry_id, depth, full_range;
   int y, cr, cb, alpha;
+  guint32 ayuv;
+  gboolean changed = FALSE;
 
   GST_MEMDUMP ("DVB clut packet", buf, buf_size);
 
@@ -597,7 +621,7 @@ _dvb_sub_parse_clut_segment (DvbSub * dvb_sub, guint16 page_id, guint8 * buf,
 
     if (depth == 0) {
       GST_WARNING ("Invalid clut depth 0x%x!", *buf);
-      return;
+      break;
     }
 
     full_range = (*buf++) & 1;
@@ -622,12 +646,29 @@ _dvb_sub_parse_clut_segment (DvbSub * dvb_sub, guint16 page_id, guint8 * buf,
     GST_DEBUG ("CLUT DEFINITION: clut %d := (%d,%d,%d,%d)", entry_id, y, cb, cr,
         alpha);
 
-    if (depth & 0x80)
-      clut->clut4[entry_id] = AYUV (y, cb, cr, 255 - alpha);
-    if (depth & 0x40)
-      clut->clut16[entry_id] = AYUV (y, cb, cr, 255 - alpha);
-    if (depth & 0x20)
-      clut->clut256[entry_id] = AYUV (y, cb, cr, 255 - alpha);
+    ayuv = AYUV (y, cb, cr, 255 - alpha);
+
+    if (depth & 0x80) {
+      changed |= clut->clut4[entry_id] != ayuv;
+      clut->clut4[entry_id] = ayuv;
+    }
+    if (depth & 0x40) {
+      changed |= clut->clut16[entry_id] != ayuv;
+      clut->clut16[entry_id] = ayuv;
+    }
+    if (depth & 0x20) {
+      changed |= clut->clut256[entry_id] != ayuv;
+      clut->clut256[entry_id] = ayuv;
+    }
+  }
+
+  /* CLUTs are usually sent again with every page, only regions using this
+   * one need to be converted again if it actually changed */
+  if (changed) {
+    for (region = dvb_sub->region_list; region; region = region->next) {
+      if (region->clut == clut_id)
+        region_changed (dvb_sub, region);
+    }
   }
 }
 
@@ -936,6 +977,8 @@ _dvb_sub_parse_pixel_data_block (DvbSub * dvb_sub,
     return;
   }
 
+  region_changed (dvb_sub, region);
+
   pbuf = region->pbuf;
 
   x_pos = display->x_pos;
@@ -1223,6 +1266,8 @@ _dvb_sub_parse_end_of_display_set (DvbSub * dvb_sub, guint16 page_id,
 #if 0                           /* FIXME: Needed to be specified once we support strings of characters based subtitles */
     rect->type = SUBTITLE_BITMAP;
 #endif
+    rect->region_id = region->id;
+    rect->version = region->version;
     rect->pict.rowstride = region->width;
     rect->pict.palette_bits_count = region->depth;
 
@@ -1246,14 +1291,17 @@ _dvb_sub_parse_end_of_display_set (DvbSub * dvb_sub, guint16 page_id,
 
     /* FIXME: Tweak this to be saved in a format most suitable for Qt and GStreamer instead.
      * Currently kept in AVPicture for quick save_display_set testing */
-    rect->pict.palette = g_malloc ((1 << region->depth) * sizeof (guint32));    /* FIXME: Can we use GSlice here? */
+    /* The palette and the pixels share one allocation, see
+     * dvb_subtitles_free() */
+    rect->pict.palette = g_malloc ((1 << region->depth) * sizeof (guint32) +
+        region->buf_size);
     memcpy (rect->pict.palette, clut_table,
         (1 << region->depth) * sizeof (guint32));
 
     GST_MEMDUMP ("rect->pict.data.palette content",
         (guint8 *) rect->pict.palette, (1 << region->depth) * sizeof (guint32));
 
-    rect->pict.data = g_malloc (region->buf_size);      /* FIXME: Can we use GSlice here? */
+    rect->pict.data = (guint8 *) (rect->pict.palette + (1 << region->depth));
     memcpy (rect->pict.data, region->pbuf, region->buf_size);
 
     GST_DEBUG ("DISPLAY: an object rect created: iteration %u, "
@@ -1289,8 +1337,8 @@ dvb_subtitles_free (DVBSubtitles * sub)
 
   /* Now free up all the temporary memory we allocated */
   for (i = 0; i < sub->num_rects; ++i) {
+    /* pict.data is part of the palette allocation */
     g_free (sub->rects[i].pict.palette);
-    g_free (sub->rects[i].pict.data);
   }
   g_free (sub->rects);
   g_slice_free (DVBSubtitles, sub);
@@ -30,7 +30,7 @@ typedef struct _DvbSub DvbSub;
 /**
  * DVBSubtitlePicture:
  * @data: the data in the form of palette indices, each byte represents one pixel
- *   as an index into the @palette.
+ *   as an index into the @palette. Allocated together with @palette.
  * @palette: the palette used for this subtitle rectangle, up to 256 items depending
  *   on the depth of the subpicture; each palette item is in ARGB form, 8-bits per channel.
  * @palette_bits_count: the amount of bits used in indeces into @palette in @data.
@@ -53,6 +53,9 @@ typedef struct DVBSubtitlePicture {
  * @y: y coordinate of top left corner
  * @w: the width of this subpicture rectangle
  * @h: the height of this subpicture rectangle
+ * @region_id: the id of the region shown in this rectangle
+ * @version: the version of the region contents, changes whenever the pixels or
+ *   the palette of the region change
  * @pict: the content of this subpicture rectangle
  *
  * A structure representing one subtitle objects position, dimension and content.
@@ -63,6 +66,9 @@ typedef struct DVBSubtitleRect {
 	int w;
 	int h;
 
+	guint8 region_id;
+	guint32 version;
+
 	DVBSubtitlePicture pict;
 } DVBSubtitleRect;
 
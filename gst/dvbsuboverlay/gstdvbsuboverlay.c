@@ -48,6 +48,16 @@
 GST_DEBUG_CATEGORY_STATIC (gst_dvbsub_overlay_debug);
 #define GST_CAT_DEFAULT gst_dvbsub_overlay_debug
 
+/* A rectangle converted for a region, identified by the region version and
+ * the position it was rendered at */
+typedef struct
+{
+  guint8 region_id;
+  guint32 version;
+  gint x, y, width, height;
+  GstVideoOverlayRectangle *rect;
+} DVBSubOverlayCachedRect;
+
 /* Filter signals and props */
 enum
 {
@@ -175,6 +185,17 @@ gst_dvbsub_overlay_class_init (GstDVBSubOverlayClass * klass)
       "Renders DVB subtitles", "Mart Raudsepp <mart.raudsepp@collabora.co.uk>");
 }
 
+static void
+gst_dvbsub_overlay_clear_rect_cache (GArray * cache)
+{
+  guint i;
+
+  for (i = 0; i < cache->len; i++)
+    gst_video_overlay_rectangle_unref (g_array_index (cache,
+            DVBSubOverlayCachedRect, i).rect);
+  g_array_set_size (cache, 0);
+}
+
 static void
 gst_dvbsub_overlay_flush_subtitles (GstDVBSubOverlay * render)
 {
@@ -193,6 +214,9 @@ gst_dvbsub_overlay_flush_subtitles (GstDVBSubOverlay * render)
     gst_video_overlay_composition_unref (render->current_comp);
   render->current_comp = NULL;
 
+  /* region versions start again with the new DvbSub */
+  gst_dvbsub_overlay_clear_rect_cache (render->rect_cache);
+
   if (render->dvb_sub)
     dvb_sub_free (render->dvb_sub);
 
@@ -247,6 +271,8 @@ gst_dvbsub_overlay_init (GstDVBSubOverlay * render)
 
   render->current_subtitle = NULL;
   render->pending_subtitles = g_queue_new ();
+  render->rect_cache =
+      g_array_new (FALSE, FALSE, sizeof (DVBSubOverlayCachedRect));
 
   render->enable = DEFAULT_ENABLE;
   render->max_page_timeout = DEFAULT_MAX_PAGE_TIMEOUT;
@@ -280,6 +306,9 @@ gst_dvbsub_overlay_finalize (GObject * object)
     gst_video_overlay_composition_unref (overlay->current_comp);
   overlay->current_comp = NULL;
 
+  gst_dvbsub_overlay_clear_rect_cache (overlay->rect_cache);
+  g_array_free (overlay->rect_cache, TRUE);
+
   if (overlay->dvb_sub)
     dvb_sub_free (overlay->dvb_sub);
 
@@ -887,14 +916,63 @@ gst_dvbsub_overlay_chain_text (GstPad * pad, GstObject * parent,
   return GST_FLOW_OK;
 }
 
+/* Converts the palette indexed pixels of the region to AYUV */
+static GstVideoOverlayRectangle *
+gst_dvbsub_overlay_convert_rect (DVBSubtitleRect * srect, gint rx, gint ry,
+    gint rw, gint rh)
+{
+  GstVideoOverlayRectangle *rect;
+  GstBuffer *buf;
+  guint32 lut[256];
+  guint32 *data;
+  guint8 *in_data;
+  gint w, h, stride, n_colors;
+  gint k, l;
+  GstMapInfo map;
+
+  w = srect->w;
+  h = srect->h;
+
+  /* The rectangle is stored as big endian AYUV, so swap the palette once
+   * instead of every pixel. Indices outside of the palette are transparent */
+  n_colors = 1 << srect->pict.palette_bits_count;
+  for (k = 0; k < n_colors; k++)
+    lut[k] = GUINT32_TO_BE (srect->pict.palette[k]);
+  for (; k < 256; k++)
+    lut[k] = 0;
+
+  buf = gst_buffer_new_and_alloc (w * h * 4);
+  gst_buffer_map (buf, &map, GST_MAP_WRITE);
+  data = (guint32 *) map.data;
+  in_data = srect->pict.data;
+  stride = srect->pict.rowstride;
+  for (k = 0; k < h; k++) {
+    for (l = 0; l < w; l++)
+      data[l] = lut[in_data[l]];
+    in_data += stride;
+    data += w;
+  }
+  gst_buffer_unmap (buf, &map);
+
+  gst_buffer_add_video_meta (buf, GST_VIDEO_FRAME_FLAG_NONE,
+      GST_VIDEO_OVERLAY_COMPOSITION_FORMAT_YUV, w, h);
+  rect = gst_video_overlay_rectangle_new_raw (buf, rx, ry, rw, rh, 0);
+  g_assert (rect);
+  gst_buffer_unref (buf);
+
+  return rect;
+}
+
 static GstVideoOverlayComposition *
 gst_dvbsub_overlay_subs_to_comp (GstDVBSubOverlay * overlay,
     DVBSubtitles * subs)
 {
   GstVideoOverlayComposition *comp = NULL;
   GstVideoOverlayRectangle *rect;
+  GArray *cache;
   gint width, height, dw, dh, wx, wy;
   gint i;
+  guint j;
 
   g_return_val_if_fail (subs != NULL && subs->num_rects > 0, NULL);
 
@@ -919,66 +997,64 @@ gst_dvbsub_overlay_subs_to_comp (GstDVBSubOverlay * overlay,
     wy = 0;
   }
 
+  cache = g_array_sized_new (FALSE, FALSE, sizeof (DVBSubOverlayCachedRect),
+      subs->num_rects);
+
   for (i = 0; i < subs->num_rects; i++) {
     DVBSubtitleRect *srect = &subs->rects[i];
-    GstBuffer *buf;
-    gint w, h;
-    guint8 *in_data;
-    guint32 *palette, *data;
-    gint rx, ry, rw, rh, stride;
-    gint k, l;
-    GstMapInfo map;
+    DVBSubOverlayCachedRect entry;
 
     GST_LOG_OBJECT (overlay, "rectangle %d: %dx%d @ (%d, %d)", i,
         srect->w, srect->h, srect->x, srect->y);
 
-    w = srect->w;
-    h = srect->h;
-
-    buf = gst_buffer_new_and_alloc (w * h * 4);
-    gst_buffer_map (buf, &map, GST_MAP_WRITE);
-    data = (guint32 *) map.data;
-    in_data = srect->pict.data;
-    palette = srect->pict.palette;
-    stride = srect->pict.rowstride;
-    for (k = 0; k < h; k++) {
-      for (l = 0; l < w; l++) {
-        guint32 ayuv;
-
-        ayuv = palette[*in_data];
-        GST_WRITE_UINT32_BE (data, ayuv);
-        in_data++;
-        data++;
-      }
-      in_data += stride - w;
-    }
-    gst_buffer_unmap (buf, &map);
-
     /* this is assuming the subtitle rectangle coordinates are relative
      * to the window (if there is one) within a display of specified dimension.
      * Coordinate wrt the latter is then scaled to the actual dimension of
      * the video we are dealing with here. */
-    rx = gst_util_uint64_scale (wx + srect->x, width, dw);
-    ry = gst_util_uint64_scale (wy + srect->y, height, dh);
-    rw = gst_util_uint64_scale (srect->w, width, dw);
-    rh = gst_util_uint64_scale (srect->h, height, dh);
+    entry.region_id = srect->region_id;
+    entry.version = srect->version;
+    entry.x = gst_util_uint64_scale (wx + srect->x, width, dw);
+    entry.y = gst_util_uint64_scale (wy + srect->y, height, dh);
+    entry.width = gst_util_uint64_scale (srect->w, width, dw);
+    entry.height = gst_util_uint64_scale (srect->h, height, dh);
 
     GST_LOG_OBJECT (overlay, "rectangle %d rendered: %dx%d @ (%d, %d)", i,
-        rw, rh, rx, ry);
+        entry.width, entry.height, entry.x, entry.y);
+
+    /* reuse the rectangle of the previous page if the region is unchanged */
+    rect = NULL;
+    for (j = 0; j < overlay->rect_cache->len; j++) {
+      DVBSubOverlayCachedRect *cached =
+          &g_array_index (overlay->rect_cache, DVBSubOverlayCachedRect, j);
+
+      if (cached->region_id == entry.region_id &&
+          cached->version == entry.version && cached->x == entry.x &&
+          cached->y == entry.y && cached->width == entry.width &&
+          cached->height == entry.height) {
+        GST_LOG_OBJECT (overlay, "rectangle %d unchanged", i);
+        rect = gst_video_overlay_rectangle_ref (cached->rect);
+        break;
+      }
+    }
+
+    if (rect == NULL)
+      rect = gst_dvbsub_overlay_convert_rect (srect, entry.x, entry.y,
+          entry.width, entry.height);
 
-    gst_buffer_add_video_meta (buf, GST_VIDEO_FRAME_FLAG_NONE,
-        GST_VIDEO_OVERLAY_COMPOSITION_FORMAT_YUV, w, h);
-    rect = gst_video_overlay_rectangle_new_raw (buf, rx, ry, rw, rh, 0);
-    g_assert (rect);
     if (comp) {
       gst_video_overlay_composition_add_rectangle (comp, rect);
     } else {
       comp = gst_video_overlay_composition_new (rect);
     }
-    gst_video_overlay_rectangle_unref (rect);
-    gst_buffer_unref (buf);
+
+    entry.rect = rect;
+    g_array_append_val (cache, entry);
   }
 
+  gst_dvbsub_overlay_clear_rect_cache (overlay->rect_cache);
+  g_array_free (overlay->rect_cache, TRUE);
+  overlay->rect_cache = cache;
+
   return comp;
 }
 
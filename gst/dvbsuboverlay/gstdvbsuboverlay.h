@@ -56,6 +56,9 @@ struct _GstDVBSubOverlay
 
   DVBSubtitles *current_subtitle; /* The currently active set of subtitle regions, if any */
   GstVideoOverlayComposition *current_comp;
+  /* The converted rectangles of current_comp, reused for regions that
+   * did not change on the next page */
+  GArray *rect_cache;
   GQueue *pending_subtitles; /* A queue of raw subtitle region sets with
 			      * metadata that are waiting their running time */
 
@@ -44,30 +44,23 @@ gstspu_clear_comp_buffers (SpuState * state)
   memset (state->comp_bufs[2] + left, 0, uv_width);
 }
 
+/* Store the U/V/A values accumulated in the compositing buffers as a chroma
+ * run on line uv_y of the sub-sampled planes */
 void
-gstspu_blend_comp_buffers (SpuState * state, guint8 * planes[3])
+gstspu_store_comp_buffers (SpuState * state, gint16 uv_y)
 {
+  SpuChromaRun run;
   gint16 uv_end;
   gint16 left, x;
-  guint8 *out_U;
-  guint8 *out_V;
   guint32 *in_U;
   guint32 *in_V;
   guint32 *in_A;
+  guint32 *out;
   gint16 comp_last_x = state->comp_right;
 
   if (comp_last_x < state->comp_left)
     return;                     /* Didn't draw in the comp buffers, nothing to do... */
 
-#if 0
-  GST_LOG ("Blending comp buffers from x=%d to x=%d",
-      state->comp_left, state->comp_right);
-#endif
-
-  /* Set up the output pointers */
-  out_U = planes[1];            /* U plane */
-  out_V = planes[2];            /* V plane */
-
   /* Input starts at the first pixel of the compositing buffer */
   in_U = state->comp_bufs[0];   /* U comp buffer */
   in_V = state->comp_bufs[1];   /* V comp buffer */
@@ -79,21 +72,154 @@ gstspu_blend_comp_buffers (SpuState * state, guint8 * planes[3])
   uv_end = (comp_last_x + 1) / 2;
   left = state->comp_left / 2;
 
-  out_U += left * GST_VIDEO_INFO_COMP_PSTRIDE (&state->info, 1);
-  out_V += left * GST_VIDEO_INFO_COMP_PSTRIDE (&state->info, 2);
+  /* Fully transparent pixels leave the frame untouched, skip them at the
+   * edges of the run */
+  while (left < uv_end && in_A[left] == 0)
+    left++;
+  while (uv_end > left && in_A[uv_end - 1] == 0)
+    uv_end--;
+  if (left == uv_end)
+    return;
+
+  run.x = left;
+  run.y = uv_y;
+  run.len = uv_end - left;
+  run.offset = state->chroma_sums->len;
+  g_array_append_val (state->chroma_runs, run);
+
+  g_array_set_size (state->chroma_sums, run.offset + 3 * run.len);
+  out = &g_array_index (state->chroma_sums, guint32, run.offset);
   for (x = left; x < uv_end; x++) {
-    guint32 tmp;
-    /* Each entry in the compositing buffer is 4 summed pixels, so the
-     * inverse alpha is (4 * 0xff) - in_A[x] */
-    guint16 inv_A = (4 * 0xff) - in_A[x];
+    *out++ = in_U[x];
+    *out++ = in_V[x];
+    *out++ = in_A[x];
+  }
+}
+
+/* Store a run of len luma pixels at x,y in the given colour */
+void
+gstspu_store_luma_run (SpuState * state, gint16 x, gint16 y, gint16 len,
+    SpuColour * colour)
+{
+  SpuLumaRun run;
+
+  if (len <= 0 || colour->A == 0)
+    return;
+
+  run.x = x;
+  run.y = y;
+  run.len = len;
+  run.Y = colour->Y;
+  run.A = colour->A;
+  g_array_append_val (state->luma_runs, run);
+}
+
+void
+gstspu_cache_init (SpuState * state)
+{
+  state->luma_runs = g_array_new (FALSE, FALSE, sizeof (SpuLumaRun));
+  state->chroma_runs = g_array_new (FALSE, FALSE, sizeof (SpuChromaRun));
+  state->chroma_sums = g_array_new (FALSE, FALSE, sizeof (guint32));
+  state->cache_valid = FALSE;
+}
 
-    tmp = in_U[x] + inv_A * *out_U;
-    *out_U = (guint8) (tmp / (4 * 0xff));
+void
+gstspu_cache_free (SpuState * state)
+{
+  g_array_free (state->luma_runs, TRUE);
+  g_array_free (state->chroma_runs, TRUE);
+  g_array_free (state->chroma_sums, TRUE);
+  state->luma_runs = state->chroma_runs = state->chroma_sums = NULL;
+}
+
+/* Must be called whenever anything that changes the rendered SPU changes */
+void
+gstspu_cache_invalidate (SpuState * state)
+{
+  state->cache_valid = FALSE;
+}
 
-    tmp = in_V[x] + inv_A * *out_V;
-    *out_V = (guint8) (tmp / (4 * 0xff));
+/* Returns TRUE if the cache needs to be rendered again, in which case it is
+ * emptied and marked valid */
+gboolean
+gstspu_cache_begin (SpuState * state)
+{
+  if (state->cache_valid)
+    return FALSE;
+
+  g_array_set_size (state->luma_runs, 0);
+  g_array_set_size (state->chroma_runs, 0);
+  g_array_set_size (state->chroma_sums, 0);
+  state->cache_valid = TRUE;
+
+  return TRUE;
+}
+
+/* Blend the cached runs onto the frame */
+void
+gstspu_cache_blend (SpuState * state, GstVideoFrame * frame)
+{
+  guint8 *planes[3];
+  gint strides[3];
+  gint pstride_U, pstride_V;
+  gint width, height;
+  guint i;
+
+  planes[0] = GST_VIDEO_FRAME_COMP_DATA (frame, 0);
+  planes[1] = GST_VIDEO_FRAME_COMP_DATA (frame, 1);
+  planes[2] = GST_VIDEO_FRAME_COMP_DATA (frame, 2);
+
+  strides[0] = GST_VIDEO_FRAME_COMP_STRIDE (frame, 0);
+  strides[1] = GST_VIDEO_FRAME_COMP_STRIDE (frame, 1);
+  strides[2] = GST_VIDEO_FRAME_COMP_STRIDE (frame, 2);
+
+  pstride_U = GST_VIDEO_FRAME_COMP_PSTRIDE (frame, 1);
+  pstride_V = GST_VIDEO_FRAME_COMP_PSTRIDE (frame, 2);
+
+  height = GST_VIDEO_FRAME_HEIGHT (frame);
+  width = GST_VIDEO_FRAME_COMP_WIDTH (frame, 1);
+
+  for (i = 0; i < state->luma_runs->len; i++) {
+    SpuLumaRun *run = &g_array_index (state->luma_runs, SpuLumaRun, i);
+    guint8 *out_Y;
+    guint32 inv_A = 0xff - run->A;
+    guint32 Y = run->Y;
+    gint x;
+
+    if (G_UNLIKELY (run->y >= height))
+      continue;
+
+    out_Y = planes[0] + strides[0] * run->y + run->x;
+    for (x = 0; x < run->len; x++)
+      out_Y[x] = (inv_A * out_Y[x] + Y) / 0xff;
+  }
 
-    out_U += GST_VIDEO_INFO_COMP_PSTRIDE (&state->info, 1);
-    out_V += GST_VIDEO_INFO_COMP_PSTRIDE (&state->info, 2);
+  height = GST_VIDEO_FRAME_COMP_HEIGHT (frame, 1);
+
+  for (i = 0; i < state->chroma_runs->len; i++) {
+    SpuChromaRun *run = &g_array_index (state->chroma_runs, SpuChromaRun, i);
+    guint32 *in = &g_array_index (state->chroma_sums, guint32, run->offset);
+    guint8 *out_U;
+    guint8 *out_V;
+    gint x, len;
+
+    if (G_UNLIKELY (run->y >= height || run->x >= width))
+      continue;
+    len = MIN (run->len, width - run->x);
+
+    out_U = planes[1] + strides[1] * run->y + pstride_U * run->x;
+    out_V = planes[2] + strides[2] * run->y + pstride_V * run->x;
+    for (x = 0; x < len; x++) {
+      /* Each entry in the compositing buffer is 4 summed pixels, so the
+       * inverse alpha is (4 * 0xff) - A */
+      guint32 inv_A = (4 * 0xff) - in[2];
+
+      *out_U = (guint8) ((in[0] + inv_A * *out_U) / (4 * 0xff));
+      *out_V = (guint8) ((in[1] + inv_A * *out_V) / (4 * 0xff));
+
+      in += 3;
+      out_U += pstride_U;
+      out_V += pstride_V;
+    }
   }
 }
@@ -173,6 +173,7 @@ gst_dvd_spu_init (GstDVDSpu * dvdspu)
 
   g_mutex_init (&dvdspu->spu_lock);
   dvdspu->pending_spus = g_queue_new ();
+  gstspu_cache_init (&dvdspu->spu_state);
 
   gst_dvd_spu_clear (dvdspu);
 }
@@ -219,6 +220,7 @@ gst_dvd_spu_finalize (GObject * object)
       dvdspu->spu_state.comp_bufs[i] = NULL;
     }
   }
+  gstspu_cache_free (&dvdspu->spu_state);
   g_queue_free (dvdspu->pending_spus);
   g_mutex_clear (&dvdspu->spu_lock);
 
@@ -263,6 +265,7 @@ gst_dvd_spu_flush_spu_info (GstDVDSpu * dvdspu, gboolean keep_events)
 
   state->flags &= ~(SPU_STATE_FLAGS_MASK);
   state->next_ts = GST_CLOCK_TIME_NONE;
+  gstspu_cache_invalidate (state);
 
   switch (dvdspu->spu_input_type) {
     case SPU_INPUT_TYPE_VOBSUB:
@@ -333,6 +336,7 @@ gst_dvd_spu_video_set_caps (GstPad * pad, GstCaps * caps)
   state = &dvdspu->spu_state;
 
   state->info = info;
+  gstspu_cache_invalidate (state);
   for (i = 0; i < 3; i++) {
     state->comp_bufs[i] = g_realloc (state->comp_bufs[i],
         sizeof (guint32) * info.width);
@@ -75,6 +75,13 @@ struct SpuState {
   guint16 comp_left;
   guint16 comp_right;
 
+  /* The rendered SPU, kept as runs that are blended onto every frame until
+   * the SPU state changes and the cache is invalidated */
+  gboolean cache_valid;
+  GArray *luma_runs;
+  GArray *chroma_runs;
+  GArray *chroma_sums;
+
   SpuVobsubState vobsub;
   SpuPgsState pgs;
 };
@@ -30,6 +30,8 @@ typedef struct _GstDVDSpu      GstDVDSpu;
 typedef struct SpuState SpuState;
 typedef struct SpuColour SpuColour;
 typedef struct SpuRect SpuRect;
+typedef struct SpuLumaRun SpuLumaRun;
+typedef struct SpuChromaRun SpuChromaRun;
 
 /* Describe the limits of a rectangle */
 struct SpuRect {
@@ -48,8 +50,35 @@ struct SpuColour {
   guint8 A;
 };
 
+/* A run of luma pixels covered by one pre-multiplied colour */
+struct SpuLumaRun {
+  guint16 x;
+  guint16 y;
+  guint16 len;
+  guint16 Y;
+  guint8 A;
+};
+
+/* A run of chroma pixels from the compositing buffers. The summed U, V and A
+ * values of each pixel are stored in the chroma_sums array of the state,
+ * starting at offset */
+struct SpuChromaRun {
+  guint16 x;
+  guint16 y;
+  guint16 len;
+  guint offset;
+};
+
 void gstspu_clear_comp_buffers (SpuState * state);
-void gstspu_blend_comp_buffers (SpuState * state, guint8 * planes[3]);
+void gstspu_store_comp_buffers (SpuState * state, gint16 uv_y);
+void gstspu_store_luma_run (SpuState * state, gint16 x, gint16 y, gint16 len,
+    SpuColour * colour);
+
+void gstspu_cache_init (SpuState * state);
+void gstspu_cache_free (SpuState * state);
+void gstspu_cache_invalidate (SpuState * state);
+gboolean gstspu_cache_begin (SpuState * state);
+void gstspu_cache_blend (SpuState * state, GstVideoFrame * frame);
 
 
 G_END_DECLS
@@ -174,8 +174,7 @@ pgs_composition_object_render (PgsCompositionObject * obj, SpuState * state,
     GstVideoFrame * frame)
 {
   SpuColour *colour;
-  guint8 *planes[3];            /* YUV frame pointers */
-  gint strides[3];
+  gint stride;
   guint8 *data, *end;
   guint16 obj_w;
   guint16 obj_h G_GNUC_UNUSED;
@@ -195,28 +194,17 @@ pgs_composition_object_render (PgsCompositionObject * obj, SpuState * state,
    * intersection of the crop rectangle for this object (if any) and the
    * window specified by the object's window_id */
 
-  /* Store the start of each plane */
-  planes[0] = GST_VIDEO_FRAME_COMP_DATA (frame, 0);
-  planes[1] = GST_VIDEO_FRAME_COMP_DATA (frame, 1);
-  planes[2] = GST_VIDEO_FRAME_COMP_DATA (frame, 2);
-
-  strides[0] = GST_VIDEO_FRAME_COMP_STRIDE (frame, 0);
-  strides[1] = GST_VIDEO_FRAME_COMP_STRIDE (frame, 1);
-  strides[2] = GST_VIDEO_FRAME_COMP_STRIDE (frame, 2);
+  stride = GST_VIDEO_FRAME_COMP_STRIDE (frame, 0);
 
   y = MIN (obj->y, state->info.height);
 
-  planes[0] += strides[0] * y;
-  planes[1] += strides[1] * (y / 2);
-  planes[2] += strides[2] * (y / 2);
-
   /* RLE data: */
   obj_w = GST_READ_UINT16_BE (data);
   obj_h = GST_READ_UINT16_BE (data + 2);
   data += 4;
 
-  min_x = MIN (obj->x, strides[0]);
-  max_x = MIN (obj->x + obj_w, strides[0]);
+  min_x = MIN (obj->x, stride);
+  max_x = MIN (obj->x + obj_w, stride);
 
   state->comp_left = x = min_x;
   state->comp_right = max_x;
@@ -266,13 +254,12 @@ pgs_composition_object_render (PgsCompositionObject * obj, SpuState * state,
 
     colour = &state->pgs.palette[pal_id];
     if (colour->A) {
-      guint32 inv_A = 0xff - colour->A;
       if (G_UNLIKELY (x + run_len > max_x))
         run_len = (max_x - x);
 
-      for (i = 0; i < run_len; i++) {
-        planes[0][x] = (inv_A * planes[0][x] + colour->Y) / 0xff;
+      gstspu_store_luma_run (state, x, y, run_len, colour);
 
+      for (i = 0; i < run_len; i++) {
         state->comp_bufs[0][x / 2] += colour->U;
         state->comp_bufs[1][x / 2] += colour->V;
         state->comp_bufs[2][x / 2] += colour->A;
@@ -284,14 +271,10 @@ pgs_composition_object_render (PgsCompositionObject * obj, SpuState * state,
 
     if (!run_len || x > max_x) {
       x = min_x;
-      planes[0] += strides[0];
 
       if (y % 2) {
-        gstspu_blend_comp_buffers (state, planes);
+        gstspu_store_comp_buffers (state, y / 2);
         gstspu_clear_comp_buffers (state);
-
-        planes[1] += strides[1];
-        planes[2] += strides[2];
       }
       y++;
       if (y >= state->info.height)
@@ -300,7 +283,7 @@ pgs_composition_object_render (PgsCompositionObject * obj, SpuState * state,
   }
 
   if (y % 2)
-    gstspu_blend_comp_buffers (state, planes);
+    gstspu_store_comp_buffers (state, y / 2);
 }
 
 static void
@@ -742,6 +725,7 @@ gstspu_pgs_execute_event (GstDVDSpu * dvdspu)
   SpuState *state = &dvdspu->spu_state;
 
   if (state->pgs.pending_cmd) {
+    gstspu_cache_invalidate (state);
     gstspu_exec_pgs_buffer (dvdspu, state->pgs.pending_cmd);
     gst_buffer_unref (state->pgs.pending_cmd);
     state->pgs.pending_cmd = NULL;
@@ -767,11 +751,17 @@ gstspu_pgs_render (GstDVDSpu * dvdspu, GstVideoFrame * frame)
   if (ps->objects == NULL)
     return;
 
-  for (i = 0; i < ps->objects->len; i++) {
-    PgsCompositionObject *cur =
-        &g_array_index (ps->objects, PgsCompositionObject, i);
-    pgs_composition_object_render (cur, state, frame);
+  /* Only decode the objects again when the presentation changed, otherwise
+   * blend the runs from the previous frame */
+  if (gstspu_cache_begin (state)) {
+    for (i = 0; i < ps->objects->len; i++) {
+      PgsCompositionObject *cur =
+          &g_array_index (ps->objects, PgsCompositionObject, i);
+      pgs_composition_object_render (cur, state, frame);
+    }
   }
+
+  gstspu_cache_blend (state, frame);
 }
 
 gboolean
@@ -785,6 +775,8 @@ gstspu_pgs_flush (GstDVDSpu * dvdspu)
 {
   SpuPgsState *pgs_state = &dvdspu->spu_state.pgs;
 
+  gstspu_cache_invalidate (&dvdspu->spu_state);
+
   if (pgs_state->pending_cmd) {
     gst_buffer_unref (pgs_state->pending_cmd);
     pgs_state->pending_cmd = NULL;
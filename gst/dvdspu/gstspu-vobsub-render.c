@@ -178,12 +178,9 @@ gstspu_vobsub_draw_rle_run (SpuState * state, gint16 x, gint16 end,
 #endif
 
   if (colour->A != 0) {
-    guint32 inv_A = 0xff - colour->A;
+    gstspu_store_luma_run (state, x, state->vobsub.cur_Y, end - x, colour);
 
-    /* FIXME: This could be more efficient */
     while (x < end) {
-      state->vobsub.out_Y[x] =
-          (inv_A * state->vobsub.out_Y[x] + colour->Y) / 0xff;
       state->vobsub.out_U[x / 2] += colour->U;
       state->vobsub.out_V[x / 2] += colour->V;
       state->vobsub.out_A[x / 2] += colour->A;
@@ -205,12 +202,11 @@ rle_end_x (guint16 rle_code, gint16 x, gint16 end)
 }
 
 static void gstspu_vobsub_render_line_with_chgcol (SpuState * state,
-    guint8 * planes[3], guint16 * rle_offset);
+    guint16 * rle_offset);
 static gboolean gstspu_vobsub_update_chgcol (SpuState * state);
 
 static void
-gstspu_vobsub_render_line (SpuState * state, guint8 * planes[3],
-    guint16 * rle_offset)
+gstspu_vobsub_render_line (SpuState * state, guint16 * rle_offset)
 {
   gint16 x, next_x, end, rle_code, next_draw_x;
   SpuColour *colour;
@@ -222,7 +218,7 @@ gstspu_vobsub_render_line (SpuState * state, guint8 * planes[3],
       /* Check the top & bottom, because we might not be within the region yet */
       if (state->vobsub.cur_Y >= state->vobsub.cur_chg_col->top &&
           state->vobsub.cur_Y <= state->vobsub.cur_chg_col->bottom) {
-        gstspu_vobsub_render_line_with_chgcol (state, planes, rle_offset);
+        gstspu_vobsub_render_line_with_chgcol (state, rle_offset);
         return;
       }
     }
@@ -231,7 +227,6 @@ gstspu_vobsub_render_line (SpuState * state, guint8 * planes[3],
   /* No special case. Render as normal */
 
   /* Set up our output pointers */
-  state->vobsub.out_Y = planes[0];
   state->vobsub.out_U = state->comp_bufs[0];
   state->vobsub.out_V = state->comp_bufs[1];
   state->vobsub.out_A = state->comp_bufs[2];
@@ -283,8 +278,7 @@ gstspu_vobsub_update_chgcol (SpuState * state)
 }
 
 static void
-gstspu_vobsub_render_line_with_chgcol (SpuState * state, guint8 * planes[3],
-    guint16 * rle_offset)
+gstspu_vobsub_render_line_with_chgcol (SpuState * state, guint16 * rle_offset)
 {
   SpuVobsubLineCtrlI *chg_col = state->vobsub.cur_chg_col;
 
@@ -297,7 +291,6 @@ gstspu_vobsub_render_line_with_chgcol (SpuState * state, guint8 * planes[3],
   gint16 cur_reg_end;
   gint i;
 
-  state->vobsub.out_Y = planes[0];
   state->vobsub.out_U = state->comp_bufs[0];
   state->vobsub.out_V = state->comp_bufs[1];
   state->vobsub.out_A = state->comp_bufs[2];
@@ -361,7 +354,7 @@ gstspu_vobsub_render_line_with_chgcol (SpuState * state, guint8 * planes[3],
 }
 
 static void
-gstspu_vobsub_blend_comp_buffers (SpuState * state, guint8 * planes[3])
+gstspu_vobsub_store_comp_buffers (SpuState * state)
 {
   state->comp_left = state->vobsub.disp_rect.left;
   state->comp_right =
@@ -370,7 +363,7 @@ gstspu_vobsub_blend_comp_buffers (SpuState * state, guint8 * planes[3])
   state->comp_left = MAX (state->comp_left, state->vobsub.clip_rect.left);
   state->comp_right = MIN (state->comp_right, state->vobsub.clip_rect.right);
 
-  gstspu_blend_comp_buffers (state, planes);
+  gstspu_store_comp_buffers (state, state->vobsub.cur_Y / 2);
 }
 
 static void
@@ -409,30 +402,12 @@ gstspu_vobsub_draw_highlight (SpuState * state,
   }
 }
 
-void
-gstspu_vobsub_render (GstDVDSpu * dvdspu, GstVideoFrame * frame)
+/* Decode the RLE data of the current SPU into the render cache */
+static void
+gstspu_vobsub_render_cache (GstDVDSpu * dvdspu, gint width, gint height)
 {
   SpuState *state = &dvdspu->spu_state;
-  guint8 *planes[3];            /* YUV frame pointers */
   gint y, last_y;
-  gint width, height;
-  gint strides[3];
-
-  /* Set up our initial state */
-  if (G_UNLIKELY (state->vobsub.pix_buf == NULL))
-    return;
-
-  /* Store the start of each plane */
-  planes[0] = GST_VIDEO_FRAME_COMP_DATA (frame, 0);
-  planes[1] = GST_VIDEO_FRAME_COMP_DATA (frame, 1);
-  planes[2] = GST_VIDEO_FRAME_COMP_DATA (frame, 2);
-
-  strides[0] = GST_VIDEO_FRAME_COMP_STRIDE (frame, 0);
-  strides[1] = GST_VIDEO_FRAME_COMP_STRIDE (frame, 1);
-  strides[2] = GST_VIDEO_FRAME_COMP_STRIDE (frame, 2);
-
-  width = GST_VIDEO_FRAME_WIDTH (frame);
-  height = GST_VIDEO_FRAME_HEIGHT (frame);
 
   GST_DEBUG_OBJECT (dvdspu,
       "Rendering SPU. disp_rect %d,%d to %d,%d. hl_rect %d,%d to %d,%d",
@@ -537,11 +512,6 @@ gstspu_vobsub_render (GstDVDSpu * dvdspu, GstVideoFrame * frame)
    * single line at the end if the display rect ends on an even line too. */
   last_y = (state->vobsub.disp_rect.bottom - 1) & ~(0x01);
 
-  /* Update our plane references to the first line of the disp_rect */
-  planes[0] += strides[0] * y;
-  planes[1] += strides[1] * (y / 2);
-  planes[2] += strides[2] * (y / 2);
-
   for (state->vobsub.cur_Y = y; state->vobsub.cur_Y <= last_y;
       state->vobsub.cur_Y++) {
     gboolean clip;
@@ -553,26 +523,18 @@ gstspu_vobsub_render (GstDVDSpu * dvdspu, GstVideoFrame * frame)
     gstspu_vobsub_clear_comp_buffers (state);
     /* Render even line */
     state->vobsub.comp_last_x_ptr = state->vobsub.comp_last_x;
-    gstspu_vobsub_render_line (state, planes, &state->vobsub.cur_offsets[0]);
-
-    /* Advance the luminance output pointer */
-    planes[0] += strides[0];
+    gstspu_vobsub_render_line (state, &state->vobsub.cur_offsets[0]);
 
     state->vobsub.cur_Y++;
 
     /* Render odd line */
     state->vobsub.comp_last_x_ptr = state->vobsub.comp_last_x + 1;
-    gstspu_vobsub_render_line (state, planes, &state->vobsub.cur_offsets[1]);
+    gstspu_vobsub_render_line (state, &state->vobsub.cur_offsets[1]);
 
     if (!clip) {
-      /* Blend the accumulated UV compositing buffers onto the output */
-      gstspu_vobsub_blend_comp_buffers (state, planes);
+      /* Store the accumulated UV compositing buffers for blending */
+      gstspu_vobsub_store_comp_buffers (state);
     }
-
-    /* Update all the output pointers */
-    planes[0] += strides[0];
-    planes[1] += strides[1];
-    planes[2] += strides[2];
   }
 
   if (state->vobsub.cur_Y == state->vobsub.disp_rect.bottom) {
@@ -588,10 +550,28 @@ gstspu_vobsub_render (GstDVDSpu * dvdspu, GstVideoFrame * frame)
        * after the above loop exited. */
       gstspu_vobsub_clear_comp_buffers (state);
       state->vobsub.comp_last_x_ptr = state->vobsub.comp_last_x;
-      gstspu_vobsub_render_line (state, planes, &state->vobsub.cur_offsets[0]);
-      gstspu_vobsub_blend_comp_buffers (state, planes);
+      gstspu_vobsub_render_line (state, &state->vobsub.cur_offsets[0]);
+      gstspu_vobsub_store_comp_buffers (state);
     }
   }
+}
+
+void
+gstspu_vobsub_render (GstDVDSpu * dvdspu, GstVideoFrame * frame)
+{
+  SpuState *state = &dvdspu->spu_state;
+
+  /* Set up our initial state */
+  if (G_UNLIKELY (state->vobsub.pix_buf == NULL))
+    return;
+
+  /* Only decode the RLE data again when the SPU changed, otherwise blend
+   * the runs from the previous frame */
+  if (gstspu_cache_begin (state))
+    gstspu_vobsub_render_cache (dvdspu, GST_VIDEO_FRAME_WIDTH (frame),
+        GST_VIDEO_FRAME_HEIGHT (frame));
+
+  gstspu_cache_blend (state, frame);
 
   /* for debugging purposes, draw a faint rectangle at the edges of the disp_rect */
   if ((dvdspu_debug_flags & GST_DVD_SPU_DEBUG_RENDER_RECTANGLE) != 0) {
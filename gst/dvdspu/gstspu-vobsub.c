@@ -124,6 +124,8 @@ gst_dvd_spu_exec_cmd_blk (GstDVDSpu * dvdspu, guint8 * data, guint8 * end)
 {
   SpuState *state = &dvdspu->spu_state;
 
+  gstspu_cache_invalidate (state);
+
   while (data < end) {
     guint8 cmd;
 
@@ -420,6 +422,8 @@ gstspu_vobsub_handle_dvd_event (GstDVDSpu * dvdspu, GstEvent * event)
 
   event_type = gst_structure_get_string (structure, "event");
 
+  gstspu_cache_invalidate (state);
+
   if (strcmp (event_type, "dvd-spu-clut-change") == 0) {
     gchar prop_name[32];
     gint i;
@@ -497,6 +501,8 @@ gstspu_vobsub_flush (GstDVDSpu * dvdspu)
 {
   SpuState *state = &dvdspu->spu_state;
 
+  gstspu_cache_invalidate (state);
+
   if (state->vobsub.buf) {
     gst_buffer_unref (state->vobsub.buf);
     state->vobsub.buf = NULL;
@@ -95,7 +95,6 @@ struct SpuVobsubState {
   SpuVobsubLineCtrlI *cur_chg_col_end;
 
   /* Output position tracking */
-  guint8  *out_Y;
   guint32 *out_U;
   guint32 *out_V;
   guint32 *out_A;
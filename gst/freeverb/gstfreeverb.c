@@ -198,17 +198,33 @@ freeverb_allpass_getfeedback(freeverb_allpass* allpass)
   return allpass->feedback;
 }*/
 
-#define freeverb_allpass_process(_allpass, _input_1) \
-{ \
-  gfloat output; \
-  gfloat bufout; \
-  bufout = _allpass.buffer[_allpass.bufidx]; \
-  output = bufout-_input_1; \
-  _allpass.buffer[_allpass.bufidx] = _input_1 + (bufout * _allpass.feedback); \
-  if (++_allpass.bufidx >= _allpass.bufsize) { \
-    _allpass.bufidx = 0; \
-  } \
-  _input_1 = output; \
+/* Runs @n samples of @data through the allpass, in place. The loop is split
+ * where the delay line wraps around, so the inner loop has no branches. */
+static void
+freeverb_allpass_process_block (freeverb_allpass * allpass, gfloat * data,
+    guint n)
+{
+  gfloat feedback = allpass->feedback;
+  gfloat *buffer = allpass->buffer;
+  gint bufidx = allpass->bufidx;
+  guint i, len;
+
+  while (n > 0) {
+    len = MIN (n, allpass->bufsize - bufidx);
+    for (i = 0; i < len; i++) {
+      gfloat bufout = buffer[bufidx + i];
+      gfloat input = data[i];
+
+      buffer[bufidx + i] = input + (bufout * feedback);
+      data[i] = bufout - input;
+    }
+    bufidx += len;
+    if (bufidx >= allpass->bufsize)
+      bufidx = 0;
+    data += len;
+    n -= len;
+  }
+  allpass->bufidx = bufidx;
 }
 
 /* comb filter */
@@ -277,15 +293,37 @@ freeverb_comb_getfeedback(freeverb_comb* comb)
   return comb->feedback;
 }*/
 
-#define freeverb_comb_process(_comb, _input_1, _output) \
-{ \
-  gfloat _tmp = _comb.buffer[_comb.bufidx]; \
-  _comb.filterstore = (_tmp * _comb.damp2) + (_comb.filterstore * _comb.damp1); \
-  _comb.buffer[_comb.bufidx] = _input_1 + (_comb.filterstore * _comb.feedback); \
-  if (++_comb.bufidx >= _comb.bufsize) { \
-    _comb.bufidx = 0; \
-  } \
-  _output += _tmp; \
+/* Runs @n samples of @input through the comb and adds its output to
+ * @output. Like for the allpass, the loop is split at the wrap point. */
+static void
+freeverb_comb_process_block (freeverb_comb * comb, const gfloat * input,
+    gfloat * output, guint n)
+{
+  gfloat feedback = comb->feedback;
+  gfloat damp1 = comb->damp1, damp2 = comb->damp2;
+  gfloat filterstore = comb->filterstore;
+  gfloat *buffer = comb->buffer;
+  gint bufidx = comb->bufidx;
+  guint i, len;
+
+  while (n > 0) {
+    len = MIN (n, comb->bufsize - bufidx);
+    for (i = 0; i < len; i++) {
+      gfloat tmp = buffer[bufidx + i];
+
+      filterstore = (tmp * damp2) + (filterstore * damp1);
+      buffer[bufidx + i] = input[i] + (filterstore * feedback);
+      output[i] += tmp;
+    }
+    bufidx += len;
+    if (bufidx >= comb->bufsize)
+      bufidx = 0;
+    input += len;
+    output += len;
+    n -= len;
+  }
+  comb->filterstore = filterstore;
+  comb->bufidx = bufidx;
 }
 
 #define numcombs 8
@@ -298,6 +336,10 @@ freeverb_comb_getfeedback(freeverb_comb* comb)
 #define offsetroom 0.7f
 #define stereospread 23
 
+/* number of samples processed at once, the comb and allpass filters run one
+ * after the other over a whole block */
+#define blocksize 256
+
 /* These values assume 44.1KHz sample rate
  * they will need scaling for 96KHz (or other) sample rates.
  * The values were obtained by listening tests.
@@ -379,6 +421,37 @@ freeverb_revmodel_free (GstFreeverb * filter)
   }
 }
 
+/* Runs the reverb over a block of @n samples. The input has the gain and DC
+ * offset applied already, the DC offset is removed from the output. */
+static void
+freeverb_revmodel_process_block (GstFreeverb * filter, const gfloat * in_l,
+    const gfloat * in_r, gfloat * out_l, gfloat * out_r, guint n)
+{
+  GstFreeverbPrivate *priv = filter->priv;
+  gint i;
+  guint k;
+
+  memset (out_l, 0, n * sizeof (gfloat));
+  memset (out_r, 0, n * sizeof (gfloat));
+
+  /* Accumulate comb filters in parallel */
+  for (i = 0; i < numcombs; i++) {
+    freeverb_comb_process_block (&priv->combL[i], in_l, out_l, n);
+    freeverb_comb_process_block (&priv->combR[i], in_r, out_r, n);
+  }
+  /* Feed through allpasses in series */
+  for (i = 0; i < numallpasses; i++) {
+    freeverb_allpass_process_block (&priv->allpassL[i], out_l, n);
+    freeverb_allpass_process_block (&priv->allpassR[i], out_r, n);
+  }
+
+  /* Remove the DC offset */
+  for (k = 0; k < n; k++) {
+    out_l[k] -= DC_OFFSET;
+    out_r[k] -= DC_OFFSET;
+  }
+}
+
 /* GObject vmethod implementations */
 
 static void
@@ -695,45 +768,41 @@ gst_freeverb_transform_m2s_int (GstFreeverb * filter,
     gint16 * idata, gint16 * odata, guint num_samples)
 {
   GstFreeverbPrivate *priv = filter->priv;
-  gint i, k;
-  gfloat out_l1, out_r1, input_1;
+  gfloat input_1[blocksize], out_l1[blocksize], out_r1[blocksize];
   gfloat out_l2, out_r2, input_2;
   gboolean drained = TRUE;
+  guint k, n;
 
-  for (k = 0; k < num_samples; k++) {
-
-    out_l1 = out_r1 = 0.0;
+  while (num_samples > 0) {
+    n = MIN (num_samples, blocksize);
 
     /* The original Freeverb code expects a stereo signal and 'input_1'
      * is set to the sum of the left and right input_1 sample. Since
      * this code works on a mono signal, 'input_1' is set to twice the
      * input_1 sample. */
-    input_2 = (gfloat) * idata++;
-    input_1 = (2.0f * input_2 + DC_OFFSET) * priv->gain;
-
-    /* Accumulate comb filters in parallel */
-    for (i = 0; i < numcombs; i++) {
-      freeverb_comb_process (priv->combL[i], input_1, out_l1);
-      freeverb_comb_process (priv->combR[i], input_1, out_r1);
-    }
-    /* Feed through allpasses in series */
-    for (i = 0; i < numallpasses; i++) {
-      freeverb_allpass_process (priv->allpassL[i], out_l1);
-      freeverb_allpass_process (priv->allpassR[i], out_r1);
-    }
+    for (k = 0; k < n; k++)
+      input_1[k] = (2.0f * (gfloat) idata[k] + DC_OFFSET) * priv->gain;
 
-    /* Remove the DC offset */
-    out_l1 -= DC_OFFSET;
-    out_r1 -= DC_OFFSET;
+    freeverb_revmodel_process_block (filter, input_1, input_1, out_l1, out_r1,
+        n);
 
     /* Calculate output */
-    out_l2 = out_l1 * priv->wet1 + out_r1 * priv->wet2 + input_2 * priv->dry;
-    out_r2 = out_r1 * priv->wet1 + out_l1 * priv->wet2 + input_2 * priv->dry;
-    *odata++ = (gint16) CLAMP (out_l2, G_MININT16, G_MAXINT16);
-    *odata++ = (gint16) CLAMP (out_r2, G_MININT16, G_MAXINT16);
+    for (k = 0; k < n; k++) {
+      input_2 = (gfloat) idata[k];
+      out_l2 = out_l1[k] * priv->wet1 + out_r1[k] * priv->wet2 +
+          input_2 * priv->dry;
+      out_r2 = out_r1[k] * priv->wet1 + out_l1[k] * priv->wet2 +
+          input_2 * priv->dry;
+      odata[2 * k] = (gint16) CLAMP (out_l2, G_MININT16, G_MAXINT16);
+      odata[2 * k + 1] = (gint16) CLAMP (out_r2, G_MININT16, G_MAXINT16);
+
+      if (abs (out_l2) > 0 || abs (out_r2) > 0)
+        drained = FALSE;
+    }
 
-    if (abs (out_l2) > 0 || abs (out_r2) > 0)
-      drained = FALSE;
+    idata += n;
+    odata += 2 * n;
+    num_samples -= n;
   }
   return drained;
 }
@@ -743,43 +812,41 @@ gst_freeverb_transform_s2s_int (GstFreeverb * filter,
     gint16 * idata, gint16 * odata, guint num_samples)
 {
   GstFreeverbPrivate *priv = filter->priv;
-  gint i, k;
-  gfloat out_l1, out_r1, input_1l, input_1r;
+  gfloat input_1l[blocksize], input_1r[blocksize];
+  gfloat out_l1[blocksize], out_r1[blocksize];
   gfloat out_l2, out_r2, input_2l, input_2r;
   gboolean drained = TRUE;
+  guint k, n;
 
-  for (k = 0; k < num_samples; k++) {
-
-    out_l1 = out_r1 = 0.0;
-
-    input_2l = (gfloat) * idata++;
-    input_2r = (gfloat) * idata++;
-    input_1l = (input_2l + DC_OFFSET) * priv->gain;
-    input_1r = (input_2r + DC_OFFSET) * priv->gain;
+  while (num_samples > 0) {
+    n = MIN (num_samples, blocksize);
 
-    /* Accumulate comb filters in parallel */
-    for (i = 0; i < numcombs; i++) {
-      freeverb_comb_process (priv->combL[i], input_1l, out_l1);
-      freeverb_comb_process (priv->combR[i], input_1r, out_r1);
-    }
-    /* Feed through allpasses in series */
-    for (i = 0; i < numallpasses; i++) {
-      freeverb_allpass_process (priv->allpassL[i], out_l1);
-      freeverb_allpass_process (priv->allpassR[i], out_r1);
+    for (k = 0; k < n; k++) {
+      input_1l[k] = ((gfloat) idata[2 * k] + DC_OFFSET) * priv->gain;
+      input_1r[k] = ((gfloat) idata[2 * k + 1] + DC_OFFSET) * priv->gain;
     }
 
-    /* Remove the DC offset */
-    out_l1 -= DC_OFFSET;
-    out_r1 -= DC_OFFSET;
+    freeverb_revmodel_process_block (filter, input_1l, input_1r, out_l1,
+        out_r1, n);
 
     /* Calculate output */
-    out_l2 = out_l1 * priv->wet1 + out_r1 * priv->wet2 + input_2l * priv->dry;
-    out_r2 = out_r1 * priv->wet1 + out_l1 * priv->wet2 + input_2r * priv->dry;
-    *odata++ = (gint16) CLAMP (out_l2, G_MININT16, G_MAXINT16);
-    *odata++ = (gint16) CLAMP (out_r2, G_MININT16, G_MAXINT16);
+    for (k = 0; k < n; k++) {
+      input_2l = (gfloat) idata[2 * k];
+      input_2r = (gfloat) idata[2 * k + 1];
+      out_l2 = out_l1[k] * priv->wet1 + out_r1[k] * priv->wet2 +
+          input_2l * priv->dry;
+      out_r2 = out_r1[k] * priv->wet1 + out_l1[k] * priv->wet2 +
+          input_2r * priv->dry;
+      odata[2 * k] = (gint16) CLAMP (out_l2, G_MININT16, G_MAXINT16);
+      odata[2 * k + 1] = (gint16) CLAMP (out_r2, G_MININT16, G_MAXINT16);
+
+      if (abs (out_l2) > 0 || abs (out_r2) > 0)
+        drained = FALSE;
+    }
 
-    if (abs (out_l2) > 0 || abs (out_r2) > 0)
-      drained = FALSE;
+    idata += 2 * n;
+    odata += 2 * n;
+    num_samples -= n;
   }
   return drained;
 }
@@ -789,45 +856,41 @@ gst_freeverb_transform_m2s_float (GstFreeverb * filter,
     gfloat * idata, gfloat * odata, guint num_samples)
 {
   GstFreeverbPrivate *priv = filter->priv;
-  gint i, k;
-  gfloat out_l1, out_r1, input_1;
+  gfloat input_1[blocksize], out_l1[blocksize], out_r1[blocksize];
   gfloat out_l2, out_r2, input_2;
   gboolean drained = TRUE;
+  guint k, n;
 
-  for (k = 0; k < num_samples; k++) {
-
-    out_l1 = out_r1 = 0.0;
+  while (num_samples > 0) {
+    n = MIN (num_samples, blocksize);
 
     /* The original Freeverb code expects a stereo signal and 'input_1'
      * is set to the sum of the left and right input_1 sample. Since
      * this code works on a mono signal, 'input_1' is set to twice the
      * input_1 sample. */
-    input_2 = *idata++;
-    input_1 = (2.0f * input_2 + DC_OFFSET) * priv->gain;
+    for (k = 0; k < n; k++)
+      input_1[k] = (2.0f * idata[k] + DC_OFFSET) * priv->gain;
 
-    /* Accumulate comb filters in parallel */
-    for (i = 0; i < numcombs; i++) {
-      freeverb_comb_process (priv->combL[i], input_1, out_l1);
-      freeverb_comb_process (priv->combR[i], input_1, out_r1);
-    }
-    /* Feed through allpasses in series */
-    for (i = 0; i < numallpasses; i++) {
-      freeverb_allpass_process (priv->allpassL[i], out_l1);
-      freeverb_allpass_process (priv->allpassR[i], out_r1);
-    }
-
-    /* Remove the DC offset */
-    out_l1 -= DC_OFFSET;
-    out_r1 -= DC_OFFSET;
+    freeverb_revmodel_process_block (filter, input_1, input_1, out_l1, out_r1,
+        n);
 
     /* Calculate output */
-    out_l2 = out_l1 * priv->wet1 + out_r1 * priv->wet2 + input_2 * priv->dry;
-    out_r2 = out_r1 * priv->wet1 + out_l1 * priv->wet2 + input_2 * priv->dry;
-    *odata++ = out_l2;
-    *odata++ = out_r2;
+    for (k = 0; k < n; k++) {
+      input_2 = idata[k];
+      out_l2 = out_l1[k] * priv->wet1 + out_r1[k] * priv->wet2 +
+          input_2 * priv->dry;
+      out_r2 = out_r1[k] * priv->wet1 + out_l1[k] * priv->wet2 +
+          input_2 * priv->dry;
+      odata[2 * k] = out_l2;
+      odata[2 * k + 1] = out_r2;
+
+      if (fabs (out_l2) > 0 || fabs (out_r2) > 0)
+        drained = FALSE;
+    }
 
-    if (fabs (out_l2) > 0 || fabs (out_r2) > 0)
-      drained = FALSE;
+    idata += n;
+    odata += 2 * n;
+    num_samples -= n;
   }
   return drained;
 }
@@ -837,43 +900,41 @@ gst_freeverb_transform_s2s_float (GstFreeverb * filter,
     gfloat * idata, gfloat * odata, guint num_samples)
 {
   GstFreeverbPrivate *priv = filter->priv;
-  gint i, k;
-  gfloat out_l1, out_r1, input_1l, input_1r;
+  gfloat input_1l[blocksize], input_1r[blocksize];
+  gfloat out_l1[blocksize], out_r1[blocksize];
   gfloat out_l2, out_r2, input_2l, input_2r;
   gboolean drained = TRUE;
+  guint k, n;
 
-  for (k = 0; k < num_samples; k++) {
+  while (num_samples > 0) {
+    n = MIN (num_samples, blocksize);
 
-    out_l1 = out_r1 = 0.0;
-
-    input_2l = *idata++;
-    input_2r = *idata++;
-    input_1l = (input_2l + DC_OFFSET) * priv->gain;
-    input_1r = (input_2r + DC_OFFSET) * priv->gain;
-
-    /* Accumulate comb filters in parallel */
-    for (i = 0; i < numcombs; i++) {
-      freeverb_comb_process (priv->combL[i], input_1l, out_l1);
-      freeverb_comb_process (priv->combR[i], input_1r, out_r1);
-    }
-    /* Feed through allpasses in series */
-    for (i = 0; i < numallpasses; i++) {
-      freeverb_allpass_process (priv->allpassL[i], out_l1);
-      freeverb_allpass_process (priv->allpassR[i], out_r1);
+    for (k = 0; k < n; k++) {
+      input_1l[k] = (idata[2 * k] + DC_OFFSET) * priv->gain;
+      input_1r[k] = (idata[2 * k + 1] + DC_OFFSET) * priv->gain;
     }
 
-    /* Remove the DC offset */
-    out_l1 -= DC_OFFSET;
-    out_r1 -= DC_OFFSET;
+    freeverb_revmodel_process_block (filter, input_1l, input_1r, out_l1,
+        out_r1, n);
 
     /* Calculate output */
-    out_l2 = out_l1 * priv->wet1 + out_r1 * priv->wet2 + input_2l * priv->dry;
-    out_r2 = out_r1 * priv->wet1 + out_l1 * priv->wet2 + input_2r * priv->dry;
-    *odata++ = out_l2;
-    *odata++ = out_r2;
+    for (k = 0; k < n; k++) {
+      input_2l = idata[2 * k];
+      input_2r = idata[2 * k + 1];
+      out_l2 = out_l1[k] * priv->wet1 + out_r1[k] * priv->wet2 +
+          input_2l * priv->dry;
+      out_r2 = out_r1[k] * priv->wet1 + out_l1[k] * priv->wet2 +
+          input_2r * priv->dry;
+      odata[2 * k] = out_l2;
+      odata[2 * k + 1] = out_r2;
+
+      if (fabs (out_l2) > 0 || fabs (out_r2) > 0)
+        drained = FALSE;
+    }
 
-    if (fabs (out_l2) > 0 || fabs (out_r2) > 0)
-      drained = FALSE;
+    idata += 2 * n;
+    odata += 2 * n;
+    num_samples -= n;
   }
   return drained;
 }
@@ -50,6 +50,12 @@
  *
  * Gaussianblur blurs the video stream in realtime.
  *
+ * By default the gaussian kernel is applied exactly, in fixed point, so
+ * the cost grows with #GstGaussianBlur:sigma.  In box
+ * #GstGaussianBlur:mode the blur is approximated by three box blurs of
+ * matching size, whose cost does not depend on sigma.  Frames are split
+ * into bands that are processed on #GstGaussianBlur:n-threads threads.
+ *
  * <refsect2>
  * <title>Example launch line</title>
  * |[
@@ -112,17 +118,49 @@ enum
 {
   PROP_0,
   PROP_SIGMA,
+  PROP_MODE,
+  PROP_N_THREADS,
   PROP_LAST
 };
 
 static gboolean make_gaussian_kernel (GstGaussianBlur * gb, float sigma);
 static void gaussian_smooth (GstGaussianBlur * gb, guint8 * image,
     guint8 * out_image);
+static void box_smooth (GstGaussianBlur * gb, guint8 * image,
+    guint8 * out_image);
 
 #define gst_gaussianblur_parent_class parent_class
 G_DEFINE_TYPE (GstGaussianBlur, gst_gaussianblur, GST_TYPE_VIDEO_FILTER);
 
 #define DEFAULT_SIGMA 1.2
+#define DEFAULT_MODE GST_GAUSSIAN_BLUR_MODE_EXACT
+#define DEFAULT_N_THREADS 1
+
+#define MAX_THREADS 64
+/* at least this many rows or bytes of columns per band */
+#define MIN_BAND_SIZE 32
+
+/* fixed point precision of the kernel and of the x blurred rows */
+#define KERNEL_SHIFT 14
+#define TMP_SHIFT 4
+
+#define GST_TYPE_GAUSSIAN_BLUR_MODE (gst_gaussian_blur_mode_get_type ())
+static GType
+gst_gaussian_blur_mode_get_type (void)
+{
+  static GType mode_type = 0;
+
+  static const GEnumValue modes[] = {
+    {GST_GAUSSIAN_BLUR_MODE_EXACT, "Exact gaussian kernel", "exact"},
+    {GST_GAUSSIAN_BLUR_MODE_BOX, "Approximation by box blurs", "box"},
+    {0, NULL, NULL},
+  };
+
+  if (!mode_type) {
+    mode_type = g_enum_register_static ("GstGaussianBlurMode", modes);
+  }
+  return mode_type;
+}
 
 /* Initalize the gaussianblur's class. */
 static void
@@ -152,6 +190,15 @@ gst_gaussianblur_class_init (GstGaussianBlurClass * klass)
           "Sigma value for gaussian blur (negative for sharpen)",
           -20.0, 20.0, DEFAULT_SIGMA,
           G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_MODE,
+      g_param_spec_enum ("mode", "Mode",
+          "How the gaussian kernel is applied", GST_TYPE_GAUSSIAN_BLUR_MODE,
+          DEFAULT_MODE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      g_param_spec_int ("n-threads", "Number of Threads",
+          "Number of threads used to process a frame "
+          "(0 == number of processors)", 0, MAX_THREADS, DEFAULT_N_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   vfilter_class->transform_frame =
       GST_DEBUG_FUNCPTR (gst_gaussianblur_transform_frame);
@@ -171,7 +218,11 @@ gst_gaussianblur_set_info (GstVideoFilter * filter, GstCaps * incaps,
   /* get stride */
   gb->stride = GST_VIDEO_INFO_COMP_STRIDE (in_info, 0);
   n_elems = gb->stride * gb->height;
-  gb->tempim = g_malloc (sizeof (gfloat) * n_elems);
+
+  g_free (gb->smoothedim);
+  gb->smoothedim = g_new (gint16, n_elems);
+  g_free (gb->boxim);
+  gb->boxim = g_malloc (n_elems);
 
   return TRUE;
 }
@@ -181,6 +232,11 @@ gst_gaussianblur_init (GstGaussianBlur * gb)
 {
   gb->sigma = DEFAULT_SIGMA;
   gb->cur_sigma = -1.0;
+  gb->mode = DEFAULT_MODE;
+  gb->n_threads = DEFAULT_N_THREADS;
+
+  g_mutex_init (&gb->lock);
+  g_cond_init (&gb->cond);
 }
 
 static void
@@ -188,16 +244,26 @@ gst_gaussianblur_finalize (GObject * object)
 {
   GstGaussianBlur *gb = GST_GAUSSIANBLUR (object);
 
-  g_free (gb->tempim);
-  gb->tempim = NULL;
+  if (gb->pool)
+    g_thread_pool_free (gb->pool, FALSE, TRUE);
+  gb->pool = NULL;
 
   g_free (gb->smoothedim);
   gb->smoothedim = NULL;
+  g_free (gb->boxim);
+  gb->boxim = NULL;
 
   g_free (gb->kernel);
   gb->kernel = NULL;
   g_free (gb->kernel_sum);
   gb->kernel_sum = NULL;
+  g_free (gb->ikernel);
+  gb->ikernel = NULL;
+  g_free (gb->ikernel_sum);
+  gb->ikernel_sum = NULL;
+
+  g_mutex_clear (&gb->lock);
+  g_cond_clear (&gb->cond);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
@@ -210,6 +276,7 @@ gst_gaussianblur_transform_frame (GstVideoFilter * vfilter,
   GstClockTime timestamp;
   gint64 stream_time;
   gfloat sigma;
+  GstGaussianBlurMode mode;
   guint8 *src, *dest;
 
   /* GstController: update the properties */
@@ -226,6 +293,7 @@ gst_gaussianblur_transform_frame (GstVideoFilter * vfilter,
 
   GST_OBJECT_LOCK (filter);
   sigma = filter->sigma;
+  mode = filter->mode;
   GST_OBJECT_UNLOCK (filter);
 
   if (filter->cur_sigma != sigma) {
@@ -233,6 +301,10 @@ gst_gaussianblur_transform_frame (GstVideoFilter * vfilter,
     filter->kernel = NULL;
     g_free (filter->kernel_sum);
     filter->kernel_sum = NULL;
+    g_free (filter->ikernel);
+    filter->ikernel = NULL;
+    g_free (filter->ikernel_sum);
+    filter->ikernel_sum = NULL;
     filter->cur_sigma = sigma;
   }
   if (filter->kernel == NULL &&
@@ -246,69 +318,187 @@ gst_gaussianblur_transform_frame (GstVideoFilter * vfilter,
    * Perform gaussian smoothing on the image using the input standard
    * deviation.
    */
-  src = GST_VIDEO_FRAME_COMP_DATA (in_frame, 0);
-  dest = GST_VIDEO_FRAME_COMP_DATA (out_frame, 0);
-  gst_video_frame_copy (out_frame, in_frame);
-  gaussian_smooth (filter, src, dest);
+  /* all four bytes of the pixels are blurred, start at the first one so
+   * the last pixel of the frame does not reach past its end */
+  src = GST_VIDEO_FRAME_PLANE_DATA (in_frame, 0);
+  dest = GST_VIDEO_FRAME_PLANE_DATA (out_frame, 0);
+  if (mode == GST_GAUSSIAN_BLUR_MODE_BOX)
+    box_smooth (filter, src, dest);
+  else
+    gaussian_smooth (filter, src, dest);
 
   return GST_FLOW_OK;
 }
 
+typedef struct _BlurBand BlurBand;
+typedef void (*BlurBandFunc) (GstGaussianBlur * gb, BlurBand * band);
+
+/* A band of rows, or of bytes in each row, processed by one thread */
+struct _BlurBand
+{
+  BlurBandFunc func;
+  guint8 *src;
+  guint8 *dest;
+  gint start, end;
+};
+
+static void
+blur_band_thread_func (gpointer data, gpointer user_data)
+{
+  BlurBand *band = data;
+  GstGaussianBlur *gb = user_data;
+
+  band->func (gb, band);
+
+  g_mutex_lock (&gb->lock);
+  if (--gb->pending_bands == 0)
+    g_cond_signal (&gb->cond);
+  g_mutex_unlock (&gb->lock);
+}
+
+static gint
+get_n_threads (GstGaussianBlur * gb)
+{
+  gint n_threads;
+
+  GST_OBJECT_LOCK (gb);
+  n_threads = gb->n_threads;
+  GST_OBJECT_UNLOCK (gb);
+
+  if (n_threads == 0) {
+#if GLIB_CHECK_VERSION (2, 36, 0)
+    n_threads = g_get_num_processors ();
+#else
+    n_threads = 1;
+#endif
+  }
+
+  return CLAMP (n_threads, 1, MAX_THREADS);
+}
+
+/* Splits [0, size) into bands, runs @func on all of them and waits for
+ * them to finish */
 static void
-blur_row_x (GstGaussianBlur * gb, guint8 * in_row, gfloat * out_row)
+run_bands (GstGaussianBlur * gb, BlurBandFunc func, guint8 * src,
+    guint8 * dest, gint size)
 {
-  int c, cc, center;
-  float dot[4], sum;
-  int k, kmin, kmax;
+  BlurBand bands[MAX_THREADS];
+  gint n_bands, i;
+
+  n_bands = MIN (get_n_threads (gb), size / MIN_BAND_SIZE);
+  n_bands = MAX (n_bands, 1);
+
+  for (i = 0; i < n_bands; i++) {
+    bands[i].func = func;
+    bands[i].src = src;
+    bands[i].dest = dest;
+    bands[i].start = (gint64) size * i / n_bands;
+    bands[i].end = (gint64) size * (i + 1) / n_bands;
+  }
+
+  if (n_bands == 1) {
+    func (gb, &bands[0]);
+    return;
+  }
+
+  if (!gb->pool) {
+    gb->pool = g_thread_pool_new (blur_band_thread_func, gb, n_bands, FALSE,
+        NULL);
+  } else if (g_thread_pool_get_max_threads (gb->pool) < n_bands) {
+    g_thread_pool_set_max_threads (gb->pool, n_bands, NULL);
+  }
+
+  g_mutex_lock (&gb->lock);
+  gb->pending_bands = n_bands;
+  g_mutex_unlock (&gb->lock);
+
+  for (i = 0; i < n_bands; i++)
+    g_thread_pool_push (gb->pool, &bands[i], NULL);
+
+  g_mutex_lock (&gb->lock);
+  while (gb->pending_bands > 0)
+    g_cond_wait (&gb->cond, &gb->lock);
+  g_mutex_unlock (&gb->lock);
+}
+
+/* rounded division of the weighted sum @acc by @sum, both fixed point */
+static inline gint
+div_round (gint64 acc, gint64 sum)
+{
+  return acc >= 0 ? (acc + sum / 2) / sum : (acc - sum / 2) / sum;
+}
+
+/* Blurs rows in the x direction into 12.4 fixed point */
+static void
+blur_rows_x (GstGaussianBlur * gb, BlurBand * band)
+{
+  gint r, c, cc, center, k, kmin, kmax;
+  const gint32 *kernel = gb->ikernel;
+  gint full_sum = 1 << KERNEL_SHIFT;
 
   center = gb->windowsize / 2;
 
-  for (c = 0; c < gb->width; c++) {
-    /* Calculate min */
-    cc = center - c;
-    kmin = MAX (0, cc);
-    cc = kmin - cc;
-    /* Calc max */
-    kmax = MIN (gb->windowsize, gb->width - cc);
-    cc *= 4;
-
-    dot[0] = dot[1] = dot[2] = dot[3] = 0.0;
-    /* Calculate sum for range */
-    sum = gb->kernel_sum[kmax - 1];
-    sum -= kmin ? gb->kernel_sum[kmin - 1] : 0.0;
-
-    for (k = kmin; k < kmax; k++) {
-      float coeff = gb->kernel[k];
-      dot[0] += (float) in_row[cc++] * coeff;
-      dot[1] += (float) in_row[cc++] * coeff;
-      dot[2] += (float) in_row[cc++] * coeff;
-      dot[3] += (float) in_row[cc++] * coeff;
-    }
+  for (r = band->start; r < band->end; r++) {
+    const guint8 *in_row = band->src + r * gb->stride;
+    gint16 *out_row = gb->smoothedim + r * gb->stride;
 
-    out_row[c * 4] = dot[0] / sum;
-    out_row[c * 4 + 1] = dot[1] / sum;
-    out_row[c * 4 + 2] = dot[2] / sum;
-    out_row[c * 4 + 3] = dot[3] / sum;
+    for (c = 0; c < gb->width; c++) {
+      gint32 dot[4] = { 0, 0, 0, 0 };
+      gint32 sum;
+
+      /* Calculate min */
+      cc = center - c;
+      kmin = MAX (0, cc);
+      cc = kmin - cc;
+      /* Calc max */
+      kmax = MIN (gb->windowsize, gb->width - cc);
+      cc *= 4;
+
+      for (k = kmin; k < kmax; k++, cc += 4) {
+        gint32 coeff = kernel[k];
+        dot[0] += in_row[cc] * coeff;
+        dot[1] += in_row[cc + 1] * coeff;
+        dot[2] += in_row[cc + 2] * coeff;
+        dot[3] += in_row[cc + 3] * coeff;
+      }
+
+      /* Calculate sum for range */
+      sum = gb->ikernel_sum[kmax - 1];
+      sum -= kmin ? gb->ikernel_sum[kmin - 1] : 0;
+
+      if (sum == full_sum) {
+        const gint shift = KERNEL_SHIFT - TMP_SHIFT;
+        const gint round = 1 << (shift - 1);
+
+        out_row[c * 4] = (dot[0] + round) >> shift;
+        out_row[c * 4 + 1] = (dot[1] + round) >> shift;
+        out_row[c * 4 + 2] = (dot[2] + round) >> shift;
+        out_row[c * 4 + 3] = (dot[3] + round) >> shift;
+      } else {
+        out_row[c * 4] = div_round ((gint64) dot[0] << TMP_SHIFT, sum);
+        out_row[c * 4 + 1] = div_round ((gint64) dot[1] << TMP_SHIFT, sum);
+        out_row[c * 4 + 2] = div_round ((gint64) dot[2] << TMP_SHIFT, sum);
+        out_row[c * 4 + 3] = div_round ((gint64) dot[3] << TMP_SHIFT, sum);
+      }
+    }
   }
 }
 
+/* Blurs the x blurred rows in the y direction into the output rows */
 static void
-gaussian_smooth (GstGaussianBlur * gb, guint8 * image, guint8 * out_image)
+blur_rows_y (GstGaussianBlur * gb, BlurBand * band)
 {
-  int r, c, rr, center;
-  float dot[4], sum;
-  int k, kmin, kmax;
-  guint8 *in_row = image;
-  float *tmp_out_row = gb->tempim;
-  float *tmp_in_pos;
-  gint y_avail = 0;
-  guint8 *out_row;
-
-  /* Apply the gaussian kernel */
+  gint r, rr, i, k, kmin, kmax, center;
+  gint n = gb->width * 4;
+  gint32 *acc = g_new (gint32, n);
+  gint full_sum = 1 << KERNEL_SHIFT;
+
   center = gb->windowsize / 2;
 
-  /* Blur in the y - direction. */
-  for (r = 0; r < gb->height; r++) {
+  for (r = band->start; r < band->end; r++) {
+    guint8 *out_row = band->dest + r * gb->stride;
+    gint32 sum;
+
     /* Calculate input row range */
     rr = center - r;
     kmin = MAX (0, rr);
@@ -317,40 +507,185 @@ gaussian_smooth (GstGaussianBlur * gb, guint8 * image, guint8 * out_image)
     kmax = MIN (gb->windowsize, gb->height - rr);
 
     /* Precalculate sum for range */
-    sum = gb->kernel_sum[kmax - 1];
-    sum -= kmin ? gb->kernel_sum[kmin - 1] : 0.0;
-
-    /* Blur more input rows (x direction blur) */
-    while (y_avail <= (r + center) && y_avail < gb->height) {
-      blur_row_x (gb, in_row, tmp_out_row);
-      in_row += gb->stride;
-      tmp_out_row += gb->stride;
-      y_avail++;
+    sum = gb->ikernel_sum[kmax - 1];
+    sum -= kmin ? gb->ikernel_sum[kmin - 1] : 0;
+
+    memset (acc, 0, n * sizeof (gint32));
+    for (k = kmin; k < kmax; k++, rr++) {
+      const gint16 *tmp = gb->smoothedim + rr * gb->stride;
+      gint32 kern = gb->ikernel[k];
+
+      for (i = 0; i < n; i++)
+        acc[i] += tmp[i] * kern;
     }
 
-    tmp_in_pos = gb->tempim + (rr * gb->stride);
-    out_row = out_image + r * gb->stride;
+    if (sum == full_sum) {
+      const gint shift = KERNEL_SHIFT + TMP_SHIFT;
+      const gint round = 1 << (shift - 1);
 
-    for (c = 0; c < gb->width; c++) {
-      float *tmp = tmp_in_pos;
-
-      dot[0] = dot[1] = dot[2] = dot[3] = 0.0;
-      for (k = kmin; k < kmax; k++, tmp += gb->stride) {
-        float kern = gb->kernel[k];
-        dot[0] += tmp[0] * kern;
-        dot[1] += tmp[1] * kern;
-        dot[2] += tmp[2] * kern;
-        dot[3] += tmp[3] * kern;
-      }
+      for (i = 0; i < n; i++)
+        out_row[i] = CLAMP ((acc[i] + round) >> shift, 0, 255);
+    } else {
+      gint64 div = (gint64) sum << TMP_SHIFT;
+
+      for (i = 0; i < n; i++)
+        out_row[i] = CLAMP (div_round (acc[i], div), 0, 255);
+    }
+  }
+
+  g_free (acc);
+}
 
-      *out_row++ = (guint8) CLAMP ((dot[0] / sum + 0.5), 0, 255);
-      *out_row++ = (guint8) CLAMP ((dot[1] / sum + 0.5), 0, 255);
-      *out_row++ = (guint8) CLAMP ((dot[2] / sum + 0.5), 0, 255);
-      *out_row++ = (guint8) CLAMP ((dot[3] / sum + 0.5), 0, 255);
+static void
+gaussian_smooth (GstGaussianBlur * gb, guint8 * image, guint8 * out_image)
+{
+  /* Apply the gaussian kernel, first in the x and then in the y direction.
+   * All rows have to be blurred in x before any of them can be blurred
+   * in y. */
+  run_bands (gb, blur_rows_x, image, NULL, gb->height);
+  run_bands (gb, blur_rows_y, NULL, out_image, gb->height);
+}
+
+/* Box blurs @n_lanes independent lanes of @len samples with radius @r.
+ * Sample i of a lane is at i * @step from its start, lanes are next to each
+ * other.  Samples outside of the lane repeat the edge samples. */
+static void
+box_blur_lanes (const guint8 * src, guint8 * dest, gint len, gint step,
+    gint n_lanes, gint r, gint32 * sums)
+{
+  gint size = 2 * r + 1;
+  guint32 mul = ((1 << 16) + size / 2) / size;
+  gint i, l;
+
+  for (l = 0; l < n_lanes; l++)
+    sums[l] = (r + 1) * src[l];
+  for (i = 1; i <= r; i++) {
+    const guint8 *s = src + MIN (i, len - 1) * step;
+
+    for (l = 0; l < n_lanes; l++)
+      sums[l] += s[l];
+  }
+
+  for (i = 0; i < len; i++) {
+    const guint8 *add = src + MIN (i + r + 1, len - 1) * step;
+    const guint8 *sub = src + MAX (i - r, 0) * step;
+    guint8 *d = dest + i * step;
+
+    for (l = 0; l < n_lanes; l++) {
+      d[l] = (sums[l] * mul + (1 << 15)) >> 16;
+      sums[l] += add[l] - sub[l];
+    }
+  }
+}
+
+/* Box blurs rows in the x direction into boxim */
+static void
+box_rows_x (GstGaussianBlur * gb, BlurBand * band)
+{
+  gint row_size = gb->width * 4;
+  guint8 *tmp = g_malloc (2 * row_size);
+  gint32 sums[4];
+  gint r, p;
+
+  for (r = band->start; r < band->end; r++) {
+    const guint8 *in = band->src + r * gb->stride;
+    guint8 *out = gb->boxim + r * gb->stride;
+
+    for (p = 0; p < GST_GAUSSIAN_BLUR_BOX_PASSES; p++) {
+      guint8 *d = p == GST_GAUSSIAN_BLUR_BOX_PASSES - 1 ? out :
+          tmp + (p & 1) * row_size;
 
-      tmp_in_pos += 4;
+      box_blur_lanes (in, d, gb->width, 4, 4, gb->box_radius[p], sums);
+      in = d;
     }
   }
+
+  g_free (tmp);
+}
+
+/* Box blurs a band of bytes of every row in the y direction, alternating
+ * between boxim and the output so the last pass ends in the output */
+static void
+box_columns_y (GstGaussianBlur * gb, BlurBand * band)
+{
+  gint n_lanes = band->end - band->start;
+  gint32 *sums = g_new (gint32, n_lanes);
+  guint8 *bufs[2];
+  gint p;
+
+  bufs[0] = gb->boxim + band->start;
+  bufs[1] = band->dest + band->start;
+
+  for (p = 0; p < GST_GAUSSIAN_BLUR_BOX_PASSES; p++) {
+    gint from = p & 1;
+
+    box_blur_lanes (bufs[from], bufs[!from], gb->height, gb->stride, n_lanes,
+        gb->box_radius[p], sums);
+  }
+
+  if (gb->cur_sigma < 0) {
+    /* sharpen by taking the blurred picture away from the original */
+    gint r, i;
+
+    for (r = 0; r < gb->height; r++) {
+      const guint8 *s = band->src + r * gb->stride + band->start;
+      guint8 *d = band->dest + r * gb->stride + band->start;
+
+      for (i = 0; i < n_lanes; i++)
+        d[i] = CLAMP (2 * s[i] - d[i], 0, 255);
+    }
+  }
+
+  g_free (sums);
+}
+
+static void
+box_smooth (GstGaussianBlur * gb, guint8 * image, guint8 * out_image)
+{
+  run_bands (gb, box_rows_x, image, NULL, gb->height);
+  run_bands (gb, box_columns_y, image, out_image, gb->width * 4);
+}
+
+/* Radii of box blurs that together approximate a gaussian of @sigma */
+static void
+make_box_radii (GstGaussianBlur * gb, float sigma)
+{
+  const gint n = GST_GAUSSIAN_BLUR_BOX_PASSES;
+  float w_ideal = sqrt (12.0 * sigma * sigma / n + 1.0);
+  gint wl, wu, m, i;
+
+  wl = floor (w_ideal);
+  if (wl % 2 == 0)
+    wl--;
+  wu = wl + 2;
+  m = floor ((12.0 * sigma * sigma - n * wl * wl - 4 * n * wl - 3 * n) /
+      (-4.0 * wl - 4.0) + 0.5);
+
+  for (i = 0; i < n; i++)
+    gb->box_radius[i] = ((i < m ? wl : wu) - 1) / 2;
+}
+
+/* Converts the kernel to fixed point, with the center coefficient
+ * adjusted so that the coefficients add up to exactly one */
+static void
+make_fixed_point_kernel (GstGaussianBlur * gb)
+{
+  gint i, sum = 0;
+
+  gb->ikernel = g_new (gint32, gb->windowsize);
+  gb->ikernel_sum = g_new (gint32, gb->windowsize);
+
+  for (i = 0; i < gb->windowsize; i++) {
+    gb->ikernel[i] = floor (gb->kernel[i] * (1 << KERNEL_SHIFT) + 0.5);
+    sum += gb->ikernel[i];
+  }
+  gb->ikernel[gb->windowsize / 2] += (1 << KERNEL_SHIFT) - sum;
+
+  sum = 0;
+  for (i = 0; i < gb->windowsize; i++) {
+    sum += gb->ikernel[i];
+    gb->ikernel_sum[i] = sum;
+  }
 }
 
 /*
@@ -375,6 +710,8 @@ make_gaussian_kernel (GstGaussianBlur * gb, float sigma)
   if (gb->windowsize == 1) {
     gb->kernel[0] = 1.0;
     gb->kernel_sum[0] = 1.0;
+    make_fixed_point_kernel (gb);
+    make_box_radii (gb, 0.0);
     return TRUE;
   }
 
@@ -398,6 +735,9 @@ make_gaussian_kernel (GstGaussianBlur * gb, float sigma)
   for (i = 0; i < gb->windowsize; i++)
     gb->kernel[i] /= sum;
 
+  make_fixed_point_kernel (gb);
+  make_box_radii (gb, fabs (sigma));
+
   sum2 = 0.0;
   for (i = 0; i < gb->windowsize; i++) {
     sum2 += gb->kernel[i];
@@ -430,6 +770,16 @@ gst_gaussianblur_set_property (GObject * object,
       gb->sigma = g_value_get_double (value);
       GST_OBJECT_UNLOCK (object);
       break;
+    case PROP_MODE:
+      GST_OBJECT_LOCK (object);
+      gb->mode = g_value_get_enum (value);
+      GST_OBJECT_UNLOCK (object);
+      break;
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (object);
+      gb->n_threads = g_value_get_int (value);
+      GST_OBJECT_UNLOCK (object);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -447,6 +797,16 @@ gst_gaussianblur_get_property (GObject * object,
       g_value_set_double (value, gb->sigma);
       GST_OBJECT_UNLOCK (gb);
       break;
+    case PROP_MODE:
+      GST_OBJECT_LOCK (gb);
+      g_value_set_enum (value, gb->mode);
+      GST_OBJECT_UNLOCK (gb);
+      break;
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (gb);
+      g_value_set_int (value, gb->n_threads);
+      GST_OBJECT_UNLOCK (gb);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
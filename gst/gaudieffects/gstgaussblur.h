@@ -61,6 +61,13 @@ G_BEGIN_DECLS
 typedef struct GstGaussianBlur GstGaussianBlur;
 typedef struct GstGaussianBlurClass GstGaussianBlurClass;
 
+typedef enum {
+  GST_GAUSSIAN_BLUR_MODE_EXACT,
+  GST_GAUSSIAN_BLUR_MODE_BOX
+} GstGaussianBlurMode;
+
+#define GST_GAUSSIAN_BLUR_BOX_PASSES 3
+
 struct GstGaussianBlur
 {
   GstVideoFilter videofilter;
@@ -68,11 +75,27 @@ struct GstGaussianBlur
 
   float cur_sigma, sigma;
   int windowsize;
+  GstGaussianBlurMode mode;
+  gint n_threads;
 
   float *kernel;
   float *kernel_sum;
-  float *tempim;
+  /* kernel in 2.14 fixed point and its running sum */
+  gint32 *ikernel;
+  gint32 *ikernel_sum;
+  /* box radii approximating the kernel */
+  gint box_radius[GST_GAUSSIAN_BLUR_BOX_PASSES];
+
+  /* rows blurred in x direction: 12.4 fixed point in exact mode,
+   * 8 bit in box mode */
   gint16 *smoothedim;
+  guint8 *boxim;
+
+  /* frames are processed in bands on these threads */
+  GThreadPool *pool;
+  GMutex lock;
+  GCond cond;
+  gint pending_bands;
 };
 
 struct GstGaussianBlurClass
@@ -125,30 +125,27 @@ G_STMT_START {							\
 #define POLY       0x1021
 #define CRC_INIT   0xFFFF
 
+/* number of bytes processed per step by the sliced CRC loop */
+#define CRC_SLICES 8
+
 /*** HELPER FUNCTIONS ***/
 
-static gboolean
-gst_dp_header_from_buffer_any (const GstBuffer * buffer, GstDPHeaderFlag flags,
-    guint * length, guint8 ** header, GstDPVersion version)
+/* Fill the GST_DP_HEADER_LENGTH bytes at @h with the header for @buffer.
+ * The payload is only mapped when a payload CRC is asked for. */
+void
+gst_dp_header_fill_from_buffer (const GstBuffer * buffer,
+    GstDPHeaderFlag flags, GstDPVersion version, guint8 * h)
 {
-  guint8 *h;
   guint16 flags_mask;
   GstMapInfo map;
 
-  g_return_val_if_fail (GST_IS_BUFFER (buffer), FALSE);
-  g_return_val_if_fail (length, FALSE);
-  g_return_val_if_fail (header, FALSE);
-
-  *length = GST_DP_HEADER_LENGTH;
-  h = g_malloc0 (GST_DP_HEADER_LENGTH);
+  memset (h, 0, GST_DP_HEADER_LENGTH);
 
   /* version, flags, type */
   GST_DP_INIT_HEADER (h, version, flags, GST_DP_PAYLOAD_BUFFER);
 
-  gst_buffer_map ((GstBuffer *) buffer, &map, GST_MAP_READ);
-
   /* buffer properties */
-  GST_WRITE_UINT32_BE (h + 6, map.size);
+  GST_WRITE_UINT32_BE (h + 6, gst_buffer_get_size ((GstBuffer *) buffer));
   GST_WRITE_UINT64_BE (h + 10, GST_BUFFER_TIMESTAMP (buffer));
   GST_WRITE_UINT64_BE (h + 18, GST_BUFFER_DURATION (buffer));
   GST_WRITE_UINT64_BE (h + 26, GST_BUFFER_OFFSET (buffer));
@@ -164,11 +161,32 @@ gst_dp_header_from_buffer_any (const GstBuffer * buffer, GstDPHeaderFlag flags,
   /* from gstreamer 1.x, buffers also have the DTS */
   GST_WRITE_UINT64_BE (h + 44, GST_BUFFER_DTS (buffer));
 
-  GST_DP_SET_CRC (h, flags, map.data, map.size);
-
-  gst_buffer_unmap ((GstBuffer *) buffer, &map);
+  if (flags & GST_DP_HEADER_FLAG_CRC_PAYLOAD) {
+    gst_buffer_map ((GstBuffer *) buffer, &map, GST_MAP_READ);
+    GST_DP_SET_CRC (h, flags, map.data, map.size);
+    gst_buffer_unmap ((GstBuffer *) buffer, &map);
+  } else {
+    GST_DP_SET_CRC (h, flags, NULL, 0);
+  }
 
   GST_MEMDUMP ("created header from buffer", h, GST_DP_HEADER_LENGTH);
+}
+
+static gboolean
+gst_dp_header_from_buffer_any (const GstBuffer * buffer, GstDPHeaderFlag flags,
+    guint * length, guint8 ** header, GstDPVersion version)
+{
+  guint8 *h;
+
+  g_return_val_if_fail (GST_IS_BUFFER (buffer), FALSE);
+  g_return_val_if_fail (length, FALSE);
+  g_return_val_if_fail (header, FALSE);
+
+  *length = GST_DP_HEADER_LENGTH;
+  h = g_malloc (GST_DP_HEADER_LENGTH);
+
+  gst_dp_header_fill_from_buffer (buffer, flags, version, h);
+
   *header = h;
   return TRUE;
 }
@@ -248,6 +266,31 @@ static const guint16 gst_dp_crc_table[256] = {
   0x6e17, 0x7e36, 0x4e55, 0x5e74, 0x2e93, 0x3eb2, 0x0ed1, 0x1ef0
 };
 
+/* gst_dp_crc_slices[k][b] is the CRC contribution of byte b followed by
+ * k zero bytes, so that CRC_SLICES bytes can be folded in at once */
+static guint16 gst_dp_crc_slices[CRC_SLICES][256];
+
+static void
+gst_dp_crc_init_slices (void)
+{
+  static gsize initialized = 0;
+
+  if (g_once_init_enter (&initialized)) {
+    guint i, k;
+
+    for (i = 0; i < 256; i++) {
+      gst_dp_crc_slices[0][i] = gst_dp_crc_table[i];
+      for (k = 1; k < CRC_SLICES; k++) {
+        guint16 prev = gst_dp_crc_slices[k - 1][i];
+
+        gst_dp_crc_slices[k][i] =
+            (guint16) ((prev << 8) ^ gst_dp_crc_table[prev >> 8]);
+      }
+    }
+    g_once_init_leave (&initialized, 1);
+  }
+}
+
 /**
  * gst_dp_crc:
  * @buffer: array of bytes
@@ -266,7 +309,21 @@ gst_dp_crc (const guint8 * buffer, guint length)
 
   g_return_val_if_fail (buffer != NULL || length == 0, 0);
 
-  /* calc CRC */
+  gst_dp_crc_init_slices ();
+
+  /* calc CRC, CRC_SLICES bytes at a time. The register only covers the
+   * first two bytes, the others go through their table directly */
+  for (; length >= CRC_SLICES; length -= CRC_SLICES, buffer += CRC_SLICES) {
+    crc_register =
+        gst_dp_crc_slices[7][(crc_register >> 8) ^ buffer[0]] ^
+        gst_dp_crc_slices[6][(crc_register & 0xff) ^ buffer[1]] ^
+        gst_dp_crc_slices[5][buffer[2]] ^
+        gst_dp_crc_slices[4][buffer[3]] ^
+        gst_dp_crc_slices[3][buffer[4]] ^
+        gst_dp_crc_slices[2][buffer[5]] ^
+        gst_dp_crc_slices[1][buffer[6]] ^ gst_dp_crc_slices[0][buffer[7]];
+  }
+
   for (; length--;) {
     crc_register = (guint16) ((crc_register << 8) ^
         gst_dp_crc_table[((crc_register >> 8) & 0x00ff) ^ *buffer++]);
@@ -442,14 +499,23 @@ gst_dp_buffer_from_header (guint header_length, const guint8 * header)
       gst_buffer_new_allocate (NULL,
       (guint) GST_DP_HEADER_PAYLOAD_LENGTH (header), NULL);
 
+  gst_dp_buffer_set_metadata_from_header (buffer, header);
+
+  return buffer;
+}
+
+/* Copy the timestamps, offsets and flags stored in @header on @buffer,
+ * which must be writable */
+void
+gst_dp_buffer_set_metadata_from_header (GstBuffer * buffer,
+    const guint8 * header)
+{
   GST_BUFFER_TIMESTAMP (buffer) = GST_DP_HEADER_TIMESTAMP (header);
   GST_BUFFER_DTS (buffer) = GST_DP_HEADER_DTS (header);
   GST_BUFFER_DURATION (buffer) = GST_DP_HEADER_DURATION (header);
   GST_BUFFER_OFFSET (buffer) = GST_DP_HEADER_OFFSET (header);
   GST_BUFFER_OFFSET_END (buffer) = GST_DP_HEADER_OFFSET_END (header);
   GST_BUFFER_FLAGS (buffer) = GST_DP_HEADER_BUFFER_FLAGS (header);
-
-  return buffer;
 }
 
 /**
@@ -27,6 +27,8 @@
 #include <gst/gstevent.h>
 #include <gst/gstcaps.h>
 
+#include "dataprotocol.h"
+
 G_BEGIN_DECLS
 
 /* FIXME: please make the dataprotocol format typefindable in new versions */
@@ -49,6 +51,11 @@ G_BEGIN_DECLS
 
 void gst_dp_dump_byte_array (guint8 *array, guint length);
 
+void gst_dp_header_fill_from_buffer (const GstBuffer * buffer,
+    GstDPHeaderFlag flags, GstDPVersion version, guint8 * header);
+void gst_dp_buffer_set_metadata_from_header (GstBuffer * buffer,
+    const guint8 * header);
+
 G_END_DECLS
 
 #endif /* __GST_DP_PRIVATE_H__ */
@@ -39,6 +39,7 @@
 #include <string.h>
 
 #include "dataprotocol.h"
+#include "dp-private.h"
 
 #include "gstgdpdepay.h"
 
@@ -302,21 +303,19 @@ gst_gdp_depay_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
           goto no_caps;
 
         GST_LOG_OBJECT (this, "reading GDP buffer from adapter");
-        buf = gst_dp_buffer_from_header (GST_DP_HEADER_LENGTH, this->header);
-        if (!buf)
-          goto buffer_failed;
 
-        /* now take the payload if there is any */
+        /* take the payload without copying when it is in one input buffer */
         if (this->payload_length > 0) {
-          GstMapInfo map;
-
-          gst_buffer_map (buf, &map, GST_MAP_WRITE);
-          gst_adapter_copy (this->adapter, map.data, 0, this->payload_length);
-          gst_buffer_unmap (buf, &map);
-
-          gst_adapter_flush (this->adapter, this->payload_length);
+          buf = gst_adapter_take_buffer (this->adapter, this->payload_length);
+          if (!buf)
+            goto buffer_failed;
+          buf = gst_buffer_make_writable (buf);
+        } else {
+          buf = gst_buffer_new ();
         }
 
+        gst_dp_buffer_set_metadata_from_header (buf, this->header);
+
         /* set caps and push */
         GST_LOG_OBJECT (this, "deserialized buffer %p, pushing, timestamp %"
             GST_TIME_FORMAT ", duration %" GST_TIME_FORMAT
@@ -37,6 +37,7 @@
 #endif
 
 #include "dataprotocol.h"
+#include "dp-private.h"
 
 #include "gstgdppay.h"
 
@@ -59,6 +60,9 @@ GST_DEBUG_CATEGORY_STATIC (gst_gdp_pay_debug);
 #define DEFAULT_CRC_PAYLOAD FALSE
 #define DEFAULT_VERSION GST_DP_VERSION_1_0
 
+/* maximum number of header memories kept around for reuse */
+#define MAX_HEADER_MEMS 64
+
 enum
 {
   PROP_0,
@@ -77,6 +81,8 @@ static void gst_gdp_pay_reset (GstGDPPay * this);
 
 static GstFlowReturn gst_gdp_pay_chain (GstPad * pad, GstObject * parent,
     GstBuffer * buffer);
+static GstFlowReturn gst_gdp_pay_chain_list (GstPad * pad, GstObject * parent,
+    GstBufferList * list);
 static gboolean gst_gdp_pay_src_event (GstPad * pad, GstObject * parent,
     GstEvent * event);
 static gboolean gst_gdp_pay_sink_event (GstPad * pad, GstObject * parent,
@@ -139,6 +145,8 @@ gst_gdp_pay_init (GstGDPPay * gdppay)
       gst_pad_new_from_static_template (&gdp_pay_sink_template, "sink");
   gst_pad_set_chain_function (gdppay->sinkpad,
       GST_DEBUG_FUNCPTR (gst_gdp_pay_chain));
+  gst_pad_set_chain_list_function (gdppay->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_gdp_pay_chain_list));
   gst_pad_set_event_function (gdppay->sinkpad,
       GST_DEBUG_FUNCPTR (gst_gdp_pay_sink_event));
   gst_element_add_pad (GST_ELEMENT (gdppay), gdppay->sinkpad);
@@ -156,6 +164,9 @@ gst_gdp_pay_init (GstGDPPay * gdppay)
   gdppay->offset = 0;
 
   gdppay->packetizer = gst_dp_packetizer_new (gdppay->version);
+
+  gdppay->header_mems =
+      g_ptr_array_new_with_free_func ((GDestroyNotify) gst_memory_unref);
 }
 
 static void
@@ -165,6 +176,7 @@ gst_gdp_pay_finalize (GObject * gobject)
 
   gst_gdp_pay_reset (this);
   gst_dp_packetizer_free (this->packetizer);
+  g_ptr_array_free (this->header_mems, TRUE);
 
   GST_CALL_PARENT (G_OBJECT_CLASS, finalize, (gobject));
 }
@@ -245,29 +257,60 @@ packet_failed:
   }
 }
 
+/* get a header memory that is not used by any buffer downstream anymore,
+ * or allocate a new one */
+static GstMemory *
+gst_gdp_pay_acquire_header_memory (GstGDPPay * this)
+{
+  GstMemory *mem;
+  guint i, n = this->header_mems->len;
+
+  for (i = 0; i < n; i++) {
+    guint idx = (this->header_mem_idx + i) % n;
+
+    mem = g_ptr_array_index (this->header_mems, idx);
+    /* only our own ref left, the buffer using it was freed */
+    if (GST_MINI_OBJECT_REFCOUNT_VALUE (mem) == 1) {
+      this->header_mem_idx = (idx + 1) % n;
+      return gst_memory_ref (mem);
+    }
+  }
+
+  mem = gst_allocator_alloc (NULL, GST_DP_HEADER_LENGTH, NULL);
+  if (n < MAX_HEADER_MEMS)
+    g_ptr_array_add (this->header_mems, gst_memory_ref (mem));
+
+  return mem;
+}
+
 static GstBuffer *
 gst_gdp_pay_buffer_from_buffer (GstGDPPay * this, GstBuffer * buffer)
 {
-  GstBuffer *headerbuf;
-  guint8 *header;
-  guint len;
+  GstBuffer *outbuffer;
+  GstMemory *mem;
+  GstMapInfo map;
 
-  if (!this->packetizer->header_from_buffer (buffer, this->header_flag, &len,
-          &header))
+  mem = gst_gdp_pay_acquire_header_memory (this);
+  if (!gst_memory_map (mem, &map, GST_MAP_WRITE))
     goto no_buffer;
+  gst_dp_header_fill_from_buffer (buffer, this->header_flag, this->version,
+      map.data);
+  gst_memory_unmap (mem, &map);
 
   GST_LOG_OBJECT (this, "creating GDP header and payload buffer from buffer");
-  headerbuf = gst_buffer_new_wrapped (header, len);
 
-  /* we do not want to lose the ref on the incoming buffer */
-  gst_buffer_ref (buffer);
+  /* header and payload memories in one buffer, the payload is not copied */
+  outbuffer = gst_buffer_new ();
+  gst_buffer_append_memory (outbuffer, mem);
+  gst_buffer_copy_into (outbuffer, buffer, GST_BUFFER_COPY_MEMORY, 0, -1);
 
-  return gst_buffer_append (headerbuf, buffer);
+  return outbuffer;
 
   /* ERRORS */
 no_buffer:
   {
     GST_WARNING_OBJECT (this, "could not create GDP header from buffer");
+    gst_memory_unref (mem);
     return NULL;
   }
 }
@@ -568,18 +611,16 @@ gst_gdp_queue_buffer (GstGDPPay * this, GstBuffer * buffer)
   return GST_FLOW_OK;
 }
 
+/* create the GDP buffer for @buffer in @outbuf, takes ownership of @buffer */
 static GstFlowReturn
-gst_gdp_pay_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
+gst_gdp_pay_payload (GstGDPPay * this, GstBuffer * buffer, GstBuffer ** outbuf)
 {
-  GstGDPPay *this;
 #if 0
   GstCaps *caps;
 #endif
   GstBuffer *outbuffer;
   GstFlowReturn ret;
 
-  this = GST_GDP_PAY (parent);
-
   /* we should have received a new_segment before, otherwise it's a bug.
    * fake one in that case */
   if (!this->new_segment_buf) {
@@ -629,7 +670,8 @@ gst_gdp_pay_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
   GST_BUFFER_TIMESTAMP (outbuffer) = GST_BUFFER_TIMESTAMP (buffer);
   GST_BUFFER_DURATION (outbuffer) = GST_BUFFER_DURATION (buffer);
 
-  ret = gst_gdp_queue_buffer (this, outbuffer);
+  *outbuf = outbuffer;
+  ret = GST_FLOW_OK;
 
 done:
   gst_buffer_unref (buffer);
@@ -665,6 +707,63 @@ no_buffer:
   }
 }
 
+static GstFlowReturn
+gst_gdp_pay_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
+{
+  GstGDPPay *this = GST_GDP_PAY (parent);
+  GstBuffer *outbuffer;
+  GstFlowReturn ret;
+
+  ret = gst_gdp_pay_payload (this, buffer, &outbuffer);
+  if (ret != GST_FLOW_OK)
+    return ret;
+
+  return gst_gdp_queue_buffer (this, outbuffer);
+}
+
+static GstFlowReturn
+gst_gdp_pay_chain_list (GstPad * pad, GstObject * parent, GstBufferList * list)
+{
+  GstGDPPay *this = GST_GDP_PAY (parent);
+  GstBufferList *outlist = NULL;
+  GstFlowReturn ret = GST_FLOW_OK;
+  guint i, len;
+
+  len = gst_buffer_list_length (list);
+
+  for (i = 0; i < len; i++) {
+    GstBuffer *outbuffer;
+
+    ret = gst_gdp_pay_payload (this,
+        gst_buffer_ref (gst_buffer_list_get (list, i)), &outbuffer);
+    if (ret != GST_FLOW_OK)
+      break;
+
+    /* until the streamheader is out, buffers go through the queue */
+    if (!this->sent_streamheader) {
+      ret = gst_gdp_queue_buffer (this, outbuffer);
+      if (ret != GST_FLOW_OK)
+        break;
+      continue;
+    }
+
+    if (!outlist)
+      outlist = gst_buffer_list_sized_new (len - i);
+    gst_buffer_list_add (outlist, outbuffer);
+  }
+
+  gst_buffer_list_unref (list);
+
+  if (outlist) {
+    if (ret == GST_FLOW_OK)
+      ret = gst_pad_push_list (this->srcpad, outlist);
+    else
+      gst_buffer_list_unref (outlist);
+  }
+
+  return ret;
+}
+
 static gboolean
 gst_gdp_pay_sink_event (GstPad * pad, GstObject * parent, GstEvent * event)
 {
@@ -66,6 +66,10 @@ struct _GstGDPPay
   GstDPHeaderFlag header_flag;
   GstDPVersion version;
   GstDPPacketizer *packetizer;
+
+  /* header memories, reused once downstream released them */
+  GPtrArray *header_mems;
+  guint header_mem_idx;
 };
 
 struct _GstGDPPayClass
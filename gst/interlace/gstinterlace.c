@@ -99,6 +99,7 @@ struct _GstInterlace
 
   GstBuffer *stored_frame;
   gint stored_fields;
+  gboolean discont;             /* mark the next output buffer DISCONT */
   gint phase_index;
   int field_index;              /* index of the next field to push, 0=top 1=bottom */
   GstClockTime timebase;
@@ -271,6 +272,8 @@ gst_interlace_reset (GstInterlace * interlace)
     gst_buffer_unref (interlace->stored_frame);
     interlace->stored_frame = NULL;
   }
+  interlace->stored_fields = 0;
+  interlace->discont = FALSE;
 }
 
 static void
@@ -351,6 +354,17 @@ gst_interlace_decorate_buffer (GstInterlace * interlace, GstBuffer * buf,
         interlace->src_fps_n * 2);
   }
 
+  /* the buffer might be a reused input buffer */
+  GST_BUFFER_FLAG_UNSET (buf, GST_BUFFER_FLAG_DISCONT | GST_BUFFER_FLAG_GAP |
+      GST_BUFFER_FLAG_DELTA_UNIT | GST_VIDEO_BUFFER_FLAG_TFF |
+      GST_VIDEO_BUFFER_FLAG_RFF | GST_VIDEO_BUFFER_FLAG_ONEFIELD |
+      GST_VIDEO_BUFFER_FLAG_INTERLACED);
+
+  if (interlace->discont) {
+    GST_BUFFER_FLAG_SET (buf, GST_BUFFER_FLAG_DISCONT);
+    interlace->discont = FALSE;
+  }
+
   if (interlace->field_index == 0) {
     GST_BUFFER_FLAG_SET (buf, GST_VIDEO_BUFFER_FLAG_TFF);
   }
@@ -661,6 +675,25 @@ src_map_failed:
   }
 }
 
+/* whether the data of @buf can be written without copying it first */
+static gboolean
+buffer_is_exclusive (GstBuffer * buf)
+{
+  guint i, n_mem;
+
+  if (!gst_buffer_is_writable (buf))
+    return FALSE;
+
+  n_mem = gst_buffer_n_memory (buf);
+  for (i = 0; i < n_mem; i++) {
+    GstMemory *mem = gst_buffer_peek_memory (buf, i);
+
+    if (GST_MEMORY_IS_READONLY (mem) ||
+        !gst_mini_object_is_writable (GST_MINI_OBJECT_CAST (mem)))
+      return FALSE;
+  }
+  return TRUE;
+}
 
 static GstFlowReturn
 gst_interlace_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
@@ -692,6 +725,7 @@ gst_interlace_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
     }
     interlace->stored_frame = NULL;
     interlace->stored_fields = 0;
+    interlace->discont = TRUE;
 
     if (interlace->top_field_first) {
       interlace->field_index = 0;
@@ -735,13 +769,33 @@ gst_interlace_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
     if (interlace->stored_fields > 0) {
       GST_DEBUG ("1 field from stored, 1 from current");
 
-      output_buffer = gst_buffer_new_and_alloc (gst_buffer_get_size (buffer));
-      /* take the first field from the stored frame */
-      copy_field (interlace, output_buffer, interlace->stored_frame,
-          interlace->field_index);
+      /* The stored frame is not needed after its last field and the
+       * current one only if it has fields left, so weave into one of them
+       * when nobody else uses its data and copy a single field. */
+      if (interlace->stored_fields == 1
+          && buffer_is_exclusive (interlace->stored_frame)) {
+        GST_LOG_OBJECT (interlace, "weaving into stored frame");
+        output_buffer = interlace->stored_frame;
+        interlace->stored_frame = NULL;
+        copy_field (interlace, output_buffer, buffer,
+            interlace->field_index ^ 1);
+      } else if (current_fields == 1 && buffer_is_exclusive (buffer)) {
+        GST_LOG_OBJECT (interlace, "weaving into current frame");
+        output_buffer = buffer;
+        buffer = NULL;
+        copy_field (interlace, output_buffer, interlace->stored_frame,
+            interlace->field_index);
+      } else {
+        output_buffer =
+            gst_buffer_new_and_alloc (gst_buffer_get_size (buffer));
+        /* take the first field from the stored frame */
+        copy_field (interlace, output_buffer, interlace->stored_frame,
+            interlace->field_index);
+        /* take the second field from the incoming buffer */
+        copy_field (interlace, output_buffer, buffer,
+            interlace->field_index ^ 1);
+      }
       interlace->stored_fields--;
-      /* take the second field from the incoming buffer */
-      copy_field (interlace, output_buffer, buffer, interlace->field_index ^ 1);
       current_fields--;
       n_output_fields = 2;
       interlaced = TRUE;
@@ -787,16 +841,18 @@ gst_interlace_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
 
   GST_DEBUG ("done.  %d fields remaining", current_fields);
 
+  /* the stored frame might already have been pushed, woven with the
+   * current one */
   if (interlace->stored_frame) {
     gst_buffer_unref (interlace->stored_frame);
     interlace->stored_frame = NULL;
-    interlace->stored_fields = 0;
   }
+  interlace->stored_fields = 0;
 
   if (current_fields > 0) {
     interlace->stored_frame = buffer;
     interlace->stored_fields = current_fields;
-  } else {
+  } else if (buffer) {
     gst_buffer_unref (buffer);
   }
   return ret;
@@ -73,7 +73,8 @@ static void gst_ivtc_flush (GstIvtc * ivtc);
 static void gst_ivtc_retire_fields (GstIvtc * ivtc, int n_fields);
 static void gst_ivtc_construct_frame (GstIvtc * itvc, GstBuffer * outbuf);
 
-static int get_comb_score (GstVideoFrame * top, GstVideoFrame * bottom);
+static void get_comb_scores (GstVideoFrame ** tops, GstVideoFrame ** bottoms,
+    int n_pairs, int *scores);
 
 enum
 {
@@ -299,6 +300,7 @@ add_field (GstIvtc * ivtc, GstBuffer * buffer, int parity, int index)
   field->buffer = gst_buffer_ref (buffer);
   field->parity = parity;
   field->ts = ts;
+  field->next_score = -1;
 
   gst_video_frame_map (&ivtc->fields[i].frame, &ivtc->sink_video_info,
       buffer, GST_MAP_READ);
@@ -306,27 +308,49 @@ add_field (GstIvtc * ivtc, GstBuffer * buffer, int parity, int index)
   ivtc->n_fields++;
 }
 
-static int
-similarity (GstIvtc * ivtc, int i1, int i2)
+/* Fills in the comb scores of the field pairs (i, i + 1) starting at
+ * @first, for @n_pairs pairs.  Scores only depend on the two fields, so
+ * they are kept with the fields and reused after retiring some of them.
+ * The pairs that are still missing are scored in a single pass. */
+static void
+similarity (GstIvtc * ivtc, int first, int n_pairs, int *scores)
 {
-  GstIvtcField *f1, *f2;
-  int score;
+  GstVideoFrame *tops[2], *bottoms[2];
+  int missing[2];
+  int new_scores[2];
+  int n_missing = 0;
+  int i;
 
-  g_return_val_if_fail (i1 >= 0 && i1 < ivtc->n_fields, 0);
-  g_return_val_if_fail (i2 >= 0 && i2 < ivtc->n_fields, 0);
+  g_return_if_fail (n_pairs <= 2);
+  g_return_if_fail (first >= 0 && first + n_pairs < ivtc->n_fields);
 
-  f1 = &ivtc->fields[i1];
-  f2 = &ivtc->fields[i2];
+  for (i = first; i < first + n_pairs; i++) {
+    GstIvtcField *f1 = &ivtc->fields[i];
+    GstIvtcField *f2 = &ivtc->fields[i + 1];
 
-  if (f1->parity == TOP_FIELD) {
-    score = get_comb_score (&f1->frame, &f2->frame);
-  } else {
-    score = get_comb_score (&f2->frame, &f1->frame);
+    if (f1->next_score >= 0)
+      continue;
+
+    if (f1->parity == TOP_FIELD) {
+      tops[n_missing] = &f1->frame;
+      bottoms[n_missing] = &f2->frame;
+    } else {
+      tops[n_missing] = &f2->frame;
+      bottoms[n_missing] = &f1->frame;
+    }
+    missing[n_missing++] = i;
   }
 
-  GST_DEBUG ("score %d", score);
+  if (n_missing > 0) {
+    get_comb_scores (tops, bottoms, n_missing, new_scores);
+    for (i = 0; i < n_missing; i++)
+      ivtc->fields[missing[i]].next_score = new_scores[i];
+  }
 
-  return score;
+  for (i = 0; i < n_pairs; i++) {
+    scores[i] = ivtc->fields[first + i].next_score;
+    GST_DEBUG ("score %d", scores[i]);
+  }
 }
 
 #define GET_LINE(frame,comp,line) (((unsigned char *)(frame)->data[k]) + \
@@ -565,6 +589,7 @@ gst_ivtc_construct_frame (GstIvtc * ivtc, GstBuffer * outbuf)
 {
   int anchor_index;
   int prev_score, next_score;
+  int scores[2];
   GstVideoFrame dest_frame;
   int n_retire;
   gboolean forward_ok;
@@ -576,8 +601,9 @@ gst_ivtc_construct_frame (GstIvtc * ivtc, GstBuffer * outbuf)
     forward_ok = FALSE;
   }
 
-  prev_score = similarity (ivtc, anchor_index - 1, anchor_index);
-  next_score = similarity (ivtc, anchor_index, anchor_index + 1);
+  similarity (ivtc, anchor_index - 1, 2, scores);
+  prev_score = scores[0];
+  next_score = scores[1];
 
   gst_video_frame_map (&dest_frame, &ivtc->src_video_info, outbuf,
       GST_MAP_WRITE);
@@ -629,51 +655,100 @@ gst_ivtc_construct_frame (GstIvtc * ivtc, GstBuffer * outbuf)
 
 }
 
+/* marks the pixels of @src2 that lie outside the range of the lines
+ * above and below it, returns whether any pixel was marked */
+static gboolean
+comb_line (const guint8 * src1, const guint8 * src2, const guint8 * src3,
+    guint8 * mask, int width)
+{
+  int i;
+  int any = 0;
+
+  for (i = 0; i < width; i++) {
+    int lo = MIN (src1[i], src3[i]) - 5;
+    int hi = MAX (src1[i], src3[i]) + 5;
+
+    mask[i] = (src2[i] < lo) | (src2[i] > hi);
+    any |= mask[i];
+  }
+
+  return any;
+}
+
+/* grows runs of combed pixels, which depend on the pixel to the left and
+ * the one above, and counts the pixels in long enough runs */
 static int
-get_comb_score (GstVideoFrame * top, GstVideoFrame * bottom)
+comb_accumulate (int *thisline, const guint8 * mask, int width)
 {
-  int j;
-  int thisline[MAX_WIDTH];
   int score = 0;
+  int i;
+
+  for (i = 0; i < width; i++) {
+    if (mask[i]) {
+      if (i > 0) {
+        thisline[i] += thisline[i - 1];
+      }
+      thisline[i]++;
+      if (thisline[i] > 1000)
+        thisline[i] = 1000;
+    } else {
+      thisline[i] = 0;
+    }
+    if (thisline[i] > 100) {
+      score++;
+    }
+  }
+
+  return score;
+}
+
+/* Scores how combed the frames woven from each top and bottom field pair
+ * are.  All pairs are handled line by line in the same pass, so a field
+ * shared by two pairs is read while it is still in the cache. */
+static void
+get_comb_scores (GstVideoFrame ** tops, GstVideoFrame ** bottoms,
+    int n_pairs, int *scores)
+{
+  int j;
+  int thisline[2][MAX_WIDTH];
+  gboolean clear[2];
+  guint8 mask[MAX_WIDTH];
   int height;
   int width;
   int k;
+  int p;
 
-  height = GST_VIDEO_FRAME_COMP_HEIGHT (top, 0);
-  width = GST_VIDEO_FRAME_COMP_WIDTH (top, 0);
+  height = GST_VIDEO_FRAME_COMP_HEIGHT (tops[0], 0);
+  width = GST_VIDEO_FRAME_COMP_WIDTH (tops[0], 0);
 
-  memset (thisline, 0, sizeof (thisline));
+  for (p = 0; p < n_pairs; p++) {
+    memset (thisline[p], 0, sizeof (thisline[p]));
+    clear[p] = TRUE;
+    scores[p] = 0;
+  }
 
   k = 0;
   /* remove a few lines from top and bottom, as they sometimes contain
    * artifacts */
   for (j = 2; j < height - 2; j++) {
-    guint8 *src1 = GET_LINE_IL (top, bottom, 0, j - 1);
-    guint8 *src2 = GET_LINE_IL (top, bottom, 0, j);
-    guint8 *src3 = GET_LINE_IL (top, bottom, 0, j + 1);
-    int i;
-
-    for (i = 0; i < width; i++) {
-      if (src2[i] < MIN (src1[i], src3[i]) - 5 ||
-          src2[i] > MAX (src1[i], src3[i]) + 5) {
-        if (i > 0) {
-          thisline[i] += thisline[i - 1];
-        }
-        thisline[i]++;
-        if (thisline[i] > 1000)
-          thisline[i] = 1000;
-      } else {
-        thisline[i] = 0;
-      }
-      if (thisline[i] > 100) {
-        score++;
+    for (p = 0; p < n_pairs; p++) {
+      guint8 *src1 = GET_LINE_IL (tops[p], bottoms[p], 0, j - 1);
+      guint8 *src2 = GET_LINE_IL (tops[p], bottoms[p], 0, j);
+      guint8 *src3 = GET_LINE_IL (tops[p], bottoms[p], 0, j + 1);
+
+      if (comb_line (src1, src2, src3, mask, width)) {
+        scores[p] += comb_accumulate (thisline[p], mask, width);
+        clear[p] = FALSE;
+      } else if (!clear[p]) {
+        /* nothing combed, every run ends here */
+        memset (thisline[p], 0, width * sizeof (int));
+        clear[p] = TRUE;
       }
     }
   }
 
-  GST_DEBUG ("score %d", score);
-
-  return score;
+  for (p = 0; p < n_pairs; p++)
+    GST_DEBUG ("score %d", scores[p]);
 }
 
 
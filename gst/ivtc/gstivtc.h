@@ -41,6 +41,9 @@ struct _GstIvtcField
   int parity;
   GstVideoFrame frame;
   GstClockTime ts;
+  /* comb score of this field woven with the following one, or -1 if
+   * not computed yet */
+  int next_score;
 };
 
 #define GST_IVTC_MAX_FIELDS 10
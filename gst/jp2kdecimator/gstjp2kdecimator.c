@@ -61,16 +61,21 @@ enum
 {
   PROP_0,
   PROP_MAX_LAYERS,
-  PROP_MAX_DECOMPOSITION_LEVELS
+  PROP_MAX_DECOMPOSITION_LEVELS,
+  PROP_N_THREADS
 };
 
 #define DEFAULT_MAX_LAYERS (0)
 #define DEFAULT_MAX_DECOMPOSITION_LEVELS (-1)
+#define DEFAULT_N_THREADS (1)
+
+#define MAX_THREADS 64
 
 static void gst_jp2k_decimator_set_property (GObject * object,
     guint prop_id, const GValue * value, GParamSpec * pspec);
 static void gst_jp2k_decimator_get_property (GObject * object,
     guint prop_id, GValue * value, GParamSpec * pspec);
+static void gst_jp2k_decimator_finalize (GObject * object);
 
 static GstFlowReturn gst_jp2k_decimator_sink_chain (GstPad * pad,
     GstObject * parent, GstBuffer * inbuf);
@@ -99,6 +104,7 @@ gst_jp2k_decimator_class_init (GstJP2kDecimatorClass * klass)
 
   gobject_class->set_property = gst_jp2k_decimator_set_property;
   gobject_class->get_property = gst_jp2k_decimator_get_property;
+  gobject_class->finalize = gst_jp2k_decimator_finalize;
 
   g_object_class_install_property (gobject_class, PROP_MAX_LAYERS,
       g_param_spec_int ("max-layers", "Maximum Number of Layers",
@@ -111,6 +117,12 @@ gst_jp2k_decimator_class_init (GstJP2kDecimatorClass * klass)
           "Maximum number of decomposition levels to keep (-1 == all)", -1, 32,
           DEFAULT_MAX_DECOMPOSITION_LEVELS,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      g_param_spec_int ("n-threads", "Number of Threads",
+          "Number of threads used to process the tiles of a frame "
+          "(0 == number of processors)", 0, MAX_THREADS, DEFAULT_N_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 }
 
 static void
@@ -118,6 +130,10 @@ gst_jp2k_decimator_init (GstJP2kDecimator * self)
 {
   self->max_layers = DEFAULT_MAX_LAYERS;
   self->max_decomposition_levels = DEFAULT_MAX_DECOMPOSITION_LEVELS;
+  self->n_threads = DEFAULT_N_THREADS;
+
+  g_mutex_init (&self->lock);
+  g_cond_init (&self->cond);
 
   self->sinkpad = gst_pad_new_from_static_template (&sink_pad_template, "sink");
   GST_PAD_SET_PROXY_CAPS (self->sinkpad);
@@ -145,6 +161,11 @@ gst_jp2k_decimator_set_property (GObject * object,
     case PROP_MAX_DECOMPOSITION_LEVELS:
       self->max_decomposition_levels = g_value_get_int (value);
       break;
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (self);
+      self->n_threads = g_value_get_int (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -164,12 +185,117 @@ gst_jp2k_decimator_get_property (GObject * object,
     case PROP_MAX_DECOMPOSITION_LEVELS:
       g_value_set_int (value, self->max_decomposition_levels);
       break;
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (self);
+      g_value_set_int (value, self->n_threads);
+      GST_OBJECT_UNLOCK (self);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
   }
 }
 
+static void
+gst_jp2k_decimator_finalize (GObject * object)
+{
+  GstJP2kDecimator *self = GST_JP2K_DECIMATOR (object);
+
+  if (self->pool)
+    g_thread_pool_free (self->pool, FALSE, TRUE);
+  self->pool = NULL;
+
+  g_mutex_clear (&self->lock);
+  g_cond_clear (&self->cond);
+
+  G_OBJECT_CLASS (gst_jp2k_decimator_parent_class)->finalize (object);
+}
+
+typedef struct
+{
+  const MainHeader *header;
+  Tile *tile;
+  GstBuffer *inbuf;
+  const guint8 *indata;
+  guint max_memory;
+
+  GstBuffer *outbuf;
+  GstFlowReturn ret;
+} TileJob;
+
+static void
+gst_jp2k_decimator_tile_func (gpointer data, gpointer user_data)
+{
+  GstJP2kDecimator *self = GST_JP2K_DECIMATOR (user_data);
+  TileJob *job = data;
+
+  job->ret = decimate_tile (self, job->header, job->tile, job->inbuf,
+      job->indata, job->max_memory, &job->outbuf);
+
+  g_mutex_lock (&self->lock);
+  if (--self->pending_tiles == 0)
+    g_cond_signal (&self->cond);
+  g_mutex_unlock (&self->lock);
+}
+
+static gint
+gst_jp2k_decimator_get_n_threads (GstJP2kDecimator * self)
+{
+  gint n_threads;
+
+  GST_OBJECT_LOCK (self);
+  n_threads = self->n_threads;
+  GST_OBJECT_UNLOCK (self);
+
+  if (n_threads == 0) {
+#if GLIB_CHECK_VERSION (2, 36, 0)
+    n_threads = g_get_num_processors ();
+#else
+    n_threads = 1;
+#endif
+  }
+
+  return CLAMP (n_threads, 1, MAX_THREADS);
+}
+
+/* Processes all tiles, in parallel if possible, and stores the results in
+ * @jobs in tile order */
+static void
+gst_jp2k_decimator_decimate_tiles (GstJP2kDecimator * self, TileJob * jobs,
+    guint n_jobs)
+{
+  gint n_threads = gst_jp2k_decimator_get_n_threads (self);
+  guint i;
+
+  n_threads = MIN (n_threads, (gint) n_jobs);
+
+  if (n_threads <= 1) {
+    self->pending_tiles = n_jobs;
+    for (i = 0; i < n_jobs; i++)
+      gst_jp2k_decimator_tile_func (&jobs[i], self);
+    return;
+  }
+
+  if (!self->pool) {
+    self->pool = g_thread_pool_new (gst_jp2k_decimator_tile_func, self,
+        n_threads, FALSE, NULL);
+  } else if (g_thread_pool_get_max_threads (self->pool) < n_threads) {
+    g_thread_pool_set_max_threads (self->pool, n_threads, NULL);
+  }
+
+  g_mutex_lock (&self->lock);
+  self->pending_tiles = n_jobs;
+  g_mutex_unlock (&self->lock);
+
+  for (i = 0; i < n_jobs; i++)
+    g_thread_pool_push (self->pool, &jobs[i], NULL);
+
+  g_mutex_lock (&self->lock);
+  while (self->pending_tiles > 0)
+    g_cond_wait (&self->cond, &self->lock);
+  g_mutex_unlock (&self->lock);
+}
+
 static GstFlowReturn
 gst_jp2k_decimator_decimate_jpc (GstJP2kDecimator * self, GstBuffer * inbuf,
     GstBuffer ** outbuf_)
@@ -180,7 +306,9 @@ gst_jp2k_decimator_decimate_jpc (GstJP2kDecimator * self, GstBuffer * inbuf,
   GstByteReader reader;
   GstByteWriter writer;
   MainHeader main_header;
-
+  TileJob *jobs = NULL;
+  guint max_memory;
+  gint i;
 
   if (!gst_buffer_map (inbuf, &info, GST_MAP_READ)) {
     GST_ELEMENT_ERROR (self, STREAM, WRONG_TYPE, ("Unable to map memory"),
@@ -190,7 +318,7 @@ gst_jp2k_decimator_decimate_jpc (GstJP2kDecimator * self, GstBuffer * inbuf,
   }
 
   gst_byte_reader_init (&reader, info.data, info.size);
-  gst_byte_writer_init_with_size (&writer, gst_buffer_get_size (inbuf), FALSE);
+  gst_byte_writer_init_with_size (&writer, 1024, FALSE);
 
   /* main header */
   memset (&main_header, 0, sizeof (MainHeader));
@@ -198,15 +326,74 @@ gst_jp2k_decimator_decimate_jpc (GstJP2kDecimator * self, GstBuffer * inbuf,
   if (ret != GST_FLOW_OK)
     goto done;
 
-  ret = decimate_main_header (self, &main_header);
-  if (ret != GST_FLOW_OK)
-    goto done;
-
   ret = write_main_header (self, &writer, &main_header);
   if (ret != GST_FLOW_OK)
     goto done;
 
-  outbuf = gst_byte_writer_reset_and_get_buffer (&writer);
+  /* tiles, each gets an equal share of the memories of the output buffer.
+   * Two are needed for the main header and EOC. If there are more tiles
+   * than memories left nothing is referenced from the input buffer and the
+   * tiles are copied after the main header instead */
+  if (main_header.n_tiles + 2 <= gst_buffer_get_max_memory ())
+    max_memory =
+        (gst_buffer_get_max_memory () - 2) / MAX (main_header.n_tiles, 1);
+  else
+    max_memory = 0;
+
+  jobs = g_new0 (TileJob, main_header.n_tiles);
+  for (i = 0; i < main_header.n_tiles; i++) {
+    jobs[i].header = &main_header;
+    jobs[i].tile = &main_header.tiles[i];
+    jobs[i].inbuf = inbuf;
+    jobs[i].indata = info.data;
+    jobs[i].max_memory = max_memory;
+  }
+
+  gst_jp2k_decimator_decimate_tiles (self, jobs, main_header.n_tiles);
+
+  for (i = 0; i < main_header.n_tiles; i++) {
+    if (jobs[i].ret != GST_FLOW_OK) {
+      ret = jobs[i].ret;
+      goto done;
+    }
+  }
+
+  if (max_memory == 0) {
+    for (i = 0; i < main_header.n_tiles; i++) {
+      GstMapInfo tile_info;
+      gboolean res;
+
+      gst_buffer_map (jobs[i].outbuf, &tile_info, GST_MAP_READ);
+      res = gst_byte_writer_put_data (&writer, tile_info.data, tile_info.size);
+      gst_buffer_unmap (jobs[i].outbuf, &tile_info);
+      if (!res) {
+        GST_ERROR_OBJECT (self, "Could not ensure free space");
+        ret = GST_FLOW_ERROR;
+        goto done;
+      }
+    }
+
+    ret = write_eoc (self, &writer);
+    if (ret != GST_FLOW_OK)
+      goto done;
+    outbuf = gst_byte_writer_reset_and_get_buffer (&writer);
+  } else {
+    outbuf = gst_byte_writer_reset_and_get_buffer (&writer);
+    for (i = 0; i < main_header.n_tiles; i++) {
+      outbuf = gst_buffer_append (outbuf, jobs[i].outbuf);
+      jobs[i].outbuf = NULL;
+    }
+
+    ret = write_eoc (self, &writer);
+    if (ret != GST_FLOW_OK) {
+      gst_buffer_unref (outbuf);
+      outbuf = NULL;
+      goto done;
+    }
+    outbuf = gst_buffer_append (outbuf,
+        gst_byte_writer_reset_and_get_buffer (&writer));
+  }
+
   gst_buffer_copy_into (outbuf, inbuf, GST_BUFFER_COPY_METADATA, 0, -1);
 
   GST_DEBUG_OBJECT (self,
@@ -217,6 +404,16 @@ gst_jp2k_decimator_decimate_jpc (GstJP2kDecimator * self, GstBuffer * inbuf,
       ((gdouble) gst_buffer_get_size (inbuf)));
 
 done:
+  if (jobs) {
+    for (i = 0; i < main_header.n_tiles; i++) {
+      if (jobs[i].outbuf)
+        gst_buffer_unref (jobs[i].outbuf);
+    }
+    g_free (jobs);
+  }
+  gst_byte_writer_reset (&writer);
+
+  /* the output might reference the input memories, which stay valid */
   gst_buffer_unmap (inbuf, &info);
 
   *outbuf_ = outbuf;
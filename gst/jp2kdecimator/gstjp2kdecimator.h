@@ -43,6 +43,13 @@ struct _GstJP2kDecimator
 
   gint max_layers;
   gint max_decomposition_levels;
+  gint n_threads;
+
+  /* tiles are processed by the pool if there is more than one */
+  GThreadPool *pool;
+  GMutex lock;
+  GCond cond;
+  guint pending_tiles;
 };
 
 struct _GstJP2kDecimatorClass
@@ -24,6 +24,8 @@
 
 #include "jp2kcodestream.h"
 
+#include <string.h>
+
 GST_DEBUG_CATEGORY_EXTERN (gst_jp2k_decimator_debug);
 #define GST_CAT_DEFAULT gst_jp2k_decimator_debug
 
@@ -1315,44 +1317,140 @@ write_marker_buffer (GstJP2kDecimator * self, GstByteWriter * writer,
   return GST_FLOW_OK;
 }
 
-static GstFlowReturn
-write_packet (GstJP2kDecimator * self, GstByteWriter * writer,
-    const Packet * packet)
+/* Packet data is referenced from the input buffer instead of copied if
+ * it consists of long runs of unchanged input data. Everything else is
+ * written into the byte writer */
+#define MIN_REFERENCE_SIZE 4096
+
+typedef struct
+{
+  GstBuffer *inbuf;
+  const guint8 *indata;
+  guint max_memory;
+
+  GstBuffer *outbuf;
+  GstByteWriter writer;
+
+  /* pending run of input data */
+  const guint8 *run;
+  guint run_length;
+} TileWriter;
+
+static void
+tile_writer_flush_writer (TileWriter * tw)
 {
-  guint size = packet->length;
+  guint size = gst_byte_writer_get_size (&tw->writer);
+  guint8 *data;
 
-  if (packet->sop)
-    size += 6;
-  if (packet->eph && !packet->data)
-    size += 2;
+  if (size == 0)
+    return;
 
-  if (!gst_byte_writer_ensure_free_space (writer, size)) {
+  data = gst_byte_writer_reset_and_get_data (&tw->writer);
+  gst_buffer_append_memory (tw->outbuf,
+      gst_memory_new_wrapped (0, data, size, 0, size, data, g_free));
+}
+
+static GstFlowReturn
+tile_writer_flush_run (GstJP2kDecimator * self, TileWriter * tw)
+{
+  if (tw->run_length == 0)
+    return GST_FLOW_OK;
+
+  /* One memory for the data written so far, the memories of the
+   * referenced input and one for the data written after them */
+  if (tw->run_length >= MIN_REFERENCE_SIZE
+      && gst_buffer_n_memory (tw->outbuf) + 1 +
+      gst_buffer_n_memory (tw->inbuf) + 1 <= tw->max_memory) {
+    tile_writer_flush_writer (tw);
+    gst_buffer_copy_into (tw->outbuf, tw->inbuf, GST_BUFFER_COPY_MEMORY,
+        tw->run - tw->indata, tw->run_length);
+  } else if (!gst_byte_writer_put_data (&tw->writer, tw->run,
+          tw->run_length)) {
     GST_ERROR_OBJECT (self, "Could not ensure free space");
     return GST_FLOW_ERROR;
   }
 
-  if (packet->sop) {
-    gst_byte_writer_put_uint16_be_unchecked (writer, MARKER_SOP);
-    gst_byte_writer_put_uint16_be_unchecked (writer, 4);
-    gst_byte_writer_put_uint16_be_unchecked (writer, packet->seqno);
+  tw->run = NULL;
+  tw->run_length = 0;
+
+  return GST_FLOW_OK;
+}
+
+static GstFlowReturn
+tile_writer_put_run (GstJP2kDecimator * self, TileWriter * tw,
+    const guint8 * data, guint length)
+{
+  GstFlowReturn ret;
+
+  if (tw->run && tw->run + tw->run_length == data) {
+    tw->run_length += length;
+    return GST_FLOW_OK;
   }
 
-  if (packet->data) {
-    gst_byte_writer_put_data_unchecked (writer, packet->data, packet->length);
-  } else {
-    gst_byte_writer_put_uint8_unchecked (writer, 0);
-    if (packet->eph) {
-      gst_byte_writer_put_uint16_be_unchecked (writer, MARKER_EPH);
+  ret = tile_writer_flush_run (self, tw);
+  tw->run = data;
+  tw->run_length = length;
+
+  return ret;
+}
+
+static GstFlowReturn
+write_packet (GstJP2kDecimator * self, TileWriter * tw, const Packet * packet)
+{
+  GstByteWriter *writer = &tw->writer;
+  const guint8 *data = packet->data;
+  guint length = packet->length;
+  GstFlowReturn ret;
+
+  if (packet->sop) {
+    guint8 sop[6];
+
+    GST_WRITE_UINT16_BE (sop, MARKER_SOP);
+    GST_WRITE_UINT16_BE (sop + 2, 4);
+    GST_WRITE_UINT16_BE (sop + 4, packet->seqno);
+
+    /* The input packet starts with the same SOP marker segment, keep it
+     * as part of the run */
+    if (data && memcmp (data - 6, sop, 6) == 0) {
+      data -= 6;
+      length += 6;
+    } else {
+      ret = tile_writer_flush_run (self, tw);
+      if (ret != GST_FLOW_OK)
+        return ret;
+
+      if (!gst_byte_writer_put_data (writer, sop, 6)) {
+        GST_ERROR_OBJECT (self, "Could not ensure free space");
+        return GST_FLOW_ERROR;
+      }
     }
   }
 
+  if (data)
+    return tile_writer_put_run (self, tw, data, length);
+
+  ret = tile_writer_flush_run (self, tw);
+  if (ret != GST_FLOW_OK)
+    return ret;
+
+  if (!gst_byte_writer_ensure_free_space (writer, 3)) {
+    GST_ERROR_OBJECT (self, "Could not ensure free space");
+    return GST_FLOW_ERROR;
+  }
+
+  gst_byte_writer_put_uint8_unchecked (writer, 0);
+  if (packet->eph) {
+    gst_byte_writer_put_uint16_be_unchecked (writer, MARKER_EPH);
+  }
+
   return GST_FLOW_OK;
 }
 
 static GstFlowReturn
-write_tile (GstJP2kDecimator * self, GstByteWriter * writer,
+write_tile (GstJP2kDecimator * self, TileWriter * tw,
     const MainHeader * header, Tile * tile)
 {
+  GstByteWriter *writer = &tw->writer;
   GList *l;
   GstFlowReturn ret = GST_FLOW_OK;
 
@@ -1414,11 +1512,13 @@ write_tile (GstJP2kDecimator * self, GstByteWriter * writer,
   for (l = tile->packets; l; l = l->next) {
     Packet *p = l->data;
 
-    ret = write_packet (self, writer, p);
+    ret = write_packet (self, tw, p);
     if (ret != GST_FLOW_OK)
       goto done;
   }
 
+  ret = tile_writer_flush_run (self, tw);
+
 done:
 
   return ret;
@@ -1596,14 +1696,41 @@ parse_main_header (GstJP2kDecimator * self, GstByteReader * reader,
 
   header->tiles = g_slice_alloc0 (sizeof (Tile) * header->n_tiles);
 
-  /* now at SOT marker, read the tiles */
+  /* now at SOT marker, locate the tile parts. They are parsed later
+   * and independent of each other */
   {
     gint i;
 
     for (i = 0; i < header->n_tiles; i++) {
-      ret = parse_tile (self, reader, header, &header->tiles[i]);
-      if (ret != GST_FLOW_OK)
+      Tile *tile = &header->tiles[i];
+      guint remaining = gst_byte_reader_get_remaining (reader);
+      guint32 tile_part_size;
+
+      if (remaining < 12 || !gst_byte_reader_peek_uint16_be (reader, &marker)
+          || marker != MARKER_SOT) {
+        GST_ERROR_OBJECT (self, "No SOT marker for tile %d", i);
+        ret = GST_FLOW_ERROR;
+        goto done;
+      }
+
+      tile_part_size =
+          GST_READ_UINT32_BE (gst_byte_reader_peek_data_unchecked (reader) + 6);
+
+      /* 0 means that the last tile part extends until the EOC marker */
+      if (tile_part_size == 0 && i == header->n_tiles - 1)
+        tile_part_size = remaining - 2;
+
+      /* Each tile part is followed by another SOT or the EOC marker */
+      if (tile_part_size < 12 || tile_part_size > remaining - 2) {
+        GST_ERROR_OBJECT (self, "Invalid tile part size %u (available %u)",
+            tile_part_size, remaining);
+        ret = GST_FLOW_ERROR;
         goto done;
+      }
+
+      tile->data = gst_byte_reader_peek_data_unchecked (reader);
+      tile->length = tile_part_size;
+      gst_byte_reader_skip_unchecked (reader, tile_part_size);
     }
   }
 
@@ -1693,7 +1820,6 @@ write_main_header (GstJP2kDecimator * self, GstByteWriter * writer,
 {
   GstFlowReturn ret = GST_FLOW_OK;
   GList *l;
-  gint i;
 
   if (!gst_byte_writer_ensure_free_space (writer, 2)) {
     GST_ERROR_OBJECT (self, "Could not ensure free space");
@@ -1738,84 +1864,127 @@ write_main_header (GstJP2kDecimator * self, GstByteWriter * writer,
       goto done;
   }
 
-  for (i = 0; i < header->n_tiles; i++) {
-    ret = write_tile (self, writer, header, &header->tiles[i]);
-    if (ret != GST_FLOW_OK)
-      goto done;
-  }
+done:
+  return ret;
+}
 
-  if (!gst_byte_writer_ensure_free_space (writer, 2)) {
+GstFlowReturn
+write_eoc (GstJP2kDecimator * self, GstByteWriter * writer)
+{
+  if (!gst_byte_writer_put_uint16_be (writer, MARKER_EOC)) {
     GST_ERROR_OBJECT (self, "Could not ensure free space");
-    ret = GST_FLOW_ERROR;
-    goto done;
+    return GST_FLOW_ERROR;
   }
-  gst_byte_writer_put_uint16_be_unchecked (writer, MARKER_EOC);
 
-done:
-  return ret;
+  return GST_FLOW_OK;
 }
 
-GstFlowReturn
-decimate_main_header (GstJP2kDecimator * self, MainHeader * header)
+static GstFlowReturn
+decimate_packets (GstJP2kDecimator * self, const MainHeader * header,
+    Tile * tile)
 {
   GstFlowReturn ret = GST_FLOW_OK;
-  gint i;
+  GList *l;
+  PacketIterator it;
+  PacketLengthTilePart *plt = NULL;
 
-  for (i = 0; i < header->n_tiles; i++) {
-    Tile *tile = &header->tiles[i];
-    GList *l;
-    PacketIterator it;
-    PacketLengthTilePart *plt = NULL;
-
-    if (tile->plt) {
-      if (g_list_length (tile->plt) > 1) {
-        GST_ERROR_OBJECT (self, "Multiple PLT per tile not supported yet");
-        ret = GST_FLOW_ERROR;
-        goto done;
-      }
-      plt = g_slice_new (PacketLengthTilePart);
-      plt->index = 0;
-      plt->packet_lengths = g_array_new (FALSE, FALSE, sizeof (guint32));
+  if (tile->plt) {
+    if (g_list_length (tile->plt) > 1) {
+      GST_ERROR_OBJECT (self, "Multiple PLT per tile not supported yet");
+      ret = GST_FLOW_ERROR;
+      goto done;
     }
+    plt = g_slice_new (PacketLengthTilePart);
+    plt->index = 0;
+    plt->packet_lengths = g_array_new (FALSE, FALSE, sizeof (guint32));
+  }
 
-    init_packet_iterator (self, &it, header, tile);
-
-    l = tile->packets;
-    while ((it.next (&it))) {
-      Packet *p;
-
-      if (l == NULL) {
-        GST_ERROR_OBJECT (self, "Not enough packets");
-        ret = GST_FLOW_ERROR;
-        goto done;
-      }
+  init_packet_iterator (self, &it, header, tile);
 
-      p = l->data;
+  l = tile->packets;
+  while ((it.next (&it))) {
+    Packet *p;
 
-      if ((self->max_layers != 0 && it.cur_layer >= self->max_layers) ||
-          (self->max_decomposition_levels != -1
-              && it.cur_resolution > self->max_decomposition_levels)) {
-        p->data = NULL;
-        p->length = 1;
-      }
+    if (l == NULL) {
+      GST_ERROR_OBJECT (self, "Not enough packets");
+      ret = GST_FLOW_ERROR;
+      goto done;
+    }
 
-      if (plt) {
-        guint32 len = sizeof_packet (self, p);
-        g_array_append_val (plt->packet_lengths, len);
-      }
+    p = l->data;
 
-      l = l->next;
+    if ((self->max_layers != 0 && it.cur_layer >= self->max_layers) ||
+        (self->max_decomposition_levels != -1
+            && it.cur_resolution > self->max_decomposition_levels)) {
+      p->data = NULL;
+      p->length = 1;
     }
 
     if (plt) {
-      reset_plt (self, tile->plt->data);
-      g_slice_free (PacketLengthTilePart, tile->plt->data);
-      tile->plt->data = plt;
+      guint32 len = sizeof_packet (self, p);
+      g_array_append_val (plt->packet_lengths, len);
     }
 
-    tile->sot.tile_part_size = sizeof_tile (self, tile);
+    l = l->next;
+  }
+
+  if (plt) {
+    reset_plt (self, tile->plt->data);
+    g_slice_free (PacketLengthTilePart, tile->plt->data);
+    tile->plt->data = plt;
+    plt = NULL;
   }
 
+  tile->sot.tile_part_size = sizeof_tile (self, tile);
+
 done:
+  if (plt) {
+    reset_plt (self, plt);
+    g_slice_free (PacketLengthTilePart, plt);
+  }
+
   return ret;
 }
+
+GstFlowReturn
+decimate_tile (GstJP2kDecimator * self, const MainHeader * header,
+    Tile * tile, GstBuffer * inbuf, const guint8 * indata, guint max_memory,
+    GstBuffer ** outbuf)
+{
+  GstFlowReturn ret = GST_FLOW_OK;
+  GstByteReader reader;
+  TileWriter tw;
+
+  *outbuf = NULL;
+
+  /* Include the following marker, it terminates the last packet if the
+   * packet lengths are not known */
+  gst_byte_reader_init (&reader, tile->data, tile->length + 2);
+
+  ret = parse_tile (self, &reader, header, tile);
+  if (ret != GST_FLOW_OK)
+    return ret;
+
+  ret = decimate_packets (self, header, tile);
+  if (ret != GST_FLOW_OK)
+    return ret;
+
+  memset (&tw, 0, sizeof (TileWriter));
+  tw.inbuf = inbuf;
+  tw.indata = indata;
+  tw.max_memory = max_memory;
+  tw.outbuf = gst_buffer_new ();
+  gst_byte_writer_init_with_size (&tw.writer, 1024, FALSE);
+
+  ret = write_tile (self, &tw, header, tile);
+  if (ret != GST_FLOW_OK) {
+    gst_byte_writer_reset (&tw.writer);
+    gst_buffer_unref (tw.outbuf);
+    return ret;
+  }
+
+  tile_writer_flush_writer (&tw);
+  *outbuf = tw.outbuf;
+
+  return GST_FLOW_OK;
+}
@@ -129,6 +129,10 @@ typedef struct
 
   /* TODO: COC, PPT */
 
+  /* Location of the tile part in the input */
+  const guint8 *data;
+  guint length;
+
   /* Calculated value */
   gint tile_x, tile_y;
   gint tx0, tx1, ty0, ty1;      /* tile dimensions */
@@ -188,6 +192,10 @@ GstFlowReturn parse_main_header (GstJP2kDecimator * self, GstByteReader * reader
 guint sizeof_main_header (GstJP2kDecimator * self, const MainHeader * header);
 void reset_main_header (GstJP2kDecimator * self, MainHeader * header);
 GstFlowReturn write_main_header (GstJP2kDecimator * self, GstByteWriter * writer, const MainHeader * header);
-GstFlowReturn decimate_main_header (GstJP2kDecimator * self, MainHeader * header);
+GstFlowReturn write_eoc (GstJP2kDecimator * self, GstByteWriter * writer);
+
+/* Parses, decimates and writes a single tile. Tiles are independent of each
+ * other and can be processed from different threads */
+GstFlowReturn decimate_tile (GstJP2kDecimator * self, const MainHeader * header, Tile * tile, GstBuffer * inbuf, const guint8 * indata, guint max_memory, GstBuffer ** outbuf);
 
 #endif /* __JP2K_CODESTREAM_H__ */
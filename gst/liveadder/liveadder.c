@@ -34,6 +34,8 @@
  *
  * Unlike the adder, the liveadder mixes the streams according the their
  * timestamps and waits for some milli-seconds before trying doing the mixing.
+ * Incoming data is mixed into a ring of fixed 10ms output periods which are
+ * pushed out one after the other.
  *
  * Last reviewed on 2008-02-10 (0.10.11)
  */
@@ -50,6 +52,11 @@
 
 #define DEFAULT_LATENCY_MS 60
 
+/* duration of one slot of the accumulation ring */
+#define RING_PERIOD_MS 10
+/* slots kept on top of twice the total latency to absorb jitter */
+#define RING_EXTRA_SLOTS 8
+
 GST_DEBUG_CATEGORY_STATIC (live_adder_debug);
 #define GST_CAT_DEFAULT (live_adder_debug)
 
@@ -130,6 +137,8 @@ static gboolean gst_live_adder_sink_event (GstPad * pad, GstObject * parent,
 
 
 static void reset_pad_private (GstPad * pad);
+static void gst_live_adder_clear_ring_locked (GstLiveAdder * adder);
+static void gst_live_adder_update_ring_locked (GstLiveAdder * adder);
 
 /* clipping versions */
 #define MAKE_FUNC(name,type,ttype,min,max)                      \
@@ -207,12 +216,11 @@ gst_live_adder_init (GstLiveAdder * adder)
   adder->padcount = 0;
   adder->func = NULL;
   g_cond_init (&adder->not_empty_cond);
+  g_cond_init (&adder->not_full_cond);
 
   adder->next_timestamp = GST_CLOCK_TIME_NONE;
 
   adder->latency_ms = DEFAULT_LATENCY_MS;
-
-  adder->buffers = g_queue_new ();
 }
 
 
@@ -222,11 +230,10 @@ gst_live_adder_finalize (GObject * object)
   GstLiveAdder *adder = GST_LIVE_ADDER (object);
 
   g_cond_clear (&adder->not_empty_cond);
+  g_cond_clear (&adder->not_full_cond);
 
-  g_queue_foreach (adder->buffers, (GFunc) gst_mini_object_unref, NULL);
-  while (g_queue_pop_head (adder->buffers)) {
-  }
-  g_queue_free (adder->buffers);
+  gst_live_adder_clear_ring_locked (adder);
+  g_free (adder->slots);
 
   g_list_free (adder->sinkpads);
 
@@ -250,6 +257,7 @@ gst_live_adder_set_property (GObject * object,
       GST_OBJECT_LOCK (adder);
       old_latency = adder->latency_ms;
       adder->latency_ms = new_latency;
+      gst_live_adder_update_ring_locked (adder);
       GST_OBJECT_UNLOCK (adder);
 
       /* post message if latency changed, this will inform the parent pipeline
@@ -360,6 +368,7 @@ gst_live_adder_setcaps (GstLiveAdder * adder, GstPad * pad, GstCaps * caps)
 {
   GstIterator *iter;
   struct SetCapsIterCtx ctx;
+  gint old_rate, old_bpf;
 
   GST_LOG_OBJECT (adder, "setting caps on pad %p,%s to %" GST_PTR_FORMAT, pad,
       GST_PAD_NAME (pad), caps);
@@ -399,6 +408,9 @@ gst_live_adder_setcaps (GstLiveAdder * adder, GstPad * pad, GstCaps * caps)
   }
 
   GST_OBJECT_LOCK (adder);
+  old_rate = GST_AUDIO_INFO_RATE (&adder->info);
+  old_bpf = GST_AUDIO_INFO_BPF (&adder->info);
+
   /* parse caps now */
   if (!gst_audio_info_from_caps (&adder->info, caps))
     goto not_supported;
@@ -437,6 +449,15 @@ gst_live_adder_setcaps (GstLiveAdder * adder, GstPad * pad, GstCaps * caps)
     goto not_supported;
   }
 
+  /* the data in the ring is in the old format, it can't be mixed anymore */
+  if (old_rate != GST_AUDIO_INFO_RATE (&adder->info) ||
+      old_bpf != GST_AUDIO_INFO_BPF (&adder->info)) {
+    gst_live_adder_clear_ring_locked (adder);
+    adder->period_samples =
+        MAX (1, GST_AUDIO_INFO_RATE (&adder->info) * RING_PERIOD_MS / 1000);
+  }
+  gst_live_adder_update_ring_locked (adder);
+
   GST_OBJECT_UNLOCK (adder);
   return TRUE;
 
@@ -458,9 +479,8 @@ gst_live_adder_flush_start (GstLiveAdder * adder)
   /* mark ourselves as flushing */
   adder->srcresult = GST_FLOW_FLUSHING;
 
-  /* Empty the queue */
-  g_queue_foreach (adder->buffers, (GFunc) gst_mini_object_unref, NULL);
-  while (g_queue_pop_head (adder->buffers));
+  /* Empty the ring */
+  gst_live_adder_clear_ring_locked (adder);
 
   /* unlock clock, we just unschedule, the entry will be released by the
    * locking streaming thread. */
@@ -468,6 +488,7 @@ gst_live_adder_flush_start (GstLiveAdder * adder)
     gst_clock_id_unschedule (adder->clock_id);
 
   g_cond_broadcast (&adder->not_empty_cond);
+  g_cond_broadcast (&adder->not_full_cond);
   GST_OBJECT_UNLOCK (adder);
 }
 
@@ -783,6 +804,7 @@ gst_live_adder_src_query (GstPad * pad, GstObject * parent, GstQuery * query)
         GstClockTime my_latency = adder->latency_ms * GST_MSECOND;
         GST_OBJECT_LOCK (adder);
         adder->peer_latency = min_latency;
+        gst_live_adder_update_ring_locked (adder);
         min_latency += my_latency;
         GST_OBJECT_UNLOCK (adder);
 
@@ -914,15 +936,185 @@ gst_live_adder_src_event (GstPad * pad, GstObject * parent, GstEvent * event)
   return result;
 }
 
-static guint
-gst_live_adder_length_from_duration (GstLiveAdder * adder,
-    GstClockTime duration)
+static GstClockTime
+gst_live_adder_pos_to_time (GstLiveAdder * adder, guint64 pos)
+{
+  return gst_util_uint64_scale_int (pos, GST_SECOND,
+      GST_AUDIO_INFO_RATE (&adder->info));
+}
+
+static GstLiveAdderSlot *
+gst_live_adder_get_slot (GstLiveAdder * adder, guint64 period)
+{
+  return &adder->slots[period % adder->n_slots];
+}
+
+/* sample position of the first data in the ring, the ring must not be
+ * empty */
+static guint64
+gst_live_adder_head_pos (GstLiveAdder * adder)
+{
+  GstLiveAdderSlot *slot = gst_live_adder_get_slot (adder, adder->ring_first);
+
+  return adder->ring_first * adder->period_samples + slot->start;
+}
+
+static void
+gst_live_adder_clear_ring_locked (GstLiveAdder * adder)
+{
+  guint i;
+
+  for (i = 0; i < adder->n_slots; i++)
+    gst_buffer_replace (&adder->slots[i].buffer, NULL);
+
+  adder->ring_first = adder->ring_end = 0;
+}
+
+/* Sizes the ring for twice the total latency, data that is not released yet
+ * is moved to its slot in the new ring */
+static void
+gst_live_adder_update_ring_locked (GstLiveAdder * adder)
+{
+  GstLiveAdderSlot *slots;
+  GstClockTime period_time;
+  guint64 period;
+  guint n_slots;
+
+  if (adder->period_samples == 0)
+    return;
+
+  period_time = gst_live_adder_pos_to_time (adder, adder->period_samples);
+  n_slots = 2 * (adder->latency_ms * GST_MSECOND + adder->peer_latency) /
+      period_time + RING_EXTRA_SLOTS;
+  n_slots = MAX (n_slots, adder->ring_end - adder->ring_first);
+
+  if (n_slots == adder->n_slots)
+    return;
+
+  GST_DEBUG_OBJECT (adder, "using %u slots of %u samples", n_slots,
+      adder->period_samples);
+
+  slots = g_new0 (GstLiveAdderSlot, n_slots);
+  for (period = adder->ring_first; period < adder->ring_end; period++)
+    slots[period % n_slots] = *gst_live_adder_get_slot (adder, period);
+
+  g_free (adder->slots);
+  adder->slots = slots;
+  adder->n_slots = n_slots;
+
+  g_cond_broadcast (&adder->not_full_cond);
+}
+
+/* Makes @period part of the ring, returns FALSE if it doesn't fit before some
+ * data is released */
+static gboolean
+gst_live_adder_reserve_slot_locked (GstLiveAdder * adder, guint64 period)
+{
+  if (adder->ring_first == adder->ring_end) {
+    adder->ring_first = period;
+    adder->ring_end = period + 1;
+  } else if (period < adder->ring_first) {
+    if (adder->ring_end - period > adder->n_slots)
+      return FALSE;
+    adder->ring_first = period;
+  } else if (period >= adder->ring_end) {
+    if (period + 1 - adder->ring_first > adder->n_slots)
+      return FALSE;
+    adder->ring_end = period + 1;
+  }
+
+  return TRUE;
+}
+
+/* Adds @len samples to @slot starting at sample @offset of the period. Parts
+ * that don't overlap the data already in the slot are copied, holes between
+ * them are filled with silence. */
+static void
+gst_live_adder_mix_slot (GstLiveAdder * adder, GstLiveAdderSlot * slot,
+    guint offset, const guint8 * data, guint len)
+{
+  guint bpf = GST_AUDIO_INFO_BPF (&adder->info);
+  guint end = offset + len;
+  guint mix_start, mix_end;
+  GstMapInfo map;
+
+  if (slot->buffer == NULL) {
+    slot->buffer =
+        gst_buffer_new_allocate (NULL, adder->period_samples * bpf, NULL);
+    gst_buffer_fill (slot->buffer, offset * bpf, data, len * bpf);
+    slot->start = offset;
+    slot->end = end;
+    return;
+  }
+
+  gst_buffer_map (slot->buffer, &map, GST_MAP_WRITE);
+
+  if (end < slot->start)
+    gst_audio_format_fill_silence (adder->info.finfo, map.data + end * bpf,
+        (slot->start - end) * bpf);
+  else if (offset > slot->end)
+    gst_audio_format_fill_silence (adder->info.finfo,
+        map.data + slot->end * bpf, (offset - slot->end) * bpf);
+
+  if (offset < slot->start)
+    memcpy (map.data + offset * bpf, data,
+        (MIN (end, slot->start) - offset) * bpf);
+
+  if (end > slot->end) {
+    guint copy_start = MAX (offset, slot->end);
+
+    memcpy (map.data + copy_start * bpf, data + (copy_start - offset) * bpf,
+        (end - copy_start) * bpf);
+  }
+
+  mix_start = MAX (offset, slot->start);
+  mix_end = MIN (end, slot->end);
+  if (mix_start < mix_end)
+    adder->func (map.data + mix_start * bpf,
+        (gpointer) (data + (mix_start - offset) * bpf),
+        (mix_end - mix_start) * bpf);
+
+  gst_buffer_unmap (slot->buffer, &map);
+
+  slot->start = MIN (slot->start, offset);
+  slot->end = MAX (slot->end, end);
+}
+
+/* Takes the data of the first slot of the ring as an output buffer, the ring
+ * must not be empty */
+static GstBuffer *
+gst_live_adder_pop_slot_locked (GstLiveAdder * adder)
 {
-  guint64 ret = GST_AUDIO_INFO_BPF (&adder->info) *
-      gst_util_uint64_scale_int_round (duration,
-      GST_AUDIO_INFO_RATE (&adder->info), GST_SECOND);
+  GstLiveAdderSlot *slot = gst_live_adder_get_slot (adder, adder->ring_first);
+  guint bpf = GST_AUDIO_INFO_BPF (&adder->info);
+  guint64 start, end;
+  GstBuffer *buffer;
+
+  start = adder->ring_first * adder->period_samples + slot->start;
+  end = adder->ring_first * adder->period_samples + slot->end;
+
+  buffer = slot->buffer;
+  slot->buffer = NULL;
+
+  if (slot->start != 0 || slot->end != adder->period_samples)
+    gst_buffer_resize (buffer, slot->start * bpf,
+        (slot->end - slot->start) * bpf);
+
+  GST_BUFFER_TIMESTAMP (buffer) = gst_live_adder_pos_to_time (adder, start);
+  GST_BUFFER_DURATION (buffer) = gst_live_adder_pos_to_time (adder, end) -
+      GST_BUFFER_TIMESTAMP (buffer);
+
+  adder->released_pos = end;
+
+  /* skip to the next period that holds data */
+  do {
+    adder->ring_first++;
+  } while (adder->ring_first < adder->ring_end &&
+      gst_live_adder_get_slot (adder, adder->ring_first)->buffer == NULL);
 
-  return (guint) ret;
+  g_cond_broadcast (&adder->not_full_cond);
+
+  return buffer;
 }
 
 static GstFlowReturn
@@ -931,8 +1123,10 @@ gst_live_live_adder_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
   GstLiveAdder *adder = GST_LIVE_ADDER (parent);
   GstLiveAdderPadPrivate *padprivate = NULL;
   GstFlowReturn ret = GST_FLOW_OK;
-  GList *item = NULL;
-  GstClockTime skip = 0;
+  guint64 skip = 0;
+  guint64 pos, n_samples;
+  gint rate, bpf;
+  GstMapInfo map;
   gint64 drift = 0;             /* Positive if new buffer after old buffer */
 
   GST_OBJECT_LOCK (adder);
@@ -968,6 +1162,9 @@ gst_live_live_adder_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
   if (!GST_BUFFER_TIMESTAMP_IS_VALID (buffer))
     goto invalid_timestamp;
 
+  if (adder->n_slots == 0)
+    goto not_negotiated;
+
   if (padprivate->segment.format == GST_FORMAT_UNDEFINED) {
     GST_WARNING_OBJECT (adder, "No new-segment received,"
         " initializing segment with time 0..-1");
@@ -1033,8 +1230,13 @@ gst_live_live_adder_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
       padprivate->segment.format, GST_BUFFER_TIMESTAMP (buffer));
 
 
+  rate = GST_AUDIO_INFO_RATE (&adder->info);
+  bpf = GST_AUDIO_INFO_BPF (&adder->info);
+  pos = gst_util_uint64_scale_int_round (GST_BUFFER_TIMESTAMP (buffer), rate,
+      GST_SECOND);
+
   if (GST_CLOCK_TIME_IS_VALID (adder->next_timestamp) &&
-      GST_BUFFER_TIMESTAMP (buffer) < adder->next_timestamp) {
+      pos < adder->released_pos) {
     if (GST_BUFFER_TIMESTAMP (buffer) + GST_BUFFER_DURATION (buffer) <
         adder->next_timestamp) {
       GST_DEBUG_OBJECT (adder, "Buffer is late, dropping (ts: %" GST_TIME_FORMAT
@@ -1044,113 +1246,54 @@ gst_live_live_adder_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
       gst_buffer_unref (buffer);
       goto out;
     } else {
-      skip = adder->next_timestamp - GST_BUFFER_TIMESTAMP (buffer);
+      skip = adder->released_pos - pos;
       GST_DEBUG_OBJECT (adder, "Buffer is partially late, skipping %"
-          GST_TIME_FORMAT, GST_TIME_ARGS (skip));
+          G_GUINT64_FORMAT " samples", skip);
     }
   }
 
-  /* If our new buffer's head is higher than the queue's head, lets wake up,
-   * we may not have to wait for as long
-   */
-  if (adder->clock_id &&
-      g_queue_peek_head (adder->buffers) != NULL &&
-      GST_BUFFER_TIMESTAMP (buffer) + skip <
-      GST_BUFFER_TIMESTAMP (g_queue_peek_head (adder->buffers)))
-    gst_clock_id_unschedule (adder->clock_id);
-
-  for (item = g_queue_peek_head_link (adder->buffers);
-      item; item = g_list_next (item)) {
-    GstBuffer *oldbuffer = item->data;
-    GstClockTime old_skip = 0;
-    GstClockTime mix_duration = 0;
-    GstClockTime mix_start = 0;
-    GstClockTime mix_end = 0;
-    GstMapInfo oldmap, map;
-
-    /* We haven't reached our place yet */
-    if (GST_BUFFER_TIMESTAMP (buffer) + skip >=
-        GST_BUFFER_TIMESTAMP (oldbuffer) + GST_BUFFER_DURATION (oldbuffer))
-      continue;
-
-    /* We're past our place, lets insert ouselves here */
-    if (GST_BUFFER_TIMESTAMP (buffer) + GST_BUFFER_DURATION (buffer) <=
-        GST_BUFFER_TIMESTAMP (oldbuffer))
-      break;
-
-    /* if we reach this spot, we have overlap, so we must mix */
-
-    /* First make a subbuffer with the non-overlapping part */
-    if (GST_BUFFER_TIMESTAMP (buffer) + skip < GST_BUFFER_TIMESTAMP (oldbuffer)) {
-      GstBuffer *subbuffer = NULL;
-      GstClockTime subbuffer_duration = GST_BUFFER_TIMESTAMP (oldbuffer) -
-          (GST_BUFFER_TIMESTAMP (buffer) + skip);
-
-      subbuffer = gst_buffer_copy_region (buffer, GST_BUFFER_COPY_ALL,
-          gst_live_adder_length_from_duration (adder, skip),
-          gst_live_adder_length_from_duration (adder, subbuffer_duration));
-
-      GST_BUFFER_TIMESTAMP (subbuffer) = GST_BUFFER_TIMESTAMP (buffer) + skip;
-      GST_BUFFER_DURATION (subbuffer) = subbuffer_duration;
+  gst_buffer_map (buffer, &map, GST_MAP_READ);
+  n_samples = map.size / bpf;
 
-      skip += subbuffer_duration;
+  while (skip < n_samples) {
+    guint64 cur = pos + skip;
+    guint64 period = cur / adder->period_samples;
+    guint offset = cur % adder->period_samples;
+    guint len = MIN (adder->period_samples - offset, n_samples - skip);
 
-      g_queue_insert_before (adder->buffers, item, subbuffer);
+    /* the loop may have pushed past us while we were waiting for room */
+    if (GST_CLOCK_TIME_IS_VALID (adder->next_timestamp) &&
+        cur < adder->released_pos) {
+      skip = MIN (adder->released_pos - pos, n_samples);
+      continue;
     }
 
-    /* Now we are on the overlapping part */
-    oldbuffer = gst_buffer_make_writable (oldbuffer);
-    item->data = oldbuffer;
-
-    old_skip = GST_BUFFER_TIMESTAMP (buffer) + skip -
-        GST_BUFFER_TIMESTAMP (oldbuffer);
-
-    mix_start = GST_BUFFER_TIMESTAMP (oldbuffer) + old_skip;
+    /* If our data comes before the ring's head, lets wake up, we may not
+     * have to wait for as long */
+    if (adder->clock_id && adder->ring_first != adder->ring_end &&
+        cur < gst_live_adder_head_pos (adder))
+      gst_clock_id_unschedule (adder->clock_id);
+
+    if (!gst_live_adder_reserve_slot_locked (adder, period)) {
+      GST_LOG_OBJECT (adder, "Ring is full, waiting for data to be pushed");
+      g_cond_broadcast (&adder->not_empty_cond);
+      g_cond_wait (&adder->not_full_cond, GST_OBJECT_GET_LOCK (adder));
+      if (adder->srcresult != GST_FLOW_OK) {
+        ret = adder->srcresult;
+        break;
+      }
+      continue;
+    }
 
-    if (GST_BUFFER_TIMESTAMP (buffer) + GST_BUFFER_DURATION (buffer) <
-        GST_BUFFER_TIMESTAMP (oldbuffer) + GST_BUFFER_DURATION (oldbuffer))
-      mix_end = GST_BUFFER_TIMESTAMP (buffer) + GST_BUFFER_DURATION (buffer);
-    else
-      mix_end = GST_BUFFER_TIMESTAMP (oldbuffer) +
-          GST_BUFFER_DURATION (oldbuffer);
-
-    mix_duration = mix_end - mix_start;
-
-    gst_buffer_map (oldbuffer, &oldmap, GST_MAP_WRITE);
-    gst_buffer_map (buffer, &map, GST_MAP_READ);
-    adder->func (oldmap.data +
-        gst_live_adder_length_from_duration (adder, old_skip),
-        map.data +
-        gst_live_adder_length_from_duration (adder, skip),
-        gst_live_adder_length_from_duration (adder, mix_duration));
-    gst_buffer_unmap (oldbuffer, &oldmap);
-    gst_buffer_unmap (buffer, &map);
-    skip += mix_duration;
+    gst_live_adder_mix_slot (adder, gst_live_adder_get_slot (adder, period),
+        offset, map.data + skip * bpf, len);
+    skip += len;
   }
 
-  g_cond_broadcast (&adder->not_empty_cond);
-
-  if (skip == GST_BUFFER_DURATION (buffer)) {
-    gst_buffer_unref (buffer);
-  } else {
-    if (skip) {
-      GstClockTime subbuffer_duration = GST_BUFFER_DURATION (buffer) - skip;
-      GstClockTime subbuffer_ts = GST_BUFFER_TIMESTAMP (buffer) + skip;
-      GstBuffer *new_buffer = gst_buffer_copy_region (buffer,
-          GST_BUFFER_COPY_ALL,
-          gst_live_adder_length_from_duration (adder, skip),
-          gst_live_adder_length_from_duration (adder, subbuffer_duration));
-      gst_buffer_unref (buffer);
-      buffer = new_buffer;
-      GST_BUFFER_PTS (buffer) = subbuffer_ts;
-      GST_BUFFER_DURATION (buffer) = subbuffer_duration;
-    }
+  gst_buffer_unmap (buffer, &map);
+  gst_buffer_unref (buffer);
 
-    if (item)
-      g_queue_insert_before (adder->buffers, item, buffer);
-    else
-      g_queue_push_tail (adder->buffers, buffer);
-  }
+  g_cond_broadcast (&adder->not_empty_cond);
 
 out:
 
@@ -1167,6 +1310,14 @@ invalid_timestamp:
       ("Invalid timestamp received on buffer"));
 
   return GST_FLOW_ERROR;
+
+not_negotiated:
+
+  GST_OBJECT_UNLOCK (adder);
+  gst_buffer_unref (buffer);
+  GST_DEBUG_OBJECT (adder, "Buffer received before caps");
+
+  return GST_FLOW_NOT_NEGOTIATED;
 }
 
 /*
@@ -1213,14 +1364,15 @@ again:
   for (;;) {
     if (adder->srcresult != GST_FLOW_OK)
       goto flushing;
-    if (!g_queue_is_empty (adder->buffers))
+    if (adder->ring_first != adder->ring_end)
       break;
     if (check_eos_locked (adder))
       goto eos;
     g_cond_wait (&adder->not_empty_cond, GST_OBJECT_GET_LOCK (adder));
   }
 
-  buffer_timestamp = GST_BUFFER_TIMESTAMP (g_queue_peek_head (adder->buffers));
+  buffer_timestamp =
+      gst_live_adder_pos_to_time (adder, gst_live_adder_head_pos (adder));
 
   clock = GST_ELEMENT_CLOCK (adder);
 
@@ -1252,9 +1404,9 @@ again:
   gst_clock_id_unref (id);
   adder->clock_id = NULL;
 
-  /* at this point, the clock could have been unlocked by a timeout, a new
-   * head element was added to the queue or because we are shutting down. Check
-   * for shutdown first. */
+  /* at this point, the clock could have been unlocked by a timeout, new
+   * data was added before the head of the ring or because we are shutting
+   * down. Check for shutdown first. */
 
   if (adder->srcresult != GST_FLOW_OK)
     goto flushing;
@@ -1270,11 +1422,11 @@ again:
 
 push_buffer:
 
-  buffer = g_queue_pop_head (adder->buffers);
-
-  if (!buffer)
+  if (adder->ring_first == adder->ring_end)
     goto again;
 
+  buffer = gst_live_adder_pop_slot_locked (adder);
+
   /*
    * We make sure the timestamps are exactly contiguous
    * If its only small skew (due to rounding errors), we correct it
@@ -1333,6 +1485,8 @@ flushing:
 
 clock_error:
   {
+    adder->srcresult = GST_FLOW_ERROR;
+    g_cond_broadcast (&adder->not_full_cond);
     gst_pad_pause_task (adder->srcpad);
     GST_OBJECT_UNLOCK (adder);
     GST_ELEMENT_ERROR (adder, STREAM, MUX, ("Error with the clock"),
@@ -1343,6 +1497,8 @@ clock_error:
 
 no_clock:
   {
+    adder->srcresult = GST_FLOW_ERROR;
+    g_cond_broadcast (&adder->not_full_cond);
     gst_pad_pause_task (adder->srcpad);
     GST_OBJECT_UNLOCK (adder);
     GST_ELEMENT_ERROR (adder, STREAM, MUX, ("No available clock"),
@@ -1358,8 +1514,9 @@ pause:
 
     GST_OBJECT_LOCK (adder);
 
-    /* store result */
+    /* store result and wake up the chain functions waiting for room */
     adder->srcresult = result;
+    g_cond_broadcast (&adder->not_full_cond);
     /* we don't post errors or anything because upstream will do that for us
      * when we pass the return value upstream. */
     gst_pad_pause_task (adder->srcpad);
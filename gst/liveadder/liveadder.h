@@ -40,8 +40,19 @@ G_BEGIN_DECLS
 typedef struct _GstLiveAdder GstLiveAdder;
 typedef struct _GstLiveAdderClass GstLiveAdderClass;
 
+typedef struct _GstLiveAdderSlot GstLiveAdderSlot;
+
 typedef void (*GstLiveAdderFunction) (gpointer out, gpointer in, guint size);
 
+/* one output period of the accumulation ring, start and end are the sample
+ * range inside the period that holds data */
+struct _GstLiveAdderSlot
+{
+  GstBuffer *buffer;
+  guint start;
+  guint end;
+};
+
 /**
  * GstLiveAdder:
  *
@@ -60,9 +71,17 @@ struct _GstLiveAdder
   GstFlowReturn srcresult;
   GstClockID clock_id;
 
-  /* the queue is ordered head to tail */
-  GQueue *buffers;
+  /* ring of output periods, indexed by running time in periods modulo
+   * n_slots. Periods ring_first to ring_end - 1 may hold data. */
+  GstLiveAdderSlot *slots;
+  guint n_slots;
+  guint period_samples;
+  guint64 ring_first;
+  guint64 ring_end;
+  /* sample position up to which data was pushed */
+  guint64 released_pos;
   GCond not_empty_cond;
+  GCond not_full_cond;
 
   GstClockTime next_timestamp;
 
@@ -63,6 +63,13 @@
 
 #define DURATION_SCAN_LIMIT         4 * 1024 * 1024
 
+/* minimum SCR distance between index entries that are no keyframes */
+#define INDEX_INTERVAL              (CLOCK_FREQ / 2)
+/* maximum SCR distance of a keyframe from the seek target */
+#define INDEX_MAX_KEYFRAME_DISTANCE (10 * CLOCK_FREQ)
+#define INDEX_ENTRY_SIZE            16
+#define INDEX_KEYFRAME_FLAG         G_GUINT64_CONSTANT (0x8000000000000000)
+
 typedef enum
 {
   SCAN_SCR,
@@ -274,6 +281,7 @@ gst_flups_demux_init (GstFluPSDemux * demux)
 
   demux->adapter = gst_adapter_new ();
   demux->rev_adapter = gst_adapter_new ();
+  demux->index = g_array_new (FALSE, FALSE, sizeof (GstFluPSIndexEntry));
 
   gst_flups_demux_reset (demux);
 }
@@ -287,6 +295,7 @@ gst_flups_demux_finalize (GstFluPSDemux * demux)
 
   g_object_unref (demux->adapter);
   g_object_unref (demux->rev_adapter);
+  g_array_free (demux->index, TRUE);
 
   G_OBJECT_CLASS (parent_class)->finalize (G_OBJECT (demux));
 }
@@ -337,6 +346,11 @@ gst_flups_demux_reset (GstFluPSDemux * demux)
   gst_flups_demux_flush (demux);
   demux->have_group_id = FALSE;
   demux->group_id = G_MAXUINT;
+
+  GST_OBJECT_LOCK (demux);
+  g_array_set_size (demux->index, 0);
+  GST_OBJECT_UNLOCK (demux);
+  demux->index_scr = G_MAXUINT64;
 }
 
 static GstFluPSStream *
@@ -874,6 +888,7 @@ gst_flups_demux_flush (GstFluPSDemux * demux)
   demux->adapter_offset = G_MAXUINT64;
   demux->current_scr = G_MAXUINT64;
   demux->bytes_since_scr = 0;
+  demux->index_offset = G_MAXUINT64;
 }
 
 static inline void
@@ -1089,6 +1104,141 @@ not_supported:
   }
 }
 
+/* Returns the position of the first index entry with a SCR >= @scr */
+static guint
+gst_flups_demux_index_find (GstFluPSDemux * demux, guint64 scr)
+{
+  guint lo = 0, hi = demux->index->len;
+
+  while (lo < hi) {
+    guint mid = (lo + hi) / 2;
+
+    if (g_array_index (demux->index, GstFluPSIndexEntry, mid).scr < scr)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  return lo;
+}
+
+/* Must be called with the object lock */
+static void
+gst_flups_demux_index_add (GstFluPSDemux * demux,
+    const GstFluPSIndexEntry * entry)
+{
+  GstFluPSIndexEntry *prev = NULL, *next = NULL;
+  guint pos = gst_flups_demux_index_find (demux, entry->scr);
+
+  if (pos > 0)
+    prev = &g_array_index (demux->index, GstFluPSIndexEntry, pos - 1);
+  if (pos < demux->index->len)
+    next = &g_array_index (demux->index, GstFluPSIndexEntry, pos);
+
+  /* already known, but we might only now know that it is a keyframe */
+  if (next && next->scr == entry->scr) {
+    if (entry->keyframe && !next->keyframe && next->offset == entry->offset)
+      next->keyframe = TRUE;
+    return;
+  }
+
+  /* SCR and offset must increase together, this is not the case after
+   * SCR discontinuities */
+  if ((prev && prev->offset >= entry->offset) ||
+      (next && next->offset <= entry->offset))
+    return;
+
+  if (!entry->keyframe && ((prev && entry->scr - prev->scr < INDEX_INTERVAL)
+          || (next && next->scr - entry->scr < INDEX_INTERVAL)))
+    return;
+
+  g_array_insert_val (demux->index, pos, *entry);
+}
+
+static gboolean
+gst_flups_demux_is_keyframe (gint stream_type, const guint8 * data, gsize size)
+{
+  gsize i;
+
+  if (stream_type != ST_VIDEO_MPEG1 && stream_type != ST_VIDEO_MPEG2
+      && stream_type != ST_GST_VIDEO_MPEG1_OR_2
+      && stream_type != ST_VIDEO_H264)
+    return FALSE;
+
+  for (i = 0; i + 4 <= size; i++) {
+    if (data[i + 2] > 1) {
+      i += 2;
+      continue;
+    }
+    if (data[i] != 0 || data[i + 1] != 0 || data[i + 2] != 1)
+      continue;
+
+    if (stream_type == ST_VIDEO_H264) {
+      /* IDR slice or SPS */
+      if ((data[i + 3] & 0x1f) == 5 || (data[i + 3] & 0x1f) == 7)
+        return TRUE;
+    } else {
+      /* sequence header or GOP */
+      if (data[i + 3] == 0xb3 || data[i + 3] == 0xb8)
+        return TRUE;
+    }
+  }
+
+  return FALSE;
+}
+
+static gboolean
+gst_flups_demux_handle_index_query (GstFluPSDemux * demux, GstQuery * query)
+{
+  GstStructure *structure = gst_query_writable_structure (query);
+  const GValue *value = gst_structure_get_value (structure, "entries");
+  GstBuffer *buffer;
+  GstMapInfo map;
+  guint i;
+
+  if (value && G_VALUE_HOLDS (value, GST_TYPE_BUFFER)) {
+    buffer = gst_value_get_buffer (value);
+    if (!gst_buffer_map (buffer, &map, GST_MAP_READ))
+      return FALSE;
+
+    GST_OBJECT_LOCK (demux);
+    for (i = 0; i + INDEX_ENTRY_SIZE <= map.size; i += INDEX_ENTRY_SIZE) {
+      GstFluPSIndexEntry entry;
+      guint64 scr = GST_READ_UINT64_BE (map.data + i);
+
+      entry.scr = scr & ~INDEX_KEYFRAME_FLAG;
+      entry.offset = GST_READ_UINT64_BE (map.data + i + 8);
+      entry.keyframe = (scr & INDEX_KEYFRAME_FLAG) != 0;
+      gst_flups_demux_index_add (demux, &entry);
+    }
+    GST_DEBUG_OBJECT (demux, "loaded index, now %u entries",
+        demux->index->len);
+    GST_OBJECT_UNLOCK (demux);
+
+    gst_buffer_unmap (buffer, &map);
+  } else {
+    GST_OBJECT_LOCK (demux);
+    buffer = gst_buffer_new_allocate (NULL,
+        demux->index->len * INDEX_ENTRY_SIZE, NULL);
+    gst_buffer_map (buffer, &map, GST_MAP_WRITE);
+    for (i = 0; i < demux->index->len; i++) {
+      GstFluPSIndexEntry *entry =
+          &g_array_index (demux->index, GstFluPSIndexEntry, i);
+
+      GST_WRITE_UINT64_BE (map.data + i * INDEX_ENTRY_SIZE,
+          entry->scr | (entry->keyframe ? INDEX_KEYFRAME_FLAG : 0));
+      GST_WRITE_UINT64_BE (map.data + i * INDEX_ENTRY_SIZE + 8, entry->offset);
+    }
+    GST_OBJECT_UNLOCK (demux);
+    gst_buffer_unmap (buffer, &map);
+
+    gst_structure_set (structure, "entries", GST_TYPE_BUFFER, buffer, NULL);
+    gst_buffer_unref (buffer);
+  }
+
+  return TRUE;
+}
+
 #define MAX_RECURSION_COUNT 100
 
 /* Binary search for requested SCR */
@@ -1132,11 +1282,14 @@ find_offset (GstFluPSDemux * demux, guint64 scr,
 }
 
 static inline gboolean
-gst_flups_demux_do_seek (GstFluPSDemux * demux, GstSegment * seeksegment)
+gst_flups_demux_do_seek (GstFluPSDemux * demux, GstSegment * seeksegment,
+    gboolean keyframe)
 {
   gboolean found = FALSE;
   guint64 fscr, offset;
   guint64 scr = GSTTIME_TO_MPEGTIME (seeksegment->position + demux->base_time);
+  GstFluPSIndexEntry min = { 0, }, max = { 0, }, key = { 0, };
+  gboolean have_range = FALSE, have_key = FALSE;
 
   /* In some clips the PTS values are completely unaligned with SCR values.
    * To improve the seek in that situation we apply a factor considering the
@@ -1151,9 +1304,48 @@ gst_flups_demux_do_seek (GstFluPSDemux * demux, GstSegment * seeksegment)
   GST_INFO_OBJECT (demux, "sink segment configured %" GST_SEGMENT_FORMAT
       ", trying to go at SCR: %" G_GUINT64_FORMAT, &demux->sink_segment, scr);
 
-  offset =
-      find_offset (demux, scr, demux->first_scr, demux->first_scr_offset,
-      demux->last_scr, demux->last_scr_offset, 0);
+  /* look for the entries around the SCR and the keyframe before it */
+  GST_OBJECT_LOCK (demux);
+  if (demux->index->len > 0) {
+    guint pos = gst_flups_demux_index_find (demux, scr + 1);
+    guint i;
+
+    for (i = pos; keyframe && i > 0; i--) {
+      GstFluPSIndexEntry *entry =
+          &g_array_index (demux->index, GstFluPSIndexEntry, i - 1);
+
+      if (scr - entry->scr > INDEX_MAX_KEYFRAME_DISTANCE)
+        break;
+      if (entry->keyframe) {
+        key = *entry;
+        have_key = TRUE;
+        break;
+      }
+    }
+
+    if (pos > 0 && pos < demux->index->len) {
+      min = g_array_index (demux->index, GstFluPSIndexEntry, pos - 1);
+      max = g_array_index (demux->index, GstFluPSIndexEntry, pos);
+      have_range = TRUE;
+    }
+  }
+  GST_OBJECT_UNLOCK (demux);
+
+  if (have_key) {
+    GST_DEBUG_OBJECT (demux, "using indexed keyframe at SCR %" G_GUINT64_FORMAT,
+        key.scr);
+    offset = key.offset;
+    fscr = key.scr;
+  } else if (have_range) {
+    GST_DEBUG_OBJECT (demux, "searching between indexed SCR %" G_GUINT64_FORMAT
+        " and %" G_GUINT64_FORMAT, min.scr, max.scr);
+    offset =
+        find_offset (demux, scr, min.scr, min.offset, max.scr, max.offset, 0);
+  } else {
+    offset =
+        find_offset (demux, scr, demux->first_scr, demux->first_scr_offset,
+        demux->last_scr, demux->last_scr_offset, 0);
+  }
 
   if (offset == (guint64) - 1) {
     return FALSE;
@@ -1206,7 +1398,6 @@ gst_flups_demux_handle_seek_pull (GstFluPSDemux * demux, GstEvent * event)
     goto no_scr_rate;
 
   flush = flags & GST_SEEK_FLAG_FLUSH;
-  /* keyframe = flags & GST_SEEK_FLAG_KEY_UNIT; *//* FIXME */
 
   if (flush) {
     /* Flush start up and downstream to make sure data flow and loops are
@@ -1244,7 +1435,8 @@ gst_flups_demux_handle_seek_pull (GstFluPSDemux * demux, GstEvent * event)
 
   if (flush || seeksegment.position != demux->src_segment.position) {
     /* Do the actual seeking */
-    if (!gst_flups_demux_do_seek (demux, &seeksegment)) {
+    if (!gst_flups_demux_do_seek (demux, &seeksegment,
+            (flags & GST_SEEK_FLAG_KEY_UNIT) != 0)) {
       return FALSE;
     }
   }
@@ -1509,6 +1701,15 @@ gst_flups_demux_src_query (GstPad * pad, GstObject * parent, GstQuery * query)
       res = TRUE;
       break;
     }
+    case GST_QUERY_CUSTOM:{
+      const GstStructure *structure = gst_query_get_structure (query);
+
+      if (structure && gst_structure_has_name (structure, "mpegpsdemux-index"))
+        res = gst_flups_demux_handle_index_query (demux, query);
+      else
+        res = gst_pad_query_default (pad, parent, query);
+      break;
+    }
     default:
       res = gst_pad_query_default (pad, parent, query);
       break;
@@ -1684,6 +1885,22 @@ gst_flups_demux_parse_pack_start (GstFluPSDemux * demux)
   /* scr adjusted is the new scr found + the colected adjustment */
   scr_adjusted = scr + demux->scr_adjust;
 
+  /* the index uses the SCR and offsets as seen when scanning the stream */
+  if (demux->random_access && demux->adapter_offset != G_MAXUINT64) {
+    GstFluPSIndexEntry entry;
+
+    entry.scr = scr;
+    entry.offset = demux->adapter_offset;
+    entry.keyframe = FALSE;
+
+    GST_OBJECT_LOCK (demux);
+    gst_flups_demux_index_add (demux, &entry);
+    GST_OBJECT_UNLOCK (demux);
+
+    demux->index_scr = scr;
+    demux->index_offset = demux->adapter_offset;
+  }
+
   GST_LOG_OBJECT (demux,
       "SCR: %" G_GINT64_FORMAT " (%" G_GINT64_FORMAT "), mux_rate %"
       G_GINT64_FORMAT ", GStreamer Time:%" GST_TIME_FORMAT,
@@ -2236,6 +2453,22 @@ gst_flups_demux_data_cb (GstPESFilter * filter, gboolean first,
     goto done;
   }
 
+  if (first && demux->index_offset != G_MAXUINT64
+      && gst_flups_demux_is_keyframe (demux->current_stream->type,
+          map.data + offset, datalen)) {
+    GstFluPSIndexEntry entry;
+
+    entry.scr = demux->index_scr;
+    entry.offset = demux->index_offset;
+    entry.keyframe = TRUE;
+
+    GST_OBJECT_LOCK (demux);
+    gst_flups_demux_index_add (demux, &entry);
+    GST_OBJECT_UNLOCK (demux);
+
+    demux->index_offset = G_MAXUINT64;
+  }
+
   /* After 2 seconds of bitstream emit no more pads */
   if (demux->need_no_more_pads
       && (demux->current_scr - demux->first_scr) > 2 * CLOCK_FREQ) {
@@ -83,6 +83,22 @@ typedef enum
   STATE_FLUPS_DEMUX_NEED_MORE_DATA,
 } GstFluPSDemuxState;
 
+/* Entry of the seek index, maps the SCR of a pack to the offset of its
+ * start code. Keyframe entries are packs where a video keyframe starts.
+ *
+ * The index can be saved and restored with a custom query on a source pad
+ * with a "mpegpsdemux-index" structure. Without an "entries" field the
+ * demuxer sets "entries" to a buffer with 16 bytes per entry: the SCR as
+ * big endian 64 bit integer with the highest bit set for keyframes, followed
+ * by the big endian 64 bit offset. If "entries" is set, these entries are
+ * added to the index. */
+typedef struct
+{
+  guint64 scr;
+  guint64 offset;
+  gboolean keyframe;
+} GstFluPSIndexEntry;
+
 /* Information associated with a single FluPS stream. */
 struct _GstFluPSStream
 {
@@ -154,6 +170,12 @@ struct _GstFluPSDemux
 
   /* Indicates an MPEG-2 stream */
   gboolean is_mpeg2_pack;
+
+  /* seek index sorted by SCR, protected by the object lock */
+  GArray *index;
+  /* current pack, until a keyframe was indexed for it */
+  guint64 index_scr;
+  guint64 index_offset;
 };
 
 struct _GstFluPSDemuxClass
@@ -94,7 +94,7 @@ static void gst_mpegpsmux_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec);
 
 static void mpegpsmux_finalize (GObject * object);
-static gboolean new_packet_cb (guint8 * data, guint len, void *user_data);
+static gboolean new_packet_cb (GstBuffer * buf, void *user_data);
 
 static gboolean mpegpsdemux_prepare_srcpad (MpegPsMux * mux);
 static GstFlowReturn mpegpsmux_collected (GstCollectPads * pads,
@@ -154,7 +154,6 @@ mpegpsmux_init (MpegPsMux * mux)
   psmux_set_write_func (mux->psmux, new_packet_cb, mux);
 
   mux->first = TRUE;
-  mux->last_flow_ret = GST_FLOW_OK;
   mux->last_ts = 0;             /* XXX: or -1? */
 }
 
@@ -177,6 +176,11 @@ mpegpsmux_finalize (GObject * object)
     mux->gop_list = NULL;
   }
 
+  if (mux->out_list != NULL) {
+    gst_buffer_list_unref (mux->out_list);
+    mux->out_list = NULL;
+  }
+
   G_OBJECT_CLASS (mpegpsmux_parent_class)->finalize (object);
 }
 
@@ -497,6 +501,21 @@ mpegpsmux_push_gop_list (MpegPsMux * mux)
   return flow;
 }
 
+static GstFlowReturn
+mpegpsmux_push_out_list (MpegPsMux * mux)
+{
+  GstFlowReturn flow;
+
+  if (mux->out_list == NULL)
+    return GST_FLOW_OK;
+
+  GST_LOG_OBJECT (mux, "Pushing %u buffers",
+      gst_buffer_list_length (mux->out_list));
+  flow = gst_pad_push_list (mux->srcpad, mux->out_list);
+  mux->out_list = NULL;
+  return flow;
+}
+
 static GstFlowReturn
 mpegpsmux_collected (GstCollectPads * pads, MpegPsMux * mux)
 {
@@ -559,6 +578,7 @@ mpegpsmux_collected (GstCollectPads * pads, MpegPsMux * mux)
     psmux_stream_add_data (best->stream, buf, pts, dts, keyunit);
 
     best->queued.buf = NULL;
+    mux->last_ts = best->last_ts;
 
     /* write the data from libpsmux to stream */
     while (psmux_stream_bytes_in_buffer (best->stream) > 0) {
@@ -568,7 +588,8 @@ mpegpsmux_collected (GstCollectPads * pads, MpegPsMux * mux)
         goto write_fail;
       }
     }
-    mux->last_ts = best->last_ts;
+
+    ret = mpegpsmux_push_out_list (mux);
   } else {
     /* FIXME: Drain all remaining streams */
     /* At EOS */
@@ -578,6 +599,9 @@ mpegpsmux_collected (GstCollectPads * pads, MpegPsMux * mux)
     if (!psmux_write_end_code (mux->psmux)) {
       GST_WARNING_OBJECT (mux, "Writing MPEG PS Program end code failed.");
     }
+    if (mux->gop_list != NULL)
+      mpegpsmux_push_gop_list (mux);
+    mpegpsmux_push_out_list (mux);
     gst_pad_push_event (mux->srcpad, gst_event_new_eos ());
 
     ret = GST_FLOW_EOS;
@@ -590,7 +614,11 @@ new_seg_fail:
   return GST_FLOW_ERROR;
 write_fail:
   /* FIXME: Failed writing data for some reason. Should set appropriate error */
-  return mux->last_flow_ret;
+  if (mux->out_list != NULL) {
+    gst_buffer_list_unref (mux->out_list);
+    mux->out_list = NULL;
+  }
+  return GST_FLOW_ERROR;
 }
 
 static GstPad *
@@ -659,19 +687,16 @@ mpegpsmux_release_pad (GstElement * element, GstPad * pad)
 }
 
 static gboolean
-new_packet_cb (guint8 * data, guint len, void *user_data)
+new_packet_cb (GstBuffer * buf, void *user_data)
 {
-  /* Called when the PsMux has prepared a packet for output. Return FALSE
-   * on error */
+  /* Called when the PsMux has prepared a packet for output. The packets are
+   * collected and pushed as a list once all data of the current input buffer
+   * was written. Return FALSE on error */
 
   MpegPsMux *mux = (MpegPsMux *) user_data;
-  GstBuffer *buf;
-  GstFlowReturn ret;
-
-  GST_LOG_OBJECT (mux, "Outputting a packet of length %d", len);
 
-  data = g_memdup (data, len);
-  buf = gst_buffer_new_wrapped (data, len);
+  GST_LOG_OBJECT (mux, "Outputting a packet of length %" G_GSIZE_FORMAT,
+      gst_buffer_get_size (buf));
 
   GST_BUFFER_TIMESTAMP (buf) = mux->last_ts;
 
@@ -683,13 +708,10 @@ new_packet_cb (guint8 * data, guint len, void *user_data)
     return TRUE;
   }
 
-  ret = gst_pad_push (mux->srcpad, buf);
-
-  if (G_UNLIKELY (ret != GST_FLOW_OK)) {
-    mux->last_flow_ret = ret;
-    return FALSE;
-  }
+  if (mux->out_list == NULL)
+    mux->out_list = gst_buffer_list_new ();
 
+  gst_buffer_list_add (mux->out_list, buf);
   return TRUE;
 }
 
@@ -75,12 +75,13 @@ struct MpegPsMux {
   PsMux *psmux;
 
   gboolean first;
-  GstFlowReturn last_flow_ret;
   
   GstClockTime last_ts;
 
   GstBufferList *gop_list;
   gboolean       aggregate_gops;
+
+  GstBufferList *out_list; /* packets written for the current input buffer */
 };
 
 struct MpegPsMuxClass  {
@@ -54,7 +54,7 @@
 #include "psmux.h"
 #include "crc.h"
 
-static gboolean psmux_packet_out (PsMux * mux);
+static gboolean psmux_packet_out (PsMux * mux, GstBuffer * payload);
 static gboolean psmux_write_pack_header (PsMux * mux);
 static gboolean psmux_write_system_header (PsMux * mux);
 static gboolean psmux_write_program_stream_map (PsMux * mux);
@@ -115,7 +115,11 @@ gboolean
 psmux_write_end_code (PsMux * mux)
 {
   guint8 end_code[4] = { 0, 0, 1, PSMUX_PROGRAM_END };
-  return mux->write_func (end_code, 4, mux->write_func_data);
+
+  memcpy (mux->packet_buf, end_code, 4);
+  mux->packet_bytes_written = 4;
+
+  return psmux_packet_out (mux, NULL);
 }
 
 
@@ -202,18 +206,39 @@ psmux_create_stream (PsMux * mux, PsMuxStreamType stream_type)
   return stream;
 }
 
+/* Outputs the headers written so far, followed by @payload if any */
 static gboolean
-psmux_packet_out (PsMux * mux)
+psmux_packet_out (PsMux * mux, GstBuffer * payload)
 {
+  GstBuffer *buf;
+  gsize size;
   gboolean res;
-  if (G_UNLIKELY (mux->write_func == NULL))
+
+  if (G_UNLIKELY (mux->write_func == NULL)) {
+    if (payload)
+      gst_buffer_unref (payload);
+    mux->packet_bytes_written = 0;
     return TRUE;
+  }
+
+  buf = payload ? payload : gst_buffer_new ();
 
-  res = mux->write_func (mux->packet_buf, mux->packet_bytes_written,
-      mux->write_func_data);
+  if (mux->packet_bytes_written > 0) {
+    GstMemory *mem;
+    GstMapInfo map;
+
+    mem = gst_allocator_alloc (NULL, mux->packet_bytes_written, NULL);
+    gst_memory_map (mem, &map, GST_MAP_WRITE);
+    memcpy (map.data, mux->packet_buf, mux->packet_bytes_written);
+    gst_memory_unmap (mem, &map);
+    gst_buffer_prepend_memory (buf, mem);
+  }
+
+  size = gst_buffer_get_size (buf);
+  res = mux->write_func (buf, mux->write_func_data);
 
   if (res) {
-    mux->bit_size += mux->packet_bytes_written;
+    mux->bit_size += size;
   }
   mux->packet_bytes_written = 0;
   return res;
@@ -231,7 +256,8 @@ psmux_packet_out (PsMux * mux)
 gboolean
 psmux_write_stream_packet (PsMux * mux, PsMuxStream * stream)
 {
-  gboolean res;
+  GstBuffer *payload;
+  guint hdr_len;
 
   g_return_val_if_fail (mux != NULL, FALSE);
   g_return_val_if_fail (stream != NULL, FALSE);
@@ -279,22 +305,26 @@ psmux_write_stream_packet (PsMux * mux, PsMuxStream * stream)
     mux->psm_pts = mux->pts;
   }
 
-  /* Write the packet */
-  if (!(mux->packet_bytes_written =
-          psmux_stream_get_data (stream, mux->packet_buf,
-              mux->pes_max_payload + PSMUX_PES_MAX_HDR_LEN))) {
+  /* Write the packet, the pack header, system header and PSM written above
+   * are output together with it */
+  payload = gst_buffer_new ();
+  if (!(hdr_len = psmux_stream_get_data (stream,
+              mux->packet_buf + mux->packet_bytes_written,
+              mux->pes_max_payload + PSMUX_PES_MAX_HDR_LEN, payload))) {
+    gst_buffer_unref (payload);
+    mux->packet_bytes_written = 0;
     return FALSE;
   }
+  mux->packet_bytes_written += hdr_len;
 
-  res = psmux_packet_out (mux);
-  if (!res) {
+  if (!psmux_packet_out (mux, payload)) {
     GST_DEBUG_OBJECT (mux, "packet write false");
     return FALSE;
   }
 
   mux->pes_cnt += 1;
 
-  return res;
+  return TRUE;
 }
 
 static gboolean
@@ -306,7 +336,7 @@ psmux_write_pack_header (PsMux * mux)
     scr = 0;
 
   /* pack_start_code */
-  bits_initwrite (&bw, 14, mux->packet_buf);
+  bits_initwrite (&bw, 14, mux->packet_buf + mux->packet_bytes_written);
   bits_write (&bw, 24, PSMUX_START_CODE_PREFIX);
   bits_write (&bw, 8, PSMUX_PACK_HEADER);
 
@@ -334,8 +364,8 @@ psmux_write_pack_header (PsMux * mux)
   bits_write (&bw, 5, 0x1f);
   bits_write (&bw, 3, 0);       /* pack_stuffing_length */
 
-  mux->packet_bytes_written = 14;
-  return psmux_packet_out (mux);
+  mux->packet_bytes_written += 14;
+  return TRUE;
 }
 
 static void
@@ -401,11 +431,11 @@ psmux_write_system_header (PsMux * mux)
   psmux_ensure_system_header (mux);
 
   gst_buffer_map (mux->sys_header, &map, GST_MAP_READ);
-  memcpy (mux->packet_buf, map.data, map.size);
-  mux->packet_bytes_written = map.size;
+  memcpy (mux->packet_buf + mux->packet_bytes_written, map.data, map.size);
+  mux->packet_bytes_written += map.size;
   gst_buffer_unmap (mux->sys_header, &map);
 
-  return psmux_packet_out (mux);
+  return TRUE;
 }
 
 static void
@@ -485,11 +515,11 @@ psmux_write_program_stream_map (PsMux * mux)
   psmux_ensure_program_stream_map (mux);
 
   gst_buffer_map (mux->psm, &map, GST_MAP_READ);
-  memcpy (mux->packet_buf, map.data, map.size);
-  mux->packet_bytes_written = map.size;
+  memcpy (mux->packet_buf + mux->packet_bytes_written, map.data, map.size);
+  mux->packet_bytes_written += map.size;
   gst_buffer_unmap (mux->psm, &map);
 
-  return psmux_packet_out (mux);
+  return TRUE;
 }
 
 GList *
@@ -54,7 +54,8 @@ G_BEGIN_DECLS
 
 #define PSMUX_MAX_ES_INFO_LENGTH ((1 << 12) - 1)
 
-typedef gboolean (*PsMuxWriteFunc) (guint8 *data, guint len, void *user_data);
+/* takes ownership of @buf */
+typedef gboolean (*PsMuxWriteFunc) (GstBuffer *buf, void *user_data);
 
 struct PsMux {
   GList *streams;    /* PsMuxStream* array of all streams */
@@ -81,6 +82,7 @@ struct PsMux {
   guint psm_freq; /* program stream map frequency */ 
   GstClockTime psm_pts; /* last time a psm is written */
 
+  /* headers of the next output buffer, the PES payload is referenced */
   guint8 packet_buf[PSMUX_MAX_PACKET_LEN];
   guint packet_bytes_written; /* # of bytes written in the buf */
   PsMuxWriteFunc write_func;
@@ -25,6 +25,10 @@
  * #GstPcapParse:src-port and #GstPcapParse:dst-port to restrict which packets
  * should be included.
  *
+ * When the upstream element supports pull mode (for example filesrc), the
+ * capture is read in large blocks and an index of record offsets is built
+ * while parsing, which makes time based seeking possible.
+ *
  * <refsect2>
  * <title>Example pipelines</title>
  * |[
@@ -93,6 +97,24 @@ static GstFlowReturn gst_pcap_parse_chain (GstPad * pad,
     GstObject * parent, GstBuffer * buffer);
 static gboolean gst_pcap_sink_event (GstPad * pad,
     GstObject * parent, GstEvent * event);
+static gboolean gst_pcap_parse_sink_activate (GstPad * sinkpad,
+    GstObject * parent);
+static gboolean gst_pcap_parse_sink_activate_mode (GstPad * pad,
+    GstObject * parent, GstPadMode mode, gboolean active);
+static gboolean gst_pcap_parse_src_event (GstPad * pad,
+    GstObject * parent, GstEvent * event);
+static gboolean gst_pcap_parse_src_query (GstPad * pad,
+    GstObject * parent, GstQuery * query);
+static void gst_pcap_parse_loop (GstPad * pad);
+
+/* size of the blocks read in pull mode */
+#define PULL_BLOCK_SIZE   (64 * 1024)
+
+/* minimum time between two index entries */
+#define INDEX_INTERVAL    (GST_SECOND / 10)
+
+#define PCAP_FILE_HEADER_LEN    24
+#define PCAP_RECORD_HEADER_LEN  16
 
 #define parent_class gst_pcap_parse_parent_class
 G_DEFINE_TYPE (GstPcapParse, gst_pcap_parse, GST_TYPE_ELEMENT);
@@ -159,9 +181,17 @@ gst_pcap_parse_init (GstPcapParse * self)
   gst_pad_use_fixed_caps (self->sink_pad);
   gst_pad_set_event_function (self->sink_pad,
       GST_DEBUG_FUNCPTR (gst_pcap_sink_event));
+  gst_pad_set_activate_function (self->sink_pad,
+      GST_DEBUG_FUNCPTR (gst_pcap_parse_sink_activate));
+  gst_pad_set_activatemode_function (self->sink_pad,
+      GST_DEBUG_FUNCPTR (gst_pcap_parse_sink_activate_mode));
   gst_element_add_pad (GST_ELEMENT (self), self->sink_pad);
 
   self->src_pad = gst_pad_new_from_static_template (&src_template, "src");
+  gst_pad_set_event_function (self->src_pad,
+      GST_DEBUG_FUNCPTR (gst_pcap_parse_src_event));
+  gst_pad_set_query_function (self->src_pad,
+      GST_DEBUG_FUNCPTR (gst_pcap_parse_src_query));
   gst_pad_use_fixed_caps (self->src_pad);
   gst_element_add_pad (GST_ELEMENT (self), self->src_pad);
 
@@ -170,8 +200,10 @@ gst_pcap_parse_init (GstPcapParse * self)
   self->src_port = -1;
   self->dst_port = -1;
   self->offset = -1;
+  self->filter_dirty = TRUE;
 
   self->adapter = gst_adapter_new ();
+  self->index = g_array_new (FALSE, FALSE, sizeof (GstPcapParseIndexEntry));
 
   gst_pcap_parse_reset (self);
 }
@@ -182,6 +214,7 @@ gst_pcap_parse_finalize (GObject * object)
   GstPcapParse *self = GST_PCAP_PARSE (object);
 
   g_object_unref (self->adapter);
+  g_array_free (self->index, TRUE);
   if (self->caps)
     gst_caps_unref (self->caps);
 
@@ -220,19 +253,27 @@ gst_pcap_parse_get_property (GObject * object, guint prop_id,
 
   switch (prop_id) {
     case PROP_SRC_IP:
+      GST_OBJECT_LOCK (self);
       g_value_set_string (value, get_ip_address_as_string (self->src_ip));
+      GST_OBJECT_UNLOCK (self);
       break;
 
     case PROP_DST_IP:
+      GST_OBJECT_LOCK (self);
       g_value_set_string (value, get_ip_address_as_string (self->dst_ip));
+      GST_OBJECT_UNLOCK (self);
       break;
 
     case PROP_SRC_PORT:
+      GST_OBJECT_LOCK (self);
       g_value_set_int (value, self->src_port);
+      GST_OBJECT_UNLOCK (self);
       break;
 
     case PROP_DST_PORT:
+      GST_OBJECT_LOCK (self);
       g_value_set_int (value, self->dst_port);
+      GST_OBJECT_UNLOCK (self);
       break;
 
     case PROP_CAPS:
@@ -257,19 +298,31 @@ gst_pcap_parse_set_property (GObject * object, guint prop_id,
 
   switch (prop_id) {
     case PROP_SRC_IP:
+      GST_OBJECT_LOCK (self);
       set_ip_address_from_string (&self->src_ip, g_value_get_string (value));
+      self->filter_dirty = TRUE;
+      GST_OBJECT_UNLOCK (self);
       break;
 
     case PROP_DST_IP:
+      GST_OBJECT_LOCK (self);
       set_ip_address_from_string (&self->dst_ip, g_value_get_string (value));
+      self->filter_dirty = TRUE;
+      GST_OBJECT_UNLOCK (self);
       break;
 
     case PROP_SRC_PORT:
+      GST_OBJECT_LOCK (self);
       self->src_port = g_value_get_int (value);
+      self->filter_dirty = TRUE;
+      GST_OBJECT_UNLOCK (self);
       break;
 
     case PROP_DST_PORT:
+      GST_OBJECT_LOCK (self);
       self->dst_port = g_value_get_int (value);
+      self->filter_dirty = TRUE;
+      GST_OBJECT_UNLOCK (self);
       break;
 
     case PROP_CAPS:
@@ -314,6 +367,14 @@ gst_pcap_parse_reset (GstPcapParse * self)
   self->base_ts = GST_CLOCK_TIME_NONE;
   self->newsegment_sent = FALSE;
 
+  self->pull_offset = 0;
+  self->cur_offset = 0;
+  self->index_end = 0;
+  self->seek_ts = GST_CLOCK_TIME_NONE;
+  self->seek_stop = GST_CLOCK_TIME_NONE;
+  self->discont = FALSE;
+  g_array_set_size (self->index, 0);
+
   gst_adapter_clear (self->adapter);
 }
 
@@ -333,6 +394,121 @@ gst_pcap_parse_read_uint32 (GstPcapParse * self, const guint8 * p)
   }
 }
 
+static void
+gst_pcap_parse_read_record_header (GstPcapParse * self, const guint8 * data,
+    GstClockTime * ts, guint32 * incl_len)
+{
+  guint32 ts_sec;
+  guint32 ts_usec;
+
+  ts_sec = gst_pcap_parse_read_uint32 (self, data + 0);
+  ts_usec = gst_pcap_parse_read_uint32 (self, data + 4);
+  *incl_len = gst_pcap_parse_read_uint32 (self, data + 8);
+  /* orig_len = gst_pcap_parse_read_uint32 (self, data + 12); */
+
+  *ts = ts_sec * GST_SECOND + ts_usec * GST_USECOND;
+}
+
+/* Record that the record at @offset has capture time @ts. Records are
+ * indexed in file order, and only every INDEX_INTERVAL to keep it small */
+static void
+gst_pcap_parse_add_index_entry (GstPcapParse * self, guint64 offset,
+    GstClockTime ts, guint32 incl_len)
+{
+  GstPcapParseIndexEntry entry;
+
+  if (offset < self->index_end)
+    return;
+
+  self->index_end = offset + PCAP_RECORD_HEADER_LEN + incl_len;
+
+  if (self->index->len > 0) {
+    GstPcapParseIndexEntry *last;
+
+    last = &g_array_index (self->index, GstPcapParseIndexEntry,
+        self->index->len - 1);
+    if (ts < last->ts + INDEX_INTERVAL)
+      return;
+  }
+
+  entry.ts = ts;
+  entry.offset = offset;
+  g_array_append_val (self->index, entry);
+}
+
+/* Extend the index by reading only the record headers, until a record at
+ * or after @ts is found or the end of the capture is reached */
+static void
+gst_pcap_parse_scan_index (GstPcapParse * self, GstClockTime ts)
+{
+  guint64 offset = self->index_end;
+
+  GST_DEBUG_OBJECT (self, "scanning index from offset %" G_GUINT64_FORMAT,
+      offset);
+
+  while (TRUE) {
+    GstBuffer *buf = NULL;
+    GstMapInfo map;
+    GstClockTime rec_ts = GST_CLOCK_TIME_NONE;
+    gsize pos = 0;
+
+    if (gst_pad_pull_range (self->sink_pad, offset, PULL_BLOCK_SIZE,
+            &buf) != GST_FLOW_OK)
+      break;
+
+    gst_buffer_map (buf, &map, GST_MAP_READ);
+    while (pos + PCAP_RECORD_HEADER_LEN <= map.size) {
+      guint32 incl_len;
+
+      gst_pcap_parse_read_record_header (self, map.data + pos, &rec_ts,
+          &incl_len);
+      gst_pcap_parse_add_index_entry (self, offset + pos, rec_ts, incl_len);
+      pos += PCAP_RECORD_HEADER_LEN + incl_len;
+
+      if (rec_ts >= ts)
+        break;
+    }
+    gst_buffer_unmap (buf, &map);
+    gst_buffer_unref (buf);
+
+    if (pos == 0 || (GST_CLOCK_TIME_IS_VALID (rec_ts) && rec_ts >= ts))
+      break;
+
+    offset += pos;
+  }
+}
+
+/* Return the offset of the last indexed record before @ts */
+static guint64
+gst_pcap_parse_index_lookup (GstPcapParse * self, GstClockTime ts)
+{
+  GstPcapParseIndexEntry *entry;
+  guint lo, hi;
+
+  if (self->index->len == 0 || g_array_index (self->index,
+          GstPcapParseIndexEntry, self->index->len - 1).ts < ts)
+    gst_pcap_parse_scan_index (self, ts);
+
+  if (self->index->len == 0)
+    return PCAP_FILE_HEADER_LEN;
+
+  lo = 0;
+  hi = self->index->len;
+  while (hi - lo > 1) {
+    guint mid = (lo + hi) / 2;
+
+    entry = &g_array_index (self->index, GstPcapParseIndexEntry, mid);
+    if (entry->ts <= ts)
+      lo = mid;
+    else
+      hi = mid;
+  }
+
+  entry = &g_array_index (self->index, GstPcapParseIndexEntry, lo);
+
+  return entry->offset;
+}
+
 #define ETH_HEADER_LEN    14
 #define SLL_HEADER_LEN    16
 #define IP_HEADER_MIN_LEN 20
@@ -341,6 +517,77 @@ gst_pcap_parse_read_uint32 (GstPcapParse * self, const guint8 * p)
 #define IP_PROTO_UDP      17
 #define IP_PROTO_TCP      6
 
+/* Called with the object lock */
+static void
+gst_pcap_parse_compile_filter (GstPcapParse * self)
+{
+  GstPcapParseFilterInsn *insn = self->filter;
+
+  if (self->src_ip >= 0) {
+    insn->base = PCAP_FILTER_BASE_IP;
+    insn->offset = 12;
+    insn->size = 4;
+    insn->value = self->src_ip;
+    insn++;
+  }
+
+  if (self->dst_ip >= 0) {
+    insn->base = PCAP_FILTER_BASE_IP;
+    insn->offset = 16;
+    insn->size = 4;
+    insn->value = self->dst_ip;
+    insn++;
+  }
+
+  if (self->src_port >= 0) {
+    insn->base = PCAP_FILTER_BASE_TRANSPORT;
+    insn->offset = 0;
+    insn->size = 2;
+    insn->value = self->src_port;
+    insn++;
+  }
+
+  if (self->dst_port >= 0) {
+    insn->base = PCAP_FILTER_BASE_TRANSPORT;
+    insn->offset = 2;
+    insn->size = 2;
+    insn->value = self->dst_port;
+    insn++;
+  }
+
+  self->n_filter_insns = insn - self->filter;
+  self->filter_dirty = FALSE;
+
+  GST_DEBUG_OBJECT (self, "compiled filter with %u comparisons",
+      self->n_filter_insns);
+}
+
+static gboolean
+gst_pcap_parse_run_filter (GstPcapParse * self, const guint8 * buf_ip,
+    const guint8 * buf_proto)
+{
+  guint i;
+
+  for (i = 0; i < self->n_filter_insns; i++) {
+    const GstPcapParseFilterInsn *insn = &self->filter[i];
+    const guint8 *p;
+    guint32 val;
+
+    p = (insn->base == PCAP_FILTER_BASE_IP ? buf_ip : buf_proto) +
+        insn->offset;
+
+    if (insn->size == 4)
+      memcpy (&val, p, 4);
+    else
+      val = GST_READ_UINT16_BE (p);
+
+    if (val != insn->value)
+      return FALSE;
+  }
+
+  return TRUE;
+}
+
 
 static gboolean
 gst_pcap_parse_scan_frame (GstPcapParse * self,
@@ -353,10 +600,6 @@ gst_pcap_parse_scan_frame (GstPcapParse * self,
   guint8 b;
   guint8 ip_header_size;
   guint8 ip_protocol;
-  guint32 ip_src_addr;
-  guint32 ip_dst_addr;
-  guint16 src_port;
-  guint16 dst_port;
   guint16 len;
 
   switch (self->linktype) {
@@ -395,14 +638,17 @@ gst_pcap_parse_scan_frame (GstPcapParse * self,
   if (ip_protocol != IP_PROTO_UDP && ip_protocol != IP_PROTO_TCP)
     return FALSE;
 
-  /* ip info */
-  ip_src_addr = *((guint32 *) (buf_ip + 12));
-  ip_dst_addr = *((guint32 *) (buf_ip + 16));
   buf_proto = buf_ip + ip_header_size;
 
-  /* ok for tcp and udp */
-  src_port = GUINT16_FROM_BE (*((guint16 *) (buf_proto + 0)));
-  dst_port = GUINT16_FROM_BE (*((guint16 *) (buf_proto + 2)));
+  /* addresses and ports are at the same place for tcp and udp, filter
+   * before looking at the payload */
+  GST_OBJECT_LOCK (self);
+  if (self->filter_dirty)
+    gst_pcap_parse_compile_filter (self);
+  GST_OBJECT_UNLOCK (self);
+
+  if (!gst_pcap_parse_run_filter (self, buf_ip, buf_proto))
+    return FALSE;
 
   /* extract some params and data according to protocol */
   if (ip_protocol == IP_PROTO_UDP) {
@@ -424,19 +670,6 @@ gst_pcap_parse_scan_frame (GstPcapParse * self,
     *payload_size = self->cur_packet_size - (buf_proto - buf) - len;
   }
 
-  /* but still filter as configured */
-  if (self->src_ip >= 0 && ip_src_addr != self->src_ip)
-    return FALSE;
-
-  if (self->dst_ip >= 0 && ip_dst_addr != self->dst_ip)
-    return FALSE;
-
-  if (self->src_port >= 0 && src_port != self->src_port)
-    return FALSE;
-
-  if (self->dst_port >= 0 && dst_port != self->dst_port)
-    return FALSE;
-
   return TRUE;
 }
 
@@ -461,78 +694,108 @@ gst_pcap_parse_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
 
         if (self->cur_packet_size > 0) {
           const guint8 *payload_data;
-          gint payload_size;
+          gint payload_offset = 0;
+          gint payload_size = 0;
+          gboolean matched;
 
           data = gst_adapter_map (self->adapter, self->cur_packet_size);
 
           GST_LOG_OBJECT (self, "examining packet size %" G_GINT64_FORMAT,
               self->cur_packet_size);
 
-          if (gst_pcap_parse_scan_frame (self, data, self->cur_packet_size,
-                  &payload_data, &payload_size)) {
+          matched = gst_pcap_parse_scan_frame (self, data,
+              self->cur_packet_size, &payload_data, &payload_size);
+          if (matched)
+            payload_offset = payload_data - data;
+
+          gst_adapter_unmap (self->adapter);
+
+          if (matched && GST_CLOCK_TIME_IS_VALID (self->cur_ts)) {
+            if (!GST_CLOCK_TIME_IS_VALID (self->base_ts))
+              self->base_ts = self->cur_ts;
+            if (self->offset >= 0) {
+              self->cur_ts -= self->base_ts;
+              self->cur_ts += self->offset;
+            }
+
+            /* after a seek, skip the packets before the target */
+            if (GST_CLOCK_TIME_IS_VALID (self->seek_ts) &&
+                self->cur_ts < self->seek_ts)
+              matched = FALSE;
+
+            if (GST_CLOCK_TIME_IS_VALID (self->seek_stop) &&
+                self->cur_ts > self->seek_stop) {
+              ret = GST_FLOW_EOS;
+              goto out;
+            }
+          }
+
+          if (matched) {
             GstBuffer *out_buf;
-            GstMapInfo map;
-
-            out_buf = gst_buffer_new_and_alloc (payload_size);
-            if (out_buf) {
-
-              if (GST_CLOCK_TIME_IS_VALID (self->cur_ts)) {
-                if (!GST_CLOCK_TIME_IS_VALID (self->base_ts))
-                  self->base_ts = self->cur_ts;
-                if (self->offset >= 0) {
-                  self->cur_ts -= self->base_ts;
-                  self->cur_ts += self->offset;
-                }
-              }
 
-              gst_buffer_map (out_buf, &map, GST_MAP_WRITE);
-              memcpy (map.data, payload_data, payload_size);
-              gst_buffer_unmap (out_buf, &map);
-              GST_BUFFER_TIMESTAMP (out_buf) = self->cur_ts;
+            /* push the payload as a sub-buffer of the input */
+            gst_adapter_flush (self->adapter, payload_offset);
+            if (payload_size > 0)
+              out_buf = gst_adapter_take_buffer (self->adapter, payload_size);
+            else
+              out_buf = gst_buffer_new ();
+            gst_adapter_flush (self->adapter,
+                self->cur_packet_size - payload_offset - payload_size);
 
-              if (!self->newsegment_sent &&
-                  GST_CLOCK_TIME_IS_VALID (self->cur_ts)) {
-                GstSegment segment;
+            GST_BUFFER_TIMESTAMP (out_buf) = self->cur_ts;
 
-                if (self->caps)
-                  gst_pad_set_caps (self->src_pad, self->caps);
-                gst_segment_init (&segment, GST_FORMAT_TIME);
+            if (self->discont) {
+              GST_BUFFER_FLAG_SET (out_buf, GST_BUFFER_FLAG_DISCONT);
+              self->discont = FALSE;
+            }
+
+            if (!self->newsegment_sent &&
+                GST_CLOCK_TIME_IS_VALID (self->cur_ts)) {
+              GstSegment segment;
+
+              if (self->caps)
+                gst_pad_set_caps (self->src_pad, self->caps);
+              gst_segment_init (&segment, GST_FORMAT_TIME);
+              if (GST_CLOCK_TIME_IS_VALID (self->seek_ts)) {
+                segment.start = self->seek_ts;
+                segment.time = self->seek_ts;
+                segment.stop = self->seek_stop;
+              } else {
                 segment.start = self->cur_ts;
-                gst_pad_push_event (self->src_pad,
-                    gst_event_new_segment (&segment));
-                self->newsegment_sent = TRUE;
               }
+              gst_pad_push_event (self->src_pad,
+                  gst_event_new_segment (&segment));
+              self->newsegment_sent = TRUE;
+            }
 
-              ret = gst_pad_push (self->src_pad, out_buf);
+            ret = gst_pad_push (self->src_pad, out_buf);
 
-              self->buffer_offset += payload_size;
-            }
+            self->buffer_offset += payload_size;
+          } else {
+            gst_adapter_flush (self->adapter, self->cur_packet_size);
           }
 
-          gst_adapter_unmap (self->adapter);
-          gst_adapter_flush (self->adapter, self->cur_packet_size);
+          self->cur_offset += self->cur_packet_size;
         }
 
         self->cur_packet_size = -1;
       } else {
-        guint32 ts_sec;
-        guint32 ts_usec;
         guint32 incl_len;
 
-        if (avail < 16)
+        if (avail < PCAP_RECORD_HEADER_LEN)
           break;
 
-        data = gst_adapter_map (self->adapter, 16);
-
-        ts_sec = gst_pcap_parse_read_uint32 (self, data + 0);
-        ts_usec = gst_pcap_parse_read_uint32 (self, data + 4);
-        incl_len = gst_pcap_parse_read_uint32 (self, data + 8);
-        /* orig_len = gst_pcap_parse_read_uint32 (self, data + 12); */
-
+        data = gst_adapter_map (self->adapter, PCAP_RECORD_HEADER_LEN);
+        gst_pcap_parse_read_record_header (self, data, &self->cur_ts,
+            &incl_len);
         gst_adapter_unmap (self->adapter);
-        gst_adapter_flush (self->adapter, 16);
+        gst_adapter_flush (self->adapter, PCAP_RECORD_HEADER_LEN);
+
+        if (self->pull_mode)
+          gst_pcap_parse_add_index_entry (self, self->cur_offset,
+              self->cur_ts, incl_len);
 
-        self->cur_ts = ts_sec * GST_SECOND + ts_usec * GST_USECOND;
+        self->cur_offset += PCAP_RECORD_HEADER_LEN;
         self->cur_packet_size = incl_len;
       }
     } else {
@@ -540,10 +803,10 @@ gst_pcap_parse_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
       guint32 linktype;
       guint16 major_version;
 
-      if (avail < 24)
+      if (avail < PCAP_FILE_HEADER_LEN)
         break;
 
-      data = gst_adapter_map (self->adapter, 24);
+      data = gst_adapter_map (self->adapter, PCAP_FILE_HEADER_LEN);
 
       magic = *((guint32 *) data);
       major_version = *((guint16 *) (data + 4));
@@ -580,18 +843,252 @@ gst_pcap_parse_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
       GST_DEBUG_OBJECT (self, "linktype %u", linktype);
       self->linktype = linktype;
 
-      gst_adapter_flush (self->adapter, 24);
+      gst_adapter_flush (self->adapter, PCAP_FILE_HEADER_LEN);
+      self->cur_offset += PCAP_FILE_HEADER_LEN;
+      self->index_end = self->cur_offset;
       self->initialized = TRUE;
     }
   }
 
 out:
-  if (ret != GST_FLOW_OK)
+  /* in pull mode the state is kept so that we can seek back */
+  if (ret != GST_FLOW_OK && !self->pull_mode)
     gst_pcap_parse_reset (self);
 
   return ret;
 }
 
+static void
+gst_pcap_parse_loop (GstPad * pad)
+{
+  GstPcapParse *self = GST_PCAP_PARSE (GST_PAD_PARENT (pad));
+  GstBuffer *buffer = NULL;
+  GstFlowReturn ret;
+
+  ret = gst_pad_pull_range (pad, self->pull_offset, PULL_BLOCK_SIZE, &buffer);
+  if (ret != GST_FLOW_OK)
+    goto pause;
+
+  self->pull_offset += gst_buffer_get_size (buffer);
+
+  ret = gst_pcap_parse_chain (pad, GST_OBJECT_CAST (self), buffer);
+  if (ret != GST_FLOW_OK)
+    goto pause;
+
+  return;
+
+pause:
+  {
+    const gchar *reason = gst_flow_get_name (ret);
+
+    GST_DEBUG_OBJECT (self, "pausing task, reason %s", reason);
+    gst_pad_pause_task (pad);
+    if (ret == GST_FLOW_EOS) {
+      gst_pad_push_event (self->src_pad, gst_event_new_eos ());
+    } else if (ret == GST_FLOW_NOT_LINKED || ret < GST_FLOW_EOS) {
+      GST_ELEMENT_ERROR (self, STREAM, FAILED,
+          ("Internal data flow error."),
+          ("streaming task paused, reason %s (%d)", reason, ret));
+      gst_pad_push_event (self->src_pad, gst_event_new_eos ());
+    }
+  }
+}
+
+static gboolean
+gst_pcap_parse_sink_activate (GstPad * sinkpad, GstObject * parent)
+{
+  GstQuery *query;
+  gboolean pull_mode;
+
+  query = gst_query_new_scheduling ();
+
+  if (!gst_pad_peer_query (sinkpad, query)) {
+    gst_query_unref (query);
+    goto activate_push;
+  }
+
+  pull_mode = gst_query_has_scheduling_mode_with_flags (query,
+      GST_PAD_MODE_PULL, GST_SCHEDULING_FLAG_SEEKABLE);
+  gst_query_unref (query);
+
+  if (!pull_mode)
+    goto activate_push;
+
+  GST_DEBUG_OBJECT (sinkpad, "activating pull");
+  return gst_pad_activate_mode (sinkpad, GST_PAD_MODE_PULL, TRUE);
+
+activate_push:
+  {
+    GST_DEBUG_OBJECT (sinkpad, "activating push");
+    return gst_pad_activate_mode (sinkpad, GST_PAD_MODE_PUSH, TRUE);
+  }
+}
+
+static gboolean
+gst_pcap_parse_sink_activate_mode (GstPad * pad, GstObject * parent,
+    GstPadMode mode, gboolean active)
+{
+  GstPcapParse *self = GST_PCAP_PARSE (parent);
+  gboolean res;
+
+  switch (mode) {
+    case GST_PAD_MODE_PUSH:
+      self->pull_mode = FALSE;
+      if (active)
+        gst_pcap_parse_reset (self);
+      res = TRUE;
+      break;
+    case GST_PAD_MODE_PULL:
+      if (active) {
+        self->pull_mode = TRUE;
+        gst_pcap_parse_reset (self);
+        res = gst_pad_start_task (pad, (GstTaskFunction) gst_pcap_parse_loop,
+            pad, NULL);
+      } else {
+        res = gst_pad_stop_task (pad);
+      }
+      break;
+    default:
+      res = FALSE;
+      break;
+  }
+  return res;
+}
+
+/* Convert a running position to a capture time, see ts-offset */
+static GstClockTime
+gst_pcap_parse_to_capture_time (GstPcapParse * self, GstClockTime ts)
+{
+  GstClockTime base_ts = self->base_ts;
+
+  if (self->offset < 0)
+    return ts;
+
+  if (!GST_CLOCK_TIME_IS_VALID (base_ts)) {
+    /* nothing pushed yet, the first record will be the base */
+    gst_pcap_parse_index_lookup (self, 0);
+    if (self->index->len == 0)
+      return ts;
+    base_ts = g_array_index (self->index, GstPcapParseIndexEntry, 0).ts;
+  }
+
+  if (ts < self->offset)
+    return base_ts;
+
+  return ts - self->offset + base_ts;
+}
+
+static gboolean
+gst_pcap_parse_handle_seek (GstPcapParse * self, GstEvent * event)
+{
+  gdouble rate;
+  GstFormat format;
+  GstSeekFlags flags;
+  GstSeekType start_type, stop_type;
+  gint64 start, stop;
+  gboolean flush;
+  guint64 offset;
+
+  gst_event_parse_seek (event, &rate, &format, &flags, &start_type, &start,
+      &stop_type, &stop);
+
+  if (format != GST_FORMAT_TIME || rate != 1.0 ||
+      start_type != GST_SEEK_TYPE_SET || start < 0) {
+    GST_DEBUG_OBJECT (self, "unsupported seek");
+    return FALSE;
+  }
+
+  flush = ! !(flags & GST_SEEK_FLAG_FLUSH);
+
+  if (flush)
+    gst_pad_push_event (self->src_pad, gst_event_new_flush_start ());
+  else
+    gst_pad_pause_task (self->sink_pad);
+
+  GST_PAD_STREAM_LOCK (self->sink_pad);
+
+  if (flush)
+    gst_pad_push_event (self->src_pad, gst_event_new_flush_stop (TRUE));
+
+  if (!self->initialized) {
+    GST_DEBUG_OBJECT (self, "can't seek before the header was parsed");
+    gst_pad_start_task (self->sink_pad, (GstTaskFunction) gst_pcap_parse_loop,
+        self->sink_pad, NULL);
+    GST_PAD_STREAM_UNLOCK (self->sink_pad);
+    return FALSE;
+  }
+
+  offset = gst_pcap_parse_index_lookup (self,
+      gst_pcap_parse_to_capture_time (self, start));
+
+  GST_DEBUG_OBJECT (self, "seeking to %" GST_TIME_FORMAT ", offset %"
+      G_GUINT64_FORMAT, GST_TIME_ARGS (start), offset);
+
+  gst_adapter_clear (self->adapter);
+  self->pull_offset = offset;
+  self->cur_offset = offset;
+  self->cur_packet_size = -1;
+  self->seek_ts = start;
+  if (stop_type == GST_SEEK_TYPE_SET && stop >= 0)
+    self->seek_stop = stop;
+  else
+    self->seek_stop = GST_CLOCK_TIME_NONE;
+  self->newsegment_sent = FALSE;
+  self->discont = TRUE;
+
+  gst_pad_start_task (self->sink_pad, (GstTaskFunction) gst_pcap_parse_loop,
+      self->sink_pad, NULL);
+
+  GST_PAD_STREAM_UNLOCK (self->sink_pad);
+
+  return TRUE;
+}
+
+static gboolean
+gst_pcap_parse_src_event (GstPad * pad, GstObject * parent, GstEvent * event)
+{
+  GstPcapParse *self = GST_PCAP_PARSE (parent);
+  gboolean ret;
+
+  switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_SEEK:
+      if (self->pull_mode) {
+        ret = gst_pcap_parse_handle_seek (self, event);
+        gst_event_unref (event);
+      } else {
+        ret = gst_pad_event_default (pad, parent, event);
+      }
+      break;
+    default:
+      ret = gst_pad_event_default (pad, parent, event);
+      break;
+  }
+
+  return ret;
+}
+
+static gboolean
+gst_pcap_parse_src_query (GstPad * pad, GstObject * parent, GstQuery * query)
+{
+  GstPcapParse *self = GST_PCAP_PARSE (parent);
+
+  switch (GST_QUERY_TYPE (query)) {
+    case GST_QUERY_SEEKING:
+    {
+      GstFormat format;
+
+      /* the byte offsets of the payloads have nothing to do with the ones
+       * in the capture, so only time seeks are possible */
+      gst_query_parse_seeking (query, &format, NULL, NULL, NULL);
+      gst_query_set_seeking (query, format,
+          format == GST_FORMAT_TIME && self->pull_mode, 0, -1);
+      return TRUE;
+    }
+    default:
+      return gst_pad_query_default (pad, parent, query);
+  }
+}
+
 static gboolean
 gst_pcap_sink_event (GstPad * pad, GstObject * parent, GstEvent * event)
 {
@@ -51,6 +51,28 @@ typedef enum
   DLT_SLL = 113
 } GstPcapParseLinktype;
 
+typedef enum
+{
+  PCAP_FILTER_BASE_IP,
+  PCAP_FILTER_BASE_TRANSPORT
+} GstPcapParseFilterBase;
+
+/* One comparison of the compiled packet filter, a 16 bit field is read in
+ * network byte order, a 32 bit field (an address) is compared as stored */
+typedef struct
+{
+  GstPcapParseFilterBase base;
+  guint offset;
+  guint size;
+  guint32 value;
+} GstPcapParseFilterInsn;
+
+typedef struct
+{
+  GstClockTime ts;
+  guint64 offset;
+} GstPcapParseIndexEntry;
+
 /**
  * GstPcapParse:
  *
@@ -85,6 +107,21 @@ struct _GstPcapParse
   gboolean newsegment_sent;
 
   gint64 buffer_offset;
+
+  /* compiled src/dst filter, rebuilt when the properties change */
+  GstPcapParseFilterInsn filter[4];
+  guint n_filter_insns;
+  gboolean filter_dirty;        /* OBJECT_LOCK, like the address and ports */
+
+  /* pull mode */
+  gboolean pull_mode;
+  guint64 pull_offset;
+  guint64 cur_offset;
+  GArray *index;
+  guint64 index_end;
+  GstClockTime seek_ts;
+  GstClockTime seek_stop;
+  gboolean discont;
 };
 
 struct _GstPcapParseClass
@@ -21,7 +21,16 @@
 /**
  * SECTION:element-removesilence
  *
- * Removes all silence periods from an audio stream, dropping silence buffers.
+ * Removes all silence periods from an audio stream. The stream is analysed in
+ * frames of 10 milliseconds and silent parts of a buffer are cut out at
+ * sample granularity, the remaining speech is pushed as sub-buffers sharing
+ * the memory of the input buffer.
+ *
+ * If #GstRemoveSilence:silent is set to %FALSE an element message named
+ * "removesilence" is posted on the bus whenever a silence period starts,
+ * with a "silence_detected" field holding the timestamp of its first sample,
+ * and when it ends, with a "silence_finished" field. The timestamps are
+ * interpolated from the input buffer timestamps, they are not running times.
  *
  * <refsect2>
  * <title>Example launch line</title>
@@ -45,6 +54,10 @@
 GST_DEBUG_CATEGORY_STATIC (gst_remove_silence_debug);
 #define GST_CAT_DEFAULT gst_remove_silence_debug
 #define DEFAULT_VAD_HYSTERESIS  480     /* 60 mseg */
+#define DEFAULT_SILENT          TRUE
+
+/* number of VAD frames per second */
+#define VAD_FRAMES_PER_SECOND   100
 
 /* Filter signals and args */
 enum
@@ -57,7 +70,8 @@ enum
 {
   PROP_0,
   PROP_REMOVE,
-  PROP_HYSTERESIS
+  PROP_HYSTERESIS,
+  PROP_SILENT
 };
 
 
@@ -90,6 +104,9 @@ static void gst_remove_silence_set_property (GObject * object, guint prop_id,
 static void gst_remove_silence_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec);
 
+static gboolean gst_remove_silence_set_caps (GstBaseTransform * base,
+    GstCaps * incaps, GstCaps * outcaps);
+static gboolean gst_remove_silence_start (GstBaseTransform * base);
 static GstFlowReturn gst_remove_silence_transform_ip (GstBaseTransform * base,
     GstBuffer * buf);
 static void gst_remove_silence_finalize (GObject * obj);
@@ -122,6 +139,11 @@ gst_remove_silence_class_init (GstRemoveSilenceClass * klass)
           "Set the hysteresis (on samples) used on the internal VAD",
           1, G_MAXUINT64, DEFAULT_VAD_HYSTERESIS, G_PARAM_READWRITE));
 
+  g_object_class_install_property (gobject_class, PROP_SILENT,
+      g_param_spec_boolean ("silent", "Silent",
+          "Don't post element messages when silence starts or ends",
+          DEFAULT_SILENT, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_set_static_metadata (gstelement_class,
       "RemoveSilence",
       "Filter/Effect/Audio",
@@ -134,6 +156,10 @@ gst_remove_silence_class_init (GstRemoveSilenceClass * klass)
   gst_element_class_add_pad_template (gstelement_class,
       gst_static_pad_template_get (&sink_template));
 
+  GST_BASE_TRANSFORM_CLASS (klass)->set_caps =
+      GST_DEBUG_FUNCPTR (gst_remove_silence_set_caps);
+  GST_BASE_TRANSFORM_CLASS (klass)->start =
+      GST_DEBUG_FUNCPTR (gst_remove_silence_start);
   GST_BASE_TRANSFORM_CLASS (klass)->transform_ip =
       GST_DEBUG_FUNCPTR (gst_remove_silence_transform_ip);
 }
@@ -148,6 +174,7 @@ gst_remove_silence_init (GstRemoveSilence * filter)
 {
   filter->vad = vad_new (DEFAULT_VAD_HYSTERESIS);
   filter->remove = FALSE;
+  filter->silent = DEFAULT_SILENT;
 
   if (!filter->vad) {
     GST_DEBUG ("Error initializing VAD !!");
@@ -164,6 +191,7 @@ gst_remove_silence_reset (GstRemoveSilence * filter)
   if (filter->vad) {
     vad_reset (filter->vad);
   }
+  filter->in_silence = FALSE;
   GST_DEBUG ("VAD Reseted");
 }
 
@@ -191,6 +219,9 @@ gst_remove_silence_set_property (GObject * object, guint prop_id,
     case PROP_HYSTERESIS:
       vad_set_hysteresis (filter->vad, g_value_get_uint64 (value));
       break;
+    case PROP_SILENT:
+      filter->silent = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -210,38 +241,160 @@ gst_remove_silence_get_property (GObject * object, guint prop_id,
     case PROP_HYSTERESIS:
       g_value_set_uint64 (value, vad_get_hysteresis (filter->vad));
       break;
+    case PROP_SILENT:
+      g_value_set_boolean (value, filter->silent);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
   }
 }
 
+static gboolean
+gst_remove_silence_set_caps (GstBaseTransform * trans, GstCaps * incaps,
+    GstCaps * outcaps)
+{
+  GstRemoveSilence *filter = GST_REMOVE_SILENCE (trans);
+  GstStructure *structure;
+
+  structure = gst_caps_get_structure (incaps, 0);
+  if (!gst_structure_get_int (structure, "rate", &filter->rate))
+    return FALSE;
+
+  return TRUE;
+}
+
+static gboolean
+gst_remove_silence_start (GstBaseTransform * trans)
+{
+  gst_remove_silence_reset (GST_REMOVE_SILENCE (trans));
+
+  return TRUE;
+}
+
+static GstClockTime
+gst_remove_silence_sample_time (GstRemoveSilence * filter, GstBuffer * inbuf,
+    guint offset)
+{
+  if (!GST_BUFFER_TIMESTAMP_IS_VALID (inbuf))
+    return GST_CLOCK_TIME_NONE;
+
+  return GST_BUFFER_TIMESTAMP (inbuf) +
+      gst_util_uint64_scale_int (offset, GST_SECOND, filter->rate);
+}
+
+static void
+gst_remove_silence_post_message (GstRemoveSilence * filter,
+    const gchar * field, GstClockTime timestamp)
+{
+  GstStructure *s;
+
+  GST_DEBUG_OBJECT (filter, "%s at %" GST_TIME_FORMAT, field,
+      GST_TIME_ARGS (timestamp));
+
+  if (filter->silent)
+    return;
+
+  s = gst_structure_new ("removesilence", field, G_TYPE_UINT64, timestamp,
+      NULL);
+  gst_element_post_message (GST_ELEMENT (filter),
+      gst_message_new_element (GST_OBJECT (filter), s));
+}
+
+/* pushes the speech samples [start, end[ of @inbuf downstream as a buffer
+ * sharing the memory of @inbuf */
+static GstFlowReturn
+gst_remove_silence_push_range (GstRemoveSilence * filter, GstBuffer * inbuf,
+    guint start, guint end)
+{
+  GstBuffer *outbuf;
+  GstClockTime ts;
+
+  outbuf = gst_buffer_copy_region (inbuf, GST_BUFFER_COPY_ALL,
+      start * sizeof (gint16), (end - start) * sizeof (gint16));
+
+  ts = gst_remove_silence_sample_time (filter, inbuf, start);
+  GST_BUFFER_TIMESTAMP (outbuf) = ts;
+  if (GST_CLOCK_TIME_IS_VALID (ts))
+    GST_BUFFER_DURATION (outbuf) =
+        gst_remove_silence_sample_time (filter, inbuf, end) - ts;
+  else
+    GST_BUFFER_DURATION (outbuf) = GST_CLOCK_TIME_NONE;
+  if (GST_BUFFER_OFFSET_IS_VALID (inbuf)) {
+    GST_BUFFER_OFFSET (outbuf) = GST_BUFFER_OFFSET (inbuf) + start;
+    GST_BUFFER_OFFSET_END (outbuf) = GST_BUFFER_OFFSET (inbuf) + end;
+  }
+
+  GST_LOG_OBJECT (filter, "pushing speech samples %u-%u", start, end);
+
+  return gst_pad_push (GST_BASE_TRANSFORM_SRC_PAD (filter), outbuf);
+}
+
 static GstFlowReturn
 gst_remove_silence_transform_ip (GstBaseTransform * trans, GstBuffer * inbuf)
 {
-  GstRemoveSilence *filter = NULL;
-  int frame_type;
+  GstRemoveSilence *filter = GST_REMOVE_SILENCE (trans);
+  GstFlowReturn ret = GST_FLOW_OK;
   GstMapInfo map;
-
-  filter = GST_REMOVE_SILENCE (trans);
+  gint16 *data;
+  guint n_samples, frame_size, pos, len;
+  guint speech_start = 0;
+  gboolean in_speech = FALSE;
 
   gst_buffer_map (inbuf, &map, GST_MAP_READ);
-  frame_type =
-      vad_update (filter->vad, (gint16 *) map.data, map.size / sizeof (gint16));
+  data = (gint16 *) map.data;
+  n_samples = map.size / sizeof (gint16);
+  frame_size = MAX (filter->rate / VAD_FRAMES_PER_SECOND, 1);
+
+  /* run the VAD over frames of the buffer and collect the speech ranges,
+   * each one is pushed as soon as the silence after it is found */
+  for (pos = 0; pos < n_samples; pos += len) {
+    gboolean silence;
+
+    len = MIN (frame_size, n_samples - pos);
+    silence = vad_update (filter->vad, data + pos, len) == VAD_SILENCE;
+
+    if (silence != filter->in_silence) {
+      filter->in_silence = silence;
+      gst_remove_silence_post_message (filter,
+          silence ? "silence_detected" : "silence_finished",
+          gst_remove_silence_sample_time (filter, inbuf, pos));
+    }
+
+    if (!silence && !in_speech) {
+      speech_start = pos;
+      in_speech = TRUE;
+    } else if (silence && in_speech) {
+      in_speech = FALSE;
+      if (filter->remove) {
+        ret = gst_remove_silence_push_range (filter, inbuf, speech_start, pos);
+        if (ret != GST_FLOW_OK)
+          break;
+      }
+    }
+  }
   gst_buffer_unmap (inbuf, &map);
 
-  if (frame_type == VAD_SILENCE) {
+  if (!filter->remove)
+    return GST_FLOW_OK;
 
-    GST_DEBUG ("Silence detected");
+  if (ret != GST_FLOW_OK)
+    return ret;
 
-    if (filter->remove) {
-      GST_DEBUG ("Removing silence");
-      return GST_BASE_TRANSFORM_FLOW_DROPPED;
-    }
+  if (in_speech) {
+    /* the whole buffer is speech, pass it on unchanged */
+    if (speech_start == 0)
+      return GST_FLOW_OK;
 
+    ret = gst_remove_silence_push_range (filter, inbuf, speech_start,
+        n_samples);
+    if (ret != GST_FLOW_OK)
+      return ret;
   }
 
-  return GST_FLOW_OK;
+  GST_LOG_OBJECT (filter, "removing silence");
+
+  return GST_BASE_TRANSFORM_FLOW_DROPPED;
 }
 
 /*Plugin init functions*/
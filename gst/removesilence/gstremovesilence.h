@@ -43,6 +43,10 @@ typedef struct _GstRemoveSilence {
   GstBaseTransform parent;
   VADFilter* vad;
   gboolean remove;
+  gboolean silent;
+  gint rate;
+  /* whether the last analysed frame was silence */
+  gboolean in_silence;
 } GstRemoveSilence;
 
 typedef struct _GstRemoveSilenceClass {
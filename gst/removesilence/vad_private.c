@@ -65,7 +65,7 @@ struct _vad_s
 VADFilter *
 vad_new (guint64 hysteresis)
 {
-  VADFilter *vad = malloc (sizeof (VADFilter));
+  VADFilter *vad = calloc (1, sizeof (VADFilter));
   vad_reset (vad);
   vad->hysteresis = hysteresis;
   return vad;
@@ -74,7 +74,10 @@ vad_new (guint64 hysteresis)
 void
 vad_reset (VADFilter * vad)
 {
+  guint64 hysteresis = vad->hysteresis;
+
   memset (vad, 0, sizeof (*vad));
+  vad->hysteresis = hysteresis;
   vad->cqueue.base.s = vad->vad_buffer;
   vad->cqueue.tail.a = vad->cqueue.head.a = 0;
   vad->cqueue.size = VAD_BUFFER_SIZE;
@@ -99,35 +102,41 @@ vad_get_hysteresis (struct _vad_s *p)
   return p->hysteresis;
 }
 
+/* +1 if the two samples have a different sign, -1 otherwise */
+#define ZCR_STEP(_a, _b) ((((_a) ^ (_b)) & 0x8000) ? 1 : -1)
+
 gint
 vad_update (struct _vad_s * p, gint16 * data, gint len)
 {
-  guint64 tail;
+  guint64 power = p->vad_power;
+  gint16 *queue = p->cqueue.base.s;
+  guint64 head = p->cqueue.head.a;
+  guint64 tail = p->cqueue.tail.a;
+  guint64 mask = p->cqueue.size - 1;
   gint frame_type;
-  gint16 sample;
   gint i;
 
+  /* The zero crossing rate over the samples in the queue is kept up to date
+   * as samples are added and dropped, instead of going over the whole queue
+   * for every update. */
   for (i = 0; i < len; i++) {
-    p->vad_power = VAD_POWER_ALPHA * ((data[i] * data[i] >> 14) & 0xFFFF) +
-        (0xFFFF - VAD_POWER_ALPHA) * (p->vad_power >> 16) +
-        ((0xFFFF - VAD_POWER_ALPHA) * (p->vad_power & 0xFFFF) >> 16);
+    power = VAD_POWER_ALPHA * ((data[i] * data[i] >> 14) & 0xFFFF) +
+        (0xFFFF - VAD_POWER_ALPHA) * (power >> 16) +
+        ((0xFFFF - VAD_POWER_ALPHA) * (power & 0xFFFF) >> 16);
     /* Update VAD buffer */
-    p->cqueue.base.s[p->cqueue.head.a] = data[i];
-    p->cqueue.head.a = (p->cqueue.head.a + 1) & (p->cqueue.size - 1);
-    if (p->cqueue.head.a == p->cqueue.tail.a)
-      p->cqueue.tail.a = (p->cqueue.tail.a + 1) & (p->cqueue.size - 1);
+    if (head != tail)
+      p->vad_zcr += ZCR_STEP (queue[(head - 1) & mask], data[i]);
+    queue[head] = data[i];
+    head = (head + 1) & mask;
+    if (head == tail) {
+      p->vad_zcr -= ZCR_STEP (queue[tail], queue[(tail + 1) & mask]);
+      tail = (tail + 1) & mask;
+    }
   }
 
-  tail = p->cqueue.tail.a;
-  p->vad_zcr = 0;
-  for (;;) {
-    sample = p->cqueue.base.s[tail];
-    tail = (tail + 1) & (p->cqueue.size - 1);
-    if (tail == p->cqueue.head.a)
-      break;
-    p->vad_zcr +=
-        ((sample & 0x8000) != (p->cqueue.base.s[tail] & 0x8000)) ? 1 : -1;
-  }
+  p->vad_power = power;
+  p->cqueue.head.a = head;
+  p->cqueue.tail.a = tail;
 
   frame_type = (p->vad_power > VAD_POWER_THRESHOLD
       && p->vad_zcr < VAD_ZCR_THRESHOLD) ? VAD_VOICE : VAD_SILENCE;
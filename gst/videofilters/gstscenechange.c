@@ -30,6 +30,13 @@
  * can be used to align the synchronization points among multiple
  * video encoders, which is useful for segmented streaming.
  *
+ * If #GstSceneChange:post-messages is set, an element message named
+ * "GstSceneChange" is posted for every detected cut.  With
+ * #GstSceneChange:detect-fades, messages are also posted when the
+ * video fades to or from black.  The message contains the "timestamp"
+ * of the frame, its "type" ("cut", "fade-out" or "fade-in"), the
+ * "score" and the "analysis-time" spent on the frame in nanoseconds.
+ *
  * The scenechange element does not work with compressed video.
  *
  * <refsect2>
@@ -47,7 +54,8 @@
  *  http://sourceforge.net/projects/shot-change/
  *
  * The method is relatively simple.  Calculate the sum of absolute
- * differences of a picture and the previous picture, and compare this
+ * differences of a picture and the previous picture (both downscaled
+ * by SC_THUMB_SCALE in each direction), and compare this
  * picture difference value with neighboring pictures.  In the original
  * algorithm, the value is compared to a configurable number of past
  * and future pictures.  However, comparing to future frames requires
@@ -68,6 +76,13 @@
  * of detection, and then write an automatic tuning system as opposed
  * to the manual tuning I did here.
  *
+ * The absolute score thresholds were tuned on full resolution pictures,
+ * the low one is scaled down for the noise that the downscaling removes.
+ * Scores that fall between the clear cases are decided by the
+ * distance between the luma histograms of the downscaled pictures.
+ * Only the downscaled luma of the previous picture is kept, so the
+ * previous buffer does not have to stay alive.
+ *
  * Inside the TESTING define are some hard-coded (mostly hand-written)
  * scene change frame numbers for some easily available sequences.
  *
@@ -81,6 +96,7 @@
 #include <gst/video/video.h>
 #include <gst/video/gstvideofilter.h>
 #include <string.h>
+#include <math.h>
 #include "gstscenechange.h"
 
 GST_DEBUG_CATEGORY_STATIC (gst_scene_change_debug_category);
@@ -89,6 +105,15 @@ GST_DEBUG_CATEGORY_STATIC (gst_scene_change_debug_category);
 /* prototypes */
 
 
+static void gst_scene_change_set_property (GObject * object,
+    guint property_id, const GValue * value, GParamSpec * pspec);
+static void gst_scene_change_get_property (GObject * object,
+    guint property_id, GValue * value, GParamSpec * pspec);
+static void gst_scene_change_finalize (GObject * object);
+static gboolean gst_scene_change_stop (GstBaseTransform * trans);
+static gboolean gst_scene_change_set_info (GstVideoFilter * filter,
+    GstCaps * incaps, GstVideoInfo * in_info, GstCaps * outcaps,
+    GstVideoInfo * out_info);
 static GstFlowReturn gst_scene_change_transform_frame_ip (GstVideoFilter *
     filter, GstVideoFrame * frame);
 
@@ -99,9 +124,25 @@ static gboolean is_shot_change (int frame_number);
 
 enum
 {
-  PROP_0
+  PROP_0,
+  PROP_POST_MESSAGES,
+  PROP_DETECT_FADES
 };
 
+#define DEFAULT_POST_MESSAGES FALSE
+#define DEFAULT_DETECT_FADES FALSE
+
+/* pictures are analysed at 1/SC_THUMB_SCALE of their size */
+#define SC_THUMB_SCALE 4
+/* mean absolute luma difference of full resolution pictures below which
+ * nothing changed, and above which the picture changed in any case */
+#define SC_SCORE_LOW 5.0
+#define SC_SCORE_HIGH 50.0
+/* histogram distance (0.0 - 1.0) above which an ambiguous score is a cut */
+#define SC_HIST_THRESHOLD 0.4
+/* mean luma below which a picture counts as black for fade detection */
+#define SC_BLACK_LEVEL 24
+
 #define VIDEO_CAPS \
     GST_VIDEO_CAPS_MAKE("{ I420, Y42B, Y41B, Y444 }")
 
@@ -115,6 +156,9 @@ G_DEFINE_TYPE_WITH_CODE (GstSceneChange, gst_scene_change,
 static void
 gst_scene_change_class_init (GstSceneChangeClass * klass)
 {
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+  GstBaseTransformClass *base_transform_class =
+      GST_BASE_TRANSFORM_CLASS (klass);
   GstVideoFilterClass *video_filter_class = GST_VIDEO_FILTER_CLASS (klass);
 
   gst_element_class_add_pad_template (GST_ELEMENT_CLASS (klass),
@@ -129,9 +173,24 @@ gst_scene_change_class_init (GstSceneChangeClass * klass)
       "Video/Filter", "Detects scene changes in video",
       "David Schleef <ds@entropywave.com>");
 
+  gobject_class->set_property = gst_scene_change_set_property;
+  gobject_class->get_property = gst_scene_change_get_property;
+  gobject_class->finalize = gst_scene_change_finalize;
+  base_transform_class->stop = GST_DEBUG_FUNCPTR (gst_scene_change_stop);
+  video_filter_class->set_info = GST_DEBUG_FUNCPTR (gst_scene_change_set_info);
   video_filter_class->transform_frame_ip =
       GST_DEBUG_FUNCPTR (gst_scene_change_transform_frame_ip);
 
+  g_object_class_install_property (gobject_class, PROP_POST_MESSAGES,
+      g_param_spec_boolean ("post-messages", "Post messages",
+          "Post an element message for every detected scene change",
+          DEFAULT_POST_MESSAGES,
+          G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_DETECT_FADES,
+      g_param_spec_boolean ("detect-fades", "Detect fades",
+          "Post element messages for fades to and from black",
+          DEFAULT_DETECT_FADES,
+          G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
 }
 
 static void
@@ -139,69 +198,237 @@ gst_scene_change_init (GstSceneChange * scenechange)
 {
 }
 
+static void
+gst_scene_change_set_property (GObject * object, guint property_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstSceneChange *scenechange = GST_SCENE_CHANGE (object);
+
+  switch (property_id) {
+    case PROP_POST_MESSAGES:
+      scenechange->post_messages = g_value_get_boolean (value);
+      break;
+    case PROP_DETECT_FADES:
+      scenechange->detect_fades = g_value_get_boolean (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+  }
+}
 
-static double
-get_frame_score (GstVideoFrame * f1, GstVideoFrame * f2)
+static void
+gst_scene_change_get_property (GObject * object, guint property_id,
+    GValue * value, GParamSpec * pspec)
 {
-  int i;
-  int j;
-  int score = 0;
-  int width, height;
-  guint8 *s1;
-  guint8 *s2;
-
-  width = f1->info.width;
-  height = f1->info.height;
-
-  for (j = 0; j < height; j++) {
-    s1 = (guint8 *) f1->data[0] + f1->info.stride[0] * j;
-    s2 = (guint8 *) f2->data[0] + f2->info.stride[0] * j;
-    for (i = 0; i < width; i++) {
-      score += ABS (s1[i] - s2[i]);
+  GstSceneChange *scenechange = GST_SCENE_CHANGE (object);
+
+  switch (property_id) {
+    case PROP_POST_MESSAGES:
+      g_value_set_boolean (value, scenechange->post_messages);
+      break;
+    case PROP_DETECT_FADES:
+      g_value_set_boolean (value, scenechange->detect_fades);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_scene_change_free_thumbs (GstSceneChange * scenechange)
+{
+  g_free (scenechange->thumbs[0].data);
+  scenechange->thumbs[0].data = NULL;
+  g_free (scenechange->thumbs[1].data);
+  scenechange->thumbs[1].data = NULL;
+  g_free (scenechange->row_sums);
+  scenechange->row_sums = NULL;
+  scenechange->have_old = FALSE;
+}
+
+static void
+gst_scene_change_finalize (GObject * object)
+{
+  gst_scene_change_free_thumbs (GST_SCENE_CHANGE (object));
+
+  G_OBJECT_CLASS (gst_scene_change_parent_class)->finalize (object);
+}
+
+static gboolean
+gst_scene_change_stop (GstBaseTransform * trans)
+{
+  GstSceneChange *scenechange = GST_SCENE_CHANGE (trans);
+
+  gst_scene_change_free_thumbs (scenechange);
+  scenechange->thumb_width = 0;
+  scenechange->thumb_height = 0;
+
+  return TRUE;
+}
+
+static gboolean
+gst_scene_change_set_info (GstVideoFilter * filter, GstCaps * incaps,
+    GstVideoInfo * in_info, GstCaps * outcaps, GstVideoInfo * out_info)
+{
+  GstSceneChange *scenechange = GST_SCENE_CHANGE (filter);
+  int width = GST_VIDEO_INFO_WIDTH (in_info);
+  int height = GST_VIDEO_INFO_HEIGHT (in_info);
+  int size;
+
+  gst_scene_change_free_thumbs (scenechange);
+
+  scenechange->block_width = MIN (width, SC_THUMB_SCALE);
+  scenechange->block_height = MIN (height, SC_THUMB_SCALE);
+  scenechange->thumb_width = width / scenechange->block_width;
+  scenechange->thumb_height = height / scenechange->block_height;
+
+  size = scenechange->thumb_width * scenechange->thumb_height;
+  scenechange->thumbs[0].data = g_malloc (size);
+  scenechange->thumbs[1].data = g_malloc (size);
+  scenechange->row_sums = g_new (guint, scenechange->thumb_width);
+
+  /* The low score keeps noise from being taken for a change. Averaging the
+   * blocks reduces uncorrelated noise by the square root of the number of
+   * pixels in a block. Changes that are uniform over a block, which is what
+   * the high score is about, keep their full resolution score. */
+  scenechange->score_low = SC_SCORE_LOW /
+      sqrt (scenechange->block_width * scenechange->block_height);
+
+  GST_DEBUG_OBJECT (scenechange, "analysing at %dx%d, low score %g",
+      scenechange->thumb_width, scenechange->thumb_height,
+      scenechange->score_low);
+
+  return TRUE;
+}
+
+/* averages block_width x block_height blocks of the luma plane into
+ * @thumb and fills in its histogram and mean */
+static void
+gst_scene_change_make_thumb (GstSceneChange * scenechange,
+    GstVideoFrame * frame, GstSceneChangeThumb * thumb)
+{
+  int tw = scenechange->thumb_width;
+  int th = scenechange->thumb_height;
+  int bw = scenechange->block_width;
+  int bh = scenechange->block_height;
+  int n = bw * bh;
+  guint *sums = scenechange->row_sums;
+  guint8 *d = thumb->data;
+  guint64 total = 0;
+  int i, j, k, y;
+
+  memset (thumb->hist, 0, sizeof (thumb->hist));
+
+  for (j = 0; j < th; j++) {
+    memset (sums, 0, tw * sizeof (guint));
+    for (y = 0; y < bh; y++) {
+      const guint8 *s = (guint8 *) frame->data[0] +
+          frame->info.stride[0] * (j * bh + y);
+
+      for (i = 0; i < tw; i++) {
+        for (k = 0; k < bw; k++)
+          sums[i] += s[k];
+        s += bw;
+      }
     }
+    for (i = 0; i < tw; i++) {
+      guint v = (sums[i] + n / 2) / n;
+
+      d[i] = v;
+      thumb->hist[v * SC_HIST_BINS / 256]++;
+      total += v;
+    }
+    d += tw;
   }
 
-  return ((double) score) / (width * height);
+  thumb->mean = total / (tw * th);
+}
+
+static double
+get_frame_score (const guint8 * t1, const guint8 * t2, int n)
+{
+  int i;
+  guint score = 0;
+
+  for (i = 0; i < n; i++)
+    score += ABS (t1[i] - t2[i]);
+
+  return ((double) score) / n;
+}
+
+/* 0.0 for identical histograms, 1.0 for disjoint ones */
+static double
+get_hist_distance (const guint * h1, const guint * h2, int n)
+{
+  int i;
+  guint dist = 0;
+
+  for (i = 0; i < SC_HIST_BINS; i++)
+    dist += ABS ((gint) h1[i] - (gint) h2[i]);
+
+  return ((double) dist) / (2 * n);
+}
+
+static void
+gst_scene_change_post_message (GstSceneChange * scenechange,
+    GstVideoFrame * frame, const gchar * type, double score, gint64 start)
+{
+  GstStructure *s;
+  guint64 analysis_time;
+
+  analysis_time = (g_get_monotonic_time () - start) * GST_USECOND;
+
+  s = gst_structure_new ("GstSceneChange",
+      "timestamp", G_TYPE_UINT64, GST_BUFFER_PTS (frame->buffer),
+      "type", G_TYPE_STRING, type,
+      "score", G_TYPE_DOUBLE, score,
+      "analysis-time", G_TYPE_UINT64, analysis_time, NULL);
+
+  gst_element_post_message (GST_ELEMENT_CAST (scenechange),
+      gst_message_new_element (GST_OBJECT_CAST (scenechange), s));
 }
 
+
 static GstFlowReturn
 gst_scene_change_transform_frame_ip (GstVideoFilter * filter,
     GstVideoFrame * frame)
 {
   GstSceneChange *scenechange = GST_SCENE_CHANGE (filter);
-  GstVideoFrame oldframe;
+  GstSceneChangeThumb *thumb;
+  GstSceneChangeThumb *oldthumb;
   double score_min;
   double score_max;
   double threshold;
   double score;
   gboolean change;
-  gboolean ret;
+  gboolean black;
+  gint64 start;
+  int n;
   int i;
 
   GST_DEBUG_OBJECT (scenechange, "transform_frame_ip");
 
-  if (!scenechange->oldbuf) {
+  start = g_get_monotonic_time ();
+
+  thumb = &scenechange->thumbs[scenechange->cur_thumb];
+  oldthumb = &scenechange->thumbs[!scenechange->cur_thumb];
+  n = scenechange->thumb_width * scenechange->thumb_height;
+
+  gst_scene_change_make_thumb (scenechange, frame, thumb);
+  scenechange->cur_thumb = !scenechange->cur_thumb;
+  black = thumb->mean < SC_BLACK_LEVEL;
+
+  if (!scenechange->have_old) {
     scenechange->n_diffs = 0;
     memset (scenechange->diffs, 0, sizeof (double) * SC_N_DIFFS);
-    scenechange->oldbuf = gst_buffer_ref (frame->buffer);
+    scenechange->have_old = TRUE;
+    scenechange->in_black = black;
     return GST_FLOW_OK;
   }
 
-  ret =
-      gst_video_frame_map (&oldframe, &scenechange->oldinfo,
-      scenechange->oldbuf, GST_MAP_READ);
-  if (!ret) {
-    GST_ERROR_OBJECT (scenechange, "failed to map old video frame");
-    return GST_FLOW_ERROR;
-  }
-
-  score = get_frame_score (&oldframe, frame);
-
-  gst_video_frame_unmap (&oldframe);
-
-  gst_buffer_unref (scenechange->oldbuf);
-  scenechange->oldbuf = gst_buffer_ref (frame->buffer);
-  memcpy (&scenechange->oldinfo, &frame->info, sizeof (GstVideoInfo));
+  score = get_frame_score (oldthumb->data, thumb->data, n);
 
   memmove (scenechange->diffs, scenechange->diffs + 1,
       sizeof (double) * (SC_N_DIFFS - 1));
@@ -218,16 +445,18 @@ gst_scene_change_transform_frame_ip (GstVideoFilter * filter,
   threshold = 1.8 * score_max - 0.8 * score_min;
 
   if (scenechange->n_diffs > 2) {
-    if (score < 5) {
+    if (score < scenechange->score_low) {
       change = FALSE;
     } else if (score / threshold < 1.0) {
       change = FALSE;
     } else if (score / threshold > 2.5) {
       change = TRUE;
-    } else if (score > 50) {
+    } else if (score > SC_SCORE_HIGH) {
       change = TRUE;
     } else {
-      change = FALSE;
+      /* ambiguous, let the luma distribution decide */
+      change = get_hist_distance (oldthumb->hist, thumb->hist, n) >
+          SC_HIST_THRESHOLD;
     }
   } else {
     change = FALSE;
@@ -252,7 +481,21 @@ gst_scene_change_transform_frame_ip (GstVideoFilter * filter,
         scenechange->count++);
 
     gst_pad_push_event (GST_BASE_TRANSFORM_SRC_PAD (scenechange), event);
+
+    if (scenechange->post_messages)
+      gst_scene_change_post_message (scenechange, frame, "cut", score, start);
+  }
+
+  if (scenechange->detect_fades && black != scenechange->in_black) {
+    GST_INFO_OBJECT (scenechange, "fade %s, mean luma %u",
+        black ? "out" : "in", thumb->mean);
+    gst_scene_change_post_message (scenechange, frame,
+        black ? "fade-out" : "fade-in", score, start);
   }
+  scenechange->in_black = black;
+
+  GST_LOG_OBJECT (scenechange, "analysis took %" G_GINT64_FORMAT " us",
+      g_get_monotonic_time () - start);
 
   return GST_FLOW_OK;
 }
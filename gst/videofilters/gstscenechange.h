@@ -35,6 +35,15 @@ typedef struct _GstSceneChange GstSceneChange;
 typedef struct _GstSceneChangeClass GstSceneChangeClass;
 
 #define SC_N_DIFFS 5
+#define SC_HIST_BINS 64
+
+/* downscaled luma of a frame, all analysis works on these */
+typedef struct
+{
+  guint8 *data;
+  guint hist[SC_HIST_BINS];
+  guint mean;
+} GstSceneChangeThumb;
 
 struct _GstSceneChange
 {
@@ -42,9 +51,22 @@ struct _GstSceneChange
 
   int n_diffs;
   double diffs[SC_N_DIFFS];
-  GstBuffer *oldbuf;
-  GstVideoInfo oldinfo;
   int count;
+
+  /* properties */
+  gboolean post_messages;
+  gboolean detect_fades;
+
+  int thumb_width;
+  int thumb_height;
+  int block_width;
+  int block_height;
+  double score_low;
+  GstSceneChangeThumb thumbs[2];
+  guint *row_sums;
+  int cur_thumb;
+  gboolean have_old;
+  gboolean in_black;
 };
 
 struct _GstSceneChangeClass
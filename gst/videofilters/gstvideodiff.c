@@ -19,14 +19,68 @@
 /**
  * SECTION:element-gstvideodiff
  *
- * The videodiff element does FIXME stuff.
+ * The videodiff element compares every frame with the previous one and
+ * paints the luma samples that changed by more than
+ * #GstVideoDiff:threshold with a stripe pattern.
+ *
+ * The frame is split into a grid of #GstVideoDiff:tile-columns by
+ * #GstVideoDiff:tile-rows tiles whose rows are processed on
+ * #GstVideoDiff:n-threads threads.  If #GstVideoDiff:post-messages is
+ * enabled, an element message named
+ * <classname>&quot;GstVideoDiff&quot;</classname> is posted for every frame.
+ * It contains:
+ * <itemizedlist>
+ * <listitem>
+ *   <para>
+ *   #GstClockTime
+ *   <classname>&quot;timestamp&quot;</classname>:
+ *   the timestamp of the frame.
+ *   </para>
+ * </listitem>
+ * <listitem>
+ *   <para>
+ *   #guint
+ *   <classname>&quot;changed-pixels&quot;</classname>:
+ *   the number of luma samples that changed.
+ *   </para>
+ * </listitem>
+ * <listitem>
+ *   <para>
+ *   #gint
+ *   <classname>&quot;tile-columns&quot;</classname>,
+ *   <classname>&quot;tile-rows&quot;</classname>:
+ *   the size of the grid of tiles, which is smaller than configured for
+ *   very small frames.
+ *   </para>
+ * </listitem>
+ * <listitem>
+ *   <para>
+ *   #GstValueArray
+ *   <classname>&quot;tile-changed-pixels&quot;</classname>,
+ *   <classname>&quot;tile-luma-min&quot;</classname>,
+ *   <classname>&quot;tile-luma-max&quot;</classname>:
+ *   the number of changed luma samples and the smallest and largest luma
+ *   of every tile, row by row, as #guint.
+ *   </para>
+ * </listitem>
+ * <listitem>
+ *   <para>
+ *   #GstValueArray
+ *   <classname>&quot;tile-mean-difference&quot;</classname>,
+ *   <classname>&quot;tile-luma-average&quot;</classname>,
+ *   <classname>&quot;tile-luma-variance&quot;</classname>:
+ *   the average absolute luma difference to the previous frame and the
+ *   average and variance of the luma of every tile, as #gdouble.
+ *   </para>
+ * </listitem>
+ * </itemizedlist>
  *
  * <refsect2>
  * <title>Example launch line</title>
  * |[
- * gst-launch -v fakesrc ! videodiff ! FIXME ! fakesink
+ * gst-launch -v videotestsrc pattern=ball ! videodiff ! videoconvert ! autovideosink
  * ]|
- * FIXME Describe what the pipeline does.
+ * This pipeline shows the moving ball painted with stripes.
  * </refsect2>
  */
 
@@ -44,23 +98,44 @@ GST_DEBUG_CATEGORY_STATIC (gst_video_diff_debug_category);
 
 /* prototypes */
 
+static void gst_video_diff_set_property (GObject * object,
+    guint property_id, const GValue * value, GParamSpec * pspec);
+static void gst_video_diff_get_property (GObject * object,
+    guint property_id, GValue * value, GParamSpec * pspec);
+static void gst_video_diff_finalize (GObject * object);
+static gboolean gst_video_diff_stop (GstBaseTransform * trans);
+static gboolean gst_video_diff_set_info (GstVideoFilter * filter,
+    GstCaps * incaps, GstVideoInfo * in_info, GstCaps * outcaps,
+    GstVideoInfo * out_info);
 static GstFlowReturn gst_video_diff_transform_frame (GstVideoFilter * filter,
     GstVideoFrame * inframe, GstVideoFrame * outframe);
 
 enum
 {
-  PROP_0
+  PROP_0,
+  PROP_THRESHOLD,
+  PROP_POST_MESSAGES,
+  PROP_TILE_COLUMNS,
+  PROP_TILE_ROWS,
+  PROP_N_THREADS
 };
 
+#define DEFAULT_THRESHOLD 10
+#define DEFAULT_POST_MESSAGES FALSE
+#define DEFAULT_TILE_COLUMNS 1
+#define DEFAULT_TILE_ROWS 1
+#define DEFAULT_N_THREADS 1
+
+#define MAX_TILES 256
+#define MAX_THREADS 64
+
 /* pad templates */
 
-/* FIXME: add/remove formats you can handle */
 #define VIDEO_SRC_CAPS \
-    GST_VIDEO_CAPS_MAKE("{ I420, Y444, Y42B, UYVY, RGBA }")
+    GST_VIDEO_CAPS_MAKE("{ I420, Y444, Y42B, Y41B }")
 
-/* FIXME: add/remove formats you can handle */
 #define VIDEO_SINK_CAPS \
-    GST_VIDEO_CAPS_MAKE("{ I420, Y444, Y42B, UYVY, RGBA }")
+    GST_VIDEO_CAPS_MAKE("{ I420, Y444, Y42B, Y41B }")
 
 
 /* class initialization */
@@ -72,6 +147,9 @@ G_DEFINE_TYPE_WITH_CODE (GstVideoDiff, gst_video_diff, GST_TYPE_VIDEO_FILTER,
 static void
 gst_video_diff_class_init (GstVideoDiffClass * klass)
 {
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+  GstBaseTransformClass *base_transform_class =
+      GST_BASE_TRANSFORM_CLASS (klass);
   GstVideoFilterClass *video_filter_class = GST_VIDEO_FILTER_CLASS (klass);
 
   /* Setting up pads and setting metadata should be moved to
@@ -84,57 +162,381 @@ gst_video_diff_class_init (GstVideoDiffClass * klass)
           gst_caps_from_string (VIDEO_SINK_CAPS)));
 
   gst_element_class_set_static_metadata (GST_ELEMENT_CLASS (klass),
-      "FIXME Long name", "Generic", "FIXME Description",
+      "Video difference", "Filter/Analyzer/Video",
+      "Highlights and measures the differences between consecutive frames",
       "FIXME <fixme@example.com>");
 
+  gobject_class->set_property = gst_video_diff_set_property;
+  gobject_class->get_property = gst_video_diff_get_property;
+  gobject_class->finalize = gst_video_diff_finalize;
+  base_transform_class->stop = GST_DEBUG_FUNCPTR (gst_video_diff_stop);
+  video_filter_class->set_info = GST_DEBUG_FUNCPTR (gst_video_diff_set_info);
   video_filter_class->transform_frame =
       GST_DEBUG_FUNCPTR (gst_video_diff_transform_frame);
 
+  g_object_class_install_property (gobject_class, PROP_THRESHOLD,
+      g_param_spec_int ("threshold", "Threshold",
+          "Luma difference above which a sample counts as changed",
+          0, 255, DEFAULT_THRESHOLD,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_POST_MESSAGES,
+      g_param_spec_boolean ("post-messages", "Post messages",
+          "Post an element message with the tile statistics of every frame",
+          DEFAULT_POST_MESSAGES, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_TILE_COLUMNS,
+      g_param_spec_int ("tile-columns", "Tile columns",
+          "Number of columns of tiles the statistics are gathered for",
+          1, MAX_TILES, DEFAULT_TILE_COLUMNS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_TILE_ROWS,
+      g_param_spec_int ("tile-rows", "Tile rows",
+          "Number of rows of tiles the statistics are gathered for, "
+          "which is also the maximum number of bands processed in parallel",
+          1, MAX_TILES, DEFAULT_TILE_ROWS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      g_param_spec_int ("n-threads", "Number of Threads",
+          "Number of threads used to process a frame "
+          "(0 == number of processors)", 0, MAX_THREADS, DEFAULT_N_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 }
 
 static void
 gst_video_diff_init (GstVideoDiff * videodiff)
 {
-  videodiff->threshold = 10;
+  videodiff->threshold = DEFAULT_THRESHOLD;
+  videodiff->post_messages = DEFAULT_POST_MESSAGES;
+  videodiff->tile_columns = DEFAULT_TILE_COLUMNS;
+  videodiff->tile_rows = DEFAULT_TILE_ROWS;
+  videodiff->n_threads = DEFAULT_N_THREADS;
+
+  g_mutex_init (&videodiff->lock);
+  g_cond_init (&videodiff->cond);
 }
 
-static GstFlowReturn
-gst_video_diff_transform_frame_ip_planarY (GstVideoDiff * videodiff,
-    GstVideoFrame * outframe, GstVideoFrame * inframe, GstVideoFrame * oldframe)
+static void
+gst_video_diff_set_property (GObject * object, guint property_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstVideoDiff *videodiff = GST_VIDEO_DIFF (object);
+
+  GST_OBJECT_LOCK (videodiff);
+  switch (property_id) {
+    case PROP_THRESHOLD:
+      videodiff->threshold = g_value_get_int (value);
+      break;
+    case PROP_POST_MESSAGES:
+      videodiff->post_messages = g_value_get_boolean (value);
+      break;
+    case PROP_TILE_COLUMNS:
+      videodiff->tile_columns = g_value_get_int (value);
+      videodiff->grid_changed = TRUE;
+      break;
+    case PROP_TILE_ROWS:
+      videodiff->tile_rows = g_value_get_int (value);
+      videodiff->grid_changed = TRUE;
+      break;
+    case PROP_N_THREADS:
+      videodiff->n_threads = g_value_get_int (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+  }
+  GST_OBJECT_UNLOCK (videodiff);
+}
+
+static void
+gst_video_diff_get_property (GObject * object, guint property_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstVideoDiff *videodiff = GST_VIDEO_DIFF (object);
+
+  GST_OBJECT_LOCK (videodiff);
+  switch (property_id) {
+    case PROP_THRESHOLD:
+      g_value_set_int (value, videodiff->threshold);
+      break;
+    case PROP_POST_MESSAGES:
+      g_value_set_boolean (value, videodiff->post_messages);
+      break;
+    case PROP_TILE_COLUMNS:
+      g_value_set_int (value, videodiff->tile_columns);
+      break;
+    case PROP_TILE_ROWS:
+      g_value_set_int (value, videodiff->tile_rows);
+      break;
+    case PROP_N_THREADS:
+      g_value_set_int (value, videodiff->n_threads);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+  }
+  GST_OBJECT_UNLOCK (videodiff);
+}
+
+static void
+gst_video_diff_reset (GstVideoDiff * videodiff)
+{
+  gst_buffer_replace (&videodiff->previous_buffer, NULL);
+  gst_video_tile_grid_clear (&videodiff->grid);
+  g_free (videodiff->masks);
+  videodiff->masks = NULL;
+}
+
+static void
+gst_video_diff_finalize (GObject * object)
+{
+  GstVideoDiff *videodiff = GST_VIDEO_DIFF (object);
+
+  if (videodiff->pool)
+    g_thread_pool_free (videodiff->pool, FALSE, TRUE);
+  videodiff->pool = NULL;
+
+  gst_video_diff_reset (videodiff);
+
+  g_mutex_clear (&videodiff->lock);
+  g_cond_clear (&videodiff->cond);
+
+  G_OBJECT_CLASS (gst_video_diff_parent_class)->finalize (object);
+}
+
+static gboolean
+gst_video_diff_stop (GstBaseTransform * trans)
+{
+  GstVideoDiff *videodiff = GST_VIDEO_DIFF (trans);
+
+  gst_buffer_replace (&videodiff->previous_buffer, NULL);
+
+  return TRUE;
+}
+
+static gboolean
+gst_video_diff_set_info (GstVideoFilter * filter, GstCaps * incaps,
+    GstVideoInfo * in_info, GstCaps * outcaps, GstVideoInfo * out_info)
+{
+  GstVideoDiff *videodiff = GST_VIDEO_DIFF (filter);
+
+  /* the previous frame can not be compared with frames of other caps */
+  gst_video_diff_reset (videodiff);
+
+  videodiff->masks = g_malloc (GST_VIDEO_INFO_WIDTH (in_info) * MAX_THREADS);
+  videodiff->grid_changed = TRUE;
+
+  return TRUE;
+}
+
+typedef struct
 {
-  int width = inframe->info.width;
-  int height = inframe->info.height;
-  int i, j;
-  int threshold = videodiff->threshold;
+  GstVideoFrame *inframe;
+  GstVideoFrame *outframe;
+  GstVideoFrame *oldframe;
+  guint8 *mask;
+  int threshold;
+  int start, end;
+} GstVideoDiffBand;
+
+/* Compares the lines of tile rows [start, end) with the previous frame,
+ * gathers their statistics and paints the changed samples */
+static void
+gst_video_diff_process_band (GstVideoDiff * videodiff, GstVideoDiffBand * band)
+{
+  GstVideoTileGrid *grid = &videodiff->grid;
+  int width = GST_VIDEO_FRAME_COMP_WIDTH (band->inframe, 0);
   int t = videodiff->t;
+  int row, i, j;
+
+  for (row = band->start; row < band->end; row++) {
+    gst_video_tile_grid_reset_row (grid, row);
+
+    for (j = grid->row_start[row]; j < grid->row_start[row + 1]; j++) {
+      guint8 *d = (guint8 *) band->outframe->data[0] +
+          band->outframe->info.stride[0] * j;
+      guint8 *s2 = (guint8 *) band->inframe->data[0] +
+          band->inframe->info.stride[0] * j;
+
+      if (band->oldframe) {
+        guint8 *s1 = (guint8 *) band->oldframe->data[0] +
+            band->oldframe->info.stride[0] * j;
+        guint8 *mask = band->mask;
+
+        gst_video_tile_grid_add_line (grid, row, s2, s1, band->threshold,
+            mask);
 
-  for (j = 0; j < height; j++) {
-    guint8 *d = (guint8 *) outframe->data[0] + outframe->info.stride[0] * j;
-    guint8 *s1 = (guint8 *) oldframe->data[0] + oldframe->info.stride[0] * j;
-    guint8 *s2 = (guint8 *) inframe->data[0] + inframe->info.stride[0] * j;
-    for (i = 0; i < width; i++) {
-      if ((s2[i] < s1[i] - threshold) || (s2[i] > s1[i] + threshold)) {
-        if ((i + j + t) & 0x4) {
-          d[i] = 16;
-        } else {
-          d[i] = 240;
+        for (i = 0; i < width; i++) {
+          if (mask[i]) {
+            if ((i + j + t) & 0x4) {
+              d[i] = 16;
+            } else {
+              d[i] = 240;
+            }
+          } else {
+            d[i] = s2[i];
+          }
         }
       } else {
-        d[i] = s2[i];
+        gst_video_tile_grid_add_line (grid, row, s2, NULL, 0, NULL);
+        memcpy (d, s2, width);
       }
     }
   }
-  for (j = 0; j < GST_VIDEO_FRAME_COMP_HEIGHT (inframe, 1); j++) {
-    guint8 *d = (guint8 *) outframe->data[1] + outframe->info.stride[1] * j;
-    guint8 *s = (guint8 *) inframe->data[1] + inframe->info.stride[1] * j;
-    memcpy (d, s, GST_VIDEO_FRAME_COMP_WIDTH (inframe, 1));
+}
+
+static void
+gst_video_diff_band_func (gpointer data, gpointer user_data)
+{
+  GstVideoDiff *videodiff = user_data;
+
+  gst_video_diff_process_band (videodiff, data);
+
+  g_mutex_lock (&videodiff->lock);
+  if (--videodiff->pending_bands == 0)
+    g_cond_signal (&videodiff->cond);
+  g_mutex_unlock (&videodiff->lock);
+}
+
+static gint
+gst_video_diff_get_n_threads (GstVideoDiff * videodiff)
+{
+  gint n_threads;
+
+  GST_OBJECT_LOCK (videodiff);
+  n_threads = videodiff->n_threads;
+  GST_OBJECT_UNLOCK (videodiff);
+
+  if (n_threads == 0) {
+#if GLIB_CHECK_VERSION (2, 36, 0)
+    n_threads = g_get_num_processors ();
+#else
+    n_threads = 1;
+#endif
+  }
+
+  return CLAMP (n_threads, 1, MAX_THREADS);
+}
+
+static void
+gst_video_diff_process_luma (GstVideoDiff * videodiff, int n_threads,
+    int threshold, GstVideoFrame * inframe, GstVideoFrame * outframe,
+    GstVideoFrame * oldframe)
+{
+  GstVideoDiffBand bands[MAX_THREADS];
+  int width = GST_VIDEO_FRAME_COMP_WIDTH (inframe, 0);
+  int n_rows = videodiff->grid.n_rows;
+  int n_bands, i;
+
+  n_bands = CLAMP (n_threads, 1, MIN (n_rows, MAX_THREADS));
+
+  for (i = 0; i < n_bands; i++) {
+    bands[i].inframe = inframe;
+    bands[i].outframe = outframe;
+    bands[i].oldframe = oldframe;
+    bands[i].mask = videodiff->masks + width * i;
+    bands[i].threshold = threshold;
+    bands[i].start = n_rows * i / n_bands;
+    bands[i].end = n_rows * (i + 1) / n_bands;
   }
-  for (j = 0; j < GST_VIDEO_FRAME_COMP_HEIGHT (inframe, 2); j++) {
-    guint8 *d = (guint8 *) outframe->data[2] + outframe->info.stride[2] * j;
-    guint8 *s = (guint8 *) inframe->data[2] + inframe->info.stride[2] * j;
-    memcpy (d, s, GST_VIDEO_FRAME_COMP_WIDTH (inframe, 2));
+
+  if (n_bands == 1) {
+    gst_video_diff_process_band (videodiff, &bands[0]);
+    return;
   }
-  return GST_FLOW_OK;
+
+  if (!videodiff->pool) {
+    videodiff->pool = g_thread_pool_new (gst_video_diff_band_func, videodiff,
+        n_bands, FALSE, NULL);
+  } else if (g_thread_pool_get_max_threads (videodiff->pool) < n_bands) {
+    g_thread_pool_set_max_threads (videodiff->pool, n_bands, NULL);
+  }
+
+  g_mutex_lock (&videodiff->lock);
+  videodiff->pending_bands = n_bands;
+  g_mutex_unlock (&videodiff->lock);
+
+  for (i = 0; i < n_bands; i++)
+    g_thread_pool_push (videodiff->pool, &bands[i], NULL);
+
+  g_mutex_lock (&videodiff->lock);
+  while (videodiff->pending_bands > 0)
+    g_cond_wait (&videodiff->cond, &videodiff->lock);
+  g_mutex_unlock (&videodiff->lock);
+}
+
+static void
+gst_video_diff_append_uint (GValue * array, guint value)
+{
+  GValue v = G_VALUE_INIT;
+
+  g_value_init (&v, G_TYPE_UINT);
+  g_value_set_uint (&v, value);
+  gst_value_array_append_value (array, &v);
+  g_value_unset (&v);
+}
+
+static void
+gst_video_diff_append_double (GValue * array, gdouble value)
+{
+  GValue v = G_VALUE_INIT;
+
+  g_value_init (&v, G_TYPE_DOUBLE);
+  g_value_set_double (&v, value);
+  gst_value_array_append_value (array, &v);
+  g_value_unset (&v);
+}
+
+static void
+gst_video_diff_post_message (GstVideoDiff * videodiff, GstVideoFrame * frame)
+{
+  GstVideoTileGrid *grid = &videodiff->grid;
+  GValue changed = G_VALUE_INIT, mean_diff = G_VALUE_INIT;
+  GValue average = G_VALUE_INIT, variance = G_VALUE_INIT;
+  GValue min = G_VALUE_INIT, max = G_VALUE_INIT;
+  GstStructure *s;
+  guint total_changed = 0;
+  int r, c;
+
+  g_value_init (&changed, GST_TYPE_ARRAY);
+  g_value_init (&mean_diff, GST_TYPE_ARRAY);
+  g_value_init (&average, GST_TYPE_ARRAY);
+  g_value_init (&variance, GST_TYPE_ARRAY);
+  g_value_init (&min, GST_TYPE_ARRAY);
+  g_value_init (&max, GST_TYPE_ARRAY);
+
+  for (r = 0; r < grid->n_rows; r++) {
+    for (c = 0; c < grid->n_columns; c++) {
+      GstVideoTileStats *tile = &grid->tiles[r * grid->n_columns + c];
+      gdouble n, avg;
+
+      n = (gdouble) (grid->column_start[c + 1] - grid->column_start[c]) *
+          (grid->row_start[r + 1] - grid->row_start[r]);
+      avg = tile->sum / n;
+
+      total_changed += tile->n_changed;
+      gst_video_diff_append_uint (&changed, tile->n_changed);
+      gst_video_diff_append_double (&mean_diff, tile->diff_sum / n);
+      gst_video_diff_append_double (&average, avg);
+      gst_video_diff_append_double (&variance,
+          MAX (tile->sum_sq / n - avg * avg, 0.0));
+      gst_video_diff_append_uint (&min, tile->min);
+      gst_video_diff_append_uint (&max, tile->max);
+    }
+  }
+
+  s = gst_structure_new ("GstVideoDiff",
+      "timestamp", G_TYPE_UINT64, GST_BUFFER_PTS (frame->buffer),
+      "changed-pixels", G_TYPE_UINT, total_changed,
+      "tile-columns", G_TYPE_INT, grid->n_columns,
+      "tile-rows", G_TYPE_INT, grid->n_rows, NULL);
+  gst_structure_take_value (s, "tile-changed-pixels", &changed);
+  gst_structure_take_value (s, "tile-mean-difference", &mean_diff);
+  gst_structure_take_value (s, "tile-luma-average", &average);
+  gst_structure_take_value (s, "tile-luma-variance", &variance);
+  gst_structure_take_value (s, "tile-luma-min", &min);
+  gst_structure_take_value (s, "tile-luma-max", &max);
+
+  gst_element_post_message (GST_ELEMENT_CAST (videodiff),
+      gst_message_new_element (GST_OBJECT_CAST (videodiff), s));
 }
 
 static GstFlowReturn
@@ -142,42 +544,51 @@ gst_video_diff_transform_frame (GstVideoFilter * filter,
     GstVideoFrame * inframe, GstVideoFrame * outframe)
 {
   GstVideoDiff *videodiff = GST_VIDEO_DIFF (filter);
+  GstVideoFrame oldframe;
+  gboolean have_old = FALSE;
+  gboolean post_messages;
+  int threshold, n_threads;
+  int k, j;
 
   GST_DEBUG_OBJECT (videodiff, "transform_frame_ip");
 
-  if (videodiff->previous_buffer) {
-    GstVideoFrame oldframe;
+  GST_OBJECT_LOCK (videodiff);
+  if (videodiff->grid_changed) {
+    gst_video_tile_grid_init (&videodiff->grid,
+        GST_VIDEO_FRAME_COMP_WIDTH (inframe, 0),
+        GST_VIDEO_FRAME_COMP_HEIGHT (inframe, 0), videodiff->tile_columns,
+        videodiff->tile_rows);
+    videodiff->grid_changed = FALSE;
+  }
+  post_messages = videodiff->post_messages;
+  threshold = videodiff->threshold;
+  GST_OBJECT_UNLOCK (videodiff);
 
-    gst_video_frame_map (&oldframe, &videodiff->oldinfo,
+  n_threads = gst_video_diff_get_n_threads (videodiff);
+
+  if (videodiff->previous_buffer) {
+    have_old = gst_video_frame_map (&oldframe, &videodiff->oldinfo,
         videodiff->previous_buffer, GST_MAP_READ);
+  }
 
-    switch (inframe->info.finfo->format) {
-      case GST_VIDEO_FORMAT_I420:
-      case GST_VIDEO_FORMAT_Y41B:
-      case GST_VIDEO_FORMAT_Y444:
-      case GST_VIDEO_FORMAT_Y42B:
-        gst_video_diff_transform_frame_ip_planarY (videodiff, outframe,
-            inframe, &oldframe);
-        break;
-      default:
-        g_assert_not_reached ();
-    }
+  gst_video_diff_process_luma (videodiff, n_threads, threshold, inframe,
+      outframe, have_old ? &oldframe : NULL);
 
-    gst_video_frame_unmap (&oldframe);
-    gst_buffer_unref (videodiff->previous_buffer);
-  } else {
-    int k;
-    int j;
-    for (k = 0; k < 3; k++) {
-      for (j = 0; j < GST_VIDEO_FRAME_COMP_HEIGHT (inframe, k); j++) {
-        guint8 *d = (guint8 *) outframe->data[k] + outframe->info.stride[k] * j;
-        guint8 *s = (guint8 *) inframe->data[k] + inframe->info.stride[k] * j;
-        memcpy (d, s, GST_VIDEO_FRAME_COMP_WIDTH (inframe, k));
-      }
+  for (k = 1; k < 3; k++) {
+    for (j = 0; j < GST_VIDEO_FRAME_COMP_HEIGHT (inframe, k); j++) {
+      guint8 *d = (guint8 *) outframe->data[k] + outframe->info.stride[k] * j;
+      guint8 *s = (guint8 *) inframe->data[k] + inframe->info.stride[k] * j;
+      memcpy (d, s, GST_VIDEO_FRAME_COMP_WIDTH (inframe, k));
     }
   }
 
-  videodiff->previous_buffer = gst_buffer_ref (inframe->buffer);
+  if (have_old)
+    gst_video_frame_unmap (&oldframe);
+
+  if (post_messages)
+    gst_video_diff_post_message (videodiff, inframe);
+
+  gst_buffer_replace (&videodiff->previous_buffer, inframe->buffer);
   memcpy (&videodiff->oldinfo, &inframe->info, sizeof (GstVideoInfo));
 
   return GST_FLOW_OK;
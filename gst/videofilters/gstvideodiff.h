@@ -24,6 +24,8 @@
 #include <gst/video/gstvideofilter.h>
 #include <string.h>
 
+#include "gstvideotilestats.h"
+
 G_BEGIN_DECLS
 
 #define GST_TYPE_VIDEO_DIFF   (gst_video_diff_get_type())
@@ -44,6 +46,23 @@ struct _GstVideoDiff
 
   int threshold;
   int t;
+
+  /* properties */
+  gboolean post_messages;
+  int tile_columns;
+  int tile_rows;
+  int n_threads;
+
+  GstVideoTileGrid grid;
+  gboolean grid_changed;
+
+  /* per band masks of changed pixels */
+  guint8 *masks;
+
+  GThreadPool *pool;
+  GMutex lock;
+  GCond cond;
+  int pending_bands;
 };
 
 struct _GstVideoDiffClass
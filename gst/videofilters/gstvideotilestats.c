@@ -0,0 +1,155 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include "gstvideotilestats.h"
+
+/* samples summed up in 32 bit before adding to the 64 bit totals, so that
+ * the sums of squares of a chunk can not overflow */
+#define CHUNK_SIZE 4096
+
+void
+gst_video_tile_grid_init (GstVideoTileGrid * grid, gint width, gint height,
+    gint n_columns, gint n_rows)
+{
+  gint i;
+
+  gst_video_tile_grid_clear (grid);
+
+  grid->width = width;
+  grid->height = height;
+  grid->n_columns = CLAMP (n_columns, 1, MAX (width, 1));
+  grid->n_rows = CLAMP (n_rows, 1, MAX (height, 1));
+
+  grid->column_start = g_new (gint, grid->n_columns + 1);
+  for (i = 0; i <= grid->n_columns; i++)
+    grid->column_start[i] = (gint64) width * i / grid->n_columns;
+
+  grid->row_start = g_new (gint, grid->n_rows + 1);
+  for (i = 0; i <= grid->n_rows; i++)
+    grid->row_start[i] = (gint64) height * i / grid->n_rows;
+
+  grid->tiles = g_new0 (GstVideoTileStats, grid->n_columns * grid->n_rows);
+}
+
+void
+gst_video_tile_grid_clear (GstVideoTileGrid * grid)
+{
+  g_free (grid->column_start);
+  grid->column_start = NULL;
+  g_free (grid->row_start);
+  grid->row_start = NULL;
+  g_free (grid->tiles);
+  grid->tiles = NULL;
+  grid->n_columns = 0;
+  grid->n_rows = 0;
+}
+
+/* Resets the statistics of the tiles of @row before its lines are added */
+void
+gst_video_tile_grid_reset_row (GstVideoTileGrid * grid, gint row)
+{
+  GstVideoTileStats *tiles = grid->tiles + row * grid->n_columns;
+  gint c;
+
+  memset (tiles, 0, grid->n_columns * sizeof (GstVideoTileStats));
+  for (c = 0; c < grid->n_columns; c++)
+    tiles[c].min = 255;
+}
+
+static void
+add_samples (GstVideoTileStats * tile, const guint8 * p, gint n)
+{
+  guint32 sum = 0, sum_sq = 0;
+  guint8 min = tile->min, max = tile->max;
+  gint i;
+
+  for (i = 0; i < n; i++) {
+    guint32 v = p[i];
+
+    sum += v;
+    sum_sq += v * v;
+    min = MIN (min, v);
+    max = MAX (max, v);
+  }
+
+  tile->sum += sum;
+  tile->sum_sq += sum_sq;
+  tile->min = min;
+  tile->max = max;
+}
+
+static void
+add_sample_diffs (GstVideoTileStats * tile, const guint8 * p,
+    const guint8 * old, gint n, gint threshold, guint8 * mask)
+{
+  guint32 sum = 0, sum_sq = 0, diff_sum = 0, n_changed = 0;
+  guint8 min = tile->min, max = tile->max;
+  gint i;
+
+  for (i = 0; i < n; i++) {
+    gint v = p[i];
+    gint d = ABS (v - old[i]);
+    guint8 changed = -(d > threshold);
+
+    sum += v;
+    sum_sq += v * v;
+    min = MIN (min, v);
+    max = MAX (max, v);
+    diff_sum += d;
+    n_changed += changed & 1;
+    if (mask)
+      mask[i] = changed;
+  }
+
+  tile->sum += sum;
+  tile->sum_sq += sum_sq;
+  tile->min = min;
+  tile->max = max;
+  tile->diff_sum += diff_sum;
+  tile->n_changed += n_changed;
+}
+
+/* Adds one line of 8 bit samples that belongs to tile row @row.  If
+ * @old_line is given, the samples that differ by more than @threshold from
+ * it are counted, and marked with 0xff in @mask if that is given. */
+void
+gst_video_tile_grid_add_line (GstVideoTileGrid * grid, gint row,
+    const guint8 * line, const guint8 * old_line, gint threshold,
+    guint8 * mask)
+{
+  GstVideoTileStats *tiles = grid->tiles + row * grid->n_columns;
+  gint c, x, n;
+
+  for (c = 0; c < grid->n_columns; c++) {
+    for (x = grid->column_start[c]; x < grid->column_start[c + 1]; x += n) {
+      n = MIN (grid->column_start[c + 1] - x, CHUNK_SIZE);
+
+      if (old_line)
+        add_sample_diffs (&tiles[c], line + x, old_line + x, n, threshold,
+            mask ? mask + x : NULL);
+      else
+        add_samples (&tiles[c], line + x, n);
+    }
+  }
+}
@@ -0,0 +1,70 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef _GST_VIDEO_TILE_STATS_H_
+#define _GST_VIDEO_TILE_STATS_H_
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GstVideoTileStats GstVideoTileStats;
+typedef struct _GstVideoTileGrid GstVideoTileGrid;
+
+/* statistics of the 8 bit samples of one tile, and of their differences
+ * to the samples of a previous frame */
+struct _GstVideoTileStats
+{
+  guint64 sum;
+  guint64 sum_sq;
+  guint8 min;
+  guint8 max;
+
+  guint n_changed;
+  guint64 diff_sum;
+};
+
+/* a plane split into n_columns x n_rows tiles of nearly equal size */
+struct _GstVideoTileGrid
+{
+  gint width;
+  gint height;
+  gint n_columns;
+  gint n_rows;
+
+  /* first sample column and line of every tile column and row, with one
+   * extra entry for the end */
+  gint *column_start;
+  gint *row_start;
+
+  /* n_columns * n_rows tiles, row by row */
+  GstVideoTileStats *tiles;
+};
+
+void gst_video_tile_grid_init (GstVideoTileGrid * grid, gint width,
+    gint height, gint n_columns, gint n_rows);
+void gst_video_tile_grid_clear (GstVideoTileGrid * grid);
+
+void gst_video_tile_grid_reset_row (GstVideoTileGrid * grid, gint row);
+void gst_video_tile_grid_add_line (GstVideoTileGrid * grid, gint row,
+    const guint8 * line, const guint8 * old_line, gint threshold,
+    guint8 * mask);
+
+G_END_DECLS
+
+#endif
@@ -30,6 +30,12 @@
  * #GstSimpleVideoMark:pattern-data. 1 bits will produce white squares and 0 bits will
  * produce black squares.
  * 
+ * With #GstSimpleVideoMark:pattern-clock-time, the data squares contain the
+ * time of the element's clock in milliseconds when the frame passed instead,
+ * truncated to the number of data squares.  A #GstSimpleVideoMarkDetect with
+ * #GstSimpleVideoMarkDetect:measure-latency further down the pipeline then
+ * reports the latency between both elements.
+ *
  * The element can be enabled with the #GstSimpleVideoMark:enabled property. It is
  * mostly used together with the #GstVideoDetect plugin.
  * 
@@ -52,6 +58,8 @@
 #include <gst/video/gstvideofilter.h>
 #include "gstsimplevideomark.h"
 
+#include <string.h>
+
 GST_DEBUG_CATEGORY_STATIC (gst_video_mark_debug_category);
 #define GST_CAT_DEFAULT gst_video_mark_debug_category
 
@@ -83,7 +91,8 @@ enum
   PROP_PATTERN_DATA,
   PROP_ENABLED,
   PROP_LEFT_OFFSET,
-  PROP_BOTTOM_OFFSET
+  PROP_BOTTOM_OFFSET,
+  PROP_PATTERN_CLOCK_TIME
 };
 
 #define DEFAULT_PATTERN_WIDTH        4
@@ -94,6 +103,7 @@ enum
 #define DEFAULT_ENABLED              TRUE
 #define DEFAULT_LEFT_OFFSET          0
 #define DEFAULT_BOTTOM_OFFSET        0
+#define DEFAULT_PATTERN_CLOCK_TIME   FALSE
 
 /* pad templates */
 
@@ -178,6 +188,11 @@ gst_video_mark_class_init (GstSimpleVideoMarkClass * klass)
           "The offset from the bottom border where the pattern starts", 0,
           G_MAXINT, DEFAULT_BOTTOM_OFFSET,
           G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_PATTERN_CLOCK_TIME,
+      g_param_spec_boolean ("pattern-clock-time", "Pattern clock time",
+          "Use the clock time in milliseconds as the extra data pattern",
+          DEFAULT_PATTERN_CLOCK_TIME,
+          G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
 
 }
 
@@ -219,6 +234,9 @@ gst_video_mark_set_property (GObject * object, guint property_id,
     case PROP_BOTTOM_OFFSET:
       simplevideomark->bottom_offset = g_value_get_int (value);
       break;
+    case PROP_PATTERN_CLOCK_TIME:
+      simplevideomark->pattern_clock_time = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -258,6 +276,9 @@ gst_video_mark_get_property (GObject * object, guint property_id,
     case PROP_BOTTOM_OFFSET:
       g_value_set_int (value, simplevideomark->bottom_offset);
       break;
+    case PROP_PATTERN_CLOCK_TIME:
+      g_value_set_boolean (value, simplevideomark->pattern_clock_time);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -319,28 +340,57 @@ gst_video_mark_set_info (GstVideoFilter * filter, GstCaps * incaps,
   return TRUE;
 }
 
+/* Draws the @n_boxes boxes of @width x @height next to each other line by
+ * line, with the colors in @colors */
 static void
-gst_video_mark_draw_box (GstSimpleVideoMark * simplevideomark, guint8 * data,
-    gint width, gint height, gint row_stride, gint pixel_stride, guint8 color)
+gst_video_mark_draw_boxes (GstSimpleVideoMark * simplevideomark,
+    guint8 * data, const guint8 * colors, gint n_boxes, gint width,
+    gint height, gint row_stride, gint pixel_stride)
 {
-  gint i, j;
-
-  for (i = 0; i < height; i++) {
-    for (j = 0; j < width; j++) {
-      data[pixel_stride * j] = color;
+  gint i, j, k;
+
+  for (j = 0; j < height; j++) {
+    guint8 *p = data;
+
+    for (i = 0; i < n_boxes; i++) {
+      if (pixel_stride == 1) {
+        memset (p, colors[i], width);
+      } else {
+        for (k = 0; k < width; k++)
+          p[pixel_stride * k] = colors[i];
+      }
+      p += pixel_stride * width;
     }
     data += row_stride;
   }
 }
 
+static guint64
+gst_video_mark_get_pattern_data (GstSimpleVideoMark * simplevideomark)
+{
+  GstClock *clock;
+  guint64 pattern_data = simplevideomark->pattern_data;
+
+  if (simplevideomark->pattern_clock_time) {
+    clock = gst_element_get_clock (GST_ELEMENT_CAST (simplevideomark));
+    if (clock) {
+      pattern_data = gst_clock_get_time (clock) / GST_MSECOND;
+      gst_object_unref (clock);
+    } else {
+      GST_DEBUG_OBJECT (simplevideomark, "no clock, using pattern-data");
+    }
+  }
+
+  return pattern_data;
+}
+
 static GstFlowReturn
 gst_video_mark_yuv (GstSimpleVideoMark * simplevideomark, GstVideoFrame * frame)
 {
   gint i, pw, ph, row_stride, pixel_stride;
-  gint width, height, req_width, req_height;
-  guint8 *d;
-  guint64 pattern_shift;
-  guint8 color;
+  gint width, height, req_width, req_height, n_boxes;
+  guint8 *d, *colors;
+  guint64 pattern_data;
 
   width = frame->info.width;
   height = frame->info.height;
@@ -350,9 +400,9 @@ gst_video_mark_yuv (GstSimpleVideoMark * simplevideomark, GstVideoFrame * frame)
   row_stride = GST_VIDEO_FRAME_COMP_STRIDE (frame, 0);
   pixel_stride = GST_VIDEO_FRAME_COMP_PSTRIDE (frame, 0);
 
-  req_width =
-      (simplevideomark->pattern_count +
-      simplevideomark->pattern_data_count) * pw + simplevideomark->left_offset;
+  n_boxes = simplevideomark->pattern_count +
+      simplevideomark->pattern_data_count;
+  req_width = n_boxes * pw + simplevideomark->left_offset;
   req_height = simplevideomark->bottom_offset + ph;
   if (req_width > width || req_height > height) {
     GST_ELEMENT_ERROR (simplevideomark, STREAM, WRONG_TYPE, (NULL),
@@ -361,51 +411,32 @@ gst_video_mark_yuv (GstSimpleVideoMark * simplevideomark, GstVideoFrame * frame)
     return GST_FLOW_ERROR;
   }
 
-  /* draw the bottom left pixels */
-  for (i = 0; i < simplevideomark->pattern_count; i++) {
-    d = GST_VIDEO_FRAME_COMP_DATA (frame, 0);
-    /* move to start of bottom left */
-    d += row_stride * (height - ph - simplevideomark->bottom_offset) +
-        pixel_stride * simplevideomark->left_offset;
-    /* move to i-th pattern */
-    d += pixel_stride * pw * i;
-
-    if (i & 1)
-      /* odd pixels must be white */
-      color = 255;
-    else
-      color = 0;
-
-    /* draw box of width * height */
-    gst_video_mark_draw_box (simplevideomark, d, pw, ph, row_stride,
-        pixel_stride, color);
-  }
+  if (n_boxes == 0 || pw == 0 || ph == 0)
+    return GST_FLOW_OK;
 
-  pattern_shift =
-      G_GUINT64_CONSTANT (1) << (simplevideomark->pattern_data_count - 1);
+  colors = g_alloca (n_boxes);
 
-  /* get the data of the pattern */
+  /* odd pattern boxes are white, even ones black */
+  for (i = 0; i < simplevideomark->pattern_count; i++)
+    colors[i] = (i & 1) ? 255 : 0;
+
+  /* the data boxes follow with the most significant bit first */
+  pattern_data = gst_video_mark_get_pattern_data (simplevideomark);
   for (i = 0; i < simplevideomark->pattern_data_count; i++) {
-    d = GST_VIDEO_FRAME_COMP_DATA (frame, 0);
-    /* move to start of bottom left, adjust for offsets */
-    d += row_stride * (height - ph - simplevideomark->bottom_offset) +
-        pixel_stride * simplevideomark->left_offset;
-    /* move after the fixed pattern */
-    d += pixel_stride * simplevideomark->pattern_count * pw;
-    /* move to i-th pattern data */
-    d += pixel_stride * pw * i;
-
-    if (simplevideomark->pattern_data & pattern_shift)
-      color = 255;
-    else
-      color = 0;
-
-    gst_video_mark_draw_box (simplevideomark, d, pw, ph, row_stride,
-        pixel_stride, color);
-
-    pattern_shift >>= 1;
+    gint bit = simplevideomark->pattern_data_count - 1 - i;
+
+    colors[simplevideomark->pattern_count + i] =
+        ((pattern_data >> bit) & 1) ? 255 : 0;
   }
 
+  d = GST_VIDEO_FRAME_COMP_DATA (frame, 0);
+  /* move to start of bottom left, adjust for offsets */
+  d += row_stride * (height - ph - simplevideomark->bottom_offset) +
+      pixel_stride * simplevideomark->left_offset;
+
+  gst_video_mark_draw_boxes (simplevideomark, d, colors, n_boxes, pw, ph,
+      row_stride, pixel_stride);
+
   return GST_FLOW_OK;
 }
 
@@ -47,6 +47,7 @@ struct _GstSimpleVideoMark
   gboolean enabled;
   gint left_offset;
   gint bottom_offset;
+  gboolean pattern_clock_time;
 };
 
 struct _GstSimpleVideoMarkClass
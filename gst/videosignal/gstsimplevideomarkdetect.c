@@ -82,7 +82,28 @@
  *   the data-pattern found after the pattern or 0 when have-signal is #FALSE.
  *   </para>
  * </listitem>
+ * <listitem>
+ *   <para>
+ *   #GstClockTime
+ *   <classname>&quot;clock-time&quot;</classname>:
+ *   the time of the element's clock when the frame was analysed, or
+ *   #GST_CLOCK_TIME_NONE without clock.
+ *   </para>
+ * </listitem>
  * </itemizedlist>
+ *
+ * With #GstSimpleVideoMarkDetect:measure-latency, the data is taken to be the
+ * clock time in milliseconds that a #GstSimpleVideoMark with
+ * #GstSimpleVideoMark:pattern-clock-time painted into the frame, truncated to
+ * the number of data bits.  Both elements have to use the same clock, for
+ * example by being in the same pipeline.  Messages for frames with a pattern
+ * then also contain the #GstClockTime fields
+ * <classname>&quot;latency&quot;</classname>,
+ * <classname>&quot;latency-min&quot;</classname>,
+ * <classname>&quot;latency-max&quot;</classname>,
+ * <classname>&quot;latency-average&quot;</classname> and
+ * <classname>&quot;latency-stddev&quot;</classname>, which describe the
+ * latency of this frame and of all frames since the element was started.
  * 
  * <refsect2>
  * <title>Example launch line</title>
@@ -103,6 +124,8 @@
 #include <gst/video/gstvideofilter.h>
 #include "gstsimplevideomarkdetect.h"
 
+#include <math.h>
+
 GST_DEBUG_CATEGORY_STATIC (gst_video_detect_debug_category);
 #define GST_CAT_DEFAULT gst_video_detect_debug_category
 
@@ -135,7 +158,8 @@ enum
   PROP_PATTERN_CENTER,
   PROP_PATTERN_SENSITIVITY,
   PROP_LEFT_OFFSET,
-  PROP_BOTTOM_OFFSET
+  PROP_BOTTOM_OFFSET,
+  PROP_MEASURE_LATENCY
 };
 
 #define DEFAULT_MESSAGE              TRUE
@@ -147,6 +171,7 @@ enum
 #define DEFAULT_PATTERN_SENSITIVITY  0.3
 #define DEFAULT_LEFT_OFFSET          0
 #define DEFAULT_BOTTOM_OFFSET        0
+#define DEFAULT_MEASURE_LATENCY      FALSE
 
 /* pad templates */
 
@@ -237,6 +262,11 @@ gst_video_detect_class_init (GstSimpleVideoMarkDetectClass * klass)
           "The offset from the bottom border where the pattern starts", 0,
           G_MAXINT, DEFAULT_BOTTOM_OFFSET,
           G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_MEASURE_LATENCY,
+      g_param_spec_boolean ("measure-latency", "Measure latency",
+          "Read the data as the clock time the mark was painted at and "
+          "report the latency", DEFAULT_MEASURE_LATENCY,
+          G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
 }
 
 static void
@@ -281,6 +311,9 @@ gst_video_detect_set_property (GObject * object, guint property_id,
     case PROP_BOTTOM_OFFSET:
       simplevideomarkdetect->bottom_offset = g_value_get_int (value);
       break;
+    case PROP_MEASURE_LATENCY:
+      simplevideomarkdetect->measure_latency = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -324,6 +357,9 @@ gst_video_detect_get_property (GObject * object, guint property_id,
     case PROP_BOTTOM_OFFSET:
       g_value_set_int (value, simplevideomarkdetect->bottom_offset);
       break;
+    case PROP_MEASURE_LATENCY:
+      g_value_set_boolean (value, simplevideomarkdetect->measure_latency);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -352,6 +388,8 @@ gst_video_detect_finalize (GObject * object)
   GST_DEBUG_OBJECT (simplevideomarkdetect, "finalize");
 
   /* clean up object here */
+  g_free (simplevideomarkdetect->box_sums);
+  simplevideomarkdetect->box_sums = NULL;
 
   G_OBJECT_CLASS (gst_video_detect_parent_class)->finalize (object);
 }
@@ -364,6 +402,13 @@ gst_video_detect_start (GstBaseTransform * trans)
 
   GST_DEBUG_OBJECT (simplevideomarkdetect, "start");
 
+  simplevideomarkdetect->in_pattern = FALSE;
+  simplevideomarkdetect->latency_count = 0;
+  simplevideomarkdetect->latency_min = GST_CLOCK_TIME_NONE;
+  simplevideomarkdetect->latency_max = 0;
+  simplevideomarkdetect->latency_sum = 0.0;
+  simplevideomarkdetect->latency_sum_sq = 0.0;
+
   return TRUE;
 }
 
@@ -392,12 +437,17 @@ gst_video_detect_set_info (GstVideoFilter * filter, GstCaps * incaps,
 
 static void
 gst_video_detect_post_message (GstSimpleVideoMarkDetect * simplevideomarkdetect,
-    GstBuffer * buffer, guint64 data)
+    GstBuffer * buffer, guint64 data, GstClockTime clock_time,
+    GstClockTime latency)
 {
   GstBaseTransform *trans;
+  GstStructure *s;
   GstMessage *m;
   guint64 duration, timestamp, running_time, stream_time;
 
+  if (!simplevideomarkdetect->message)
+    return;
+
   trans = GST_BASE_TRANSFORM_CAST (simplevideomarkdetect);
 
   /* get timestamps */
@@ -408,34 +458,112 @@ gst_video_detect_post_message (GstSimpleVideoMarkDetect * simplevideomarkdetect,
   stream_time = gst_segment_to_stream_time (&trans->segment, GST_FORMAT_TIME,
       timestamp);
 
+  s = gst_structure_new ("GstSimpleVideoMarkDetect",
+      "have-pattern", G_TYPE_BOOLEAN, simplevideomarkdetect->in_pattern,
+      "timestamp", G_TYPE_UINT64, timestamp,
+      "stream-time", G_TYPE_UINT64, stream_time,
+      "running-time", G_TYPE_UINT64, running_time,
+      "duration", G_TYPE_UINT64, duration,
+      "data", G_TYPE_UINT64, data,
+      "clock-time", G_TYPE_UINT64, clock_time, NULL);
+
+  if (GST_CLOCK_TIME_IS_VALID (latency)) {
+    gdouble n = simplevideomarkdetect->latency_count;
+    gdouble avg = simplevideomarkdetect->latency_sum / n;
+    gdouble var = simplevideomarkdetect->latency_sum_sq / n - avg * avg;
+
+    gst_structure_set (s,
+        "latency", G_TYPE_UINT64, latency,
+        "latency-min", G_TYPE_UINT64, simplevideomarkdetect->latency_min,
+        "latency-max", G_TYPE_UINT64, simplevideomarkdetect->latency_max,
+        "latency-average", G_TYPE_UINT64, (guint64) avg,
+        "latency-stddev", G_TYPE_UINT64, (guint64) sqrt (MAX (var, 0.0)),
+        NULL);
+  }
+
   /* post message */
-  m = gst_message_new_element (GST_OBJECT_CAST (simplevideomarkdetect),
-      gst_structure_new ("GstSimpleVideoMarkDetect",
-          "have-pattern", G_TYPE_BOOLEAN, simplevideomarkdetect->in_pattern,
-          "timestamp", G_TYPE_UINT64, timestamp,
-          "stream-time", G_TYPE_UINT64, stream_time,
-          "running-time", G_TYPE_UINT64, running_time,
-          "duration", G_TYPE_UINT64, duration,
-          "data", G_TYPE_UINT64, data, NULL));
+  m = gst_message_new_element (GST_OBJECT_CAST (simplevideomarkdetect), s);
   gst_element_post_message (GST_ELEMENT_CAST (simplevideomarkdetect), m);
 }
 
-static gdouble
-gst_video_detect_calc_brightness (GstSimpleVideoMarkDetect *
-    simplevideomarkdetect, guint8 * data, gint width, gint height,
-    gint row_stride, gint pixel_stride)
+/* Sums up the samples of all @n_boxes boxes of @width x @height next to
+ * each other in one pass over their lines */
+static void
+gst_video_detect_sum_boxes (guint64 * sums, gint n_boxes, guint8 * data,
+    gint width, gint height, gint row_stride, gint pixel_stride)
 {
-  gint i, j;
-  guint64 sum;
-
-  sum = 0;
-  for (i = 0; i < height; i++) {
-    for (j = 0; j < width; j++) {
-      sum += data[pixel_stride * j];
+  gint i, j, k;
+
+  for (i = 0; i < n_boxes; i++)
+    sums[i] = 0;
+
+  for (j = 0; j < height; j++) {
+    guint8 *p = data;
+
+    for (i = 0; i < n_boxes; i++) {
+      guint32 sum = 0;
+
+      if (pixel_stride == 1) {
+        for (k = 0; k < width; k++)
+          sum += p[k];
+      } else {
+        for (k = 0; k < width; k++)
+          sum += p[pixel_stride * k];
+      }
+      sums[i] += sum;
+      p += pixel_stride * width;
     }
     data += row_stride;
   }
-  return sum / (255.0 * width * height);
+}
+
+static GstClockTime
+gst_video_detect_get_clock_time (GstSimpleVideoMarkDetect *
+    simplevideomarkdetect)
+{
+  GstClock *clock;
+  GstClockTime clock_time = GST_CLOCK_TIME_NONE;
+
+  clock = gst_element_get_clock (GST_ELEMENT_CAST (simplevideomarkdetect));
+  if (clock) {
+    clock_time = gst_clock_get_time (clock);
+    gst_object_unref (clock);
+  }
+
+  return clock_time;
+}
+
+/* Takes @data as the clock time in milliseconds the mark was painted at and
+ * adds the latency to the distribution */
+static GstClockTime
+gst_video_detect_update_latency (GstSimpleVideoMarkDetect *
+    simplevideomarkdetect, guint64 data, GstClockTime clock_time)
+{
+  gint bits = simplevideomarkdetect->pattern_data_count;
+  guint64 mask, latency_ms;
+  GstClockTime latency;
+
+  if (!GST_CLOCK_TIME_IS_VALID (clock_time) || bits == 0)
+    return GST_CLOCK_TIME_NONE;
+
+  /* the painted time is truncated to the data bits */
+  mask = bits >= 64 ? G_MAXUINT64 : (G_GUINT64_CONSTANT (1) << bits) - 1;
+  latency_ms = (clock_time / GST_MSECOND - data) & mask;
+  latency = latency_ms * GST_MSECOND;
+
+  simplevideomarkdetect->latency_count++;
+  if (!GST_CLOCK_TIME_IS_VALID (simplevideomarkdetect->latency_min) ||
+      latency < simplevideomarkdetect->latency_min)
+    simplevideomarkdetect->latency_min = latency;
+  if (latency > simplevideomarkdetect->latency_max)
+    simplevideomarkdetect->latency_max = latency;
+  simplevideomarkdetect->latency_sum += latency;
+  simplevideomarkdetect->latency_sum_sq += (gdouble) latency * latency;
+
+  GST_DEBUG_OBJECT (simplevideomarkdetect, "latency %" GST_TIME_FORMAT,
+      GST_TIME_ARGS (latency));
+
+  return latency;
 }
 
 static void
@@ -444,9 +572,12 @@ gst_video_detect_yuv (GstSimpleVideoMarkDetect * simplevideomarkdetect,
 {
   gdouble brightness;
   gint i, pw, ph, row_stride, pixel_stride;
-  gint width, height, req_width, req_height;
+  gint width, height, req_width, req_height, n_boxes;
   guint8 *d;
   guint64 pattern_data;
+  guint64 *sums;
+  GstClockTime clock_time = GST_CLOCK_TIME_NONE;
+  GstClockTime latency = GST_CLOCK_TIME_NONE;
 
   width = frame->info.width;
   height = frame->info.height;
@@ -456,28 +587,37 @@ gst_video_detect_yuv (GstSimpleVideoMarkDetect * simplevideomarkdetect,
   row_stride = GST_VIDEO_FRAME_COMP_STRIDE (frame, 0);
   pixel_stride = GST_VIDEO_FRAME_COMP_PSTRIDE (frame, 0);
 
-  req_width =
-      (simplevideomarkdetect->pattern_count +
-      simplevideomarkdetect->pattern_data_count) * pw +
-      simplevideomarkdetect->left_offset;
+  /* only needed for the messages and the latency */
+  if (simplevideomarkdetect->message || simplevideomarkdetect->measure_latency)
+    clock_time = gst_video_detect_get_clock_time (simplevideomarkdetect);
+
+  n_boxes = simplevideomarkdetect->pattern_count +
+      simplevideomarkdetect->pattern_data_count;
+  req_width = n_boxes * pw + simplevideomarkdetect->left_offset;
   req_height = simplevideomarkdetect->bottom_offset + ph;
   if (req_width > width || req_height > height) {
     goto no_pattern;
   }
 
+  if (simplevideomarkdetect->n_box_sums < n_boxes) {
+    g_free (simplevideomarkdetect->box_sums);
+    simplevideomarkdetect->box_sums = g_new (guint64, n_boxes);
+    simplevideomarkdetect->n_box_sums = n_boxes;
+  }
+  sums = simplevideomarkdetect->box_sums;
+
+  d = GST_VIDEO_FRAME_COMP_DATA (frame, 0);
+  /* move to start of bottom left, adjust for offsets */
+  d += row_stride * (height - ph - simplevideomarkdetect->bottom_offset) +
+      pixel_stride * simplevideomarkdetect->left_offset;
+
+  /* calc brightness of all width * height boxes */
+  gst_video_detect_sum_boxes (sums, n_boxes, d, pw, ph, row_stride,
+      pixel_stride);
+
   /* analyse the bottom left pixels */
   for (i = 0; i < simplevideomarkdetect->pattern_count; i++) {
-    d = GST_VIDEO_FRAME_COMP_DATA (frame, 0);
-    /* move to start of bottom left, adjust for offsets */
-    d += row_stride * (height - ph - simplevideomarkdetect->bottom_offset) +
-        pixel_stride * simplevideomarkdetect->left_offset;
-    /* move to i-th pattern */
-    d += pixel_stride * pw * i;
-
-    /* calc brightness of width * height box */
-    brightness =
-        gst_video_detect_calc_brightness (simplevideomarkdetect, d, pw, ph,
-        row_stride, pixel_stride);
+    brightness = sums[i] / (255.0 * pw * ph);
 
     GST_DEBUG_OBJECT (simplevideomarkdetect, "brightness %f", brightness);
 
@@ -501,21 +641,10 @@ gst_video_detect_yuv (GstSimpleVideoMarkDetect * simplevideomarkdetect,
 
   pattern_data = 0;
 
-  /* get the data of the pattern */
+  /* get the data of the pattern, after the fixed pattern */
   for (i = 0; i < simplevideomarkdetect->pattern_data_count; i++) {
-    d = GST_VIDEO_FRAME_COMP_DATA (frame, 0);
-    /* move to start of bottom left, adjust for offsets */
-    d += row_stride * (height - ph - simplevideomarkdetect->bottom_offset) +
-        pixel_stride * simplevideomarkdetect->left_offset;
-    /* move after the fixed pattern */
-    d += pixel_stride * (simplevideomarkdetect->pattern_count * pw);
-    /* move to i-th pattern data */
-    d += pixel_stride * pw * i;
-
-    /* calc brightness of width * height box */
     brightness =
-        gst_video_detect_calc_brightness (simplevideomarkdetect, d, pw, ph,
-        row_stride, pixel_stride);
+        sums[simplevideomarkdetect->pattern_count + i] / (255.0 * pw * ph);
     /* update pattern, we just use the center to decide between black and white. */
     pattern_data <<= 1;
     if (brightness > simplevideomarkdetect->pattern_center)
@@ -525,9 +654,13 @@ gst_video_detect_yuv (GstSimpleVideoMarkDetect * simplevideomarkdetect,
   GST_DEBUG_OBJECT (simplevideomarkdetect, "have data %" G_GUINT64_FORMAT,
       pattern_data);
 
+  if (simplevideomarkdetect->measure_latency)
+    latency = gst_video_detect_update_latency (simplevideomarkdetect,
+        pattern_data, clock_time);
+
   simplevideomarkdetect->in_pattern = TRUE;
   gst_video_detect_post_message (simplevideomarkdetect, frame->buffer,
-      pattern_data);
+      pattern_data, clock_time, latency);
 
   return;
 
@@ -536,7 +669,8 @@ no_pattern:
     GST_DEBUG_OBJECT (simplevideomarkdetect, "no pattern found");
     if (simplevideomarkdetect->in_pattern) {
       simplevideomarkdetect->in_pattern = FALSE;
-      gst_video_detect_post_message (simplevideomarkdetect, frame->buffer, 0);
+      gst_video_detect_post_message (simplevideomarkdetect, frame->buffer, 0,
+          clock_time, GST_CLOCK_TIME_NONE);
     }
     return;
   }
@@ -47,8 +47,20 @@ struct _GstSimpleVideoMarkDetect
   gdouble pattern_sensitivity;
   gint left_offset;
   gint bottom_offset;
+  gboolean measure_latency;
 
   gboolean in_pattern;
+
+  /* brightness sums of the pattern and data boxes */
+  guint64 *box_sums;
+  gint n_box_sums;
+
+  /* latency distribution */
+  guint64 latency_count;
+  GstClockTime latency_min;
+  GstClockTime latency_max;
+  gdouble latency_sum;
+  gdouble latency_sum_sq;
 };
 
 struct _GstSimpleVideoMarkDetectClass
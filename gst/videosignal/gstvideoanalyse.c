@@ -68,6 +68,20 @@
  *   </para>
  * </listitem>
  * </itemizedlist>
+ *
+ * When the frame is split into more than one tile with the
+ * #GstVideoAnalyse:tile-columns and #GstVideoAnalyse:tile-rows properties,
+ * the message also contains the #guint <classname>&quot;tile-columns&quot;</classname>
+ * and <classname>&quot;tile-rows&quot;</classname> and two #GstValueArray of
+ * #gdouble, <classname>&quot;tile-luma-average&quot;</classname> and
+ * <classname>&quot;tile-luma-variance&quot;</classname>, with the statistics of
+ * every tile in row-major order. If #GstVideoAnalyse:histogram is #TRUE, a
+ * #GstValueArray of 256 #guint called
+ * <classname>&quot;luma-histogram&quot;</classname> is added as well.
+ *
+ * All statistics are gathered in a single pass over the luma plane, which
+ * can be restricted to every n-th pixel and line with
+ * #GstVideoAnalyse:subsample.
  * 
  * <refsect2>
  * <title>Example launch line</title>
@@ -86,6 +100,7 @@
 #include <gst/gst.h>
 #include <gst/video/video.h>
 #include <gst/video/gstvideofilter.h>
+#include <string.h>
 #include "gstvideoanalyse.h"
 
 GST_DEBUG_CATEGORY_STATIC (gst_video_analyse_debug_category);
@@ -106,10 +121,21 @@ static GstFlowReturn gst_video_analyse_transform_frame_ip (GstVideoFilter *
 enum
 {
   PROP_0,
-  PROP_MESSAGE
+  PROP_MESSAGE,
+  PROP_TILE_COLUMNS,
+  PROP_TILE_ROWS,
+  PROP_HISTOGRAM,
+  PROP_SUBSAMPLE
 };
 
 #define DEFAULT_MESSAGE TRUE
+#define DEFAULT_TILE_COLUMNS 1
+#define DEFAULT_TILE_ROWS 1
+#define DEFAULT_HISTOGRAM FALSE
+#define DEFAULT_SUBSAMPLE 1
+
+#define MAX_TILES 64
+#define MAX_SUBSAMPLE 16
 
 #define VIDEO_CAPS \
     GST_VIDEO_CAPS_MAKE("{ I420, YV12, Y444, Y42B, Y41B }")
@@ -150,6 +176,26 @@ gst_video_analyse_class_init (GstVideoAnalyseClass * klass)
           "Post statics messages",
           DEFAULT_MESSAGE,
           G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_TILE_COLUMNS,
+      g_param_spec_uint ("tile-columns", "Tile columns",
+          "Number of tile columns to gather statistics for", 1, MAX_TILES,
+          DEFAULT_TILE_COLUMNS,
+          G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_TILE_ROWS,
+      g_param_spec_uint ("tile-rows", "Tile rows",
+          "Number of tile rows to gather statistics for", 1, MAX_TILES,
+          DEFAULT_TILE_ROWS,
+          G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_HISTOGRAM,
+      g_param_spec_boolean ("histogram", "Histogram",
+          "Add a 256 bin luma histogram to the messages",
+          DEFAULT_HISTOGRAM,
+          G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_SUBSAMPLE,
+      g_param_spec_uint ("subsample", "Subsample",
+          "Only analyse every n-th pixel of every n-th line", 1,
+          MAX_SUBSAMPLE, DEFAULT_SUBSAMPLE,
+          G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
   //trans_class->passthrough_on_same_caps = TRUE;
 }
 
@@ -170,6 +216,18 @@ gst_video_analyse_set_property (GObject * object, guint property_id,
     case PROP_MESSAGE:
       videoanalyse->message = g_value_get_boolean (value);
       break;
+    case PROP_TILE_COLUMNS:
+      videoanalyse->tile_columns = g_value_get_uint (value);
+      break;
+    case PROP_TILE_ROWS:
+      videoanalyse->tile_rows = g_value_get_uint (value);
+      break;
+    case PROP_HISTOGRAM:
+      videoanalyse->histogram = g_value_get_boolean (value);
+      break;
+    case PROP_SUBSAMPLE:
+      videoanalyse->subsample = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -188,6 +246,18 @@ gst_video_analyse_get_property (GObject * object, guint property_id,
     case PROP_MESSAGE:
       g_value_set_boolean (value, videoanalyse->message);
       break;
+    case PROP_TILE_COLUMNS:
+      g_value_set_uint (value, videoanalyse->tile_columns);
+      break;
+    case PROP_TILE_ROWS:
+      g_value_set_uint (value, videoanalyse->tile_rows);
+      break;
+    case PROP_HISTOGRAM:
+      g_value_set_boolean (value, videoanalyse->histogram);
+      break;
+    case PROP_SUBSAMPLE:
+      g_value_set_uint (value, videoanalyse->subsample);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -201,17 +271,75 @@ gst_video_analyse_finalize (GObject * object)
 
   GST_DEBUG_OBJECT (videoanalyse, "finalize");
 
-  /* clean up object here */
+  g_free (videoanalyse->tile_sum);
+  g_free (videoanalyse->tile_sumsq);
+  g_free (videoanalyse->tile_count);
+  g_free (videoanalyse->tile_average);
+  g_free (videoanalyse->tile_variance);
 
   G_OBJECT_CLASS (gst_video_analyse_parent_class)->finalize (object);
 }
 
+static void
+gst_video_analyse_append_double (GValue * array, gdouble val)
+{
+  GValue v = G_VALUE_INIT;
+
+  g_value_init (&v, G_TYPE_DOUBLE);
+  g_value_set_double (&v, val);
+  gst_value_array_append_value (array, &v);
+  g_value_unset (&v);
+}
+
+static void
+gst_video_analyse_add_tiles (GstVideoAnalyse * videoanalyse,
+    GstStructure * s)
+{
+  GValue averages = G_VALUE_INIT;
+  GValue variances = G_VALUE_INIT;
+  guint i;
+
+  g_value_init (&averages, GST_TYPE_ARRAY);
+  g_value_init (&variances, GST_TYPE_ARRAY);
+  for (i = 0; i < videoanalyse->n_tiles; i++) {
+    gst_video_analyse_append_double (&averages, videoanalyse->tile_average[i]);
+    gst_video_analyse_append_double (&variances,
+        videoanalyse->tile_variance[i]);
+  }
+
+  gst_structure_set (s, "tile-columns", G_TYPE_UINT, videoanalyse->n_columns,
+      "tile-rows", G_TYPE_UINT,
+      videoanalyse->n_tiles / videoanalyse->n_columns, NULL);
+  gst_structure_take_value (s, "tile-luma-average", &averages);
+  gst_structure_take_value (s, "tile-luma-variance", &variances);
+}
+
+static void
+gst_video_analyse_add_histogram (GstVideoAnalyse * videoanalyse,
+    GstStructure * s)
+{
+  GValue hist = G_VALUE_INIT;
+  GValue v = G_VALUE_INIT;
+  guint i;
+
+  g_value_init (&hist, GST_TYPE_ARRAY);
+  g_value_init (&v, G_TYPE_UINT);
+  for (i = 0; i < 256; i++) {
+    g_value_set_uint (&v, videoanalyse->luma_histogram[i]);
+    gst_value_array_append_value (&hist, &v);
+  }
+  g_value_unset (&v);
+
+  gst_structure_take_value (s, "luma-histogram", &hist);
+}
+
 static void
 gst_video_analyse_post_message (GstVideoAnalyse * videoanalyse,
     GstVideoFrame * frame)
 {
   GstBaseTransform *trans;
   GstMessage *m;
+  GstStructure *s;
   guint64 duration, timestamp, running_time, stream_time;
 
   trans = GST_BASE_TRANSFORM_CAST (videoanalyse);
@@ -224,54 +352,142 @@ gst_video_analyse_post_message (GstVideoAnalyse * videoanalyse,
   stream_time = gst_segment_to_stream_time (&trans->segment, GST_FORMAT_TIME,
       timestamp);
 
-  m = gst_message_new_element (GST_OBJECT_CAST (videoanalyse),
-      gst_structure_new ("GstVideoAnalyse",
-          "timestamp", G_TYPE_UINT64, timestamp,
-          "stream-time", G_TYPE_UINT64, stream_time,
-          "running-time", G_TYPE_UINT64, running_time,
-          "duration", G_TYPE_UINT64, duration,
-          "luma-average", G_TYPE_DOUBLE, videoanalyse->luma_average,
-          "luma-variance", G_TYPE_DOUBLE, videoanalyse->luma_variance, NULL));
+  s = gst_structure_new ("GstVideoAnalyse",
+      "timestamp", G_TYPE_UINT64, timestamp,
+      "stream-time", G_TYPE_UINT64, stream_time,
+      "running-time", G_TYPE_UINT64, running_time,
+      "duration", G_TYPE_UINT64, duration,
+      "luma-average", G_TYPE_DOUBLE, videoanalyse->luma_average,
+      "luma-variance", G_TYPE_DOUBLE, videoanalyse->luma_variance, NULL);
+
+  if (videoanalyse->n_tiles > 1)
+    gst_video_analyse_add_tiles (videoanalyse, s);
+  if (videoanalyse->histogram)
+    gst_video_analyse_add_histogram (videoanalyse, s);
+
+  m = gst_message_new_element (GST_OBJECT_CAST (videoanalyse), s);
 
   gst_element_post_message (GST_ELEMENT_CAST (videoanalyse), m);
 }
 
+static void
+gst_video_analyse_alloc_tiles (GstVideoAnalyse * videoanalyse, guint n_tiles)
+{
+  if (videoanalyse->n_tiles == n_tiles)
+    return;
+
+  videoanalyse->tile_sum = g_renew (guint64, videoanalyse->tile_sum, n_tiles);
+  videoanalyse->tile_sumsq =
+      g_renew (guint64, videoanalyse->tile_sumsq, n_tiles);
+  videoanalyse->tile_count =
+      g_renew (guint64, videoanalyse->tile_count, n_tiles);
+  videoanalyse->tile_average =
+      g_renew (gdouble, videoanalyse->tile_average, n_tiles);
+  videoanalyse->tile_variance =
+      g_renew (gdouble, videoanalyse->tile_variance, n_tiles);
+  videoanalyse->n_tiles = n_tiles;
+}
+
+/* accumulates @n pixels of a line segment, taking every @step-th pixel.
+ * The common case of no subsampling and no histogram is kept in a loop of
+ * its own so that it vectorizes. */
+static inline void
+gst_video_analyse_segment (const guint8 * s, gint n, gint step, guint * hist,
+    guint64 * sum, guint64 * sumsq)
+{
+  guint lsum = 0;
+  guint64 lsumsq = 0;
+  gint i;
+
+  if (step == 1 && hist == NULL) {
+    for (i = 0; i < n; i++) {
+      lsum += s[i];
+      lsumsq += s[i] * s[i];
+    }
+  } else {
+    for (i = 0; i < n; i += step) {
+      lsum += s[i];
+      lsumsq += s[i] * s[i];
+      if (hist)
+        hist[s[i]]++;
+    }
+  }
+
+  *sum += lsum;
+  *sumsq += lsumsq;
+}
+
 static void
 gst_video_analyse_planar (GstVideoAnalyse * videoanalyse, GstVideoFrame * frame)
 {
-  guint64 sum;
-  gint avg, diff;
-  gint i, j;
+  guint64 sum, sumsq, count;
+  gdouble mean;
+  gint i, j, x0, x1, y, row;
   guint8 *d;
   gint width = frame->info.width;
   gint height = frame->info.height;
   gint stride;
+  gint cols = videoanalyse->tile_columns;
+  gint rows = videoanalyse->tile_rows;
+  gint step = videoanalyse->subsample;
+  guint *hist = NULL;
+
+  gst_video_analyse_alloc_tiles (videoanalyse, cols * rows);
+  videoanalyse->n_columns = cols;
+
+  memset (videoanalyse->tile_sum, 0, cols * rows * sizeof (guint64));
+  memset (videoanalyse->tile_sumsq, 0, cols * rows * sizeof (guint64));
+  memset (videoanalyse->tile_count, 0, cols * rows * sizeof (guint64));
+  if (videoanalyse->histogram) {
+    hist = videoanalyse->luma_histogram;
+    memset (hist, 0, sizeof (videoanalyse->luma_histogram));
+  }
 
   d = frame->data[0];
   stride = frame->info.stride[0];
-  sum = 0;
-  /* do brightness as average of pixel brightness in 0.0 to 1.0 */
-  for (i = 0; i < height; i++) {
-    for (j = 0; j < width; j++) {
-      sum += d[j];
+  /* sum and sum of squares of every tile in one pass */
+  for (y = 0; y < height; y += step) {
+    guint64 *tsum, *tsumsq, *tcount;
+
+    row = (gint64) y * rows / height;
+    tsum = videoanalyse->tile_sum + row * cols;
+    tsumsq = videoanalyse->tile_sumsq + row * cols;
+    tcount = videoanalyse->tile_count + row * cols;
+
+    for (i = 0; i < cols; i++) {
+      /* first pixel on the subsampling grid in this tile */
+      x0 = ((gint64) i * width / cols + step - 1) / step * step;
+      x1 = (gint64) (i + 1) * width / cols;
+      if (x0 >= x1)
+        continue;
+
+      gst_video_analyse_segment (d + y * stride + x0, x1 - x0, step, hist,
+          &tsum[i], &tsumsq[i]);
+      tcount[i] += (x1 - x0 + step - 1) / step;
     }
-    d += stride;
   }
-  avg = sum / (width * height);
-  videoanalyse->luma_average = sum / (255.0 * width * height);
 
-  d = frame->data[0];
-  stride = frame->info.stride[0];
-  sum = 0;
-  /* do variance */
-  for (i = 0; i < height; i++) {
-    for (j = 0; j < width; j++) {
-      diff = (avg - d[j]);
-      sum += diff * diff;
-    }
-    d += stride;
+  sum = sumsq = count = 0;
+  for (j = 0; j < cols * rows; j++) {
+    guint64 n = MAX (videoanalyse->tile_count[j], 1);
+
+    mean = (gdouble) videoanalyse->tile_sum[j] / n;
+    videoanalyse->tile_average[j] = mean / 255.0;
+    videoanalyse->tile_variance[j] =
+        MAX ((gdouble) videoanalyse->tile_sumsq[j] / n - mean * mean,
+        0.0) / (255.0 * 255.0);
+
+    sum += videoanalyse->tile_sum[j];
+    sumsq += videoanalyse->tile_sumsq[j];
+    count += videoanalyse->tile_count[j];
   }
-  videoanalyse->luma_variance = sum / (255.0 * 255.0 * width * height);
+
+  /* do brightness as average of pixel brightness in 0.0 to 1.0 */
+  count = MAX (count, 1);
+  mean = (gdouble) sum / count;
+  videoanalyse->luma_average = mean / 255.0;
+  videoanalyse->luma_variance =
+      MAX ((gdouble) sumsq / count - mean * mean, 0.0) / (255.0 * 255.0);
 }
 
 static GstFlowReturn
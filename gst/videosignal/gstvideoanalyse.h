@@ -40,9 +40,26 @@ struct _GstVideoAnalyse
 
   /* properties */
   gboolean message;
+  guint tile_columns;
+  guint tile_rows;
+  gboolean histogram;
+  guint subsample;
+
   guint64 interval;
   gdouble luma_average;
   gdouble luma_variance;
+
+  /* per tile accumulators and results of the last frame, in rows of
+   * n_columns tiles */
+  guint n_tiles;
+  guint n_columns;
+  guint64 *tile_sum;
+  guint64 *tile_sumsq;
+  guint64 *tile_count;
+  gdouble *tile_average;
+  gdouble *tile_variance;
+
+  guint luma_histogram[256];
 };
 
 struct _GstVideoAnalyseClass
@@ -72,18 +72,24 @@ static GstFlowReturn gst_yadif_transform (GstBaseTransform * trans,
 enum
 {
   PROP_0,
-  PROP_MODE
+  PROP_MODE,
+  PROP_N_THREADS
 };
 
 #define DEFAULT_MODE GST_DEINTERLACE_MODE_AUTO
+#define DEFAULT_N_THREADS 1
 
 /* pad templates */
 
+#define YADIF_FORMATS "{ Y42B, I420, Y444, NV12, NV21, YUY2, UYVY, YVYU, " \
+    GST_VIDEO_NE (I420_10) ", " GST_VIDEO_NE (I422_10) ", " \
+    GST_VIDEO_NE (Y444_10) ", " GST_VIDEO_NE (GRAY16) " }"
+
 static GstStaticPadTemplate gst_yadif_sink_template =
 GST_STATIC_PAD_TEMPLATE ("sink",
     GST_PAD_SINK,
     GST_PAD_ALWAYS,
-    GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE ("{Y42B,I420,Y444}")
+    GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE (YADIF_FORMATS)
         ",interlace-mode=(string){interleaved,mixed,progressive}")
     );
 
@@ -91,7 +97,7 @@ static GstStaticPadTemplate gst_yadif_src_template =
 GST_STATIC_PAD_TEMPLATE ("src",
     GST_PAD_SRC,
     GST_PAD_ALWAYS,
-    GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE ("{Y42B,I420,Y444}")
+    GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE (YADIF_FORMATS)
         ",interlace-mode=(string)progressive")
     );
 
@@ -159,6 +165,12 @@ gst_yadif_class_init (GstYadifClass * klass)
           GST_TYPE_DEINTERLACE_MODES,
           DEFAULT_MODE,
           G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      g_param_spec_int ("n-threads", "Number of Threads",
+          "Number of threads used to filter a frame "
+          "(0 == number of processors)", 0, MAX_YADIF_THREADS,
+          DEFAULT_N_THREADS,
+          G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
 
 }
 
@@ -171,6 +183,9 @@ gst_yadif_init (GstYadif * yadif)
 
   yadif->srcpad = gst_pad_new_from_static_template (&gst_yadif_src_template,
       "src");
+
+  g_mutex_init (&yadif->lock);
+  g_cond_init (&yadif->cond);
 }
 
 void
@@ -183,6 +198,11 @@ gst_yadif_set_property (GObject * object, guint property_id,
     case PROP_MODE:
       yadif->mode = g_value_get_enum (value);
       break;
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (yadif);
+      yadif->n_threads = g_value_get_int (value);
+      GST_OBJECT_UNLOCK (yadif);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -199,6 +219,11 @@ gst_yadif_get_property (GObject * object, guint property_id,
     case PROP_MODE:
       g_value_set_enum (value, yadif->mode);
       break;
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (yadif);
+      g_value_set_int (value, yadif->n_threads);
+      GST_OBJECT_UNLOCK (yadif);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -218,9 +243,14 @@ gst_yadif_dispose (GObject * object)
 void
 gst_yadif_finalize (GObject * object)
 {
-  /* GstYadif *yadif = GST_YADIF (object); */
+  GstYadif *yadif = GST_YADIF (object);
+
+  if (yadif->pool)
+    g_thread_pool_free (yadif->pool, FALSE, TRUE);
+  yadif->pool = NULL;
 
-  /* clean up object here */
+  g_mutex_clear (&yadif->lock);
+  g_cond_clear (&yadif->cond);
 
   G_OBJECT_CLASS (gst_yadif_parent_class)->finalize (object);
 }
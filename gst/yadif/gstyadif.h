@@ -56,8 +56,17 @@ struct _GstYadif
   GstVideoFrame cur_frame;
   GstVideoFrame next_frame;
   GstVideoFrame dest_frame;
+
+  /* lines are filtered in bands, one per thread */
+  gint n_threads;
+  GThreadPool *pool;
+  GMutex lock;
+  GCond cond;
+  gint pending_bands;
 };
 
+#define MAX_YADIF_THREADS 64
+
 struct _GstYadifClass
 {
   GstBaseTransformClass base_yadif_class;
@@ -38,16 +38,24 @@
 
 #define PERM_RWP AV_PERM_WRITE | AV_PERM_PRESERVE | AV_PERM_REUSE
 
+/* ps is the distance between two samples of a component, 1 for planar
+ * formats, 2 or 4 for the chroma of semi-planar and packed ones */
 #define CHECK(j)\
-    {   int score = FFABS(cur[mrefs-1+(j)] - cur[prefs-1-(j)])\
-                  + FFABS(cur[mrefs  +(j)] - cur[prefs  -(j)])\
-                  + FFABS(cur[mrefs+1+(j)] - cur[prefs+1-(j)]);\
+    {   int score = FFABS(cur[mrefs-ps+(j)*ps] - cur[prefs-ps-(j)*ps])\
+                  + FFABS(cur[mrefs   +(j)*ps] - cur[prefs   -(j)*ps])\
+                  + FFABS(cur[mrefs+ps+(j)*ps] - cur[prefs+ps-(j)*ps]);\
         if (score < spatial_score) {\
             spatial_score= score;\
-            spatial_pred= (cur[mrefs  +(j)] + cur[prefs  -(j)])>>1;\
+            spatial_pred= (cur[mrefs  +(j)*ps] + cur[prefs  -(j)*ps])>>1;\
 
-#define FILTER \
-    for (x = 0;  x < w; x++) { \
+/* the spatial check reads up to EDGE samples to each side, it is skipped
+ * for the samples at the edges of the line so that it does not read
+ * outside of it */
+#define EDGE 3
+
+/* filters the samples from x up to end */
+#define FILTER(end, is_not_edge) \
+    for (;  x < end; x++) { \
         int c = cur[mrefs]; \
         int d = (prev2[0] + next2[0])>>1; \
         int e = cur[prefs]; \
@@ -56,11 +64,14 @@
         int temporal_diff2 =(FFABS(next[mrefs] - c) + FFABS(next[prefs] - e) )>>1; \
         int diff = FFMAX3(temporal_diff0 >> 1, temporal_diff1, temporal_diff2); \
         int spatial_pred = (c+e) >> 1; \
-        int spatial_score = FFABS(cur[mrefs - 1] - cur[prefs - 1]) + FFABS(c-e) \
-                          + FFABS(cur[mrefs + 1] - cur[prefs + 1]) - 1; \
  \
-        CHECK(-1) CHECK(-2) }} }} \
-        CHECK( 1) CHECK( 2) }} }} \
+        if (is_not_edge) { \
+            int spatial_score = FFABS(cur[mrefs - ps] - cur[prefs - ps]) + FFABS(c-e) \
+                              + FFABS(cur[mrefs + ps] - cur[prefs + ps]) - 1; \
+ \
+            CHECK(-1) CHECK(-2) }} }} \
+            CHECK( 1) CHECK( 2) }} }} \
+        } \
  \
         if (mode < 2) { \
             int b = (prev2[2 * mrefs] + next2[2 * mrefs])>>1; \
@@ -78,39 +89,68 @@
  \
         dst[0] = spatial_pred; \
  \
-        dst++; \
-        cur++; \
-        prev++; \
-        next++; \
-        prev2++; \
-        next2++; \
+        dst += ps; \
+        cur += ps; \
+        prev += ps; \
+        next += ps; \
+        prev2 += ps; \
+        next2 += ps; \
     }
 
+/* filters the samples from start to end of a line of w samples */
+#define FILTER_LINE \
+    x = start; \
+    edge0 = CLAMP (EDGE, start, end); \
+    edge1 = CLAMP (w - EDGE, edge0, end); \
+ \
+    dst += start * ps; \
+    prev += start * ps; \
+    cur += start * ps; \
+    next += start * ps; \
+    prev2 += start * ps; \
+    next2 += start * ps; \
+ \
+    FILTER (edge0, 0) \
+    FILTER (edge1, 1) \
+    FILTER (end, 0)
+
 static void
 filter_line_c (guint8 * dst,
     guint8 * prev, guint8 * cur, guint8 * next,
-    int w, int prefs, int mrefs, int parity, int mode)
+    int start, int end, int w, int prefs, int mrefs, int parity, int mode)
 {
-  int x;
+  const int ps = 1;
+  int x, edge0, edge1;
   guint8 *prev2 = parity ? prev : cur;
   guint8 *next2 = parity ? cur : next;
 
-FILTER}
+FILTER_LINE}
+
+static void
+filter_line_c_interleaved (guint8 * dst,
+    guint8 * prev, guint8 * cur, guint8 * next,
+    int w, int prefs, int mrefs, int parity, int mode, int ps)
+{
+  const int start = 0, end = w;
+  int x, edge0, edge1;
+  guint8 *prev2 = parity ? prev : cur;
+  guint8 *next2 = parity ? cur : next;
+
+FILTER_LINE}
 
-#if 0
 static void
 filter_line_c_16bit (guint16 * dst,
     guint16 * prev, guint16 * cur, guint16 * next,
-    int w, int prefs, int mrefs, int parity, int mode)
+    int w, int prefs, int mrefs, int parity, int mode, int ps)
 {
-  int x;
+  const int start = 0, end = w;
+  int x, edge0, edge1;
   guint16 *prev2 = parity ? prev : cur;
   guint16 *next2 = parity ? cur : next;
   mrefs /= 2;
   prefs /= 2;
 
-FILTER}
-#endif
+FILTER_LINE}
 
 void yadif_filter (GstYadif * yadif, int parity, int tff);
 #ifdef HAVE_CPU_X86_64
@@ -119,50 +159,177 @@ void filter_line_x86_64 (guint8 * dst,
     int w, int prefs, int mrefs, int parity, int mode);
 #endif
 
-void
-yadif_filter (GstYadif * yadif, int parity, int tff)
+/* at least this many lines of the first component per band */
+#define MIN_BAND_LINES 16
+
+typedef struct
+{
+  int parity;
+  int tff;
+  int band;
+  int n_bands;
+} YadifBand;
+
+static void
+filter_line (int depth, int ps, guint8 * dst,
+    guint8 * prev, guint8 * cur, guint8 * next,
+    int w, int prefs, int mrefs, int parity, int mode)
+{
+  if (depth > 8) {
+    filter_line_c_16bit ((guint16 *) dst, (guint16 *) prev, (guint16 *) cur,
+        (guint16 *) next, w, prefs, mrefs, parity, mode, ps);
+  } else if (ps > 1) {
+    filter_line_c_interleaved (dst, prev, cur, next, w, prefs, mrefs, parity,
+        mode, ps);
+  } else {
+#if HAVE_CPU_X86_64
+    /* the SIMD version writes a whole vector at a time and always does the
+     * spatial check, only let it handle complete vectors away from the
+     * edges so it never reads outside of the line or writes past it, which
+     * might be owned by another band */
+    int simd_w = w > 2 * EDGE ? (w - 2 * EDGE) & ~7 : 0;
+
+    if (simd_w > 0) {
+      filter_line_c (dst, prev, cur, next, 0, EDGE, w, prefs, mrefs, parity,
+          mode);
+      filter_line_x86_64 (dst + EDGE, prev + EDGE, cur + EDGE, next + EDGE,
+          simd_w, prefs, mrefs, parity, mode);
+      filter_line_c (dst, prev, cur, next, EDGE + simd_w, w, w, prefs, mrefs,
+          parity, mode);
+    } else {
+      filter_line_c (dst, prev, cur, next, 0, w, w, prefs, mrefs, parity,
+          mode);
+    }
+#else
+    filter_line_c (dst, prev, cur, next, 0, w, w, prefs, mrefs, parity, mode);
+#endif
+  }
+}
+
+/* filters the lines of band @band out of @n_bands of every component */
+static void
+yadif_filter_band (GstYadif * yadif, int parity, int tff, int band,
+    int n_bands)
 {
   int y, i;
   const GstVideoInfo *vi = &yadif->video_info;
   const GstVideoFormatInfo *vfi = vi->finfo;
+  gboolean copied[GST_VIDEO_MAX_PLANES] = { FALSE, };
 
   for (i = 0; i < GST_VIDEO_FORMAT_INFO_N_COMPONENTS (vfi); i++) {
     int w = GST_VIDEO_FORMAT_INFO_SCALE_WIDTH (vfi, i, vi->width);
     int h = GST_VIDEO_FORMAT_INFO_SCALE_HEIGHT (vfi, i, vi->height);
     int refs = GST_VIDEO_INFO_COMP_STRIDE (vi, i);
     int df = GST_VIDEO_INFO_COMP_PSTRIDE (vi, i);
+    int depth = GST_VIDEO_FORMAT_INFO_DEPTH (vfi, i);
+    int ps = depth > 8 ? df / 2 : df;
+    int plane = GST_VIDEO_FORMAT_INFO_PLANE (vfi, i);
+    int y0 = (gint64) h * band / n_bands;
+    int y1 = (gint64) h * (band + 1) / n_bands;
+    gboolean copy = !copied[plane];
     guint8 *prev_data = GST_VIDEO_FRAME_COMP_DATA (&yadif->prev_frame, i);
     guint8 *cur_data = GST_VIDEO_FRAME_COMP_DATA (&yadif->cur_frame, i);
     guint8 *next_data = GST_VIDEO_FRAME_COMP_DATA (&yadif->next_frame, i);
     guint8 *dest_data = GST_VIDEO_FRAME_COMP_DATA (&yadif->dest_frame, i);
+    guint8 *cur_plane = GST_VIDEO_FRAME_PLANE_DATA (&yadif->cur_frame, plane);
+    guint8 *dest_plane =
+        GST_VIDEO_FRAME_PLANE_DATA (&yadif->dest_frame, plane);
+
+    /* kept lines are copied once per plane, for all the components that
+     * are interleaved in it */
+    copied[plane] = TRUE;
 
-    for (y = 0; y < h; y++) {
+    for (y = y0; y < y1; y++) {
       if ((y ^ parity) & 1) {
         guint8 *prev = prev_data + y * refs;
         guint8 *cur = cur_data + y * refs;
         guint8 *next = next_data + y * refs;
         guint8 *dst = dest_data + y * refs;
         int mode = ((y == 1) || (y + 2 == h)) ? 2 : yadif->mode;
-#if HAVE_CPU_X86_64
-        if (0) {
-          filter_line_c (dst, prev, cur, next, w,
-              y + 1 < h ? refs : -refs, y ? -refs : refs, parity ^ tff, mode);
-        } else {
-          filter_line_x86_64 (dst, prev, cur, next, w,
-              y + 1 < h ? refs : -refs, y ? -refs : refs, parity ^ tff, mode);
-        }
-#else
-        filter_line_c (dst, prev, cur, next, w,
-            y + 1 < h ? refs : -refs, y ? -refs : refs, parity ^ tff, mode);
-#endif
-      } else {
-        guint8 *dst = dest_data + y * refs;
-        guint8 *cur = cur_data + y * refs;
 
-        memcpy (dst, cur, w * df);
+        filter_line (depth, ps, dst, prev, cur, next, w,
+            y + 1 < h ? refs : -refs, y ? -refs : refs, parity ^ tff, mode);
+      } else if (copy) {
+        memcpy (dest_plane + y * refs, cur_plane + y * refs, w * df);
       }
     }
   }
+}
+
+static void
+yadif_band_func (gpointer data, gpointer user_data)
+{
+  YadifBand *band = data;
+  GstYadif *yadif = user_data;
+
+  yadif_filter_band (yadif, band->parity, band->tff, band->band,
+      band->n_bands);
+
+  g_mutex_lock (&yadif->lock);
+  if (--yadif->pending_bands == 0)
+    g_cond_signal (&yadif->cond);
+  g_mutex_unlock (&yadif->lock);
+}
+
+static gint
+yadif_get_n_threads (GstYadif * yadif)
+{
+  gint n_threads;
+
+  GST_OBJECT_LOCK (yadif);
+  n_threads = yadif->n_threads;
+  GST_OBJECT_UNLOCK (yadif);
+
+  if (n_threads == 0) {
+#if GLIB_CHECK_VERSION (2, 36, 0)
+    n_threads = g_get_num_processors ();
+#else
+    n_threads = 1;
+#endif
+  }
+
+  return CLAMP (n_threads, 1, MAX_YADIF_THREADS);
+}
+
+void
+yadif_filter (GstYadif * yadif, int parity, int tff)
+{
+  YadifBand bands[MAX_YADIF_THREADS];
+  int n_threads = yadif_get_n_threads (yadif);
+  int n_bands, i;
+
+  n_bands = MIN (n_threads, yadif->video_info.height / MIN_BAND_LINES);
+  n_bands = CLAMP (n_bands, 1, MAX_YADIF_THREADS);
+
+  if (n_bands > 1 && !yadif->pool) {
+    yadif->pool = g_thread_pool_new (yadif_band_func, yadif, n_bands, FALSE,
+        NULL);
+  } else if (yadif->pool && g_thread_pool_get_max_threads (yadif->pool) <
+      n_bands) {
+    g_thread_pool_set_max_threads (yadif->pool, n_bands, NULL);
+  }
+
+  if (n_bands == 1 || !yadif->pool) {
+    yadif_filter_band (yadif, parity, tff, 0, 1);
+    return;
+  }
+
+  g_mutex_lock (&yadif->lock);
+  yadif->pending_bands = n_bands;
+  g_mutex_unlock (&yadif->lock);
+
+  for (i = 0; i < n_bands; i++) {
+    bands[i].parity = parity;
+    bands[i].tff = tff;
+    bands[i].band = i;
+    bands[i].n_bands = n_bands;
+    g_thread_pool_push (yadif->pool, &bands[i], NULL);
+  }
+
+  g_mutex_lock (&yadif->lock);
+  while (yadif->pending_bands > 0)
+    g_cond_wait (&yadif->cond, &yadif->lock);
+  g_mutex_unlock (&yadif->lock);
 
 #if 0
   emms_c ();
@@ -189,6 +189,48 @@ GST_START_TEST (test_audio_pad)
 
 GST_END_TEST;
 
+/* in streamable mode only the header and fixed size data packets are
+ * pushed, nothing is rewritten or appended at EOS */
+GST_START_TEST (test_streamable)
+{
+  GstElement *asfmux;
+  GstBuffer *inbuffer;
+  GstCaps *caps;
+  GList *l;
+  gint i;
+
+  asfmux = setup_asfmux (&srcvideotemplate, "video_%u");
+  g_object_set (asfmux, "streamable", TRUE, "packet-size", 1000, NULL);
+  fail_unless (gst_element_set_state (asfmux,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+
+  caps = gst_caps_from_string (VIDEO_CAPS_STRING);
+  gst_check_setup_events (mysrcpad, asfmux, caps, GST_FORMAT_TIME);
+  gst_caps_unref (caps);
+
+  for (i = 0; i < 20; i++) {
+    inbuffer = gst_buffer_new_and_alloc (300);
+    gst_buffer_memset (inbuffer, 0, i, 300);
+    GST_BUFFER_TIMESTAMP (inbuffer) = i * GST_SECOND / 25;
+    GST_BUFFER_DURATION (inbuffer) = GST_SECOND / 25;
+    if (i % 10)
+      GST_BUFFER_FLAG_SET (inbuffer, GST_BUFFER_FLAG_DELTA_UNIT);
+    fail_unless_equals_int (gst_pad_push (mysrcpad, inbuffer), GST_FLOW_OK);
+  }
+  fail_unless (gst_pad_push_event (mysrcpad, gst_event_new_eos ()));
+
+  /* the header and at least the packets holding 6000 bytes of payload */
+  fail_unless (g_list_length (buffers) > 6);
+  for (l = buffers->next; l; l = l->next)
+    fail_unless_equals_int (gst_buffer_get_size (l->data), 1000);
+
+  cleanup_asfmux (asfmux, "video_%u");
+  gst_check_drop_buffers ();
+}
+
+GST_END_TEST;
+
 static Suite *
 asfmux_suite (void)
 {
@@ -196,6 +238,7 @@ asfmux_suite (void)
   TCase *tc_chain = tcase_create ("general");
   tcase_add_test (tc_chain, test_video_pad);
   tcase_add_test (tc_chain, test_audio_pad);
+  tcase_add_test (tc_chain, test_streamable);
 
   suite_add_tcase (s, tc_chain);
 
@@ -20,6 +20,7 @@
  */
 
 #include "../../gst/audiovisualizers/gstaudiovisualizer.c"
+#include "../../gst/audiovisualizers/gstdrawhelpers.h"
 #undef GST_CAT_DEFAULT
 
 #include <gst/check/gstcheck.h>
@@ -154,6 +155,319 @@ GST_START_TEST (count_in_out)
 
 GST_END_TEST;
 
+/* the sizes the shaders are tested with, odd and even in both directions,
+ * with and without padding at the end of the lines */
+static const struct
+{
+  gint width, height, padding;
+} shader_sizes[] = {
+  {13, 8, 0}, {12, 7, 0}, {13, 8, 12}, {12, 7, 4}, {2, 2, 0}
+};
+
+static const guint32 shade_amounts[] = {
+  0x000a0a0a, 0x00ff8001, 0x12345678, 0x00000000
+};
+
+/* rows after the frame that the shaders must not touch */
+#define GUARD_ROWS 2
+
+static void
+fill_random (guint8 * data, gsize size, guint32 seed)
+{
+  gsize i;
+
+  for (i = 0; i < size; i++) {
+    seed = seed * 1103515245 + 12345;
+    data[i] = seed >> 16;
+  }
+}
+
+/* subtracts @amount from the red, green and blue components of @pixel,
+ * clamping at 0, and clears the unused component */
+static guint32
+shade_reference (guint32 pixel, guint32 amount)
+{
+  guint32 out = 0;
+  gint shift;
+
+  for (shift = 0; shift < 24; shift += 8) {
+    guint c = (pixel >> shift) & 0xff, a = (amount >> shift) & 0xff;
+
+    out |= (c > a ? c - a : 0) << shift;
+  }
+
+  return out;
+}
+
+/* finds the source pixel that @shader shades into @x, @y of a @w x @h
+ * frame, returns FALSE when that pixel is not written */
+static gboolean
+shader_source (GstAudioVisualizerShader shader, gint w, gint h, gint x,
+    gint y, gint * sx, gint * sy)
+{
+  *sx = x;
+  *sy = y;
+
+  switch (shader) {
+    case GST_AUDIO_VISUALIZER_SHADER_FADE:
+      return TRUE;
+    case GST_AUDIO_VISUALIZER_SHADER_FADE_AND_MOVE_UP:
+      *sy = y + 1;
+      return y < h - 1;
+    case GST_AUDIO_VISUALIZER_SHADER_FADE_AND_MOVE_DOWN:
+      *sy = y - 1;
+      return y > 0;
+    case GST_AUDIO_VISUALIZER_SHADER_FADE_AND_MOVE_LEFT:
+      *sx = x + 1;
+      return x < w - 1;
+    case GST_AUDIO_VISUALIZER_SHADER_FADE_AND_MOVE_RIGHT:
+      *sx = x - 1;
+      return x > 0;
+    case GST_AUDIO_VISUALIZER_SHADER_FADE_AND_MOVE_HORIZ_OUT:
+      /* the upper half moves up and the lower half down, the row between
+       * them is left alone */
+      *sy = y < h / 2 ? y + 1 : y - 1;
+      return y < h / 2 || y > h / 2;
+    case GST_AUDIO_VISUALIZER_SHADER_FADE_AND_MOVE_HORIZ_IN:
+      /* the upper half moves down and the lower half up, which wins in the
+       * middle row */
+      if (y >= h / 2 && y < h - 1) {
+        *sy = y + 1;
+        return TRUE;
+      }
+      *sy = y - 1;
+      return y >= 1 && y <= h / 2;
+    case GST_AUDIO_VISUALIZER_SHADER_FADE_AND_MOVE_VERT_OUT:
+      *sx = x < w / 2 ? x + 1 : x - 1;
+      return x < w / 2 || x > w / 2;
+    case GST_AUDIO_VISUALIZER_SHADER_FADE_AND_MOVE_VERT_IN:
+      if (x >= w / 2 && x < w - 1) {
+        *sx = x + 1;
+        return TRUE;
+      }
+      *sx = x - 1;
+      return x >= 1 && x <= w / 2;
+    default:
+      g_assert_not_reached ();
+      return FALSE;
+  }
+}
+
+/* shades a frame of random pixels into a frame of other random pixels,
+ * only the pixels the shader writes may change */
+static void
+check_shader (GstAudioVisualizer * scope, GstAudioVisualizerShader shader,
+    gint w, gint h, gint padding, guint32 amount)
+{
+  GstVideoInfo info;
+  GstVideoFrame sframe, dframe;
+  GstBuffer *sbuf, *dbuf;
+  guint8 *src, *expected;
+  GstMapInfo map;
+  gsize size;
+  gint x, y;
+
+  g_object_set (scope, "shader", shader, "shade-amount", amount, NULL);
+
+  gst_video_info_set_format (&info, GST_VIDEO_FORMAT_xRGB, w, h);
+  info.stride[0] = w * 4 + padding;
+  info.size = info.stride[0] * h;
+  size = info.stride[0] * (h + GUARD_ROWS);
+
+  src = g_malloc (size);
+  fill_random (src, size, 1);
+  sbuf = gst_buffer_new_allocate (NULL, size, NULL);
+  gst_buffer_fill (sbuf, 0, src, size);
+
+  expected = g_malloc (size);
+  fill_random (expected, size, 2);
+  dbuf = gst_buffer_new_allocate (NULL, size, NULL);
+  gst_buffer_fill (dbuf, 0, expected, size);
+
+  for (y = 0; y < h; y++) {
+    for (x = 0; x < w; x++) {
+      guint32 *d = (guint32 *) (expected + y * info.stride[0] + x * 4);
+      gint sx, sy;
+
+      if (shader_source (shader, w, h, x, y, &sx, &sy)) {
+        *d = shade_reference (*(guint32 *) (src + sy * info.stride[0] +
+                sx * 4), amount);
+      }
+    }
+  }
+
+  fail_unless (gst_video_frame_map (&sframe, &info, sbuf, GST_MAP_READ));
+  fail_unless (gst_video_frame_map (&dframe, &info, dbuf, GST_MAP_READWRITE));
+  scope->shader (scope, &sframe, &dframe);
+  gst_video_frame_unmap (&sframe);
+  gst_video_frame_unmap (&dframe);
+
+  gst_buffer_map (dbuf, &map, GST_MAP_READ);
+  for (y = 0; y < h + GUARD_ROWS; y++) {
+    for (x = 0; x < info.stride[0]; x += 4) {
+      gint i = y * info.stride[0] + x;
+
+      fail_unless (*(guint32 *) (map.data + i) == *(guint32 *) (expected + i),
+          "shader %d, %dx%d+%d, amount 0x%08x: pixel %d,%d is 0x%08x, "
+          "expected 0x%08x", shader, w, h, padding, amount, x / 4, y,
+          *(guint32 *) (map.data + i), *(guint32 *) (expected + i));
+    }
+  }
+  gst_buffer_unmap (dbuf, &map);
+
+  gst_buffer_unref (sbuf);
+  gst_buffer_unref (dbuf);
+  g_free (src);
+  g_free (expected);
+}
+
+/* every shader gives the same result as shading each component on its own
+ * and moving the pixels, and stays inside the frame */
+GST_START_TEST (test_shaders)
+{
+  GstAudioVisualizer *scope;
+  gint shader, i, j;
+
+  scope = g_object_new (GST_TYPE_TEST_SCOPE, NULL);
+
+  for (shader = GST_AUDIO_VISUALIZER_SHADER_FADE;
+      shader <= GST_AUDIO_VISUALIZER_SHADER_FADE_AND_MOVE_VERT_IN; shader++) {
+    for (i = 0; i < G_N_ELEMENTS (shader_sizes); i++) {
+      for (j = 0; j < G_N_ELEMENTS (shade_amounts); j++) {
+        check_shader (scope, shader, shader_sizes[i].width,
+            shader_sizes[i].height, shader_sizes[i].padding,
+            shade_amounts[j]);
+      }
+    }
+  }
+
+  gst_object_unref (scope);
+}
+
+GST_END_TEST;
+
+#define LINE_WIDTH 64
+#define LINE_HEIGHT 48
+#define LINE_COLOR 0x00c08040
+
+/* start and end points, the last ones end on the last column and row */
+static const gint lines[][4] = {
+  {3, 5, 40, 5}, {40, 5, 3, 5}, {7, 2, 7, 30}, {7, 30, 7, 2},
+  {0, 0, 20, 20}, {20, 20, 0, 0}, {2, 3, 61, 17}, {61, 17, 2, 3},
+  {5, 1, 19, 44}, {19, 44, 5, 1}, {50, 4, 10, 9}, {10, 40, 13, 1},
+  {9, 9, 9, 9}, {0, 0, LINE_WIDTH - 1, LINE_HEIGHT - 1},
+  {LINE_WIDTH - 1, 0, LINE_WIDTH - 1, LINE_HEIGHT - 1},
+  {0, LINE_HEIGHT - 1, LINE_WIDTH - 1, LINE_HEIGHT - 1}
+};
+
+/* the lines take one step per pixel along their longer axis, starting at
+ * their start point and stopping before their end point; the other axis
+ * is stepped in 16.16 fixed point, which may fall up to one pixel behind
+ * the exact line, and is exact when the line is straight or diagonal */
+GST_START_TEST (test_lines)
+{
+  guint32 *vd;
+  gint i;
+
+  vd = g_new (guint32, LINE_WIDTH * LINE_HEIGHT);
+
+  for (i = 0; i < G_N_ELEMENTS (lines); i++) {
+    gint x1 = lines[i][0], y1 = lines[i][1], x2 = lines[i][2], y2 =
+        lines[i][3];
+    gint dx = x2 - x1, dy = y2 - y1;
+    gint n = MAX (ABS (dx), ABS (dy)), drawn = 0, x, y;
+
+    memset (vd, 0, LINE_WIDTH * LINE_HEIGHT * sizeof (guint32));
+    draw_line (vd, x1, x2, y1, y2, LINE_WIDTH, LINE_COLOR);
+
+    for (y = 0; y < LINE_HEIGHT; y++) {
+      for (x = 0; x < LINE_WIDTH; x++) {
+        gint k, off;
+
+        if (vd[y * LINE_WIDTH + x] == 0)
+          continue;
+        fail_unless_equals_int (vd[y * LINE_WIDTH + x], LINE_COLOR);
+        drawn++;
+
+        /* the step of the dot and its distance from the exact line, in
+         * 1/n pixels */
+        if (ABS (dx) >= ABS (dy)) {
+          k = ABS (x - x1);
+          off = (y - y1) * n - dy * k;
+        } else {
+          k = ABS (y - y1);
+          off = (x - x1) * n - dx * k;
+        }
+        fail_unless (k < n, "line %d,%d to %d,%d: dot %d,%d", x1, y1, x2, y2,
+            x, y);
+        fail_unless (ABS (off) <= n, "line %d,%d to %d,%d: dot %d,%d", x1, y1,
+            x2, y2, x, y);
+        if (dx % n == 0 && dy % n == 0)
+          fail_unless_equals_int (off, 0);
+      }
+    }
+
+    /* one dot per step, the last one a pixel before the end point */
+    fail_unless_equals_int (drawn, n);
+    if (n > 0) {
+      fail_unless_equals_int (vd[y1 * LINE_WIDTH + x1], LINE_COLOR);
+      fail_unless_equals_int (vd[y2 * LINE_WIDTH + x2], 0);
+    }
+  }
+
+  g_free (vd);
+}
+
+GST_END_TEST;
+
+/* the anti-aliased lines start with a full dot, leave the end point alone
+ * unless a neighbour of the last step covers it and do not write outside
+ * of the frame, even when they end on its last column or row */
+GST_START_TEST (test_lines_aa)
+{
+  guint32 *vd;
+  gint i, j;
+
+  vd = g_new (guint32, LINE_WIDTH * (LINE_HEIGHT + GUARD_ROWS));
+
+  for (i = 0; i < G_N_ELEMENTS (lines); i++) {
+    gint x1 = lines[i][0], y1 = lines[i][1], x2 = lines[i][2], y2 =
+        lines[i][3];
+    gint dx = x2 - x1, dy = y2 - y1;
+    gint n = MAX (ABS (dx), ABS (dy));
+
+    memset (vd, 0, LINE_WIDTH * LINE_HEIGHT * sizeof (guint32));
+    for (j = LINE_WIDTH * LINE_HEIGHT; j < LINE_WIDTH * (LINE_HEIGHT +
+            GUARD_ROWS); j++)
+      vd[j] = 0xdeadbeef;
+
+    draw_line_aa (vd, x1, x2, y1, y2, LINE_WIDTH, LINE_HEIGHT, LINE_COLOR);
+
+    for (j = LINE_WIDTH * LINE_HEIGHT; j < LINE_WIDTH * (LINE_HEIGHT +
+            GUARD_ROWS); j++)
+      fail_unless (vd[j] == 0xdeadbeef, "line %d,%d to %d,%d", x1, y1, x2, y2);
+
+    if (n == 0) {
+      for (j = 0; j < LINE_WIDTH * LINE_HEIGHT; j++)
+        fail_unless_equals_int (vd[j], 0);
+      continue;
+    }
+
+    /* the neighbours of a step lie right of and below it, so going left or
+     * up along the longer axis the last step stops a pixel short of the end
+     * point and leaves it alone, while going right or down only the first
+     * step covers the start point, and completely */
+    if ((ABS (dx) >= ABS (dy) && dx < 0) || (ABS (dy) > ABS (dx) && dy < 0))
+      fail_unless_equals_int (vd[y2 * LINE_WIDTH + x2], 0);
+    else
+      fail_unless_equals_int (vd[y1 * LINE_WIDTH + x1], LINE_COLOR);
+  }
+
+  g_free (vd);
+}
+
+GST_END_TEST;
+
 static void
 baseaudiovisualizer_init (void)
 {
@@ -170,6 +484,9 @@ baseaudiovisualizer_suite (void)
   tcase_add_checked_fixture (tc_chain, baseaudiovisualizer_init, NULL);
 
   tcase_add_test (tc_chain, count_in_out);
+  tcase_add_test (tc_chain, test_shaders);
+  tcase_add_test (tc_chain, test_lines);
+  tcase_add_test (tc_chain, test_lines_aa);
 
   return s;
 }
@@ -0,0 +1,316 @@
+/* GStreamer
+ *
+ * unit test for coloreffects
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <glib/gstdio.h>
+
+#include <string.h>
+#include <unistd.h>
+
+/* high enough for four bands of rows */
+#define WIDTH 16
+#define HEIGHT 64
+#define FRAME_SIZE (WIDTH * HEIGHT * 4)
+
+#define VIDEO_CAPS_STRING "video/x-raw, format = (string) RGBx, " \
+    "width = (int) 16, height = (int) 64, framerate = (fraction) 25/1"
+
+/* 255 is a multiple of 15, so all the grid points are 8 bit values and
+ * tables that are linear in every component give exact results */
+#define LUT_SIZE 16
+
+static GstPad *mysrcpad, *mysinkpad;
+static GstBus *bus;
+static gchar *lut_file;
+
+static GstStaticPadTemplate sinktemplate = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (VIDEO_CAPS_STRING));
+
+static GstStaticPadTemplate srctemplate = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (VIDEO_CAPS_STRING));
+
+/* writes @contents to a new .cube file and uses it for the element */
+static GstElement *
+setup_coloreffects (const gchar * contents, gint n_threads)
+{
+  GstElement *coloreffects;
+  GstCaps *caps;
+  gint fd;
+
+  fd = g_file_open_tmp ("coloreffects-XXXXXX.cube", &lut_file, NULL);
+  fail_unless (fd >= 0);
+  close (fd);
+  fail_unless (g_file_set_contents (lut_file, contents, -1, NULL));
+
+  coloreffects = gst_check_setup_element ("coloreffects");
+  g_object_set (coloreffects, "lut-file", lut_file, "n-threads", n_threads,
+      NULL);
+  mysrcpad = gst_check_setup_src_pad (coloreffects, &srctemplate);
+  mysinkpad = gst_check_setup_sink_pad (coloreffects, &sinktemplate);
+  gst_pad_set_active (mysrcpad, TRUE);
+  gst_pad_set_active (mysinkpad, TRUE);
+
+  bus = gst_bus_new ();
+  gst_element_set_bus (coloreffects, bus);
+
+  fail_unless (gst_element_set_state (coloreffects,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+
+  caps = gst_caps_from_string (VIDEO_CAPS_STRING);
+  gst_check_setup_events (mysrcpad, coloreffects, caps, GST_FORMAT_TIME);
+  gst_caps_unref (caps);
+
+  return coloreffects;
+}
+
+static void
+cleanup_coloreffects (GstElement * coloreffects)
+{
+  gst_element_set_state (coloreffects, GST_STATE_NULL);
+
+  gst_element_set_bus (coloreffects, NULL);
+  gst_object_unref (bus);
+  bus = NULL;
+
+  gst_check_drop_buffers ();
+  gst_pad_set_active (mysrcpad, FALSE);
+  gst_pad_set_active (mysinkpad, FALSE);
+  gst_check_teardown_src_pad (coloreffects);
+  gst_check_teardown_sink_pad (coloreffects);
+  gst_check_teardown_element (coloreffects);
+
+  g_unlink (lut_file);
+  g_free (lut_file);
+  lut_file = NULL;
+}
+
+/* pushes a frame of pseudo random pixels, which are copied to @data */
+static GstFlowReturn
+push_frame (guint8 * data)
+{
+  GstBuffer *buffer;
+  guint32 seed = 1;
+  gint i;
+
+  for (i = 0; i < FRAME_SIZE; i++) {
+    seed = seed * 1103515245 + 12345;
+    data[i] = seed >> 16;
+  }
+
+  buffer = gst_buffer_new_allocate (NULL, FRAME_SIZE, NULL);
+  gst_buffer_fill (buffer, 0, data, FRAME_SIZE);
+  GST_BUFFER_PTS (buffer) = 0;
+  GST_BUFFER_DURATION (buffer) = GST_SECOND / 25;
+
+  return gst_pad_push (mysrcpad, buffer);
+}
+
+/* creates a .cube table where output component @c is input component
+ * @map[c], with the given header and line ending */
+static gchar *
+make_table (const gchar * header, const gint * map, gint n_entries,
+    const gchar * eol)
+{
+  GString *str = g_string_new (header);
+  gint i;
+
+  for (i = 0; i < n_entries; i++) {
+    gint in[3], c;
+
+    in[0] = i % LUT_SIZE;
+    in[1] = i / LUT_SIZE % LUT_SIZE;
+    in[2] = i / (LUT_SIZE * LUT_SIZE);
+
+    for (c = 0; c < 3; c++) {
+      gchar buf[G_ASCII_DTOSTR_BUF_SIZE];
+
+      g_ascii_formatd (buf, sizeof (buf), "%.6f",
+          in[map[c]] / (gdouble) (LUT_SIZE - 1));
+      g_string_append_printf (str, c < 2 ? "%s " : "%s", buf);
+    }
+    g_string_append (str, eol);
+  }
+
+  return g_string_free (str, FALSE);
+}
+
+/* applies @table and checks that output component @c of every pixel is
+ * input component @map[c], with one thread and with bands on the thread
+ * pool */
+static void
+check_table (const gchar * table, const gint * map)
+{
+  static const gint n_threads[] = { 1, 4 };
+  GstElement *coloreffects;
+  guint8 *in, *out;
+  gint t, i, c;
+
+  in = g_malloc (FRAME_SIZE);
+  out = g_malloc (FRAME_SIZE);
+
+  for (t = 0; t < G_N_ELEMENTS (n_threads); t++) {
+    coloreffects = setup_coloreffects (table, n_threads[t]);
+
+    fail_unless_equals_int (push_frame (in), GST_FLOW_OK);
+    fail_unless_equals_int (g_list_length (buffers), 1);
+    gst_buffer_extract (buffers->data, 0, out, FRAME_SIZE);
+
+    for (i = 0; i < FRAME_SIZE; i += 4) {
+      for (c = 0; c < 3; c++)
+        fail_unless_equals_int (out[i + c], in[i + map[c]]);
+    }
+
+    fail_if (gst_bus_pop_filtered (bus, GST_MESSAGE_ERROR) != NULL);
+    cleanup_coloreffects (coloreffects);
+  }
+
+  g_free (in);
+  g_free (out);
+}
+
+/* checks that @table is rejected with an error containing @reason */
+static void
+check_error (const gchar * table, const gchar * reason)
+{
+  GstElement *coloreffects;
+  GstMessage *msg;
+  GError *err = NULL;
+  gchar *debug = NULL;
+  guint8 *in;
+
+  in = g_malloc (FRAME_SIZE);
+  coloreffects = setup_coloreffects (table, 1);
+
+  fail_unless_equals_int (push_frame (in), GST_FLOW_ERROR);
+  fail_unless_equals_int (g_list_length (buffers), 0);
+
+  msg = gst_bus_pop_filtered (bus, GST_MESSAGE_ERROR);
+  fail_unless (msg != NULL);
+  gst_message_parse_error (msg, &err, &debug);
+  fail_unless (g_error_matches (err, GST_RESOURCE_ERROR,
+          GST_RESOURCE_ERROR_OPEN_READ));
+  fail_unless (debug != NULL && strstr (debug, reason) != NULL,
+      "\"%s\" does not contain \"%s\"", debug, reason);
+
+  g_error_free (err);
+  g_free (debug);
+  gst_message_unref (msg);
+
+  cleanup_coloreffects (coloreffects);
+  g_free (in);
+}
+
+/* the identity table gives back the input pixels */
+GST_START_TEST (test_identity)
+{
+  static const gint map[3] = { 0, 1, 2 };
+  gchar *table;
+
+  table = make_table ("LUT_3D_SIZE 16\n", map,
+      LUT_SIZE * LUT_SIZE * LUT_SIZE, "\n");
+  check_table (table, map);
+  g_free (table);
+}
+
+GST_END_TEST;
+
+/* a table with comments, keywords, the default domain and Windows line
+ * endings that swaps red and blue */
+GST_START_TEST (test_valid)
+{
+  static const gint map[3] = { 2, 1, 0 };
+  gchar *table;
+
+  table = make_table ("# swaps red and blue\r\n"
+      "TITLE \"swap\"\r\n"
+      "\r\n"
+      "LUT_3D_SIZE 16\r\n"
+      "DOMAIN_MIN 0.0 0.0 0.0\r\n"
+      "DOMAIN_MAX 1.0 1.0 1.0\r\n", map, LUT_SIZE * LUT_SIZE * LUT_SIZE,
+      "\r\n");
+  check_table (table, map);
+  g_free (table);
+}
+
+GST_END_TEST;
+
+/* lines that are not keywords must have three numbers */
+GST_START_TEST (test_malformed)
+{
+  check_error ("LUT_3D_SIZE 2\n"
+      "0.0 0.0 0.0\n" "1.0 0.0\n", "could not parse \"1.0 0.0\"");
+  check_error ("LUT_3D_SIZE 2\n"
+      "0.0 0.0 0.0 0.0\n", "could not parse \"0.0 0.0 0.0 0.0\"");
+  check_error ("0.0 0.0 0.0\n" "LUT_3D_SIZE 2\n", "could not parse");
+  check_error ("LUT_3D_SIZE 2\n" "DOMAIN_MIN 0.0\n", "could not parse");
+  check_error ("LUT_3D_SIZE 2\n" "LUT_3D_INPUT_RANGE 1.0 1.0\n"
+      "0 0 0\n1 0 0\n0 1 0\n1 1 0\n0 0 1\n1 0 1\n0 1 1\n1 1 1\n",
+      "Empty input domain");
+  check_error ("LUT_1D_SIZE 2\n" "0 0 0\n1 1 1\n", "1D tables");
+  check_error ("TITLE \"empty\"\n", "No LUT_3D_SIZE");
+}
+
+GST_END_TEST;
+
+/* the number of entries must match LUT_3D_SIZE, which must be in the
+ * supported range */
+GST_START_TEST (test_wrong_size)
+{
+  static const gint map[3] = { 0, 1, 2 };
+  gchar *table;
+
+  table = make_table ("LUT_3D_SIZE 16\n", map,
+      LUT_SIZE * LUT_SIZE * LUT_SIZE - 1, "\n");
+  check_error (table, "Expected 4096 table entries but got 4095");
+  g_free (table);
+
+  table = make_table ("LUT_3D_SIZE 15\n", map,
+      LUT_SIZE * LUT_SIZE * LUT_SIZE, "\n");
+  check_error (table, "could not parse");
+  g_free (table);
+
+  check_error ("LUT_3D_SIZE 1\n" "0 0 0\n", "unsupported LUT_3D_SIZE 1");
+  check_error ("LUT_3D_SIZE 66\n", "unsupported LUT_3D_SIZE 66");
+  check_error ("LUT_3D_SIZE 2\n" "LUT_3D_SIZE 2\n", "given twice");
+}
+
+GST_END_TEST;
+
+static Suite *
+coloreffects_suite (void)
+{
+  Suite *s = suite_create ("coloreffects");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_identity);
+  tcase_add_test (tc_chain, test_valid);
+  tcase_add_test (tc_chain, test_malformed);
+  tcase_add_test (tc_chain, test_wrong_size);
+
+  return s;
+}
+
+GST_CHECK_MAIN (coloreffects);
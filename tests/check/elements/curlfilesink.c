@@ -334,6 +334,96 @@ GST_START_TEST (test_two_files)
 
 GST_END_TEST;
 
+GST_START_TEST (test_queued_big_file)
+{
+  GstElement *sink;
+  GstCaps *caps;
+  GstStructure *stats;
+  const gchar *location = "file:///tmp/";
+  gchar *file_name = g_strdup_printf ("curlfilesink_%d", g_random_int ());
+  const gchar *file_line1 = "line 1\r\n";
+  const gchar *file_line2 = "line 2\r\n";
+  const gchar *file_line3 = "line 3\r\n";
+  const gchar *expected_file_content = "line 1\r\n" "line 2\r\n" "line 3\r\n";
+  guint64 bytes_sent = 0;
+
+  sink = setup_curlfilesink ();
+
+  /* use a queue smaller than a buffer so that the transfer thread has to
+   * read across buffer boundaries and render has to wait for space */
+  g_object_set (G_OBJECT (sink), "location", location, NULL);
+  g_object_set (G_OBJECT (sink), "file-name", file_name, NULL);
+  g_object_set (G_OBJECT (sink), "max-queue-bytes", 5, NULL);
+
+  /* start playing */
+  ASSERT_SET_STATE (sink, GST_STATE_PLAYING, GST_STATE_CHANGE_ASYNC);
+  caps = gst_caps_from_string ("application/x-gst-check");
+  gst_check_setup_events (srcpad, sink, caps, GST_FORMAT_BYTES);
+
+  test_set_and_play_buffer (file_line1);
+  test_set_and_play_buffer (file_line2);
+  test_set_and_play_buffer (file_line3);
+
+  /* eos drains the queue */
+  fail_unless (gst_pad_push_event (srcpad, gst_event_new_eos ()));
+
+  g_object_get (sink, "stats", &stats, NULL);
+  fail_unless (stats != NULL);
+  fail_unless (gst_structure_get_uint64 (stats, "bytes-sent", &bytes_sent));
+  fail_unless_equals_uint64 (bytes_sent, strlen (expected_file_content));
+  gst_structure_free (stats);
+
+  ASSERT_SET_STATE (sink, GST_STATE_NULL, GST_STATE_CHANGE_SUCCESS);
+
+  gst_caps_unref (caps);
+  cleanup_curlfilesink (sink);
+
+  /* verify file content */
+  test_verify_file_data ("/tmp", file_name, expected_file_content);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_queued_two_files)
+{
+  GstElement *sink;
+  GstCaps *caps;
+  const gchar *location = "file:///tmp/";
+  gchar *file_name1 = g_strdup_printf ("curlfilesink_%d", g_random_int ());
+  gchar *file_name2 = g_strdup_printf ("curlfilesink_%d", g_random_int ());
+  const gchar *file_content1 = "file content 1\r\n";
+  const gchar *file_content2 = "file content 2\r\n";
+
+  sink = setup_curlfilesink ();
+
+  g_object_set (G_OBJECT (sink), "location", location, NULL);
+  g_object_set (G_OBJECT (sink), "file-name", file_name1, NULL);
+  g_object_set (G_OBJECT (sink), "max-queue-bytes", 1024, NULL);
+
+  /* start playing */
+  ASSERT_SET_STATE (sink, GST_STATE_PLAYING, GST_STATE_CHANGE_ASYNC);
+  caps = gst_caps_from_string ("application/x-gst-check");
+  gst_check_setup_events (srcpad, sink, caps, GST_FORMAT_BYTES);
+
+  /* queued data has to end up in the first file even though render
+   * returns before it has been sent */
+  test_set_and_play_buffer (file_content1);
+  g_object_set (G_OBJECT (sink), "file-name", file_name2, NULL);
+  test_set_and_play_buffer (file_content2);
+
+  /* eos */
+  fail_unless (gst_pad_push_event (srcpad, gst_event_new_eos ()));
+  ASSERT_SET_STATE (sink, GST_STATE_NULL, GST_STATE_CHANGE_SUCCESS);
+
+  gst_caps_unref (caps);
+  cleanup_curlfilesink (sink);
+
+  test_verify_file_data ("/tmp", file_name1, file_content1);
+  test_verify_file_data ("/tmp", file_name2, file_content2);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_create_dirs)
 {
   GstElement *sink;
@@ -448,6 +538,8 @@ curlsink_suite (void)
   tcase_add_test (tc_chain, test_two_files);
   tcase_add_test (tc_chain, test_missing_path);
   tcase_add_test (tc_chain, test_create_dirs);
+  tcase_add_test (tc_chain, test_queued_big_file);
+  tcase_add_test (tc_chain, test_queued_two_files);
 
   return s;
 }
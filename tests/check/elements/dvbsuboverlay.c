@@ -0,0 +1,306 @@
+/* GStreamer
+ *
+ * unit test for dvbsuboverlay
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <gst/video/video.h>
+#include <gst/video/video-overlay-composition.h>
+
+#define VIDEO_CAPS_STRING "video/x-raw, format = (string) I420, " \
+    "width = (int) 720, height = (int) 576, framerate = (fraction) 25/1"
+
+/* two regions of 8x2 pixels, each showing one object */
+#define REGION_WIDTH 8
+#define REGION_HEIGHT 2
+#define REGION_1_Y 400
+#define REGION_2_Y 450
+
+static GstPad *myvideosrcpad, *mytextsrcpad, *mysinkpad;
+
+static GstStaticPadTemplate sinktemplate = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("video/x-raw"));
+
+static GstStaticPadTemplate videosrctemplate = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("video/x-raw"));
+
+static GstStaticPadTemplate textsrctemplate = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("subpicture/x-dvb"));
+
+/* announce support for the composition meta, so that the overlay attaches
+ * its rectangles to the buffers instead of blending them */
+static gboolean
+sink_query (GstPad * pad, GstObject * parent, GstQuery * query)
+{
+  if (GST_QUERY_TYPE (query) == GST_QUERY_ALLOCATION) {
+    gst_query_add_allocation_meta (query,
+        GST_VIDEO_OVERLAY_COMPOSITION_META_API_TYPE, NULL);
+    return TRUE;
+  }
+
+  return gst_pad_query_default (pad, parent, query);
+}
+
+static GstElement *
+setup_dvbsuboverlay (void)
+{
+  GstElement *overlay;
+  GstCaps *caps;
+
+  overlay = gst_check_setup_element ("dvbsuboverlay");
+  myvideosrcpad = gst_check_setup_src_pad_by_name (overlay,
+      &videosrctemplate, "video_sink");
+  mytextsrcpad = gst_check_setup_src_pad_by_name (overlay,
+      &textsrctemplate, "text_sink");
+  mysinkpad = gst_check_setup_sink_pad (overlay, &sinktemplate);
+  gst_pad_set_query_function (mysinkpad, sink_query);
+
+  gst_pad_set_active (myvideosrcpad, TRUE);
+  gst_pad_set_active (mytextsrcpad, TRUE);
+  gst_pad_set_active (mysinkpad, TRUE);
+
+  fail_unless (gst_element_set_state (overlay,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+
+  caps = gst_caps_from_string (VIDEO_CAPS_STRING);
+  gst_check_setup_events (myvideosrcpad, overlay, caps, GST_FORMAT_TIME);
+  gst_caps_unref (caps);
+
+  caps = gst_caps_from_string ("subpicture/x-dvb");
+  gst_check_setup_events (mytextsrcpad, overlay, caps, GST_FORMAT_TIME);
+  gst_caps_unref (caps);
+
+  return overlay;
+}
+
+static void
+cleanup_dvbsuboverlay (GstElement * overlay)
+{
+  gst_element_set_state (overlay, GST_STATE_NULL);
+
+  gst_check_drop_buffers ();
+  gst_pad_set_active (myvideosrcpad, FALSE);
+  gst_pad_set_active (mytextsrcpad, FALSE);
+  gst_pad_set_active (mysinkpad, FALSE);
+  gst_check_teardown_pad_by_name (overlay, "video_sink");
+  gst_check_teardown_pad_by_name (overlay, "text_sink");
+  gst_check_teardown_sink_pad (overlay);
+  gst_check_teardown_element (overlay);
+}
+
+static void
+add_segment (GByteArray * pes, guint8 type, const guint8 * data, guint16 len)
+{
+  guint8 header[6];
+
+  header[0] = 0x0f;
+  header[1] = type;
+  GST_WRITE_UINT16_BE (header + 2, 1);
+  GST_WRITE_UINT16_BE (header + 4, len);
+  g_byte_array_append (pes, header, sizeof (header));
+  g_byte_array_append (pes, data, len);
+}
+
+static void
+add_region (GByteArray * pes, guint8 region_id, guint16 object_id,
+    gboolean fill)
+{
+  guint8 region[16] = { 0, };
+
+  region[0] = region_id;
+  region[1] = fill ? 0x08 : 0x00;
+  GST_WRITE_UINT16_BE (region + 2, REGION_WIDTH);
+  GST_WRITE_UINT16_BE (region + 4, REGION_HEIGHT);
+  /* 4 bit depth, CLUT 0 */
+  region[6] = 0x08;
+  region[7] = 0;
+  /* one basic object at 0,0 */
+  GST_WRITE_UINT16_BE (region + 10, object_id);
+  add_segment (pes, 0x11, region, sizeof (region));
+}
+
+static void
+add_object (GByteArray * pes, guint16 object_id, guint8 color)
+{
+  guint8 object[14];
+  guint8 nibbles = (color << 4) | color;
+
+  GST_WRITE_UINT16_BE (object, object_id);
+  /* pixel coding, no bottom field so that the top field is used for both */
+  object[2] = 0;
+  GST_WRITE_UINT16_BE (object + 3, 7);
+  GST_WRITE_UINT16_BE (object + 5, 0);
+  /* a 4 bit pixel string of 8 pixels, its end, and the end of the line */
+  object[7] = 0x11;
+  object[8] = object[9] = object[10] = object[11] = nibbles;
+  object[12] = 0x00;
+  object[13] = 0xf0;
+  add_segment (pes, 0x13, object, sizeof (object));
+}
+
+/* Pushes a display set with both regions. Only the objects with a non-zero
+ * color are drawn again, and the luma of entry 1 of the CLUT is @y */
+static void
+push_page (GstClockTime pts, gboolean fill, guint8 color1, guint8 color2,
+    guint8 y)
+{
+  static const guint8 eds[1] = { 0, };
+  GByteArray *pes;
+  GstBuffer *buffer;
+  guint8 page[14] = { 0, };
+  guint8 clut[8] = { 0, };
+
+  pes = g_byte_array_new ();
+  g_byte_array_append (pes, (const guint8 *) "\x20\x00", 2);
+
+  /* 5 seconds timeout, acquisition point */
+  page[0] = 5;
+  page[1] = 1 << 2;
+  page[2] = 1;
+  GST_WRITE_UINT16_BE (page + 4, 0);
+  GST_WRITE_UINT16_BE (page + 6, REGION_1_Y);
+  page[8] = 2;
+  GST_WRITE_UINT16_BE (page + 10, 0);
+  GST_WRITE_UINT16_BE (page + 12, REGION_2_Y);
+  add_segment (pes, 0x10, page, sizeof (page));
+
+  add_region (pes, 1, 1, fill);
+  add_region (pes, 2, 2, fill);
+
+  /* CLUT 0, full range 16 colour entry 1 */
+  clut[2] = 1;
+  clut[3] = 0x41;
+  clut[4] = y;
+  clut[5] = 128;
+  clut[6] = 128;
+  add_segment (pes, 0x12, clut, sizeof (clut));
+
+  if (color1)
+    add_object (pes, 1, color1);
+  if (color2)
+    add_object (pes, 2, color2);
+
+  add_segment (pes, 0x80, eds, 0);
+  g_byte_array_append (pes, (const guint8 *) "\xff", 1);
+
+  buffer = gst_buffer_new_wrapped (pes->data, pes->len);
+  g_byte_array_free (pes, FALSE);
+  GST_BUFFER_TIMESTAMP (buffer) = pts;
+
+  fail_unless_equals_int (gst_pad_push (mytextsrcpad, buffer), GST_FLOW_OK);
+}
+
+/* pushes a video frame at @pts and returns the rectangles of the regions
+ * attached to it, the frame stays in the buffers list */
+static void
+push_frame (GstClockTime pts, GstVideoOverlayRectangle ** rect1,
+    GstVideoOverlayRectangle ** rect2)
+{
+  GstVideoOverlayCompositionMeta *meta;
+  GstBuffer *buffer;
+  guint i, n;
+
+  buffer = gst_buffer_new_and_alloc (720 * 576 * 3 / 2);
+  gst_buffer_memset (buffer, 0, 0, 720 * 576 * 3 / 2);
+  GST_BUFFER_TIMESTAMP (buffer) = pts;
+  GST_BUFFER_DURATION (buffer) = GST_SECOND / 25;
+
+  fail_unless_equals_int (gst_pad_push (myvideosrcpad, buffer), GST_FLOW_OK);
+
+  buffer = g_list_last (buffers)->data;
+  meta = gst_buffer_get_video_overlay_composition_meta (buffer);
+  fail_unless (meta != NULL);
+
+  n = gst_video_overlay_composition_n_rectangles (meta->overlay);
+  fail_unless_equals_int (n, 2);
+
+  *rect1 = *rect2 = NULL;
+  for (i = 0; i < n; i++) {
+    GstVideoOverlayRectangle *rect;
+    gint x, y;
+    guint w, h;
+
+    rect = gst_video_overlay_composition_get_rectangle (meta->overlay, i);
+    gst_video_overlay_rectangle_get_render_rectangle (rect, &x, &y, &w, &h);
+    fail_unless_equals_int (w, REGION_WIDTH);
+    fail_unless_equals_int (h, REGION_HEIGHT);
+    if (y == REGION_1_Y)
+      *rect1 = rect;
+    else if (y == REGION_2_Y)
+      *rect2 = rect;
+  }
+  fail_unless (*rect1 != NULL && *rect2 != NULL);
+}
+
+/* regions that did not change between pages keep their converted rectangle,
+ * redrawn regions and a changed CLUT get new ones */
+GST_START_TEST (test_region_reuse)
+{
+  GstElement *overlay;
+  GstVideoOverlayRectangle *first1, *first2, *rect1, *rect2;
+
+  overlay = setup_dvbsuboverlay ();
+
+  push_page (0, TRUE, 1, 1, 235);
+  push_frame (0, &first1, &first2);
+  fail_if (first1 == first2);
+
+  /* everything sent again, but nothing drawn */
+  push_page (1 * GST_SECOND, FALSE, 0, 0, 235);
+  push_frame (1 * GST_SECOND, &rect1, &rect2);
+  fail_unless (rect1 == first1);
+  fail_unless (rect2 == first2);
+
+  /* only the object of the second region is drawn again */
+  push_page (2 * GST_SECOND, FALSE, 0, 1, 235);
+  push_frame (2 * GST_SECOND, &rect1, &rect2);
+  fail_unless (rect1 == first1);
+  fail_if (rect2 == first2);
+  first2 = rect2;
+
+  /* the CLUT both regions use changes */
+  push_page (3 * GST_SECOND, FALSE, 0, 0, 128);
+  push_frame (3 * GST_SECOND, &rect1, &rect2);
+  fail_if (rect1 == first1);
+  fail_if (rect2 == first2);
+
+  cleanup_dvbsuboverlay (overlay);
+}
+
+GST_END_TEST;
+
+static Suite *
+dvbsuboverlay_suite (void)
+{
+  Suite *s = suite_create ("dvbsuboverlay");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_region_reuse);
+
+  return s;
+}
+
+GST_CHECK_MAIN (dvbsuboverlay);
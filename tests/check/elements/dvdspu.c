@@ -0,0 +1,588 @@
+/* GStreamer
+ *
+ * unit test for dvdspu
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "../../gst/dvdspu/gstdvdspu.c"
+#include "../../gst/dvdspu/gstdvdspu-render.c"
+#include "../../gst/dvdspu/gstspu-vobsub.c"
+#include "../../gst/dvdspu/gstspu-vobsub-render.c"
+#include "../../gst/dvdspu/gstspu-pgs.c"
+#undef GST_CAT_DEFAULT
+
+#include <gst/check/gstcheck.h>
+#include <string.h>
+
+#define FRAME_DURATION (40 * GST_MSECOND)
+
+static GstStaticPadTemplate sinktemplate = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("video/x-raw"));
+
+static GstStaticPadTemplate videosrctemplate = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("video/x-raw"));
+
+static GstStaticPadTemplate subpicsrctemplate = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("subpicture/x-dvd; subpicture/x-pgs"));
+
+/* One dvdspu with the pads feeding it. The test runs two of them on the same
+ * input, one of them has its render cache invalidated before every frame,
+ * so it decodes the subpicture again each time like before the cache. */
+typedef struct
+{
+  GstElement *spu;
+  GstPad *video, *subpic, *sink;
+} SpuSetup;
+
+static GstCaps *
+make_video_caps (gint width, gint height)
+{
+  return gst_caps_new_simple ("video/x-raw",
+      "format", G_TYPE_STRING, "I420",
+      "width", G_TYPE_INT, width, "height", G_TYPE_INT, height,
+      "framerate", GST_TYPE_FRACTION, 25, 1, NULL);
+}
+
+static void
+setup_spu (SpuSetup * setup, const gchar * subpic_caps, gint width,
+    gint height)
+{
+  GstCaps *caps;
+
+  setup->spu = gst_check_setup_element ("dvdspu");
+  fail_unless (GST_IS_DVD_SPU (setup->spu));
+  setup->video = gst_check_setup_src_pad_by_name (setup->spu,
+      &videosrctemplate, "video");
+  setup->subpic = gst_check_setup_src_pad_by_name (setup->spu,
+      &subpicsrctemplate, "subpicture");
+  setup->sink = gst_check_setup_sink_pad (setup->spu, &sinktemplate);
+
+  gst_pad_set_active (setup->video, TRUE);
+  gst_pad_set_active (setup->subpic, TRUE);
+  gst_pad_set_active (setup->sink, TRUE);
+
+  fail_unless (gst_element_set_state (setup->spu,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+
+  caps = make_video_caps (width, height);
+  gst_check_setup_events (setup->video, setup->spu, caps, GST_FORMAT_TIME);
+  gst_caps_unref (caps);
+
+  caps = gst_caps_from_string (subpic_caps);
+  gst_check_setup_events (setup->subpic, setup->spu, caps, GST_FORMAT_TIME);
+  gst_caps_unref (caps);
+}
+
+static void
+cleanup_spu (SpuSetup * setup)
+{
+  gst_element_set_state (setup->spu, GST_STATE_NULL);
+
+  gst_check_drop_buffers ();
+  gst_pad_set_active (setup->video, FALSE);
+  gst_pad_set_active (setup->subpic, FALSE);
+  gst_pad_set_active (setup->sink, FALSE);
+  gst_check_teardown_pad_by_name (setup->spu, "video");
+  gst_check_teardown_pad_by_name (setup->spu, "subpicture");
+  gst_check_teardown_sink_pad (setup->spu);
+  gst_check_teardown_element (setup->spu);
+}
+
+static gboolean
+cache_valid (SpuSetup * setup)
+{
+  GstDVDSpu *dvdspu = GST_DVD_SPU (setup->spu);
+  gboolean valid;
+
+  DVD_SPU_LOCK (dvdspu);
+  valid = dvdspu->spu_state.cache_valid;
+  DVD_SPU_UNLOCK (dvdspu);
+
+  return valid;
+}
+
+static void
+push_subpic (SpuSetup * setups, const guint8 * data, gsize size,
+    GstClockTime ts)
+{
+  gint i;
+
+  for (i = 0; i < 2; i++) {
+    GstBuffer *buffer = gst_buffer_new_allocate (NULL, size, NULL);
+
+    gst_buffer_fill (buffer, 0, data, size);
+    GST_BUFFER_TIMESTAMP (buffer) = ts;
+    fail_unless_equals_int (gst_pad_push (setups[i].subpic, buffer),
+        GST_FLOW_OK);
+  }
+}
+
+static void
+push_dvd_event (SpuSetup * setups, GstStructure * s)
+{
+  gint i;
+
+  for (i = 0; i < 2; i++)
+    fail_unless (gst_pad_push_event (setups[i].subpic,
+            gst_event_new_custom (GST_EVENT_CUSTOM_DOWNSTREAM_OOB,
+                gst_structure_copy (s))));
+  gst_structure_free (s);
+}
+
+/* flushes the subpicture pads and starts a new segment on them */
+static void
+flush_subpic (SpuSetup * setups)
+{
+  GstSegment segment;
+  gint i;
+
+  gst_segment_init (&segment, GST_FORMAT_TIME);
+  for (i = 0; i < 2; i++) {
+    fail_unless (gst_pad_push_event (setups[i].subpic,
+            gst_event_new_flush_start ()));
+    fail_unless (gst_pad_push_event (setups[i].subpic,
+            gst_event_new_flush_stop (TRUE)));
+    fail_unless (gst_pad_push_event (setups[i].subpic,
+            gst_event_new_segment (&segment)));
+  }
+}
+
+static void
+set_video_caps (SpuSetup * setups, gint width, gint height)
+{
+  GstCaps *caps = make_video_caps (width, height);
+  gint i;
+
+  for (i = 0; i < 2; i++)
+    fail_unless (gst_pad_push_event (setups[i].video,
+            gst_event_new_caps (caps)));
+  gst_caps_unref (caps);
+}
+
+/* Pushes frame @n to both elements and checks that the cached rendering is
+ * the same as the uncached one, and that the subpicture was drawn if
+ * @drawn is set */
+static void
+push_frame (SpuSetup * setups, guint n, gint width, gint height,
+    gboolean drawn)
+{
+  GstDVDSpu *uncached = GST_DVD_SPU (setups[1].spu);
+  GstVideoInfo info;
+  GstBuffer *in, *out, *ref_out;
+  GstMapInfo map, out_map, ref_map;
+  GstCaps *caps;
+  gsize i;
+
+  caps = make_video_caps (width, height);
+  fail_unless (gst_video_info_from_caps (&info, caps));
+  gst_caps_unref (caps);
+
+  in = gst_buffer_new_allocate (NULL, info.size, NULL);
+  gst_buffer_map (in, &map, GST_MAP_WRITE);
+  for (i = 0; i < map.size; i++)
+    map.data[i] = (i * 7 + n * 13) & 0xff;
+  gst_buffer_unmap (in, &map);
+  GST_BUFFER_TIMESTAMP (in) = n * FRAME_DURATION;
+  GST_BUFFER_DURATION (in) = FRAME_DURATION;
+
+  fail_unless_equals_int (gst_pad_push (setups[0].video, gst_buffer_ref (in)),
+      GST_FLOW_OK);
+
+  DVD_SPU_LOCK (uncached);
+  gstspu_cache_invalidate (&uncached->spu_state);
+  DVD_SPU_UNLOCK (uncached);
+  fail_unless_equals_int (gst_pad_push (setups[1].video, gst_buffer_ref (in)),
+      GST_FLOW_OK);
+
+  fail_unless_equals_int (g_list_length (buffers), 2);
+  out = buffers->data;
+  ref_out = buffers->next->data;
+
+  gst_buffer_map (in, &map, GST_MAP_READ);
+  gst_buffer_map (out, &out_map, GST_MAP_READ);
+  gst_buffer_map (ref_out, &ref_map, GST_MAP_READ);
+  fail_unless_equals_int (out_map.size, info.size);
+  fail_unless_equals_int (ref_map.size, info.size);
+  fail_unless (memcmp (out_map.data, ref_map.data, info.size) == 0,
+      "frame %u differs from the uncached rendering", n);
+  if (drawn)
+    fail_if (memcmp (out_map.data, map.data, info.size) == 0,
+        "nothing drawn on frame %u", n);
+  else
+    fail_unless (memcmp (out_map.data, map.data, info.size) == 0,
+        "something drawn on frame %u", n);
+  gst_buffer_unmap (in, &map);
+  gst_buffer_unmap (out, &out_map);
+  gst_buffer_unmap (ref_out, &ref_map);
+
+  gst_check_drop_buffers ();
+  gst_buffer_unref (in);
+}
+
+/* VobSub */
+
+#define SPU_LEFT 8
+#define SPU_RIGHT 39
+#define SPU_TOP 10
+#define SPU_BOTTOM 25
+
+typedef struct
+{
+  GByteArray *data;
+  gboolean half;
+} NibbleWriter;
+
+static void
+put_nibble (NibbleWriter * w, guint8 nibble)
+{
+  if (!w->half) {
+    guint8 byte = nibble << 4;
+
+    g_byte_array_append (w->data, &byte, 1);
+  } else {
+    w->data->data[w->data->len - 1] |= nibble;
+  }
+  w->half = !w->half;
+}
+
+/* writes a run of @len pixels, 0 runs to the end of the line */
+static void
+put_run (NibbleWriter * w, guint len, guint colour)
+{
+  guint code = (len << 2) | colour;
+  gint n_nibbles;
+
+  if (len == 0 || len >= 64)
+    n_nibbles = 4;
+  else if (len >= 16)
+    n_nibbles = 3;
+  else if (len >= 4)
+    n_nibbles = 2;
+  else
+    n_nibbles = 1;
+
+  while (n_nibbles--)
+    put_nibble (w, (code >> (4 * n_nibbles)) & 0xf);
+}
+
+/* the runs of each line start at a different x and use all four colours, the
+ * last one fills the line */
+static void
+put_vobsub_line (NibbleWriter * w, gint line)
+{
+  put_run (w, 1 + line % 5, 0);
+  put_run (w, 5, 1);
+  put_run (w, 2 + line % 3, 2);
+  put_run (w, 7, 3);
+  put_run (w, 3, 1);
+  put_run (w, 0, 2);
+  /* lines start byte aligned */
+  w->half = FALSE;
+}
+
+/* Builds a SPU with two command blocks. The first one shows the subpicture
+ * at once, the second one changes the contrast ~100ms later. */
+static GByteArray *
+make_vobsub_spu (void)
+{
+  NibbleWriter w = { NULL, FALSE };
+  guint16 top, bottom, dcsq1, dcsq2;
+  gint line;
+  guint8 *d;
+
+  w.data = g_byte_array_new ();
+  g_byte_array_set_size (w.data, 4);
+
+  top = w.data->len;
+  for (line = 0; line <= SPU_BOTTOM - SPU_TOP; line += 2)
+    put_vobsub_line (&w, line);
+  bottom = w.data->len;
+  for (line = 1; line <= SPU_BOTTOM - SPU_TOP; line += 2)
+    put_vobsub_line (&w, line);
+
+  dcsq1 = w.data->len;
+  dcsq2 = dcsq1 + 24;
+  g_byte_array_set_size (w.data, dcsq2 + 8);
+  d = w.data->data + dcsq1;
+
+  GST_WRITE_UINT16_BE (d, 0);
+  GST_WRITE_UINT16_BE (d + 2, dcsq2);
+  /* palette entries 0 to 3 */
+  d[4] = SPU_CMD_SET_COLOR;
+  d[5] = 0x32;
+  d[6] = 0x10;
+  /* transparent background */
+  d[7] = SPU_CMD_SET_ALPHA;
+  d[8] = 0x48;
+  d[9] = 0xf0;
+  d[10] = SPU_CMD_SET_DAREA;
+  d[11] = SPU_LEFT >> 4;
+  d[12] = ((SPU_LEFT & 0xf) << 4) | (SPU_RIGHT >> 8);
+  d[13] = SPU_RIGHT & 0xff;
+  d[14] = SPU_TOP >> 4;
+  d[15] = ((SPU_TOP & 0xf) << 4) | (SPU_BOTTOM >> 8);
+  d[16] = SPU_BOTTOM & 0xff;
+  d[17] = SPU_CMD_DSPXA;
+  GST_WRITE_UINT16_BE (d + 18, top);
+  GST_WRITE_UINT16_BE (d + 20, bottom);
+  d[22] = SPU_CMD_DSP;
+  d[23] = SPU_CMD_END;
+
+  d = w.data->data + dcsq2;
+  GST_WRITE_UINT16_BE (d, 9);
+  GST_WRITE_UINT16_BE (d + 2, dcsq2);
+  d[4] = SPU_CMD_SET_ALPHA;
+  d[5] = 0x8f;
+  d[6] = 0xc3;
+  d[7] = SPU_CMD_END;
+
+  GST_WRITE_UINT16_BE (w.data->data, w.data->len);
+  GST_WRITE_UINT16_BE (w.data->data + 2, dcsq1);
+
+  return w.data;
+}
+
+GST_START_TEST (test_vobsub_cache)
+{
+  SpuSetup setups[2];
+  GByteArray *spu;
+  guint n = 0;
+  gint i;
+
+  for (i = 0; i < 2; i++)
+    setup_spu (&setups[i], "subpicture/x-dvd", 64, 48);
+
+  spu = make_vobsub_spu ();
+  push_subpic (setups, spu->data, spu->len, 0);
+
+  /* the first command block, then the second one at 102.4ms */
+  for (; n < 5; n++) {
+    if (n > 0 && n != 3)
+      fail_unless (cache_valid (&setups[0]));
+    push_frame (setups, n, 64, 48, TRUE);
+  }
+
+  /* a new CLUT */
+  push_dvd_event (setups, gst_structure_new ("application/x-gst-dvd",
+          "event", G_TYPE_STRING, "dvd-spu-clut-change",
+          "clut00", G_TYPE_INT, 0x00108080, "clut01", G_TYPE_INT, 0x00d05a28,
+          "clut02", G_TYPE_INT, 0x0040c0a0, "clut03", G_TYPE_INT, 0x00806020,
+          NULL));
+  fail_if (cache_valid (&setups[0]));
+  for (; n < 7; n++)
+    push_frame (setups, n, 64, 48, TRUE);
+
+  /* a highlight over part of the subpicture */
+  push_dvd_event (setups, gst_structure_new ("application/x-gst-dvd",
+          "event", G_TYPE_STRING, "dvd-spu-highlight",
+          "palette", G_TYPE_INT, 0x21308ff4, "sx", G_TYPE_INT, 16,
+          "sy", G_TYPE_INT, 12, "ex", G_TYPE_INT, 27, "ey", G_TYPE_INT, 19,
+          NULL));
+  fail_if (cache_valid (&setups[0]));
+  for (; n < 9; n++)
+    push_frame (setups, n, 64, 48, TRUE);
+
+  /* a flush drops the subpicture until it is sent again */
+  flush_subpic (setups);
+  fail_if (cache_valid (&setups[0]));
+  push_frame (setups, n++, 64, 48, FALSE);
+  push_subpic (setups, spu->data, spu->len, n * FRAME_DURATION);
+  for (; n < 14; n++)
+    push_frame (setups, n, 64, 48, TRUE);
+
+  /* a smaller frame, which clips the subpicture */
+  set_video_caps (setups, 32, 24);
+  fail_if (cache_valid (&setups[0]));
+  for (; n < 16; n++)
+    push_frame (setups, n, 32, 24, TRUE);
+
+  g_byte_array_unref (spu);
+  for (i = 0; i < 2; i++)
+    cleanup_spu (&setups[i]);
+}
+
+GST_END_TEST;
+
+/* PGS */
+
+#define PGS_X 10
+#define PGS_Y 7
+#define PGS_WIDTH 30
+#define PGS_HEIGHT 12
+
+static void
+add_pgs_segment (GByteArray * pkt, guint8 type, const guint8 * data,
+    guint16 len)
+{
+  guint8 header[3];
+
+  header[0] = type;
+  GST_WRITE_UINT16_BE (header + 1, len);
+  g_byte_array_append (pkt, header, sizeof (header));
+  g_byte_array_append (pkt, data, len);
+}
+
+/* Builds a display set showing one object, starting on an odd line, with
+ * one of two palettes */
+static GByteArray *
+make_pgs_packet (gint version)
+{
+  static const guint8 palettes[2][3][4] = {
+    {{200, 100, 150, 255}, {50, 200, 60, 128}, {120, 128, 128, 64}},
+    {{30, 150, 90, 192}, {220, 60, 200, 255}, {90, 110, 140, 32}}
+  };
+  GByteArray *pkt, *rle;
+  guint8 pcs[19] = { 0, };
+  guint8 wds[10] = { 0, };
+  guint8 pds[2 + 3 * 5];
+  guint8 *ods;
+  gint i;
+
+  pkt = g_byte_array_new ();
+
+  GST_WRITE_UINT16_BE (pcs, 64);
+  GST_WRITE_UINT16_BE (pcs + 2, 48);
+  pcs[4] = 0x10;
+  GST_WRITE_UINT16_BE (pcs + 5, version);
+  pcs[7] = 0x80;
+  pcs[8] = PGS_PRES_SEGMENT_FLAG_UPDATE_PALETTE;
+  pcs[9] = 0;
+  pcs[10] = 1;
+  /* object 0 in window 0 */
+  GST_WRITE_UINT16_BE (pcs + 15, PGS_X);
+  GST_WRITE_UINT16_BE (pcs + 17, PGS_Y);
+  add_pgs_segment (pkt, PGS_COMMAND_PRESENTATION_SEGMENT, pcs, sizeof (pcs));
+
+  wds[0] = 1;
+  GST_WRITE_UINT16_BE (wds + 2, PGS_X);
+  GST_WRITE_UINT16_BE (wds + 4, PGS_Y);
+  GST_WRITE_UINT16_BE (wds + 6, PGS_WIDTH);
+  GST_WRITE_UINT16_BE (wds + 8, PGS_HEIGHT);
+  add_pgs_segment (pkt, PGS_COMMAND_SET_WINDOW, wds, sizeof (wds));
+
+  pds[0] = 0;
+  pds[1] = version;
+  for (i = 0; i < 3; i++) {
+    pds[2 + 5 * i] = i + 1;
+    memcpy (pds + 3 + 5 * i, palettes[version][i], 4);
+  }
+  add_pgs_segment (pkt, PGS_COMMAND_SET_PALETTE, pds, sizeof (pds));
+
+  rle = g_byte_array_new ();
+  g_byte_array_set_size (rle, 11);
+  for (i = 0; i < PGS_HEIGHT; i++) {
+    const guint8 line[] = {
+      /* transparent, then colour 1 */
+      0x00, 1 + i % 3, 0x00, 0x80 | (4 + i % 4), 1,
+      /* three single pixels of colour 2, six of colour 3 */
+      2, 2, 2, 0x00, 0x80 | 6, 3,
+      /* transparent in the long form, colour 1 and the end of the line */
+      0x00, 0x40, 0x03, 0x00, 0x80 | 5, 1, 0x00, 0x00
+    };
+
+    g_byte_array_append (rle, line, sizeof (line));
+  }
+
+  /* object 0, complete in this segment */
+  ods = rle->data;
+  memset (ods, 0, 11);
+  ods[3] = PGS_OBJECT_UPDATE_FLAG_START_RLE | PGS_OBJECT_UPDATE_FLAG_END_RLE;
+  GST_WRITE_UINT24_BE (ods + 4, rle->len - 7);
+  GST_WRITE_UINT16_BE (ods + 7, PGS_WIDTH);
+  GST_WRITE_UINT16_BE (ods + 9, PGS_HEIGHT);
+  add_pgs_segment (pkt, PGS_COMMAND_SET_OBJECT_DATA, rle->data, rle->len);
+  g_byte_array_unref (rle);
+
+  add_pgs_segment (pkt, PGS_COMMAND_END_DISPLAY, NULL, 0);
+
+  return pkt;
+}
+
+/* PGS ignores the DVD events, its subpicture only changes with a new
+ * display set */
+GST_START_TEST (test_pgs_cache)
+{
+  SpuSetup setups[2];
+  GByteArray *first, *second;
+  guint n = 0;
+  gint i;
+
+  for (i = 0; i < 2; i++)
+    setup_spu (&setups[i], "subpicture/x-pgs", 64, 48);
+
+  first = make_pgs_packet (0);
+  second = make_pgs_packet (1);
+  push_subpic (setups, first->data, first->len, 0);
+  push_subpic (setups, second->data, second->len, 100 * GST_MSECOND);
+
+  /* the first display set, then the second one from frame 3 on */
+  for (; n < 5; n++) {
+    if (n > 0 && n != 3)
+      fail_unless (cache_valid (&setups[0]));
+    push_frame (setups, n, 64, 48, TRUE);
+  }
+
+  /* a flush drops the subpicture until it is sent again */
+  flush_subpic (setups);
+  fail_if (cache_valid (&setups[0]));
+  push_frame (setups, n++, 64, 48, FALSE);
+  push_subpic (setups, first->data, first->len, n * FRAME_DURATION);
+  for (; n < 8; n++)
+    push_frame (setups, n, 64, 48, TRUE);
+
+  /* a smaller frame, which clips the object */
+  set_video_caps (setups, 32, 24);
+  fail_if (cache_valid (&setups[0]));
+  for (; n < 10; n++)
+    push_frame (setups, n, 32, 24, TRUE);
+
+  g_byte_array_unref (first);
+  g_byte_array_unref (second);
+  for (i = 0; i < 2; i++)
+    cleanup_spu (&setups[i]);
+}
+
+GST_END_TEST;
+
+static void
+dvdspu_init (void)
+{
+  gst_dvd_spu_plugin_init (NULL);
+}
+
+static Suite *
+dvdspu_suite (void)
+{
+  Suite *s = suite_create ("dvdspu");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_checked_fixture (tc_chain, dvdspu_init, NULL);
+  tcase_add_test (tc_chain, test_vobsub_cache);
+  tcase_add_test (tc_chain, test_pgs_cache);
+
+  return s;
+}
+
+GST_CHECK_MAIN (dvdspu);
@@ -0,0 +1,252 @@
+/* GStreamer
+ *
+ * unit test for fpsdisplaysink
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <gst/check/gsttestclock.h>
+
+#define HISTOGRAM_BINS 12
+
+/* the running time of the clock while the QoS events arrive */
+#define NOW (10 * GST_SECOND)
+
+static GstPad *video_sink_pad;
+static GstBus *bus;
+static GstClock *test_clock;
+
+typedef struct
+{
+  GstClockTimeDiff jitter;
+  GstClockTime latency;
+  gint jitter_bin;
+  gint latency_bin;
+} QosFrame;
+
+/* the bins are the number of bits of the time in ms, the last one takes
+ * everything from 1024 ms */
+static const QosFrame frames[] = {
+  {-2 * GST_MSECOND, 0, 2, 0},
+  {-500 * GST_USECOND, 3 * GST_MSECOND, 0, 2},
+  {20 * GST_MSECOND, 100 * GST_MSECOND, 5, 7},
+  {5 * GST_SECOND, 5 * GST_SECOND, 11, 11},
+  {0, GST_MSECOND, 0, 1},
+};
+
+static GstElement *
+setup_fpsdisplaysink (gboolean stats_only)
+{
+  GstElement *fpsdisplaysink, *fakesink;
+
+  fpsdisplaysink = gst_check_setup_element ("fpsdisplaysink");
+  fakesink = gst_element_factory_make ("fakesink", NULL);
+  fail_unless (fakesink != NULL);
+  g_object_set (fakesink, "async", FALSE, NULL);
+  g_object_set (fpsdisplaysink, "video-sink", fakesink, "sync", FALSE,
+      "text-overlay", FALSE, "silent", FALSE, "stats-only", stats_only,
+      "fps-update-interval", 1, NULL);
+  video_sink_pad = gst_element_get_static_pad (fakesink, "sink");
+
+  test_clock = gst_test_clock_new_with_start_time (NOW);
+  gst_element_set_clock (fpsdisplaysink, test_clock);
+  gst_element_set_base_time (fpsdisplaysink, 0);
+
+  bus = gst_bus_new ();
+  gst_element_set_bus (fpsdisplaysink, bus);
+
+  fail_unless (gst_element_set_state (fpsdisplaysink,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+
+  return fpsdisplaysink;
+}
+
+static void
+cleanup_fpsdisplaysink (GstElement * fpsdisplaysink)
+{
+  gst_element_set_state (fpsdisplaysink, GST_STATE_NULL);
+
+  gst_element_set_bus (fpsdisplaysink, NULL);
+  gst_object_unref (bus);
+  bus = NULL;
+  gst_object_unref (test_clock);
+  test_clock = NULL;
+  gst_object_unref (video_sink_pad);
+  video_sink_pad = NULL;
+
+  gst_check_teardown_element (fpsdisplaysink);
+}
+
+/* sends the QoS event of @frame upstream from the video sink, a bit later
+ * than the update interval after the previous one */
+static void
+send_qos (const QosFrame * frame)
+{
+  GstEvent *event;
+
+  g_usleep (2000);
+  event = gst_event_new_qos (GST_QOS_TYPE_UNDERFLOW, 1.0, frame->jitter,
+      NOW - frame->latency);
+  gst_pad_push_event (video_sink_pad, event);
+}
+
+static guint
+get_uint (const GstStructure * s, const gchar * field)
+{
+  guint value;
+
+  fail_unless (gst_structure_get_uint (s, field, &value), "no %s field",
+      field);
+
+  return value;
+}
+
+/* checks that @field has a bin for each entry of @expected */
+static void
+check_histogram (const GstStructure * s, const gchar * field,
+    const guint * expected)
+{
+  const GValue *array;
+  gint i;
+
+  array = gst_structure_get_value (s, field);
+  fail_unless (array != NULL, "no %s field", field);
+  fail_unless (GST_VALUE_HOLDS_ARRAY (array));
+  fail_unless_equals_int (gst_value_array_get_size (array), HISTOGRAM_BINS);
+
+  for (i = 0; i < HISTOGRAM_BINS; i++) {
+    const GValue *bin = gst_value_array_get_value (array, i);
+
+    fail_unless (G_VALUE_HOLDS_UINT (bin));
+    fail_unless_equals_int (g_value_get_uint (bin), expected[i]);
+  }
+}
+
+/* in stats-only mode every update posts the counters and the jitter and
+ * latency histograms of all the QoS events so far */
+GST_START_TEST (test_stats_message)
+{
+  GstElement *fpsdisplaysink;
+  guint jitter[HISTOGRAM_BINS] = { 0, }, latency[HISTOGRAM_BINS] = { 0, };
+  guint rendered = 0, dropped = 0;
+  gchar *last_message;
+  gint i;
+
+  fpsdisplaysink = setup_fpsdisplaysink (TRUE);
+
+  for (i = 0; i < G_N_ELEMENTS (frames); i++) {
+    const GstStructure *s;
+    GstMessage *msg;
+
+    send_qos (&frames[i]);
+    if (frames[i].jitter <= 0)
+      rendered++;
+    else
+      dropped++;
+    jitter[frames[i].jitter_bin]++;
+    latency[frames[i].latency_bin]++;
+
+    /* the first event only starts the measurement */
+    msg = gst_bus_pop_filtered (bus, GST_MESSAGE_ELEMENT);
+    if (i == 0) {
+      fail_unless (msg == NULL);
+      continue;
+    }
+    fail_unless (msg != NULL, "no message for frame %d", i);
+
+    s = gst_message_get_structure (msg);
+    fail_unless (gst_structure_has_name (s, "GstFPSDisplaySink"));
+    fail_unless_equals_int (get_uint (s, "frames-rendered"), rendered);
+    fail_unless_equals_int (get_uint (s, "frames-dropped"), dropped);
+    fail_unless (gst_structure_has_field_typed (s, "current-fps",
+            G_TYPE_DOUBLE));
+    fail_unless (gst_structure_has_field_typed (s, "drop-rate",
+            G_TYPE_DOUBLE));
+    fail_unless (gst_structure_has_field_typed (s, "average-fps",
+            G_TYPE_DOUBLE));
+    check_histogram (s, "jitter-histogram", jitter);
+    check_histogram (s, "latency-histogram", latency);
+    gst_message_unref (msg);
+  }
+
+  /* and nothing is formatted */
+  g_object_get (fpsdisplaysink, "last-message", &last_message, NULL);
+  fail_unless (last_message == NULL);
+
+  cleanup_fpsdisplaysink (fpsdisplaysink);
+}
+
+GST_END_TEST;
+
+/* stats-only only takes effect when starting, a running sink keeps
+ * formatting the last message */
+GST_START_TEST (test_stats_only_latched)
+{
+  GstElement *fpsdisplaysink;
+  GstMessage *msg;
+  gboolean stats_only;
+  gchar *last_message;
+
+  fpsdisplaysink = setup_fpsdisplaysink (FALSE);
+
+  g_object_set (fpsdisplaysink, "stats-only", TRUE, NULL);
+  g_object_get (fpsdisplaysink, "stats-only", &stats_only, NULL);
+  fail_unless (stats_only);
+
+  send_qos (&frames[0]);
+  send_qos (&frames[1]);
+  fail_if (gst_bus_pop_filtered (bus, GST_MESSAGE_ELEMENT) != NULL);
+
+  g_object_get (fpsdisplaysink, "last-message", &last_message, NULL);
+  fail_unless (last_message != NULL);
+  fail_unless (g_str_has_prefix (last_message, "rendered: 2, dropped: 0"),
+      "unexpected message \"%s\"", last_message);
+  g_free (last_message);
+
+  /* the next start picks it up */
+  gst_element_set_state (fpsdisplaysink, GST_STATE_NULL);
+  fail_unless (gst_element_set_state (fpsdisplaysink,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+  send_qos (&frames[0]);
+  send_qos (&frames[1]);
+  msg = gst_bus_pop_filtered (bus, GST_MESSAGE_ELEMENT);
+  fail_unless (msg != NULL);
+  fail_unless (gst_structure_has_name (gst_message_get_structure (msg),
+          "GstFPSDisplaySink"));
+  gst_message_unref (msg);
+
+  cleanup_fpsdisplaysink (fpsdisplaysink);
+}
+
+GST_END_TEST;
+
+static Suite *
+fpsdisplaysink_suite (void)
+{
+  Suite *s = suite_create ("fpsdisplaysink");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_stats_message);
+  tcase_add_test (tc_chain, test_stats_only_latched);
+
+  return s;
+}
+
+GST_CHECK_MAIN (fpsdisplaysink);
@@ -0,0 +1,243 @@
+/* GStreamer
+ *
+ * unit test for freeverb
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "../../gst/freeverb/gstfreeverb.c"
+#undef GST_CAT_DEFAULT
+
+#include <gst/check/gstcheck.h>
+#include <string.h>
+
+/* the filters one sample at a time, as they were before the block
+ * processing */
+
+#define ref_allpass_process(_allpass, _input_1) \
+{ \
+  gfloat output; \
+  gfloat bufout; \
+  bufout = _allpass.buffer[_allpass.bufidx]; \
+  output = bufout-_input_1; \
+  _allpass.buffer[_allpass.bufidx] = _input_1 + (bufout * _allpass.feedback); \
+  if (++_allpass.bufidx >= _allpass.bufsize) { \
+    _allpass.bufidx = 0; \
+  } \
+  _input_1 = output; \
+}
+
+#define ref_comb_process(_comb, _input_1, _output) \
+{ \
+  gfloat _tmp = _comb.buffer[_comb.bufidx]; \
+  _comb.filterstore = (_tmp * _comb.damp2) + (_comb.filterstore * _comb.damp1); \
+  _comb.buffer[_comb.bufidx] = _input_1 + (_comb.filterstore * _comb.feedback); \
+  if (++_comb.bufidx >= _comb.bufsize) { \
+    _comb.bufidx = 0; \
+  } \
+  _output += _tmp; \
+}
+
+/* Processes @num_samples frames of @filter's format sample by sample, the
+ * way the transform functions did before they worked on blocks. */
+static gboolean
+ref_process (GstFreeverb * filter, gpointer idata, gpointer odata,
+    guint num_samples)
+{
+  GstFreeverbPrivate *priv = filter->priv;
+  gboolean is_float = GST_AUDIO_INFO_IS_FLOAT (&filter->info);
+  gint channels = GST_AUDIO_INFO_CHANNELS (&filter->info);
+  gint16 *iint = idata, *oint = odata;
+  gfloat *ifloat = idata, *ofloat = odata;
+  gfloat out_l1, out_r1, input_1l, input_1r;
+  gfloat out_l2, out_r2, input_2l, input_2r;
+  gboolean drained = TRUE;
+  gint i;
+  guint k;
+
+  for (k = 0; k < num_samples; k++) {
+    out_l1 = out_r1 = 0.0;
+
+    if (is_float) {
+      input_2l = *ifloat++;
+      input_2r = channels == 2 ? *ifloat++ : input_2l;
+    } else {
+      input_2l = (gfloat) * iint++;
+      input_2r = channels == 2 ? (gfloat) * iint++ : input_2l;
+    }
+    if (channels == 1) {
+      input_1l = input_1r = (2.0f * input_2l + DC_OFFSET) * priv->gain;
+    } else {
+      input_1l = (input_2l + DC_OFFSET) * priv->gain;
+      input_1r = (input_2r + DC_OFFSET) * priv->gain;
+    }
+
+    /* Accumulate comb filters in parallel */
+    for (i = 0; i < numcombs; i++) {
+      ref_comb_process (priv->combL[i], input_1l, out_l1);
+      ref_comb_process (priv->combR[i], input_1r, out_r1);
+    }
+    /* Feed through allpasses in series */
+    for (i = 0; i < numallpasses; i++) {
+      ref_allpass_process (priv->allpassL[i], out_l1);
+      ref_allpass_process (priv->allpassR[i], out_r1);
+    }
+
+    /* Remove the DC offset */
+    out_l1 -= DC_OFFSET;
+    out_r1 -= DC_OFFSET;
+
+    /* Calculate output */
+    out_l2 = out_l1 * priv->wet1 + out_r1 * priv->wet2 + input_2l * priv->dry;
+    out_r2 = out_r1 * priv->wet1 + out_l1 * priv->wet2 + input_2r * priv->dry;
+    if (is_float) {
+      *ofloat++ = out_l2;
+      *ofloat++ = out_r2;
+      if (fabs (out_l2) > 0 || fabs (out_r2) > 0)
+        drained = FALSE;
+    } else {
+      *oint++ = (gint16) CLAMP (out_l2, G_MININT16, G_MAXINT16);
+      *oint++ = (gint16) CLAMP (out_r2, G_MININT16, G_MAXINT16);
+      if (abs (out_l2) > 0 || abs (out_r2) > 0)
+        drained = FALSE;
+    }
+  }
+  return drained;
+}
+
+static GstFreeverb *
+setup_freeverb (const gchar * format, gint channels)
+{
+  GstFreeverb *filter;
+  GstCaps *incaps, *outcaps;
+
+  filter = g_object_new (GST_TYPE_FREEVERB, "room-size", 0.8, "damping",
+      0.3, "width", 0.7, "level", 0.6, NULL);
+
+  incaps = gst_caps_new_simple ("audio/x-raw",
+      "format", G_TYPE_STRING, format,
+      "layout", G_TYPE_STRING, "interleaved",
+      "rate", G_TYPE_INT, 44100, "channels", G_TYPE_INT, channels, NULL);
+  outcaps = gst_caps_copy (incaps);
+  gst_caps_set_simple (outcaps, "channels", G_TYPE_INT, 2, NULL);
+  fail_unless (gst_freeverb_set_caps (GST_BASE_TRANSFORM (filter), incaps,
+          outcaps));
+  gst_caps_unref (incaps);
+  gst_caps_unref (outcaps);
+
+  return filter;
+}
+
+/* buffer sizes around the block size and over the longest delay line, the
+ * input is noise that stops halfway so that the tail decays to silence */
+static const guint chunks[] = { 1, 255, 256, 257, 1000, 1617, 4000, 3000 };
+
+#define N_NOISE 4000
+
+static void
+check_block_vs_sample (const gchar * format, gint channels)
+{
+  GstFreeverb *filter, *ref;
+  gboolean is_float;
+  gint bps, i;
+  guint pos = 0;
+  GRand *rand;
+
+  filter = setup_freeverb (format, channels);
+  ref = setup_freeverb (format, channels);
+  is_float = GST_AUDIO_INFO_IS_FLOAT (&filter->info);
+  bps = GST_AUDIO_INFO_BPS (&filter->info);
+  rand = g_rand_new_with_seed (42);
+
+  for (i = 0; i < G_N_ELEMENTS (chunks); i++) {
+    guint n = chunks[i], k;
+    gpointer in, out, ref_out;
+    gboolean drained, ref_drained;
+
+    in = g_malloc0 (n * channels * bps);
+    out = g_malloc (n * 2 * bps);
+    ref_out = g_malloc (n * 2 * bps);
+
+    for (k = 0; k < n * channels && pos + k / channels < N_NOISE; k++) {
+      if (is_float)
+        ((gfloat *) in)[k] = g_rand_double_range (rand, -0.8, 0.8);
+      else
+        ((gint16 *) in)[k] = g_rand_int_range (rand, -20000, 20000);
+    }
+    pos += n;
+
+    drained = filter->process (filter, in, out, n);
+    ref_drained = ref_process (ref, in, ref_out, n);
+
+    fail_unless (memcmp (out, ref_out, n * 2 * bps) == 0,
+        "%s, %d channels: output differs in chunk %d", format, channels, i);
+    fail_unless_equals_int (drained, ref_drained);
+
+    g_free (in);
+    g_free (out);
+    g_free (ref_out);
+  }
+
+  g_rand_free (rand);
+  gst_object_unref (filter);
+  gst_object_unref (ref);
+}
+
+/* the block processing gives the same output as the per-sample code */
+GST_START_TEST (test_block_s16_mono)
+{
+  check_block_vs_sample (GST_AUDIO_NE (S16), 1);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_block_s16_stereo)
+{
+  check_block_vs_sample (GST_AUDIO_NE (S16), 2);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_block_f32_mono)
+{
+  check_block_vs_sample (GST_AUDIO_NE (F32), 1);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_block_f32_stereo)
+{
+  check_block_vs_sample (GST_AUDIO_NE (F32), 2);
+}
+
+GST_END_TEST;
+
+static Suite *
+freeverb_suite (void)
+{
+  Suite *s = suite_create ("freeverb");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_block_s16_mono);
+  tcase_add_test (tc_chain, test_block_s16_stereo);
+  tcase_add_test (tc_chain, test_block_f32_mono);
+  tcase_add_test (tc_chain, test_block_f32_stereo);
+
+  return s;
+}
+
+GST_CHECK_MAIN (freeverb);
@@ -0,0 +1,305 @@
+/* GStreamer
+ *
+ * unit test for gaussianblur
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+
+#include <math.h>
+#include <string.h>
+
+/* high enough for two bands of rows */
+#define WIDTH 48
+#define HEIGHT 72
+#define STRIDE (WIDTH * 4)
+#define FRAME_SIZE (STRIDE * HEIGHT)
+
+#define VIDEO_CAPS_STRING "video/x-raw, format = (string) AYUV, " \
+    "width = (int) 48, height = (int) 72, framerate = (fraction) 25/1"
+
+/* the default sigma, approximated by box blurs of 1, 3 and 3 samples */
+#define SIGMA 1.2
+static const gint box_radius[] = { 0, 1, 1 };
+
+static GstPad *mysrcpad, *mysinkpad;
+
+static GstStaticPadTemplate sinktemplate = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (VIDEO_CAPS_STRING));
+
+static GstStaticPadTemplate srctemplate = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (VIDEO_CAPS_STRING));
+
+static GstElement *
+setup_gaussianblur (const gchar * mode, gint n_threads)
+{
+  GstElement *gaussianblur;
+  GstCaps *caps;
+
+  gaussianblur = gst_check_setup_element ("gaussianblur");
+  g_object_set (gaussianblur, "sigma", SIGMA, "n-threads", n_threads, NULL);
+  gst_util_set_object_arg (G_OBJECT (gaussianblur), "mode", mode);
+  mysrcpad = gst_check_setup_src_pad (gaussianblur, &srctemplate);
+  mysinkpad = gst_check_setup_sink_pad (gaussianblur, &sinktemplate);
+  gst_pad_set_active (mysrcpad, TRUE);
+  gst_pad_set_active (mysinkpad, TRUE);
+
+  fail_unless (gst_element_set_state (gaussianblur,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+
+  caps = gst_caps_from_string (VIDEO_CAPS_STRING);
+  gst_check_setup_events (mysrcpad, gaussianblur, caps, GST_FORMAT_TIME);
+  gst_caps_unref (caps);
+
+  return gaussianblur;
+}
+
+static void
+cleanup_gaussianblur (GstElement * gaussianblur)
+{
+  gst_element_set_state (gaussianblur, GST_STATE_NULL);
+
+  gst_check_drop_buffers ();
+  gst_pad_set_active (mysrcpad, FALSE);
+  gst_pad_set_active (mysinkpad, FALSE);
+  gst_check_teardown_src_pad (gaussianblur);
+  gst_check_teardown_sink_pad (gaussianblur);
+  gst_check_teardown_element (gaussianblur);
+}
+
+/* pseudo random bytes, the worst case for the rounding */
+static void
+fill_noise (guint8 * data)
+{
+  guint32 seed = 1;
+  gint i;
+
+  for (i = 0; i < FRAME_SIZE; i++) {
+    seed = seed * 1103515245 + 12345;
+    data[i] = seed >> 16;
+  }
+}
+
+/* blurs @in into @out in @mode with @n_threads threads */
+static void
+blur_frame (const gchar * mode, gint n_threads, const guint8 * in,
+    guint8 * out)
+{
+  GstElement *gaussianblur;
+  GstBuffer *buffer;
+
+  gaussianblur = setup_gaussianblur (mode, n_threads);
+
+  buffer = gst_buffer_new_allocate (NULL, FRAME_SIZE, NULL);
+  gst_buffer_fill (buffer, 0, in, FRAME_SIZE);
+  GST_BUFFER_PTS (buffer) = 0;
+  GST_BUFFER_DURATION (buffer) = GST_SECOND / 25;
+  fail_unless_equals_int (gst_pad_push (mysrcpad, buffer), GST_FLOW_OK);
+
+  fail_unless_equals_int (g_list_length (buffers), 1);
+  fail_unless_equals_int (gst_buffer_get_size (buffers->data), FRAME_SIZE);
+  gst_buffer_extract (buffers->data, 0, out, FRAME_SIZE);
+
+  cleanup_gaussianblur (gaussianblur);
+}
+
+/* the gaussian blur in floating point, the kernel is renormalised where it
+ * reaches past the edges of the frame */
+static void
+reference_gaussian (const guint8 * in, guint8 * out)
+{
+  gint center = ceil (2.5 * SIGMA);
+  gdouble *kernel = g_new (gdouble, 2 * center + 1);
+  gdouble *tmp = g_new (gdouble, FRAME_SIZE);
+  gint x, y, l, k;
+
+  for (k = -center; k <= center; k++)
+    kernel[k + center] = exp (-0.5 * k * k / (SIGMA * SIGMA));
+
+  for (y = 0; y < HEIGHT; y++) {
+    for (x = 0; x < WIDTH; x++) {
+      for (l = 0; l < 4; l++) {
+        gdouble acc = 0, sum = 0;
+
+        for (k = MAX (-center, -x); k <= MIN (center, WIDTH - 1 - x); k++) {
+          acc += kernel[k + center] * in[y * STRIDE + (x + k) * 4 + l];
+          sum += kernel[k + center];
+        }
+        tmp[y * STRIDE + x * 4 + l] = acc / sum;
+      }
+    }
+  }
+
+  for (y = 0; y < HEIGHT; y++) {
+    for (x = 0; x < STRIDE; x++) {
+      gdouble acc = 0, sum = 0;
+
+      for (k = MAX (-center, -y); k <= MIN (center, HEIGHT - 1 - y); k++) {
+        acc += kernel[k + center] * tmp[(y + k) * STRIDE + x];
+        sum += kernel[k + center];
+      }
+      out[y * STRIDE + x] = CLAMP (floor (acc / sum + 0.5), 0, 255);
+    }
+  }
+
+  g_free (tmp);
+  g_free (kernel);
+}
+
+/* box blurs @len samples @step apart with radius @r, repeating the edge
+ * samples and rounding to the nearest value */
+static void
+reference_box_lane (guint8 * data, gint len, gint step, gint r)
+{
+  guint8 *copy = g_new (guint8, len);
+  gint i, j;
+
+  for (i = 0; i < len; i++)
+    copy[i] = data[i * step];
+
+  for (i = 0; i < len; i++) {
+    gint sum = 0;
+
+    for (j = i - r; j <= i + r; j++)
+      sum += copy[CLAMP (j, 0, len - 1)];
+    data[i * step] = (2 * sum + 2 * r + 1) / (2 * (2 * r + 1));
+  }
+
+  g_free (copy);
+}
+
+/* three box blurs in x and then in y */
+static void
+reference_box (const guint8 * in, guint8 * out)
+{
+  gint p, x, y;
+
+  memcpy (out, in, FRAME_SIZE);
+
+  for (p = 0; p < G_N_ELEMENTS (box_radius); p++) {
+    for (y = 0; y < HEIGHT; y++) {
+      for (x = 0; x < 4; x++)
+        reference_box_lane (out + y * STRIDE + x, WIDTH, 4, box_radius[p]);
+    }
+  }
+  for (p = 0; p < G_N_ELEMENTS (box_radius); p++) {
+    for (x = 0; x < STRIDE; x++)
+      reference_box_lane (out + x, HEIGHT, STRIDE, box_radius[p]);
+  }
+}
+
+/* the fixed point kernel gives the floating point result, give or take
+ * the rounding, with one thread and with bands on the thread pool */
+GST_START_TEST (test_exact_blur)
+{
+  guint8 *in, *out, *out_threaded, *expected;
+  gint i;
+
+  in = g_malloc (FRAME_SIZE);
+  out = g_malloc (FRAME_SIZE);
+  out_threaded = g_malloc (FRAME_SIZE);
+  expected = g_malloc (FRAME_SIZE);
+
+  fill_noise (in);
+  reference_gaussian (in, expected);
+
+  blur_frame ("exact", 1, in, out);
+  for (i = 0; i < FRAME_SIZE; i++) {
+    fail_unless (ABS (out[i] - expected[i]) <= 1,
+        "byte %d is %d, expected %d", i, out[i], expected[i]);
+  }
+
+  blur_frame ("exact", 4, in, out_threaded);
+  fail_unless (memcmp (out, out_threaded, FRAME_SIZE) == 0);
+
+  g_free (in);
+  g_free (out);
+  g_free (out_threaded);
+  g_free (expected);
+}
+
+GST_END_TEST;
+
+/* the box blurs round every pass to the nearest value, with one thread and
+ * with bands on the thread pool */
+GST_START_TEST (test_box_blur)
+{
+  guint8 *in, *out, *expected;
+  gint i;
+
+  in = g_malloc (FRAME_SIZE);
+  out = g_malloc (FRAME_SIZE);
+  expected = g_malloc (FRAME_SIZE);
+
+  fill_noise (in);
+  reference_box (in, expected);
+
+  blur_frame ("box", 1, in, out);
+  for (i = 0; i < FRAME_SIZE; i++) {
+    fail_unless_equals_int (out[i], expected[i]);
+  }
+
+  blur_frame ("box", 4, in, out);
+  fail_unless (memcmp (out, expected, FRAME_SIZE) == 0);
+
+  g_free (in);
+  g_free (out);
+  g_free (expected);
+}
+
+GST_END_TEST;
+
+/* a flat frame stays exactly the same in both modes */
+GST_START_TEST (test_flat)
+{
+  guint8 *in, *out;
+
+  in = g_malloc (FRAME_SIZE);
+  out = g_malloc (FRAME_SIZE);
+  memset (in, 235, FRAME_SIZE);
+
+  blur_frame ("exact", 1, in, out);
+  fail_unless (memcmp (in, out, FRAME_SIZE) == 0);
+  blur_frame ("box", 1, in, out);
+  fail_unless (memcmp (in, out, FRAME_SIZE) == 0);
+
+  g_free (in);
+  g_free (out);
+}
+
+GST_END_TEST;
+
+static Suite *
+gaussianblur_suite (void)
+{
+  Suite *s = suite_create ("gaussianblur");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_exact_blur);
+  tcase_add_test (tc_chain, test_box_blur);
+  tcase_add_test (tc_chain, test_flat);
+
+  return s;
+}
+
+GST_CHECK_MAIN (gaussianblur);
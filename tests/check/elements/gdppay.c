@@ -549,6 +549,107 @@ GST_START_TEST (test_crc)
 
 GST_END_TEST;
 
+GST_START_TEST (test_crc_value)
+{
+  const guint8 check[] = "123456789";
+  guint8 data[100];
+  guint16 crc_register;
+  guint i, j;
+
+  /* known check value for this CRC (CCITT with final XOR) */
+  fail_unless_equals_int (gst_dp_crc (check, 9), 0xd64e);
+
+  /* compare the sliced implementation with the bytewise one for all the
+   * lengths around the slice size */
+  for (i = 0; i < sizeof (data); i++)
+    data[i] = g_random_int_range (0, 256);
+
+  for (i = 0; i < sizeof (data); i++) {
+    crc_register = CRC_INIT;
+    for (j = 0; j < i; j++)
+      crc_register = (guint16) ((crc_register << 8) ^
+          gst_dp_crc_table[((crc_register >> 8) & 0x00ff) ^ data[j]]);
+
+    fail_unless_equals_int (gst_dp_crc (data, i), 0xffff ^ crc_register);
+  }
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_buffer_list)
+{
+  GstCaps *caps;
+  GstElement *gdppay;
+  GstBufferList *list;
+  GstBuffer *outbuffer;
+  GstMemory *header_mems[3], *mem;
+  gint i;
+
+  gdppay = setup_gdppay ();
+
+  fail_unless (gst_element_set_state (gdppay,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+
+  caps = gst_caps_from_string (AUDIO_CAPS_STRING);
+  gst_check_setup_events (mysrcpad, gdppay, caps, GST_FORMAT_TIME);
+
+  list = gst_buffer_list_new ();
+  for (i = 0; i < 3; i++)
+    gst_buffer_list_add (list, gst_buffer_new_and_alloc (4));
+
+  fail_unless (gst_pad_push_list (mysrcpad, list) == GST_FLOW_OK);
+
+  /* stream-start, caps and segment, then our three buffers */
+  fail_unless_equals_int (g_list_length (buffers), 6);
+
+  check_stream_start_buffer (2);
+  check_caps_buffer (2, caps);
+  check_segment_buffer (2);
+
+  for (i = 0; i < 3; i++) {
+    fail_if ((outbuffer = (GstBuffer *) buffers->data) == NULL);
+    buffers = g_list_remove (buffers, outbuffer);
+    fail_unless_equals_int (gst_buffer_get_size (outbuffer),
+        GST_DP_HEADER_LENGTH + 4);
+    /* header and payload are separate memories */
+    fail_unless_equals_int (gst_buffer_n_memory (outbuffer), 2);
+    /* every buffer still downstream has its own header memory */
+    header_mems[i] = gst_buffer_peek_memory (outbuffer, 0);
+    fail_unless_equals_int (gst_memory_get_sizes (header_mems[i], NULL,
+            NULL), GST_DP_HEADER_LENGTH);
+    if (i > 0)
+      fail_if (header_mems[i] == header_mems[i - 1]);
+    gst_buffer_unref (outbuffer);
+  }
+
+  /* the header memories are not used downstream anymore, so the next buffer
+   * gets one of them instead of a new one */
+  list = gst_buffer_list_new ();
+  gst_buffer_list_add (list, gst_buffer_new_and_alloc (4));
+  fail_unless (gst_pad_push_list (mysrcpad, list) == GST_FLOW_OK);
+  fail_unless_equals_int (g_list_length (buffers), 1);
+
+  outbuffer = (GstBuffer *) buffers->data;
+  mem = gst_buffer_peek_memory (outbuffer, 0);
+  fail_unless (mem == header_mems[0] || mem == header_mems[1]
+      || mem == header_mems[2]);
+  /* owned by gdppay and by the buffer downstream */
+  ASSERT_MINI_OBJECT_REFCOUNT (mem, "header memory", 2);
+
+  fail_unless (gst_element_set_state (gdppay,
+          GST_STATE_NULL) == GST_STATE_CHANGE_SUCCESS, "could not set to null");
+
+  gst_caps_unref (caps);
+  g_list_foreach (buffers, (GFunc) gst_mini_object_unref, NULL);
+  g_list_free (buffers);
+  buffers = NULL;
+  ASSERT_OBJECT_REFCOUNT (gdppay, "gdppay", 1);
+  cleanup_gdppay (gdppay);
+}
+
+GST_END_TEST;
+
 
 static Suite *
 gdppay_suite (void)
@@ -562,6 +663,8 @@ gdppay_suite (void)
   tcase_add_test (tc_chain, test_first_no_new_segment);
   tcase_add_test (tc_chain, test_streamheader);
   tcase_add_test (tc_chain, test_crc);
+  tcase_add_test (tc_chain, test_crc_value);
+  tcase_add_test (tc_chain, test_buffer_list);
 
   return s;
 }
@@ -0,0 +1,221 @@
+/* GStreamer
+ *
+ * unit test for hlssink
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <gst/video/video.h>
+
+#include <string.h>
+
+static GstPad *mysrcpad;
+
+static GstStaticPadTemplate srctemplate = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("video/mpegts"));
+
+static GstElement *
+setup_hlssink (guint max_files, guint playlist_length)
+{
+  GstElement *hlssink;
+  GstCaps *caps;
+
+  hlssink = gst_check_setup_element ("hlssink");
+  g_object_set (hlssink, "in-memory", TRUE, "target-duration", 0,
+      "max-files", max_files, "playlist-length", playlist_length, NULL);
+  mysrcpad = gst_check_setup_src_pad (hlssink, &srctemplate);
+  gst_pad_set_active (mysrcpad, TRUE);
+
+  fail_unless (gst_element_set_state (hlssink,
+          GST_STATE_PLAYING) != GST_STATE_CHANGE_FAILURE,
+      "could not set to playing");
+
+  caps = gst_caps_from_string ("video/mpegts");
+  gst_check_setup_events (mysrcpad, hlssink, caps, GST_FORMAT_TIME);
+  gst_caps_unref (caps);
+
+  return hlssink;
+}
+
+static void
+cleanup_hlssink (GstElement * hlssink)
+{
+  gst_element_set_state (hlssink, GST_STATE_NULL);
+
+  gst_pad_set_active (mysrcpad, FALSE);
+  gst_check_teardown_src_pad (hlssink);
+  gst_check_teardown_element (hlssink);
+}
+
+/* pushes a fragment of two 1 second buffers of 188 bytes, and the key unit
+ * event that closes it */
+static void
+push_fragment (guint index)
+{
+  GstClockTime ts = 2 * index * GST_SECOND;
+  GstBuffer *buffer;
+  gint i;
+
+  for (i = 0; i < 2; i++) {
+    buffer = gst_buffer_new_allocate (NULL, 188, NULL);
+    gst_buffer_memset (buffer, 0, index, 188);
+    GST_BUFFER_TIMESTAMP (buffer) = ts + i * GST_SECOND;
+    GST_BUFFER_DURATION (buffer) = GST_SECOND;
+    fail_unless_equals_int (gst_pad_push (mysrcpad, buffer), GST_FLOW_OK);
+  }
+
+  fail_unless (gst_pad_push_event (mysrcpad,
+          gst_video_event_new_downstream_force_key_unit (ts + 2 * GST_SECOND,
+              ts + 2 * GST_SECOND, ts + 2 * GST_SECOND, TRUE, index + 1)));
+}
+
+static GstBufferList *
+get_fragment (GstElement * hlssink, guint index)
+{
+  GstBufferList *list = NULL;
+  gchar *name;
+
+  name = g_strdup_printf ("segment%05u.ts", index);
+  g_signal_emit_by_name (hlssink, "get-fragment", name, &list);
+  g_free (name);
+
+  return list;
+}
+
+static guint
+count_entries (const gchar * playlist)
+{
+  const gchar *p = playlist;
+  guint n = 0;
+
+  while ((p = strstr (p, "#EXTINF"))) {
+    n++;
+    p++;
+  }
+
+  return n;
+}
+
+/* the store keeps the last max-files fragments, referencing the pushed data */
+GST_START_TEST (test_memory_store)
+{
+  GstElement *hlssink;
+  GstBufferList *list;
+  GstMapInfo map;
+  guint i;
+
+  hlssink = setup_hlssink (2, 5);
+
+  for (i = 0; i < 4; i++)
+    push_fragment (i);
+
+  fail_unless (get_fragment (hlssink, 0) == NULL);
+  fail_unless (get_fragment (hlssink, 1) == NULL);
+
+  for (i = 2; i < 4; i++) {
+    list = get_fragment (hlssink, i);
+    fail_unless (list != NULL);
+    fail_unless_equals_int (gst_buffer_list_length (list), 2);
+    gst_buffer_map (gst_buffer_list_get (list, 0), &map, GST_MAP_READ);
+    fail_unless_equals_int (map.size, 188);
+    fail_unless_equals_int (map.data[0], i);
+    gst_buffer_unmap (gst_buffer_list_get (list, 0), &map);
+    gst_buffer_list_unref (list);
+  }
+
+  cleanup_hlssink (hlssink);
+}
+
+GST_END_TEST;
+
+/* max-files=0 must not keep a live stream in memory forever */
+GST_START_TEST (test_memory_store_unlimited)
+{
+  GstElement *hlssink;
+  GstBufferList *list;
+  guint i;
+
+  hlssink = setup_hlssink (0, 2);
+
+  for (i = 0; i < 6; i++)
+    push_fragment (i);
+
+  /* the playlist entries and the one before them */
+  for (i = 0; i < 3; i++)
+    fail_unless (get_fragment (hlssink, i) == NULL);
+  for (i = 3; i < 6; i++) {
+    list = get_fragment (hlssink, i);
+    fail_unless (list != NULL);
+    gst_buffer_list_unref (list);
+  }
+
+  cleanup_hlssink (hlssink);
+}
+
+GST_END_TEST;
+
+/* the playlist is updated for every fragment and slides over the last
+ * playlist-length ones */
+GST_START_TEST (test_playlist)
+{
+  GstElement *hlssink;
+  gchar *playlist = NULL;
+  guint i;
+
+  hlssink = setup_hlssink (10, 3);
+
+  g_signal_emit_by_name (hlssink, "get-playlist", &playlist);
+  fail_unless (playlist == NULL);
+
+  for (i = 0; i < 5; i++) {
+    push_fragment (i);
+
+    g_signal_emit_by_name (hlssink, "get-playlist", &playlist);
+    fail_unless (playlist != NULL);
+    fail_unless (g_str_has_prefix (playlist, "#EXTM3U"));
+    fail_unless_equals_int (count_entries (playlist), MIN (i + 1, 3));
+    g_free (playlist);
+  }
+
+  g_signal_emit_by_name (hlssink, "get-playlist", &playlist);
+  fail_unless (strstr (playlist, "segment00001.ts") == NULL);
+  fail_unless (strstr (playlist, "segment00002.ts") != NULL);
+  fail_unless (strstr (playlist, "segment00004.ts") != NULL);
+  g_free (playlist);
+
+  cleanup_hlssink (hlssink);
+}
+
+GST_END_TEST;
+
+static Suite *
+hlssink_suite (void)
+{
+  Suite *s = suite_create ("hlssink");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_memory_store);
+  tcase_add_test (tc_chain, test_memory_store_unlimited);
+  tcase_add_test (tc_chain, test_playlist);
+
+  return s;
+}
+
+GST_CHECK_MAIN (hlssink);
@@ -0,0 +1,278 @@
+/* GStreamer
+ *
+ * unit test for interlace
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <gst/video/video.h>
+
+#define WIDTH 16
+#define HEIGHT 8
+
+#define VIDEO_CAPS_STRING "video/x-raw, format = (string) I420, " \
+    "width = (int) 16, height = (int) 8, framerate = (fraction) 24/1, " \
+    "interlace-mode = (string) progressive"
+
+/* 24p to 60i, the output buffers last two fields of 1/60s */
+#define FIELDS_TO_TIME(n) gst_util_uint64_scale (n, GST_SECOND, 60)
+
+#define N_INPUT 4
+
+static GstPad *mysrcpad, *mysinkpad;
+static GstVideoInfo info;
+
+static GstStaticPadTemplate sinktemplate = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("video/x-raw"));
+
+static GstStaticPadTemplate srctemplate = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (VIDEO_CAPS_STRING));
+
+static GstElement *
+setup_interlace (void)
+{
+  GstElement *interlace;
+  GstCaps *caps;
+
+  interlace = gst_check_setup_element ("interlace");
+  g_object_set (interlace, "top-field-first", TRUE, NULL);
+  mysrcpad = gst_check_setup_src_pad (interlace, &srctemplate);
+  mysinkpad = gst_check_setup_sink_pad (interlace, &sinktemplate);
+  gst_pad_set_active (mysrcpad, TRUE);
+  gst_pad_set_active (mysinkpad, TRUE);
+
+  fail_unless (gst_element_set_state (interlace,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+
+  caps = gst_caps_from_string (VIDEO_CAPS_STRING);
+  fail_unless (gst_video_info_from_caps (&info, caps));
+  gst_check_setup_events (mysrcpad, interlace, caps, GST_FORMAT_TIME);
+  gst_caps_unref (caps);
+
+  return interlace;
+}
+
+static void
+cleanup_interlace (GstElement * interlace)
+{
+  gst_element_set_state (interlace, GST_STATE_NULL);
+
+  gst_check_drop_buffers ();
+  gst_pad_set_active (mysrcpad, FALSE);
+  gst_pad_set_active (mysinkpad, FALSE);
+  gst_check_teardown_src_pad (interlace);
+  gst_check_teardown_sink_pad (interlace);
+  gst_check_teardown_element (interlace);
+}
+
+/* the value of all the samples of input frame @n */
+static guint8
+get_value (guint n)
+{
+  return 16 + n * 32;
+}
+
+/* creates input frame @n, the first one starting a new stream and the
+ * others depending on it */
+static GstBuffer *
+make_frame (guint n)
+{
+  GstBuffer *buffer;
+
+  buffer = gst_buffer_new_allocate (NULL, GST_VIDEO_INFO_SIZE (&info), NULL);
+  gst_buffer_memset (buffer, 0, get_value (n), GST_VIDEO_INFO_SIZE (&info));
+  GST_BUFFER_PTS (buffer) = gst_util_uint64_scale (n, GST_SECOND, 24);
+  GST_BUFFER_DURATION (buffer) = GST_SECOND / 24;
+  if (n == 0)
+    GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DISCONT);
+  else
+    GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DELTA_UNIT);
+
+  return buffer;
+}
+
+/* checks that the top field of @buffer comes from input frame @top and the
+ * bottom field from input frame @bottom */
+static void
+check_fields (GstBuffer * buffer, guint top, guint bottom)
+{
+  GstVideoFrame frame;
+  guint i;
+  gint x, y;
+
+  fail_unless (gst_video_frame_map (&frame, &info, buffer, GST_MAP_READ));
+  for (i = 0; i < GST_VIDEO_FRAME_N_PLANES (&frame); i++) {
+    guint8 *data = GST_VIDEO_FRAME_PLANE_DATA (&frame, i);
+    gint stride = GST_VIDEO_FRAME_PLANE_STRIDE (&frame, i);
+
+    for (y = 0; y < GST_VIDEO_FRAME_COMP_HEIGHT (&frame, i); y++) {
+      guint8 expected = get_value ((y & 1) ? bottom : top);
+
+      for (x = 0; x < GST_VIDEO_FRAME_COMP_WIDTH (&frame, i); x++)
+        fail_unless_equals_int (data[y * stride + x], expected);
+    }
+  }
+  gst_video_frame_unmap (&frame);
+}
+
+/* checks output buffer @n of two fields, woven if @top and @bottom
+ * differ */
+static void
+check_output (GstBuffer * buffer, guint n, guint top, guint bottom)
+{
+  fail_unless_equals_uint64 (GST_BUFFER_PTS (buffer), FIELDS_TO_TIME (2 * n));
+  fail_unless_equals_uint64 (GST_BUFFER_DURATION (buffer), FIELDS_TO_TIME (2));
+
+  fail_unless (GST_BUFFER_FLAG_IS_SET (buffer, GST_VIDEO_BUFFER_FLAG_TFF));
+  fail_if (GST_BUFFER_FLAG_IS_SET (buffer, GST_VIDEO_BUFFER_FLAG_RFF));
+  fail_unless_equals_int (GST_BUFFER_FLAG_IS_SET (buffer,
+          GST_VIDEO_BUFFER_FLAG_INTERLACED), top != bottom);
+
+  /* only the first buffer starts a new stream, and the flags of the input
+   * buffers are not kept on the ones that are reused */
+  fail_unless_equals_int (GST_BUFFER_FLAG_IS_SET (buffer,
+          GST_BUFFER_FLAG_DISCONT), n == 0);
+  fail_if (GST_BUFFER_FLAG_IS_SET (buffer, GST_BUFFER_FLAG_DELTA_UNIT));
+  fail_if (GST_BUFFER_FLAG_IS_SET (buffer, GST_BUFFER_FLAG_GAP));
+
+  check_fields (buffer, top, bottom);
+}
+
+/* Pushes four frames with a 2:3 pattern, which gives the frames A, B, B/C,
+ * C/D and D, where the last field of B and C is woven with the first one of
+ * the next frame. If @shared, the input buffers are kept by the test and
+ * cannot be reused for the output, which must be the same. */
+static void
+check_pulldown (gboolean shared)
+{
+  GstElement *interlace;
+  GstBuffer *inbufs[N_INPUT];
+  guint i;
+
+  interlace = setup_interlace ();
+
+  for (i = 0; i < N_INPUT; i++) {
+    inbufs[i] = make_frame (i);
+    if (shared)
+      gst_buffer_ref (inbufs[i]);
+    fail_unless_equals_int (gst_pad_push (mysrcpad, inbufs[i]), GST_FLOW_OK);
+
+    switch (i) {
+      case 0:
+      case 1:
+        fail_unless_equals_int (g_list_length (buffers), 1);
+        check_output (buffers->data, i, i, i);
+        break;
+      case 2:
+        fail_unless_equals_int (g_list_length (buffers), 1);
+        check_output (buffers->data, 2, 1, 2);
+        /* the stored frame is only used by us, weave into it */
+        fail_unless_equals_int (buffers->data == inbufs[1], !shared);
+        break;
+      case 3:
+        fail_unless_equals_int (g_list_length (buffers), 2);
+        check_output (buffers->data, 3, 2, 3);
+        fail_unless_equals_int (buffers->data == inbufs[2], !shared);
+        check_output (buffers->next->data, 4, 3, 3);
+        break;
+    }
+
+    /* release the output, so the input buffers it was copied from are
+     * not shared anymore */
+    gst_check_drop_buffers ();
+  }
+
+  if (shared) {
+    /* the input buffers were not written to */
+    for (i = 0; i < N_INPUT; i++) {
+      check_fields (inbufs[i], i, i);
+      gst_buffer_unref (inbufs[i]);
+    }
+  }
+
+  cleanup_interlace (interlace);
+}
+
+/* the input buffers are only used by the element, which weaves the fields
+ * into them */
+GST_START_TEST (test_pulldown_exclusive)
+{
+  check_pulldown (FALSE);
+}
+
+GST_END_TEST;
+
+/* the input buffers are used elsewhere, so the fields are woven into new
+ * buffers */
+GST_START_TEST (test_pulldown_shared)
+{
+  check_pulldown (TRUE);
+}
+
+GST_END_TEST;
+
+/* a flush drops the stored field, the next frame starts the pattern
+ * again */
+GST_START_TEST (test_flush)
+{
+  GstElement *interlace;
+  GstSegment segment;
+
+  interlace = setup_interlace ();
+
+  fail_unless_equals_int (gst_pad_push (mysrcpad, make_frame (0)),
+      GST_FLOW_OK);
+  fail_unless_equals_int (gst_pad_push (mysrcpad, make_frame (1)),
+      GST_FLOW_OK);
+  fail_unless_equals_int (g_list_length (buffers), 2);
+  gst_check_drop_buffers ();
+
+  fail_unless (gst_pad_push_event (mysrcpad, gst_event_new_flush_start ()));
+  fail_unless (gst_pad_push_event (mysrcpad, gst_event_new_flush_stop (TRUE)));
+  gst_segment_init (&segment, GST_FORMAT_TIME);
+  fail_unless (gst_pad_push_event (mysrcpad, gst_event_new_segment (&segment)));
+
+  fail_unless_equals_int (gst_pad_push (mysrcpad, make_frame (2)),
+      GST_FLOW_OK);
+  fail_unless_equals_int (g_list_length (buffers), 1);
+  check_fields (buffers->data, 2, 2);
+
+  cleanup_interlace (interlace);
+}
+
+GST_END_TEST;
+
+static Suite *
+interlace_suite (void)
+{
+  Suite *s = suite_create ("interlace");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_pulldown_exclusive);
+  tcase_add_test (tc_chain, test_pulldown_shared);
+  tcase_add_test (tc_chain, test_flush);
+
+  return s;
+}
+
+GST_CHECK_MAIN (interlace);
@@ -0,0 +1,405 @@
+/* GStreamer
+ *
+ * unit test for ivtc
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "../../gst/ivtc/gstivtc.c"
+#undef GST_CAT_DEFAULT
+/* both elements of the plugin have a property enum */
+#define PROP_0 COMB_DETECT_PROP_0
+#include "../../gst/ivtc/gstcombdetect.c"
+#undef PROP_0
+#undef GST_CAT_DEFAULT
+
+#include <gst/check/gstcheck.h>
+#include <string.h>
+
+#define WIDTH 64
+#define HEIGHT 48
+/* the comb score of two fields of different film frames */
+#define COMBED_SCORE 2680
+
+static GstPad *mysrcpad, *mysinkpad;
+
+static GstStaticPadTemplate sinktemplate = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("video/x-raw"));
+
+static GstStaticPadTemplate srctemplate = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("video/x-raw"));
+
+static GstCaps *
+make_caps (void)
+{
+  return gst_caps_new_simple ("video/x-raw",
+      "format", G_TYPE_STRING, "I420",
+      "width", G_TYPE_INT, WIDTH, "height", G_TYPE_INT, HEIGHT,
+      "framerate", GST_TYPE_FRACTION, 30000, 1001,
+      "interlace-mode", G_TYPE_STRING, "interleaved", NULL);
+}
+
+static void
+make_info (GstVideoInfo * info)
+{
+  GstCaps *caps = make_caps ();
+
+  fail_unless (gst_video_info_from_caps (info, caps));
+  gst_caps_unref (caps);
+}
+
+/* The luma of line @line of film frame @film, a vertical ramp that does not
+ * comb with itself. The ramps of the frames are far enough apart that all
+ * pixels comb when two of them are woven */
+static guint8
+film_luma (guint film, gint line)
+{
+  return 16 + 20 * (film % 8) + line;
+}
+
+/* Creates a TFF interlaced frame with the top field from film frame @top
+ * and the bottom field from film frame @bottom */
+static GstBuffer *
+make_frame (guint top, guint bottom)
+{
+  GstVideoInfo info;
+  GstVideoFrame frame;
+  GstBuffer *buffer;
+  gint j, k;
+
+  make_info (&info);
+  buffer = gst_buffer_new_allocate (NULL, info.size, NULL);
+  gst_video_frame_map (&frame, &info, buffer, GST_MAP_WRITE);
+  for (j = 0; j < HEIGHT; j++)
+    memset (GST_VIDEO_FRAME_COMP_DATA (&frame, 0) +
+        j * GST_VIDEO_FRAME_COMP_STRIDE (&frame, 0),
+        film_luma ((j & 1) ? bottom : top, j), WIDTH);
+  for (k = 1; k < 3; k++)
+    for (j = 0; j < GST_VIDEO_FRAME_COMP_HEIGHT (&frame, k); j++)
+      memset (GST_VIDEO_FRAME_COMP_DATA (&frame, k) +
+          j * GST_VIDEO_FRAME_COMP_STRIDE (&frame, k), 128,
+          GST_VIDEO_FRAME_COMP_WIDTH (&frame, k));
+  gst_video_frame_unmap (&frame);
+
+  GST_BUFFER_FLAG_SET (buffer, GST_VIDEO_BUFFER_FLAG_INTERLACED);
+  GST_BUFFER_FLAG_SET (buffer, GST_VIDEO_BUFFER_FLAG_TFF);
+
+  return buffer;
+}
+
+/* checks that @buffer is woven from the fields of film frames @top and
+ * @bottom */
+static void
+check_frame (GstBuffer * buffer, guint top, guint bottom)
+{
+  GstVideoInfo info;
+  GstVideoFrame frame;
+  gint i, j, k;
+
+  make_info (&info);
+  fail_unless (gst_video_frame_map (&frame, &info, buffer, GST_MAP_READ));
+  for (k = 0; k < 3; k++) {
+    for (j = 0; j < GST_VIDEO_FRAME_COMP_HEIGHT (&frame, k); j++) {
+      const guint8 *line = GST_VIDEO_FRAME_COMP_DATA (&frame, k) +
+          j * GST_VIDEO_FRAME_COMP_STRIDE (&frame, k);
+      guint8 expected = k ? 128 : film_luma ((j & 1) ? bottom : top, j);
+
+      for (i = 0; i < GST_VIDEO_FRAME_COMP_WIDTH (&frame, k); i++)
+        fail_unless_equals_int (line[i], expected);
+    }
+  }
+  gst_video_frame_unmap (&frame);
+}
+
+/* comb_line() marks the pixels more than 5 outside the range of the lines
+ * above and below */
+GST_START_TEST (test_comb_line)
+{
+  const guint8 src1[] = { 100, 100, 100, 100, 100, 100, 0, 255 };
+  const guint8 src3[] = { 110, 110, 110, 110, 110, 110, 20, 240 };
+  const guint8 src2[] = { 94, 95, 105, 115, 116, 100, 26, 234 };
+  const guint8 expected[] = { 1, 0, 0, 0, 1, 0, 1, 1 };
+  guint8 mask[8];
+  gint i;
+
+  fail_unless (comb_line (src1, src2, src3, mask, 8));
+  for (i = 0; i < 8; i++)
+    fail_unless_equals_int (mask[i], expected[i]);
+
+  /* nothing marked */
+  fail_if (comb_line (src1, src2 + 1, src3, mask, 3));
+  for (i = 0; i < 3; i++)
+    fail_unless_equals_int (mask[i], 0);
+}
+
+GST_END_TEST;
+
+/* get_comb_scores() scores pairs alone and together the same, only counting
+ * pixels in long enough runs of combing */
+GST_START_TEST (test_comb_scores)
+{
+  GstVideoInfo info;
+  GstBuffer *bufs[4];
+  GstVideoFrame frames[4];
+  GstVideoFrame *tops[2], *bottoms[2];
+  int scores[2];
+  gint i, j;
+
+  make_info (&info);
+  bufs[0] = make_frame (0, 0);
+  bufs[1] = make_frame (1, 1);
+  bufs[2] = make_frame (2, 2);
+  /* a bottom field from the same film frame with two combed blocks, the
+   * second one after some lines without any combing */
+  bufs[3] = make_frame (2, 2);
+  for (i = 0; i < 4; i++)
+    fail_unless (gst_video_frame_map (&frames[i], &info, bufs[i],
+            i == 3 ? GST_MAP_READWRITE : GST_MAP_READ));
+  for (j = 11; j < 30; j += 2)
+    memset (GST_VIDEO_FRAME_COMP_DATA (&frames[3], 0) +
+        j * GST_VIDEO_FRAME_COMP_STRIDE (&frames[3], 0) + 20,
+        film_luma (2, j) + 60, 8);
+  for (j = 35; j < 40; j += 2)
+    memset (GST_VIDEO_FRAME_COMP_DATA (&frames[3], 0) +
+        j * GST_VIDEO_FRAME_COMP_STRIDE (&frames[3], 0) + 40,
+        film_luma (2, j) + 60, 10);
+
+  /* the fields of a film frame */
+  tops[0] = &frames[0];
+  bottoms[0] = &frames[0];
+  get_comb_scores (tops, bottoms, 1, scores);
+  fail_unless_equals_int (scores[0], 0);
+
+  /* fields of two film frames */
+  tops[0] = &frames[1];
+  bottoms[0] = &frames[0];
+  get_comb_scores (tops, bottoms, 1, scores);
+  fail_unless_equals_int (scores[0], COMBED_SCORE);
+
+  /* both pairs sharing a field in the same pass */
+  tops[0] = &frames[1];
+  bottoms[0] = &frames[0];
+  tops[1] = &frames[1];
+  bottoms[1] = &frames[1];
+  get_comb_scores (tops, bottoms, 2, scores);
+  fail_unless_equals_int (scores[0], COMBED_SCORE);
+  fail_unless_equals_int (scores[1], 0);
+
+  tops[0] = &frames[2];
+  bottoms[0] = &frames[2];
+  tops[1] = &frames[2];
+  bottoms[1] = &frames[3];
+  get_comb_scores (tops, bottoms, 2, scores);
+  fail_unless_equals_int (scores[0], 0);
+  fail_unless_equals_int (scores[1], 118);
+
+  tops[0] = &frames[2];
+  bottoms[0] = &frames[3];
+  get_comb_scores (tops, bottoms, 1, scores);
+  fail_unless_equals_int (scores[0], 118);
+
+  for (i = 0; i < 4; i++) {
+    gst_video_frame_unmap (&frames[i]);
+    gst_buffer_unref (bufs[i]);
+  }
+}
+
+GST_END_TEST;
+
+/* The comb score of a pair is kept with its first field, it moves with the
+ * fields when the ones before are retired */
+GST_START_TEST (test_scores_after_retire)
+{
+  /* the top and bottom film frames of three telecined frames */
+  const guint films[3][2] = { {0, 0}, {1, 1}, {1, 2} };
+  GstIvtc *ivtc;
+  GstBuffer *buffer, *outbuf;
+  GstVideoFrame *tops[1], *bottoms[1];
+  GstVideoFrame dest_frame;
+  int scores[2], fresh[1];
+  gint i;
+
+  ivtc = g_object_new (GST_TYPE_IVTC, NULL);
+  make_info (&ivtc->sink_video_info);
+  ivtc->src_video_info = ivtc->sink_video_info;
+  ivtc->field_duration = gst_util_uint64_scale_int (GST_SECOND, 1001, 60000);
+  gst_segment_init (&ivtc->segment, GST_FORMAT_TIME);
+
+  for (i = 0; i < 3; i++) {
+    buffer = make_frame (films[i][0], films[i][1]);
+    GST_BUFFER_PTS (buffer) =
+        gst_util_uint64_scale (i * GST_SECOND, 1001, 30000);
+    add_field (ivtc, buffer, TOP_FIELD, 0);
+    add_field (ivtc, buffer, BOTTOM_FIELD, 1);
+    gst_buffer_unref (buffer);
+  }
+  fail_unless_equals_int (ivtc->n_fields, 6);
+
+  /* B0 T1 and T1 B1 */
+  similarity (ivtc, 1, 2, scores);
+  fail_unless_equals_int (scores[0], COMBED_SCORE);
+  fail_unless_equals_int (scores[1], 0);
+
+  gst_ivtc_retire_fields (ivtc, 1);
+  fail_unless_equals_int (ivtc->n_fields, 5);
+  fail_unless_equals_int (ivtc->fields[0].next_score, COMBED_SCORE);
+  fail_unless_equals_int (ivtc->fields[1].next_score, 0);
+  fail_unless_equals_int (ivtc->fields[2].next_score, -1);
+
+  /* the moved scores are still those of the moved fields */
+  for (i = 0; i < 2; i++) {
+    GstIvtcField *f1 = &ivtc->fields[i];
+    GstIvtcField *f2 = &ivtc->fields[i + 1];
+
+    tops[0] = f1->parity == TOP_FIELD ? &f1->frame : &f2->frame;
+    bottoms[0] = f1->parity == TOP_FIELD ? &f2->frame : &f1->frame;
+    get_comb_scores (tops, bottoms, 1, fresh);
+    fail_unless_equals_int (fresh[0], f1->next_score);
+  }
+
+  /* one cached pair and one new one: T1 B1 and B1 T1, then B1 T1 and
+   * T1 B2 */
+  similarity (ivtc, 1, 2, scores);
+  fail_unless_equals_int (scores[0], 0);
+  fail_unless_equals_int (scores[1], 0);
+  similarity (ivtc, 2, 2, scores);
+  fail_unless_equals_int (scores[0], 0);
+  fail_unless_equals_int (scores[1], COMBED_SCORE);
+
+  /* the moved fields are still mapped */
+  outbuf = gst_buffer_new_allocate (NULL, ivtc->src_video_info.size, NULL);
+  gst_video_frame_map (&dest_frame, &ivtc->src_video_info, outbuf,
+      GST_MAP_WRITE);
+  reconstruct (ivtc, &dest_frame, 1, 2);
+  gst_video_frame_unmap (&dest_frame);
+  check_frame (outbuf, 1, 1);
+  gst_buffer_unref (outbuf);
+
+  gst_ivtc_retire_fields (ivtc, ivtc->n_fields);
+  gst_object_unref (ivtc);
+}
+
+GST_END_TEST;
+
+static GstElement *
+setup_ivtc (void)
+{
+  GstElement *ivtc;
+  GstCaps *caps;
+
+  ivtc = gst_check_setup_element ("ivtc");
+  fail_unless (GST_IS_IVTC (ivtc));
+  mysrcpad = gst_check_setup_src_pad (ivtc, &srctemplate);
+  mysinkpad = gst_check_setup_sink_pad (ivtc, &sinktemplate);
+  gst_pad_set_active (mysrcpad, TRUE);
+  gst_pad_set_active (mysinkpad, TRUE);
+
+  fail_unless (gst_element_set_state (ivtc,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+
+  caps = make_caps ();
+  gst_check_setup_events (mysrcpad, ivtc, caps, GST_FORMAT_TIME);
+  gst_caps_unref (caps);
+
+  return ivtc;
+}
+
+static void
+cleanup_ivtc (GstElement * ivtc)
+{
+  gst_element_set_state (ivtc, GST_STATE_NULL);
+
+  gst_check_drop_buffers ();
+  gst_pad_set_active (mysrcpad, FALSE);
+  gst_pad_set_active (mysinkpad, FALSE);
+  gst_check_teardown_src_pad (ivtc);
+  gst_check_teardown_sink_pad (ivtc);
+  gst_check_teardown_element (ivtc);
+}
+
+#define N_FILM_FRAMES 16
+
+/* 3:2 pulldown of 16 film frames into 20 TFF frames, each film frame
+ * comes out once, woven from its own fields */
+GST_START_TEST (test_telecine)
+{
+  /* number of output frames after each input frame */
+  const guint n_out[] = {
+    0, 1, 2, 3, 4, 4, 5, 6, 7, 8, 8, 9, 10, 11, 12, 12, 13, 14, 15, 16
+  };
+  guint fields[N_FILM_FRAMES * 5 / 2];
+  GstElement *ivtc;
+  guint film, i, n_fields = 0;
+  GList *l;
+
+  ivtc = setup_ivtc ();
+
+  /* the fields are A A B B B C C D D D */
+  for (film = 0; film < N_FILM_FRAMES; film++)
+    for (i = 0; i < 2 + film % 2; i++)
+      fields[n_fields++] = film;
+  fail_unless_equals_int (n_fields / 2, G_N_ELEMENTS (n_out));
+
+  for (i = 0; i < n_fields / 2; i++) {
+    GstBuffer *buffer = make_frame (fields[2 * i], fields[2 * i + 1]);
+
+    GST_BUFFER_PTS (buffer) =
+        gst_util_uint64_scale (i * GST_SECOND, 1001, 30000);
+    GST_BUFFER_DURATION (buffer) =
+        gst_util_uint64_scale (GST_SECOND, 1001, 30000);
+    fail_unless_equals_int (gst_pad_push (mysrcpad, buffer), GST_FLOW_OK);
+    fail_unless_equals_int (g_list_length (buffers), n_out[i]);
+  }
+
+  for (l = buffers, film = 0; l; l = l->next, film++) {
+    check_frame (l->data, film, film);
+    fail_unless_equals_uint64 (GST_BUFFER_PTS (l->data),
+        film * gst_util_uint64_scale (GST_SECOND, 1001, 24000));
+  }
+
+  cleanup_ivtc (ivtc);
+}
+
+GST_END_TEST;
+
+static void
+ivtc_init (void)
+{
+  plugin_init (NULL);
+}
+
+static Suite *
+ivtc_suite (void)
+{
+  Suite *s = suite_create ("ivtc");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_checked_fixture (tc_chain, ivtc_init, NULL);
+  tcase_add_test (tc_chain, test_comb_line);
+  tcase_add_test (tc_chain, test_comb_scores);
+  tcase_add_test (tc_chain, test_scores_after_retire);
+  tcase_add_test (tc_chain, test_telecine);
+
+  return s;
+}
+
+GST_CHECK_MAIN (ivtc);
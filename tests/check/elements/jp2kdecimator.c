@@ -0,0 +1,295 @@
+/* GStreamer
+ *
+ * unit test for jp2kdecimator
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <gst/base/gstbytewriter.h>
+
+#include <string.h>
+
+/* images in 16x16 tiles */
+#define TILE_SIZE 16
+
+static GstPad *mysrcpad, *mysinkpad;
+
+static GstStaticPadTemplate sinktemplate = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("image/x-jpc"));
+
+static GstStaticPadTemplate srctemplate = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("image/x-jpc"));
+
+static GstElement *
+setup_jp2kdecimator (gint n_threads)
+{
+  GstElement *decimator;
+  GstCaps *caps;
+
+  decimator = gst_check_setup_element ("jp2kdecimator");
+  g_object_set (decimator, "max-layers", 1, "n-threads", n_threads, NULL);
+  mysrcpad = gst_check_setup_src_pad (decimator, &srctemplate);
+  mysinkpad = gst_check_setup_sink_pad (decimator, &sinktemplate);
+  gst_pad_set_active (mysrcpad, TRUE);
+  gst_pad_set_active (mysinkpad, TRUE);
+
+  fail_unless (gst_element_set_state (decimator,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+
+  caps = gst_caps_from_string ("image/x-jpc");
+  gst_check_setup_events (mysrcpad, decimator, caps, GST_FORMAT_TIME);
+  gst_caps_unref (caps);
+
+  return decimator;
+}
+
+static void
+cleanup_jp2kdecimator (GstElement * decimator)
+{
+  gst_element_set_state (decimator, GST_STATE_NULL);
+
+  gst_check_drop_buffers ();
+  gst_pad_set_active (mysrcpad, FALSE);
+  gst_pad_set_active (mysinkpad, FALSE);
+  gst_check_teardown_src_pad (decimator);
+  gst_check_teardown_sink_pad (decimator);
+  gst_check_teardown_element (decimator);
+}
+
+/* Writes a packet of @packet_size bytes with a SOP marker. The layer 1
+ * packets are replaced by empty ones if @decimated */
+static void
+write_packet (GstByteWriter * writer, guint16 seqno, guint tile, guint layer,
+    guint packet_size, gboolean decimated)
+{
+  guint i;
+
+  gst_byte_writer_put_uint16_be (writer, 0xff91);
+  gst_byte_writer_put_uint16_be (writer, 4);
+  gst_byte_writer_put_uint16_be (writer, seqno);
+
+  if (decimated && layer > 0) {
+    gst_byte_writer_put_uint8 (writer, 0);
+  } else {
+    gst_byte_writer_put_uint8 (writer, 0x80);
+    gst_byte_writer_put_uint8 (writer, tile);
+    gst_byte_writer_put_uint8 (writer, layer);
+    /* no 0xff, which could start a marker */
+    for (i = 3; i < packet_size; i++)
+      gst_byte_writer_put_uint8 (writer, 0x55 ^ (i & 0x7f));
+  }
+}
+
+/* Creates a single component @image_size x @image_size codestream with two
+ * quality layers and no decomposition levels, so every tile has one packet
+ * per layer. If @decimated, this is what the decimator produces with
+ * max-layers=1 */
+static GstBuffer *
+make_codestream (guint image_size, guint packet_size, gboolean decimated)
+{
+  GstByteWriter writer;
+  guint i, layer, tile_size, n_tiles;
+
+  gst_byte_writer_init (&writer);
+
+  /* SOC */
+  gst_byte_writer_put_uint16_be (&writer, 0xff4f);
+
+  /* SIZ */
+  gst_byte_writer_put_uint16_be (&writer, 0xff51);
+  gst_byte_writer_put_uint16_be (&writer, 38 + 3);
+  gst_byte_writer_put_uint16_be (&writer, 0);
+  gst_byte_writer_put_uint32_be (&writer, image_size);
+  gst_byte_writer_put_uint32_be (&writer, image_size);
+  gst_byte_writer_put_uint32_be (&writer, 0);
+  gst_byte_writer_put_uint32_be (&writer, 0);
+  gst_byte_writer_put_uint32_be (&writer, TILE_SIZE);
+  gst_byte_writer_put_uint32_be (&writer, TILE_SIZE);
+  gst_byte_writer_put_uint32_be (&writer, 0);
+  gst_byte_writer_put_uint32_be (&writer, 0);
+  gst_byte_writer_put_uint16_be (&writer, 1);
+  gst_byte_writer_put_uint8 (&writer, 7);
+  gst_byte_writer_put_uint8 (&writer, 1);
+  gst_byte_writer_put_uint8 (&writer, 1);
+
+  /* COD: SOP markers, LRCP, 2 layers, no decomposition levels */
+  gst_byte_writer_put_uint16_be (&writer, 0xff52);
+  gst_byte_writer_put_uint16_be (&writer, 12);
+  gst_byte_writer_put_uint8 (&writer, 0x02);
+  gst_byte_writer_put_uint8 (&writer, 0);
+  gst_byte_writer_put_uint16_be (&writer, 2);
+  gst_byte_writer_put_uint8 (&writer, 0);
+  gst_byte_writer_put_uint8 (&writer, 0);
+  gst_byte_writer_put_uint8 (&writer, 4);
+  gst_byte_writer_put_uint8 (&writer, 4);
+  gst_byte_writer_put_uint8 (&writer, 0);
+  gst_byte_writer_put_uint8 (&writer, 1);
+
+  /* QCD: no quantization, one subband */
+  gst_byte_writer_put_uint16_be (&writer, 0xff5c);
+  gst_byte_writer_put_uint16_be (&writer, 4);
+  gst_byte_writer_put_uint8 (&writer, 0x40);
+  gst_byte_writer_put_uint8 (&writer, 0x40);
+
+  tile_size = 12 + 2 + 2 * (6 + packet_size);
+  if (decimated)
+    tile_size -= packet_size - 1;
+
+  n_tiles = (image_size / TILE_SIZE) * (image_size / TILE_SIZE);
+  for (i = 0; i < n_tiles; i++) {
+    /* SOT */
+    gst_byte_writer_put_uint16_be (&writer, 0xff90);
+    gst_byte_writer_put_uint16_be (&writer, 10);
+    gst_byte_writer_put_uint16_be (&writer, i);
+    gst_byte_writer_put_uint32_be (&writer, tile_size);
+    gst_byte_writer_put_uint8 (&writer, 0);
+    gst_byte_writer_put_uint8 (&writer, 1);
+
+    /* SOD */
+    gst_byte_writer_put_uint16_be (&writer, 0xff93);
+
+    for (layer = 0; layer < 2; layer++)
+      write_packet (&writer, layer, i, layer, packet_size, decimated);
+  }
+
+  /* EOC */
+  gst_byte_writer_put_uint16_be (&writer, 0xffd9);
+
+  return gst_byte_writer_reset_and_get_buffer (&writer);
+}
+
+/* Returns the number of memories of @buf that point into the data of
+ * @inbuf */
+static guint
+count_referenced_memories (GstBuffer * buf, GstBuffer * inbuf)
+{
+  GstMapInfo in_map, map;
+  guint i, n = 0;
+
+  gst_buffer_map (inbuf, &in_map, GST_MAP_READ);
+  for (i = 0; i < gst_buffer_n_memory (buf); i++) {
+    GstMemory *mem = gst_buffer_peek_memory (buf, i);
+
+    gst_memory_map (mem, &map, GST_MAP_READ);
+    if (map.data >= in_map.data && map.data < in_map.data + in_map.size)
+      n++;
+    gst_memory_unmap (mem, &map);
+  }
+  gst_buffer_unmap (inbuf, &in_map);
+
+  return n;
+}
+
+static void
+check_decimation (gint n_threads, guint image_size, guint packet_size,
+    guint n_referenced)
+{
+  GstElement *decimator;
+  GstBuffer *inbuf, *outbuf, *expected;
+  GstMapInfo map, expected_map;
+
+  decimator = setup_jp2kdecimator (n_threads);
+
+  inbuf = make_codestream (image_size, packet_size, FALSE);
+  GST_BUFFER_TIMESTAMP (inbuf) = 0;
+  fail_unless_equals_int (gst_pad_push (mysrcpad, gst_buffer_ref (inbuf)),
+      GST_FLOW_OK);
+  fail_unless_equals_int (g_list_length (buffers), 1);
+  outbuf = buffers->data;
+
+  /* the tiles come out in order, with the second layer removed */
+  expected = make_codestream (image_size, packet_size, TRUE);
+  gst_buffer_map (outbuf, &map, GST_MAP_READ);
+  gst_buffer_map (expected, &expected_map, GST_MAP_READ);
+  fail_unless_equals_int (map.size, expected_map.size);
+  fail_unless (memcmp (map.data, expected_map.data, map.size) == 0);
+  gst_buffer_unmap (expected, &expected_map);
+  gst_buffer_unmap (outbuf, &map);
+  gst_buffer_unref (expected);
+
+  /* the kept packets are referenced from the input if they are large
+   * enough and there are enough memories for them, and the memories were
+   * not merged again when the tiles were put together */
+  fail_unless (gst_buffer_n_memory (outbuf) <= gst_buffer_get_max_memory ());
+  fail_unless_equals_int (count_referenced_memories (outbuf, inbuf),
+      n_referenced);
+
+  fail_unless_equals_uint64 (GST_BUFFER_TIMESTAMP (outbuf), 0);
+
+  gst_buffer_unref (inbuf);
+  cleanup_jp2kdecimator (decimator);
+}
+
+/* the tiles of a frame are decimated one after another */
+GST_START_TEST (test_decimate_tiles)
+{
+  check_decimation (1, 64, 4, 0);
+}
+
+GST_END_TEST;
+
+/* the tiles of a frame are decimated by the thread pool, and the result is
+ * the same as with a single thread */
+GST_START_TEST (test_decimate_tiles_parallel)
+{
+  check_decimation (4, 64, 4, 0);
+}
+
+GST_END_TEST;
+
+/* the first layer of each of the 4 tiles is referenced from the input, the
+ * writer needs one memory before and one after it */
+GST_START_TEST (test_decimate_reference)
+{
+  fail_unless (gst_buffer_get_max_memory () >= 2 + 4 * 3);
+  check_decimation (1, 32, 4096, 4);
+  check_decimation (4, 32, 8000, 4);
+}
+
+GST_END_TEST;
+
+/* with 16 tiles there are not enough memories to reference the packets
+ * of every tile, and everything is copied */
+GST_START_TEST (test_decimate_reference_many_tiles)
+{
+  fail_unless (gst_buffer_get_max_memory () < 2 + 16);
+  check_decimation (4, 64, 4096, 0);
+}
+
+GST_END_TEST;
+
+static Suite *
+jp2kdecimator_suite (void)
+{
+  Suite *s = suite_create ("jp2kdecimator");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_decimate_tiles);
+  tcase_add_test (tc_chain, test_decimate_tiles_parallel);
+  tcase_add_test (tc_chain, test_decimate_reference);
+  tcase_add_test (tc_chain, test_decimate_reference_many_tiles);
+
+  return s;
+}
+
+GST_CHECK_MAIN (jp2kdecimator);
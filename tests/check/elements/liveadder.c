@@ -0,0 +1,310 @@
+/* GStreamer
+ *
+ * unit test for liveadder
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <gst/check/gsttestclock.h>
+#include <gst/audio/audio.h>
+
+#define RATE 8000
+
+#define AUDIO_CAPS_STRING "audio/x-raw, " \
+                           "format = (string) " GST_AUDIO_NE (S16) ", "\
+                           "layout = (string) interleaved, " \
+                           "rate = (int) 8000, " \
+                           "channels = (int) 1"
+
+static GstPad *mysrcpads[2], *mysinkpad;
+static GstPad *adder_sinkpads[2];
+
+static GstStaticPadTemplate sinktemplate = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (AUDIO_CAPS_STRING));
+
+static GstStaticPadTemplate srctemplate = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (AUDIO_CAPS_STRING));
+
+static GstElement *
+setup_liveadder (gint n_inputs)
+{
+  GstElement *adder;
+  gint i;
+
+  adder = gst_check_setup_element ("liveadder");
+  mysinkpad = gst_check_setup_sink_pad (adder, &sinktemplate);
+  gst_pad_set_active (mysinkpad, TRUE);
+
+  for (i = 0; i < n_inputs; i++) {
+    adder_sinkpads[i] = gst_element_get_request_pad (adder, "sink_%u");
+    fail_unless (adder_sinkpads[i] != NULL);
+    mysrcpads[i] = gst_pad_new_from_static_template (&srctemplate, "src");
+    fail_unless (gst_pad_link (mysrcpads[i],
+            adder_sinkpads[i]) == GST_PAD_LINK_OK);
+    gst_pad_set_active (mysrcpads[i], TRUE);
+  }
+
+  return adder;
+}
+
+static void
+setup_input_events (GstElement * adder, gint n_inputs)
+{
+  GstCaps *caps;
+  gint i;
+
+  caps = gst_caps_from_string (AUDIO_CAPS_STRING);
+  for (i = 0; i < n_inputs; i++)
+    gst_check_setup_events (mysrcpads[i], adder, caps, GST_FORMAT_TIME);
+  gst_caps_unref (caps);
+}
+
+static void
+cleanup_liveadder (GstElement * adder, gint n_inputs)
+{
+  gint i;
+
+  gst_element_set_state (adder, GST_STATE_NULL);
+
+  for (i = 0; i < n_inputs; i++) {
+    gst_pad_set_active (mysrcpads[i], FALSE);
+    gst_pad_unlink (mysrcpads[i], adder_sinkpads[i]);
+    gst_element_release_request_pad (adder, adder_sinkpads[i]);
+    gst_object_unref (adder_sinkpads[i]);
+    gst_object_unref (mysrcpads[i]);
+  }
+
+  gst_check_drop_buffers ();
+  gst_pad_set_active (mysinkpad, FALSE);
+  gst_check_teardown_sink_pad (adder);
+  gst_check_teardown_element (adder);
+}
+
+static GstBuffer *
+make_buffer (guint64 pos, guint n_samples, gint16 value, gboolean ramp)
+{
+  GstBuffer *buffer;
+  GstMapInfo map;
+  gint16 *data;
+  guint i;
+
+  buffer = gst_buffer_new_allocate (NULL, n_samples * sizeof (gint16), NULL);
+  gst_buffer_map (buffer, &map, GST_MAP_WRITE);
+  data = (gint16 *) map.data;
+  for (i = 0; i < n_samples; i++)
+    data[i] = ramp ? (gint16) ((pos + i) & 0x7fff) : value;
+  gst_buffer_unmap (buffer, &map);
+
+  GST_BUFFER_TIMESTAMP (buffer) =
+      gst_util_uint64_scale_int (pos, GST_SECOND, RATE);
+  GST_BUFFER_DURATION (buffer) =
+      gst_util_uint64_scale_int (pos + n_samples, GST_SECOND, RATE) -
+      GST_BUFFER_TIMESTAMP (buffer);
+
+  return buffer;
+}
+
+static guint
+count_samples (void)
+{
+  GList *l;
+  guint n_samples = 0;
+
+  for (l = buffers; l; l = l->next)
+    n_samples += gst_buffer_get_size (GST_BUFFER (l->data)) / sizeof (gint16);
+
+  return n_samples;
+}
+
+static void
+wait_for_samples (guint n_samples)
+{
+  g_mutex_lock (&check_mutex);
+  while (count_samples () < n_samples)
+    g_cond_wait (&check_cond, &check_mutex);
+  g_mutex_unlock (&check_mutex);
+}
+
+/* checks that the output is contiguous from @pos on and copies the samples
+ * to @out */
+static void
+collect_output (guint64 pos, gint16 * out, guint n_samples)
+{
+  GList *l;
+  guint offset = 0;
+
+  for (l = buffers; l; l = l->next) {
+    GstBuffer *buffer = GST_BUFFER (l->data);
+    GstMapInfo map;
+
+    fail_unless_equals_uint64 (GST_BUFFER_TIMESTAMP (buffer),
+        gst_util_uint64_scale_int (pos + offset, GST_SECOND, RATE));
+
+    gst_buffer_map (buffer, &map, GST_MAP_READ);
+    fail_unless (offset + map.size / sizeof (gint16) <= n_samples);
+    memcpy (out + offset, map.data, map.size);
+    offset += map.size / sizeof (gint16);
+    gst_buffer_unmap (buffer, &map);
+  }
+
+  fail_unless_equals_int (offset, n_samples);
+}
+
+/* buffers of random size with some timestamp jitter must come out
+ * contiguous and unchanged */
+GST_START_TEST (test_jitter)
+{
+  GstElement *adder;
+  GRand *rand;
+  gint16 *out;
+  guint64 pos = 0;
+  guint i;
+
+  adder = setup_liveadder (1);
+  fail_unless (gst_element_set_state (adder,
+          GST_STATE_PAUSED) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to paused");
+  setup_input_events (adder, 1);
+
+  rand = g_rand_new_with_seed (42);
+  for (i = 0; i < 200; i++) {
+    guint n_samples = g_rand_int_range (rand, 1, 300);
+    GstBuffer *buffer = make_buffer (pos, n_samples, 0, TRUE);
+
+    /* less than the 10ms of drift the element corrects */
+    if (GST_BUFFER_TIMESTAMP (buffer) > GST_MSECOND)
+      GST_BUFFER_TIMESTAMP (buffer) += g_rand_int_range (rand, -GST_MSECOND,
+          GST_MSECOND);
+
+    fail_unless_equals_int (gst_pad_push (mysrcpads[0], buffer), GST_FLOW_OK);
+    pos += n_samples;
+  }
+  g_rand_free (rand);
+
+  wait_for_samples (pos);
+
+  out = g_new (gint16, pos);
+  collect_output (0, out, pos);
+  for (i = 0; i < pos; i++)
+    fail_unless_equals_int (out[i], (gint16) (i & 0x7fff));
+  g_free (out);
+
+  cleanup_liveadder (adder, 1);
+}
+
+GST_END_TEST;
+
+static GstElement *
+setup_clocked_liveadder (GstClock ** clock)
+{
+  GstElement *adder;
+
+  adder = setup_liveadder (2);
+  g_object_set (adder, "latency", 20, NULL);
+
+  *clock = gst_test_clock_new ();
+  gst_element_set_clock (adder, *clock);
+  gst_element_set_base_time (adder, 0);
+  fail_unless (gst_element_set_state (adder,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+  setup_input_events (adder, 2);
+
+  return adder;
+}
+
+/* overlapping inputs are mixed with clipping, the rest is passed through */
+GST_START_TEST (test_mix)
+{
+  GstElement *adder;
+  GstClock *clock;
+  gint16 out[120];
+  guint i;
+
+  adder = setup_clocked_liveadder (&clock);
+
+  /* 0-10ms and 5-15ms, released once the clock reaches 20ms */
+  fail_unless_equals_int (gst_pad_push (mysrcpads[0], make_buffer (0, 80,
+              20000, FALSE)), GST_FLOW_OK);
+  fail_unless_equals_int (gst_pad_push (mysrcpads[1], make_buffer (40, 80,
+              20000, FALSE)), GST_FLOW_OK);
+
+  gst_test_clock_set_time (GST_TEST_CLOCK (clock), GST_SECOND);
+  wait_for_samples (120);
+
+  collect_output (0, out, 120);
+  for (i = 0; i < 120; i++)
+    fail_unless_equals_int (out[i], (i >= 40 && i < 80) ? G_MAXINT16 : 20000);
+
+  cleanup_liveadder (adder, 2);
+  gst_object_unref (clock);
+}
+
+GST_END_TEST;
+
+/* data before what was already pushed is dropped */
+GST_START_TEST (test_late_buffer)
+{
+  GstElement *adder;
+  GstClock *clock;
+  gint16 out[160];
+  guint i;
+
+  adder = setup_clocked_liveadder (&clock);
+
+  fail_unless_equals_int (gst_pad_push (mysrcpads[0], make_buffer (0, 120,
+              1000, FALSE)), GST_FLOW_OK);
+  gst_test_clock_set_time (GST_TEST_CLOCK (clock), GST_SECOND);
+  wait_for_samples (120);
+
+  /* completely late */
+  fail_unless_equals_int (gst_pad_push (mysrcpads[1], make_buffer (0, 80,
+              2000, FALSE)), GST_FLOW_OK);
+  /* partially late, only the last 40 samples are used */
+  fail_unless_equals_int (gst_pad_push (mysrcpads[1], make_buffer (80, 80,
+              2000, FALSE)), GST_FLOW_OK);
+  wait_for_samples (160);
+
+  collect_output (0, out, 160);
+  for (i = 0; i < 160; i++)
+    fail_unless_equals_int (out[i], i < 120 ? 1000 : 2000);
+
+  cleanup_liveadder (adder, 2);
+  gst_object_unref (clock);
+}
+
+GST_END_TEST;
+
+static Suite *
+liveadder_suite (void)
+{
+  Suite *s = suite_create ("liveadder");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_jitter);
+  tcase_add_test (tc_chain, test_mix);
+  tcase_add_test (tc_chain, test_late_buffer);
+
+  return s;
+}
+
+GST_CHECK_MAIN (liveadder);
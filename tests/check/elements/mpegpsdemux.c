@@ -0,0 +1,368 @@
+/* GStreamer
+ *
+ * unit test for mpegpsdemux
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <glib/gstdio.h>
+#include <unistd.h>
+
+/* one pack every 200ms, starting at 1s, with a keyframe every 10 packs */
+#define N_PACKS 100
+#define PACK_INTERVAL 18000
+#define FIRST_SCR 90000
+#define PTS_DELAY 9000
+#define KEYFRAME_INTERVAL 10
+#define PAYLOAD_SIZE 8
+#define PACK_SIZE (14 + 14 + PAYLOAD_SIZE)
+
+#define PACK_SCR(n) (FIRST_SCR + (n) * PACK_INTERVAL)
+#define PACK_PTS(n) \
+    gst_util_uint64_scale (PACK_SCR (n) + PTS_DELAY, GST_MSECOND, 90)
+
+static GMutex received_lock;
+static GList *received;
+
+static void
+write_pack_header (guint8 * data, guint64 scr)
+{
+  guint64 v;
+
+  GST_WRITE_UINT32_BE (data, 0x000001ba);
+
+  /* '01' ! scr:3 ! 1 ! scr:15 ! 1 ! scr:15 ! 1 ! scr_ext:9 ! 1 */
+  v = G_GUINT64_CONSTANT (1) << 46;
+  v |= ((scr >> 30) & 0x7) << 43;
+  v |= G_GUINT64_CONSTANT (1) << 42;
+  v |= ((scr >> 15) & 0x7fff) << 27;
+  v |= G_GUINT64_CONSTANT (1) << 26;
+  v |= (scr & 0x7fff) << 11;
+  v |= G_GUINT64_CONSTANT (1) << 10;
+  v |= 1;
+  GST_WRITE_UINT16_BE (data + 4, v >> 32);
+  GST_WRITE_UINT32_BE (data + 6, v & 0xffffffff);
+
+  /* mux_rate:22 ! 11 ! reserved:5 ! no stuffing */
+  GST_WRITE_UINT32_BE (data + 10, (0x3fff << 10) | 0x3f8);
+}
+
+static void
+write_pes (guint8 * data, guint64 pts, guint n)
+{
+  guint64 v;
+
+  GST_WRITE_UINT32_BE (data, 0x000001e0);
+  GST_WRITE_UINT16_BE (data + 4, 3 + 5 + PAYLOAD_SIZE);
+  data[6] = 0x80;
+  data[7] = 0x80;
+  data[8] = 5;
+
+  /* '0010' ! pts:3 ! 1 ! pts:15 ! 1 ! pts:15 ! 1 */
+  v = G_GUINT64_CONSTANT (2) << 36;
+  v |= ((pts >> 30) & 0x7) << 33;
+  v |= G_GUINT64_CONSTANT (1) << 32;
+  v |= ((pts >> 15) & 0x7fff) << 17;
+  v |= G_GUINT64_CONSTANT (1) << 16;
+  v |= (pts & 0x7fff) << 1;
+  v |= 1;
+  data[9] = v >> 32;
+  GST_WRITE_UINT32_BE (data + 10, v & 0xffffffff);
+
+  /* a sequence header on keyframes, a picture otherwise, and the number of
+   * the pack */
+  if (n % KEYFRAME_INTERVAL == 0)
+    GST_WRITE_UINT32_BE (data + 14, 0x000001b3);
+  else
+    GST_WRITE_UINT32_BE (data + 14, 0x00000100);
+  data[18] = n;
+  data[19] = data[20] = data[21] = 0xff;
+}
+
+/* Writes a program stream of N_PACKS packs with one video PES each */
+static gchar *
+write_stream (void)
+{
+  GByteArray *data;
+  GError *error = NULL;
+  gchar *filename;
+  gint fd, i;
+
+  data = g_byte_array_new ();
+
+  for (i = 0; i < N_PACKS; i++) {
+    guint8 pack[PACK_SIZE];
+
+    write_pack_header (pack, PACK_SCR (i));
+    write_pes (pack + 14, PACK_SCR (i) + PTS_DELAY, i);
+    g_byte_array_append (data, pack, sizeof (pack));
+  }
+
+  fd = g_file_open_tmp ("mpegpsdemux-XXXXXX.mpg", &filename, &error);
+  fail_unless (fd >= 0, "could not create temp file: %s",
+      error ? error->message : "");
+  close (fd);
+  fail_unless (g_file_set_contents (filename, (const gchar *) data->data,
+          data->len, NULL));
+  g_byte_array_unref (data);
+
+  return filename;
+}
+
+static void
+handoff_cb (GstElement * sink, GstBuffer * buffer, GstPad * pad,
+    gpointer user_data)
+{
+  g_mutex_lock (&received_lock);
+  received = g_list_append (received, gst_buffer_ref (buffer));
+  g_mutex_unlock (&received_lock);
+}
+
+static void
+clear_received (void)
+{
+  g_mutex_lock (&received_lock);
+  g_list_free_full (received, (GDestroyNotify) gst_buffer_unref);
+  received = NULL;
+  g_mutex_unlock (&received_lock);
+}
+
+static GstElement *
+setup_pipeline (const gchar * filename)
+{
+  GstElement *pipeline, *sink;
+  gchar *desc;
+
+  desc = g_strdup_printf ("filesrc location=\"%s\" ! mpegpsdemux name=demux "
+      "! fakesink name=sink sync=false signal-handoffs=true", filename);
+  pipeline = gst_parse_launch (desc, NULL);
+  g_free (desc);
+  fail_unless (pipeline != NULL);
+
+  sink = gst_bin_get_by_name (GST_BIN (pipeline), "sink");
+  g_signal_connect (sink, "handoff", G_CALLBACK (handoff_cb), NULL);
+  gst_object_unref (sink);
+
+  received = NULL;
+
+  return pipeline;
+}
+
+static void
+cleanup_pipeline (GstElement * pipeline)
+{
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+
+  clear_received ();
+}
+
+static void
+run_to_eos (GstElement * pipeline)
+{
+  GstMessage *msg;
+  GstBus *bus;
+
+  fail_unless (gst_element_set_state (pipeline,
+          GST_STATE_PLAYING) != GST_STATE_CHANGE_FAILURE);
+
+  bus = gst_element_get_bus (pipeline);
+  msg = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  fail_unless_equals_int (GST_MESSAGE_TYPE (msg), GST_MESSAGE_EOS);
+  gst_message_unref (msg);
+  gst_object_unref (bus);
+}
+
+static void
+pause_pipeline (GstElement * pipeline)
+{
+  fail_unless (gst_element_set_state (pipeline,
+          GST_STATE_PAUSED) != GST_STATE_CHANGE_FAILURE);
+  fail_unless_equals_int (gst_element_get_state (pipeline, NULL, NULL,
+          GST_CLOCK_TIME_NONE), GST_STATE_CHANGE_SUCCESS);
+}
+
+static void
+seek_and_run (GstElement * pipeline, GstSeekFlags flags, GstClockTime start)
+{
+  clear_received ();
+
+  pause_pipeline (pipeline);
+  fail_unless (gst_element_seek (pipeline, 1.0, GST_FORMAT_TIME,
+          GST_SEEK_FLAG_FLUSH | flags, GST_SEEK_TYPE_SET, start,
+          GST_SEEK_TYPE_NONE, -1));
+  fail_unless_equals_int (gst_element_get_state (pipeline, NULL, NULL,
+          GST_CLOCK_TIME_NONE), GST_STATE_CHANGE_SUCCESS);
+
+  run_to_eos (pipeline);
+}
+
+/* checks that the packs from @first to the last one were received */
+static void
+check_received (guint first)
+{
+  GList *walk;
+  guint i;
+
+  g_mutex_lock (&received_lock);
+  fail_unless_equals_int (g_list_length (received), N_PACKS - first);
+  for (walk = received, i = first; walk; walk = walk->next, i++) {
+    GstBuffer *buffer = walk->data;
+    GstMapInfo map;
+
+    fail_unless_equals_uint64 (GST_BUFFER_PTS (buffer), PACK_PTS (i));
+    gst_buffer_map (buffer, &map, GST_MAP_READ);
+    fail_unless_equals_int (map.size, PAYLOAD_SIZE);
+    fail_unless_equals_int (map.data[4], i);
+    gst_buffer_unmap (buffer, &map);
+  }
+  g_mutex_unlock (&received_lock);
+}
+
+static GstBuffer *
+query_index (GstElement * pipeline, GstBuffer * entries)
+{
+  GstElement *demux;
+  GstStructure *structure;
+  GstQuery *query;
+  GstPad *pad;
+  GstBuffer *result = NULL;
+
+  structure = gst_structure_new_empty ("mpegpsdemux-index");
+  if (entries)
+    gst_structure_set (structure, "entries", GST_TYPE_BUFFER, entries, NULL);
+  query = gst_query_new_custom (GST_QUERY_CUSTOM, structure);
+
+  demux = gst_bin_get_by_name (GST_BIN (pipeline), "demux");
+  pad = gst_element_get_static_pad (demux, "video_e0");
+  fail_unless (pad != NULL);
+  fail_unless (gst_pad_query (pad, query));
+  gst_object_unref (pad);
+  gst_object_unref (demux);
+
+  if (!entries) {
+    fail_unless (gst_structure_get (gst_query_get_structure (query),
+            "entries", GST_TYPE_BUFFER, &result, NULL));
+  }
+  gst_query_unref (query);
+
+  return result;
+}
+
+/* a seek goes to the first pack at or after the position, a key unit seek
+ * goes to the keyframe before it */
+GST_START_TEST (test_seek)
+{
+  GstElement *pipeline;
+  gchar *filename;
+
+  filename = write_stream ();
+  pipeline = setup_pipeline (filename);
+
+  /* build the index */
+  run_to_eos (pipeline);
+  check_received (0);
+
+  /* pack 25 is at 5s and pack 26 at 5.2s from the start */
+  seek_and_run (pipeline, 0, 5100 * GST_MSECOND);
+  check_received (26);
+
+  seek_and_run (pipeline, GST_SEEK_FLAG_KEY_UNIT, 5100 * GST_MSECOND);
+  check_received (20);
+
+  cleanup_pipeline (pipeline);
+  g_unlink (filename);
+  g_free (filename);
+}
+
+GST_END_TEST;
+
+/* the index of a stream that was played can be saved, and be loaded into
+ * another demuxer that did not see the stream yet */
+GST_START_TEST (test_index_query)
+{
+  GstElement *pipeline;
+  GstBuffer *entries;
+  GstMapInfo map;
+  gchar *filename;
+  guint64 last_offset = 0;
+  guint i, n_keyframes = 0;
+
+  filename = write_stream ();
+  pipeline = setup_pipeline (filename);
+
+  run_to_eos (pipeline);
+  entries = query_index (pipeline, NULL);
+  fail_unless (entries != NULL);
+
+  /* every entry points to a pack, all keyframes are in it */
+  gst_buffer_map (entries, &map, GST_MAP_READ);
+  fail_unless (map.size > 0);
+  fail_unless_equals_int (map.size % 16, 0);
+  for (i = 0; i < map.size; i += 16) {
+    guint64 scr = GST_READ_UINT64_BE (map.data + i);
+    guint64 offset = GST_READ_UINT64_BE (map.data + i + 8);
+    gboolean keyframe = (scr >> 63) != 0;
+    guint n = offset / PACK_SIZE;
+
+    scr &= ~(G_GUINT64_CONSTANT (1) << 63);
+    fail_unless_equals_uint64 (offset, n * PACK_SIZE);
+    fail_unless_equals_uint64 (scr, PACK_SCR (n));
+    fail_unless_equals_int (keyframe, n % KEYFRAME_INTERVAL == 0);
+    fail_unless (i == 0 || offset > last_offset);
+    last_offset = offset;
+
+    if (keyframe)
+      n_keyframes++;
+  }
+  gst_buffer_unmap (entries, &map);
+  fail_unless_equals_int (n_keyframes, N_PACKS / KEYFRAME_INTERVAL);
+
+  cleanup_pipeline (pipeline);
+
+  /* the keyframe at 14s is more than 10s after the only one the new demuxer
+   * saw, it is only found through the loaded index */
+  pipeline = setup_pipeline (filename);
+  pause_pipeline (pipeline);
+  query_index (pipeline, entries);
+  gst_buffer_unref (entries);
+
+  seek_and_run (pipeline, GST_SEEK_FLAG_KEY_UNIT, 15100 * GST_MSECOND);
+  check_received (70);
+
+  cleanup_pipeline (pipeline);
+  g_unlink (filename);
+  g_free (filename);
+}
+
+GST_END_TEST;
+
+static Suite *
+mpegpsdemux_suite (void)
+{
+  Suite *s = suite_create ("mpegpsdemux");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_seek);
+  tcase_add_test (tc_chain, test_index_query);
+
+  return s;
+}
+
+GST_CHECK_MAIN (mpegpsdemux);
@@ -0,0 +1,226 @@
+/* GStreamer
+ *
+ * unit test for mpegpsmux
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+
+#define VIDEO_CAPS_STRING "video/mpeg, mpegversion = (int) 2, " \
+    "systemstream = (boolean) false"
+
+/* the payload of a PES packet written by the muxer is at most this large */
+#define MAX_PES_PAYLOAD 65500
+
+static GstPad *mysrcpad, *mysinkpad, *mux_sinkpad;
+static GList *lists;
+
+static GstStaticPadTemplate sinktemplate = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("video/mpeg, systemstream = (boolean) true"));
+
+static GstStaticPadTemplate srctemplate = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (VIDEO_CAPS_STRING));
+
+static GstPadProbeReturn
+list_probe (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+  GstBufferList *list = GST_PAD_PROBE_INFO_BUFFER_LIST (info);
+
+  lists = g_list_append (lists, gst_buffer_list_ref (list));
+
+  return GST_PAD_PROBE_OK;
+}
+
+static GstElement *
+setup_mpegpsmux (void)
+{
+  GstElement *mux;
+  GstCaps *caps;
+
+  mux = gst_check_setup_element ("mpegpsmux");
+
+  mysrcpad = gst_pad_new_from_static_template (&srctemplate, "src");
+  mux_sinkpad = gst_element_get_request_pad (mux, "sink_%u");
+  fail_unless (mux_sinkpad != NULL);
+  fail_unless_equals_int (gst_pad_link (mysrcpad, mux_sinkpad),
+      GST_PAD_LINK_OK);
+
+  mysinkpad = gst_check_setup_sink_pad (mux, &sinktemplate);
+  gst_pad_add_probe (mysinkpad, GST_PAD_PROBE_TYPE_BUFFER_LIST, list_probe,
+      NULL, NULL);
+  lists = NULL;
+
+  gst_pad_set_active (mysrcpad, TRUE);
+  gst_pad_set_active (mysinkpad, TRUE);
+
+  fail_unless (gst_element_set_state (mux,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+
+  caps = gst_caps_from_string (VIDEO_CAPS_STRING);
+  gst_check_setup_events (mysrcpad, mux, caps, GST_FORMAT_TIME);
+  gst_caps_unref (caps);
+
+  return mux;
+}
+
+static void
+cleanup_mpegpsmux (GstElement * mux)
+{
+  gst_element_set_state (mux, GST_STATE_NULL);
+
+  g_list_free_full (lists, (GDestroyNotify) gst_buffer_list_unref);
+  lists = NULL;
+
+  gst_check_drop_buffers ();
+  gst_pad_set_active (mysrcpad, FALSE);
+  gst_pad_set_active (mysinkpad, FALSE);
+  gst_check_teardown_sink_pad (mux);
+
+  gst_pad_unlink (mysrcpad, mux_sinkpad);
+  gst_object_unref (mysrcpad);
+  gst_element_release_request_pad (mux, mux_sinkpad);
+  gst_object_unref (mux_sinkpad);
+
+  gst_check_teardown_element (mux);
+}
+
+static GstBuffer *
+make_buffer (gsize size, GstClockTime pts, gboolean keyframe)
+{
+  GstBuffer *buffer;
+
+  buffer = gst_buffer_new_allocate (NULL, size, NULL);
+  gst_buffer_memset (buffer, 0, 0x55, size);
+  GST_BUFFER_PTS (buffer) = pts;
+  if (!keyframe)
+    GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DELTA_UNIT);
+
+  return buffer;
+}
+
+/* checks that the payload of the PES packet in @outbuf is the part of
+ * @inbuf at @offset, without having been copied */
+static void
+check_payload (GstBuffer * outbuf, GstBuffer * inbuf, gsize offset, gsize size)
+{
+  GstMemory *mem;
+  GstMapInfo map, inmap;
+
+  /* the headers, followed by the payload */
+  fail_unless_equals_int (gst_buffer_n_memory (outbuf), 2);
+  mem = gst_buffer_peek_memory (outbuf, 1);
+
+  fail_unless (gst_memory_map (mem, &map, GST_MAP_READ));
+  fail_unless (gst_buffer_map (inbuf, &inmap, GST_MAP_READ));
+  fail_unless_equals_int (map.size, size);
+  fail_unless (map.data == inmap.data + offset);
+  gst_buffer_unmap (inbuf, &inmap);
+  gst_memory_unmap (mem, &map);
+}
+
+/* every input buffer is pushed as one list, the PES packets reference the
+ * input data and carry the timestamp of the input buffer */
+GST_START_TEST (test_push_list)
+{
+  GstElement *mux;
+  GstBuffer *inbuf;
+  GstBufferList *list;
+  guint i;
+
+  mux = setup_mpegpsmux ();
+
+  for (i = 0; i < 3; i++) {
+    inbuf = make_buffer (1000, i * 40 * GST_MSECOND, i == 0);
+    gst_buffer_ref (inbuf);
+    fail_unless_equals_int (gst_pad_push (mysrcpad, inbuf), GST_FLOW_OK);
+
+    fail_unless_equals_int (g_list_length (lists), i + 1);
+    list = g_list_last (lists)->data;
+    fail_unless_equals_int (gst_buffer_list_length (list), 1);
+    fail_unless_equals_int (g_list_length (buffers), i + 1);
+    fail_unless (gst_buffer_list_get (list, 0) == g_list_last (buffers)->data);
+
+    fail_unless_equals_uint64 (GST_BUFFER_TIMESTAMP (gst_buffer_list_get (list,
+                0)), i * 40 * GST_MSECOND);
+    check_payload (gst_buffer_list_get (list, 0), inbuf, 0, 1000);
+    gst_buffer_unref (inbuf);
+  }
+
+  /* the program end code */
+  fail_unless (gst_pad_push_event (mysrcpad, gst_event_new_eos ()));
+  fail_unless_equals_int (g_list_length (lists), 4);
+  list = g_list_last (lists)->data;
+  fail_unless_equals_int (gst_buffer_list_length (list), 1);
+  fail_unless_equals_int (gst_buffer_get_size (gst_buffer_list_get (list, 0)),
+      4);
+
+  cleanup_mpegpsmux (mux);
+}
+
+GST_END_TEST;
+
+/* an input buffer that does not fit into one PES packet is split over
+ * several, which are pushed together */
+GST_START_TEST (test_push_list_split)
+{
+  GstElement *mux;
+  GstBuffer *inbuf;
+  GstBufferList *list;
+  gsize size = MAX_PES_PAYLOAD + 1000;
+  guint i;
+
+  mux = setup_mpegpsmux ();
+
+  inbuf = make_buffer (size, 0, TRUE);
+  gst_buffer_ref (inbuf);
+  fail_unless_equals_int (gst_pad_push (mysrcpad, inbuf), GST_FLOW_OK);
+
+  fail_unless_equals_int (g_list_length (lists), 1);
+  list = lists->data;
+  fail_unless_equals_int (gst_buffer_list_length (list), 2);
+
+  for (i = 0; i < 2; i++)
+    fail_unless_equals_uint64 (GST_BUFFER_TIMESTAMP (gst_buffer_list_get (list,
+                i)), 0);
+  check_payload (gst_buffer_list_get (list, 0), inbuf, 0, MAX_PES_PAYLOAD);
+  check_payload (gst_buffer_list_get (list, 1), inbuf, MAX_PES_PAYLOAD, 1000);
+  gst_buffer_unref (inbuf);
+
+  cleanup_mpegpsmux (mux);
+}
+
+GST_END_TEST;
+
+static Suite *
+mpegpsmux_suite (void)
+{
+  Suite *s = suite_create ("mpegpsmux");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_push_list);
+  tcase_add_test (tc_chain, test_push_list_split);
+
+  return s;
+}
+
+GST_CHECK_MAIN (mpegpsmux);
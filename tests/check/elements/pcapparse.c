@@ -0,0 +1,280 @@
+/* GStreamer
+ *
+ * unit test for pcapparse
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <glib/gstdio.h>
+#include <unistd.h>
+
+#define N_PACKETS 40
+#define PACKET_INTERVAL (100 * GST_MSECOND)
+#define PAYLOAD_SIZE 4
+
+static GMutex received_lock;
+static GList *received;
+
+/* Writes a capture of N_PACKETS udp packets, one every 100ms, that
+ * alternate between source port 5000 and 5001. The payload of every packet
+ * holds its number. */
+static gchar *
+write_capture (void)
+{
+  GByteArray *data;
+  GError *error = NULL;
+  gchar *filename;
+  guint8 header[24] = { 0, };
+  gint fd, i;
+
+  data = g_byte_array_new ();
+
+  GST_WRITE_UINT32_LE (header, 0xa1b2c3d4);
+  GST_WRITE_UINT16_LE (header + 4, 2);
+  GST_WRITE_UINT16_LE (header + 6, 4);
+  GST_WRITE_UINT32_LE (header + 16, 65535);
+  GST_WRITE_UINT32_LE (header + 20, 1);
+  g_byte_array_append (data, header, sizeof (header));
+
+  for (i = 0; i < N_PACKETS; i++) {
+    guint8 record[16 + 14 + 20 + 8 + PAYLOAD_SIZE] = { 0, };
+    guint8 *eth = record + 16, *ip = eth + 14, *udp = ip + 20;
+    GstClockTime ts = 1000 * GST_SECOND + i * PACKET_INTERVAL;
+
+    GST_WRITE_UINT32_LE (record, ts / GST_SECOND);
+    GST_WRITE_UINT32_LE (record + 4, (ts % GST_SECOND) / GST_USECOND);
+    GST_WRITE_UINT32_LE (record + 8, sizeof (record) - 16);
+    GST_WRITE_UINT32_LE (record + 12, sizeof (record) - 16);
+
+    GST_WRITE_UINT16_BE (eth + 12, 0x0800);
+
+    ip[0] = 0x45;
+    GST_WRITE_UINT16_BE (ip + 2, 20 + 8 + PAYLOAD_SIZE);
+    ip[8] = 64;
+    ip[9] = 17;
+    GST_WRITE_UINT32_BE (ip + 12, 0x0a000001);
+    GST_WRITE_UINT32_BE (ip + 16, 0x0a000002);
+
+    GST_WRITE_UINT16_BE (udp, 5000 + (i & 1));
+    GST_WRITE_UINT16_BE (udp + 2, 6000);
+    GST_WRITE_UINT16_BE (udp + 4, 8 + PAYLOAD_SIZE);
+    GST_WRITE_UINT32_BE (udp + 8, i);
+
+    g_byte_array_append (data, record, sizeof (record));
+  }
+
+  fd = g_file_open_tmp ("pcapparse-XXXXXX.pcap", &filename, &error);
+  fail_unless (fd >= 0, "could not create temp file: %s",
+      error ? error->message : "");
+  close (fd);
+  fail_unless (g_file_set_contents (filename, (const gchar *) data->data,
+          data->len, NULL));
+  g_byte_array_unref (data);
+
+  return filename;
+}
+
+static void
+handoff_cb (GstElement * sink, GstBuffer * buffer, GstPad * pad,
+    gpointer user_data)
+{
+  g_mutex_lock (&received_lock);
+  received = g_list_append (received, gst_buffer_ref (buffer));
+  g_mutex_unlock (&received_lock);
+}
+
+static GstElement *
+setup_pipeline (const gchar * filename, const gchar * filter)
+{
+  GstElement *pipeline, *sink;
+  gchar *desc;
+
+  desc = g_strdup_printf ("filesrc location=\"%s\" ! pcapparse ts-offset=0 %s "
+      "! fakesink name=sink sync=false signal-handoffs=true", filename, filter);
+  pipeline = gst_parse_launch (desc, NULL);
+  g_free (desc);
+  fail_unless (pipeline != NULL);
+
+  sink = gst_bin_get_by_name (GST_BIN (pipeline), "sink");
+  g_signal_connect (sink, "handoff", G_CALLBACK (handoff_cb), NULL);
+  gst_object_unref (sink);
+
+  received = NULL;
+
+  return pipeline;
+}
+
+static void
+run_to_eos (GstElement * pipeline)
+{
+  GstMessage *msg;
+  GstBus *bus;
+
+  fail_unless (gst_element_set_state (pipeline,
+          GST_STATE_PLAYING) != GST_STATE_CHANGE_FAILURE);
+
+  bus = gst_element_get_bus (pipeline);
+  msg = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  fail_unless_equals_int (GST_MESSAGE_TYPE (msg), GST_MESSAGE_EOS);
+  gst_message_unref (msg);
+  gst_object_unref (bus);
+}
+
+static void
+check_received (guint first, guint step, guint n)
+{
+  GList *walk;
+  guint i;
+
+  g_mutex_lock (&received_lock);
+  fail_unless_equals_int (g_list_length (received), n);
+  for (walk = received, i = first; walk; walk = walk->next, i += step) {
+    GstBuffer *buffer = walk->data;
+    GstMapInfo map;
+
+    fail_unless_equals_uint64 (GST_BUFFER_TIMESTAMP (buffer),
+        i * PACKET_INTERVAL);
+    gst_buffer_map (buffer, &map, GST_MAP_READ);
+    fail_unless_equals_int (map.size, PAYLOAD_SIZE);
+    fail_unless_equals_int (GST_READ_UINT32_BE (map.data), i);
+    gst_buffer_unmap (buffer, &map);
+  }
+  g_mutex_unlock (&received_lock);
+}
+
+static void
+cleanup_pipeline (GstElement * pipeline, gchar * filename)
+{
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+
+  g_list_free_full (received, (GDestroyNotify) gst_buffer_unref);
+  received = NULL;
+
+  g_unlink (filename);
+  g_free (filename);
+}
+
+/* the filter passes the packets of one source port only */
+GST_START_TEST (test_filter)
+{
+  GstElement *pipeline;
+  gchar *filename;
+
+  filename = write_capture ();
+  pipeline = setup_pipeline (filename, "src-port=5001 dst-ip=10.0.0.2");
+
+  run_to_eos (pipeline);
+  check_received (1, 2, N_PACKETS / 2);
+
+  cleanup_pipeline (pipeline, filename);
+}
+
+GST_END_TEST;
+
+/* a filter that does not match anything passes nothing */
+GST_START_TEST (test_filter_no_match)
+{
+  GstElement *pipeline;
+  gchar *filename;
+
+  filename = write_capture ();
+  pipeline = setup_pipeline (filename, "src-port=5000 src-ip=10.0.0.2");
+
+  run_to_eos (pipeline);
+  check_received (0, 2, 0);
+
+  cleanup_pipeline (pipeline, filename);
+}
+
+GST_END_TEST;
+
+/* seeking in pull mode goes through the index to the first packet at or
+ * after the start, and stops after the stop position */
+GST_START_TEST (test_seek)
+{
+  GstElement *pipeline;
+  gchar *filename;
+  GstQuery *query;
+  gboolean seekable;
+
+  filename = write_capture ();
+  pipeline = setup_pipeline (filename, "src-port=5000");
+
+  fail_unless (gst_element_set_state (pipeline,
+          GST_STATE_PAUSED) != GST_STATE_CHANGE_FAILURE);
+  fail_unless_equals_int (gst_element_get_state (pipeline, NULL, NULL,
+          GST_CLOCK_TIME_NONE), GST_STATE_CHANGE_SUCCESS);
+
+  query = gst_query_new_seeking (GST_FORMAT_TIME);
+  fail_unless (gst_element_query (pipeline, query));
+  gst_query_parse_seeking (query, NULL, &seekable, NULL, NULL);
+  fail_unless (seekable);
+  gst_query_unref (query);
+
+  query = gst_query_new_seeking (GST_FORMAT_BYTES);
+  fail_unless (gst_element_query (pipeline, query));
+  gst_query_parse_seeking (query, NULL, &seekable, NULL, NULL);
+  fail_if (seekable);
+  gst_query_unref (query);
+
+  /* packets 20, 22 and 24 are in [2s, 2.5s] */
+  fail_unless (gst_element_seek (pipeline, 1.0, GST_FORMAT_TIME,
+          GST_SEEK_FLAG_FLUSH, GST_SEEK_TYPE_SET, 2 * GST_SECOND,
+          GST_SEEK_TYPE_SET, 2500 * GST_MSECOND));
+  fail_unless_equals_int (gst_element_get_state (pipeline, NULL, NULL,
+          GST_CLOCK_TIME_NONE), GST_STATE_CHANGE_SUCCESS);
+
+  run_to_eos (pipeline);
+  check_received (20, 2, 3);
+
+  /* and back to an earlier position, now from the index that was built */
+  g_list_free_full (received, (GDestroyNotify) gst_buffer_unref);
+  received = NULL;
+
+  fail_unless (gst_element_set_state (pipeline,
+          GST_STATE_PAUSED) != GST_STATE_CHANGE_FAILURE);
+  fail_unless (gst_element_seek (pipeline, 1.0, GST_FORMAT_TIME,
+          GST_SEEK_FLAG_FLUSH, GST_SEEK_TYPE_SET, 550 * GST_MSECOND,
+          GST_SEEK_TYPE_NONE, -1));
+  fail_unless_equals_int (gst_element_get_state (pipeline, NULL, NULL,
+          GST_CLOCK_TIME_NONE), GST_STATE_CHANGE_SUCCESS);
+
+  run_to_eos (pipeline);
+  check_received (6, 2, (N_PACKETS - 6) / 2);
+
+  cleanup_pipeline (pipeline, filename);
+}
+
+GST_END_TEST;
+
+static Suite *
+pcapparse_suite (void)
+{
+  Suite *s = suite_create ("pcapparse");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_filter);
+  tcase_add_test (tc_chain, test_filter_no_match);
+  tcase_add_test (tc_chain, test_seek);
+
+  return s;
+}
+
+GST_CHECK_MAIN (pcapparse);
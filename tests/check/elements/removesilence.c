@@ -0,0 +1,204 @@
+/* GStreamer
+ *
+ * unit test for removesilence
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <gst/audio/audio.h>
+
+#define RATE 8000
+
+#define AUDIO_CAPS_STRING "audio/x-raw, " \
+                           "format = (string) " GST_AUDIO_NE (S16) ", "\
+                           "layout = (string) interleaved, " \
+                           "rate = (int) 8000, " \
+                           "channels = (int) 1"
+
+static GstPad *mysrcpad, *mysinkpad;
+
+static GstStaticPadTemplate sinktemplate = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (AUDIO_CAPS_STRING));
+
+static GstStaticPadTemplate srctemplate = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (AUDIO_CAPS_STRING));
+
+static GstElement *
+setup_removesilence (void)
+{
+  GstElement *removesilence;
+  GstCaps *caps;
+
+  removesilence = gst_check_setup_element ("removesilence");
+  mysrcpad = gst_check_setup_src_pad (removesilence, &srctemplate);
+  mysinkpad = gst_check_setup_sink_pad (removesilence, &sinktemplate);
+  gst_pad_set_active (mysrcpad, TRUE);
+  gst_pad_set_active (mysinkpad, TRUE);
+
+  g_object_set (removesilence, "hysteresis", (guint64) 80, NULL);
+  fail_unless (gst_element_set_state (removesilence,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+
+  caps = gst_caps_from_string (AUDIO_CAPS_STRING);
+  gst_check_setup_events (mysrcpad, removesilence, caps, GST_FORMAT_TIME);
+  gst_caps_unref (caps);
+
+  return removesilence;
+}
+
+static void
+cleanup_removesilence (GstElement * removesilence)
+{
+  gst_element_set_state (removesilence, GST_STATE_NULL);
+
+  gst_check_drop_buffers ();
+  gst_pad_set_active (mysrcpad, FALSE);
+  gst_pad_set_active (mysinkpad, FALSE);
+  gst_check_teardown_src_pad (removesilence);
+  gst_check_teardown_sink_pad (removesilence);
+  gst_check_teardown_element (removesilence);
+}
+
+/* 50ms of silence, 100ms of signal and 50ms of silence */
+static GstBuffer *
+make_buffer (void)
+{
+  GstBuffer *buffer;
+  GstMapInfo map;
+  gint16 *data;
+  guint i;
+
+  buffer = gst_buffer_new_allocate (NULL, 1600 * sizeof (gint16), NULL);
+  gst_buffer_map (buffer, &map, GST_MAP_WRITE);
+  data = (gint16 *) map.data;
+  for (i = 0; i < 1600; i++)
+    data[i] = (i >= 400 && i < 1200) ? 10000 : 0;
+  gst_buffer_unmap (buffer, &map);
+
+  GST_BUFFER_TIMESTAMP (buffer) = 0;
+  GST_BUFFER_DURATION (buffer) = 200 * GST_MSECOND;
+
+  return buffer;
+}
+
+/* the silence around the signal is cut out of the buffer, the signal is
+ * kept until the decay of the VAD power plus the hysteresis */
+GST_START_TEST (test_cut)
+{
+  GstElement *removesilence;
+  GstBuffer *inbuf, *outbuf;
+  GstMapInfo map;
+  gint16 *data;
+  guint i;
+
+  removesilence = setup_removesilence ();
+  g_object_set (removesilence, "remove", TRUE, NULL);
+
+  inbuf = make_buffer ();
+  gst_buffer_ref (inbuf);
+  fail_unless_equals_int (gst_pad_push (mysrcpad, inbuf), GST_FLOW_OK);
+
+  fail_unless_equals_int (g_list_length (buffers), 1);
+  outbuf = GST_BUFFER (buffers->data);
+  fail_unless_equals_uint64 (GST_BUFFER_TIMESTAMP (outbuf),
+      50 * GST_MSECOND);
+  fail_unless_equals_uint64 (GST_BUFFER_DURATION (outbuf),
+      140 * GST_MSECOND);
+
+  /* the output shares the memory of the input */
+  fail_unless (gst_buffer_peek_memory (outbuf, 0) ==
+      gst_buffer_peek_memory (inbuf, 0));
+  gst_buffer_unref (inbuf);
+
+  gst_buffer_map (outbuf, &map, GST_MAP_READ);
+  fail_unless_equals_int (map.size, 1120 * sizeof (gint16));
+  data = (gint16 *) map.data;
+  for (i = 0; i < 800; i++)
+    fail_unless_equals_int (data[i], 10000);
+  gst_buffer_unmap (outbuf, &map);
+
+  cleanup_removesilence (removesilence);
+}
+
+GST_END_TEST;
+
+/* without remove the buffer goes through unchanged and the silence periods
+ * are posted on the bus */
+GST_START_TEST (test_messages)
+{
+  static const gchar *fields[] = { "silence_detected", "silence_finished",
+    "silence_detected"
+  };
+  static const GstClockTime times[] = { 0, 50 * GST_MSECOND,
+    190 * GST_MSECOND
+  };
+  GstElement *removesilence;
+  GstBus *bus;
+  GstMessage *msg;
+  guint64 timestamp;
+  guint i;
+
+  removesilence = setup_removesilence ();
+  g_object_set (removesilence, "silent", FALSE, NULL);
+  bus = gst_bus_new ();
+  gst_element_set_bus (removesilence, bus);
+
+  fail_unless_equals_int (gst_pad_push (mysrcpad, make_buffer ()),
+      GST_FLOW_OK);
+  fail_unless_equals_int (g_list_length (buffers), 1);
+  fail_unless_equals_int (gst_buffer_get_size (GST_BUFFER (buffers->data)),
+      1600 * sizeof (gint16));
+
+  for (i = 0; i < G_N_ELEMENTS (fields); i++) {
+    const GstStructure *s;
+
+    msg = gst_bus_poll (bus, GST_MESSAGE_ELEMENT, 0);
+    fail_unless (msg != NULL);
+    s = gst_message_get_structure (msg);
+    fail_unless (gst_structure_has_name (s, "removesilence"));
+    fail_unless (gst_structure_get_uint64 (s, fields[i], &timestamp));
+    fail_unless_equals_uint64 (timestamp, times[i]);
+    gst_message_unref (msg);
+  }
+  fail_unless (gst_bus_poll (bus, GST_MESSAGE_ELEMENT, 0) == NULL);
+
+  gst_element_set_bus (removesilence, NULL);
+  gst_object_unref (bus);
+  cleanup_removesilence (removesilence);
+}
+
+GST_END_TEST;
+
+static Suite *
+removesilence_suite (void)
+{
+  Suite *s = suite_create ("removesilence");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_cut);
+  tcase_add_test (tc_chain, test_messages);
+
+  return s;
+}
+
+GST_CHECK_MAIN (removesilence);
@@ -0,0 +1,270 @@
+/* GStreamer
+ *
+ * unit test for scenechange
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+
+#include <string.h>
+
+#define WIDTH 64
+#define HEIGHT 48
+#define FRAME_DURATION (GST_SECOND / 25)
+
+#define VIDEO_CAPS_STRING "video/x-raw, format = (string) I420, " \
+    "width = (int) 64, height = (int) 48, framerate = (fraction) 25/1"
+
+static GstPad *mysrcpad, *mysinkpad;
+static GstBus *bus;
+static guint32 noise_seed;
+
+static GstStaticPadTemplate sinktemplate = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (VIDEO_CAPS_STRING));
+
+static GstStaticPadTemplate srctemplate = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (VIDEO_CAPS_STRING));
+
+static GstElement *
+setup_scenechange (void)
+{
+  GstElement *scenechange;
+  GstCaps *caps;
+
+  scenechange = gst_check_setup_element ("scenechange");
+  g_object_set (scenechange, "post-messages", TRUE, "detect-fades", TRUE,
+      NULL);
+  mysrcpad = gst_check_setup_src_pad (scenechange, &srctemplate);
+  mysinkpad = gst_check_setup_sink_pad (scenechange, &sinktemplate);
+  gst_pad_set_active (mysrcpad, TRUE);
+  gst_pad_set_active (mysinkpad, TRUE);
+
+  bus = gst_bus_new ();
+  gst_element_set_bus (scenechange, bus);
+
+  fail_unless (gst_element_set_state (scenechange,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+
+  caps = gst_caps_from_string (VIDEO_CAPS_STRING);
+  gst_check_setup_events (mysrcpad, scenechange, caps, GST_FORMAT_TIME);
+  gst_caps_unref (caps);
+
+  noise_seed = 1;
+
+  return scenechange;
+}
+
+static void
+cleanup_scenechange (GstElement * scenechange)
+{
+  gst_element_set_state (scenechange, GST_STATE_NULL);
+
+  gst_element_set_bus (scenechange, NULL);
+  gst_object_unref (bus);
+  bus = NULL;
+
+  gst_check_drop_buffers ();
+  gst_pad_set_active (mysrcpad, FALSE);
+  gst_pad_set_active (mysinkpad, FALSE);
+  gst_check_teardown_src_pad (scenechange);
+  gst_check_teardown_sink_pad (scenechange);
+  gst_check_teardown_element (scenechange);
+}
+
+/* pseudo random values from -2 to 2, like the noise of a camera */
+static gint
+get_noise (void)
+{
+  noise_seed = noise_seed * 1103515245 + 12345;
+
+  return (gint) ((noise_seed >> 16) % 5) - 2;
+}
+
+typedef enum
+{
+  PICTURE_GRADIENT,
+  PICTURE_CHECKERS,
+  PICTURE_FLAT
+} Picture;
+
+/* pushes frame @n showing @picture at a luma of @level, with noise if
+ * @noisy */
+static void
+push_frame (guint n, Picture picture, gint level, gboolean noisy)
+{
+  GstBuffer *buffer;
+  GstMapInfo map;
+  gint x, y;
+
+  buffer = gst_buffer_new_allocate (NULL, WIDTH * HEIGHT * 3 / 2, NULL);
+  gst_buffer_map (buffer, &map, GST_MAP_WRITE);
+  for (y = 0; y < HEIGHT; y++) {
+    for (x = 0; x < WIDTH; x++) {
+      gint v;
+
+      switch (picture) {
+        case PICTURE_GRADIENT:
+          v = level + x * 3;
+          break;
+        case PICTURE_CHECKERS:
+          v = ((x / 8 + y / 8) % 2) ? 235 : level;
+          break;
+        case PICTURE_FLAT:
+        default:
+          /* a fine pattern that averages out in the analysed blocks */
+          v = level + ((x / 4 + y / 4) % 2) * 8;
+          break;
+      }
+      if (noisy)
+        v += get_noise ();
+      map.data[y * WIDTH + x] = CLAMP (v, 0, 255);
+    }
+  }
+  memset (map.data + WIDTH * HEIGHT, 128, WIDTH * HEIGHT / 2);
+  gst_buffer_unmap (buffer, &map);
+
+  GST_BUFFER_PTS (buffer) = n * FRAME_DURATION;
+  GST_BUFFER_DURATION (buffer) = FRAME_DURATION;
+
+  fail_unless_equals_int (gst_pad_push (mysrcpad, buffer), GST_FLOW_OK);
+}
+
+/* checks that the next message is of @type for frame @n */
+static void
+check_message (const gchar * type, guint n)
+{
+  const GstStructure *s;
+  GstMessage *msg;
+  guint64 timestamp;
+
+  msg = gst_bus_pop_filtered (bus, GST_MESSAGE_ELEMENT);
+  fail_unless (msg != NULL, "no %s message for frame %u", type, n);
+  s = gst_message_get_structure (msg);
+  fail_unless (gst_structure_has_name (s, "GstSceneChange"));
+  fail_unless_equals_string (gst_structure_get_string (s, "type"), type);
+  fail_unless (gst_structure_get_uint64 (s, "timestamp", &timestamp));
+  fail_unless_equals_uint64 (timestamp, n * FRAME_DURATION);
+  gst_message_unref (msg);
+}
+
+static void
+check_no_message (void)
+{
+  GstMessage *msg;
+
+  msg = gst_bus_pop_filtered (bus, GST_MESSAGE_ELEMENT);
+  fail_unless (msg == NULL, "unexpected message %" GST_PTR_FORMAT,
+      msg ? gst_message_get_structure (msg) : NULL);
+}
+
+/* the noise of a static picture is not a scene change */
+GST_START_TEST (test_static)
+{
+  GstElement *scenechange;
+  guint i;
+
+  scenechange = setup_scenechange ();
+
+  for (i = 0; i < 20; i++)
+    push_frame (i, PICTURE_GRADIENT, 16, TRUE);
+  check_no_message ();
+
+  cleanup_scenechange (scenechange);
+}
+
+GST_END_TEST;
+
+/* a cut between two pictures is reported once, on the first frame of the
+ * new picture */
+GST_START_TEST (test_hard_cut)
+{
+  GstElement *scenechange;
+  guint i;
+
+  scenechange = setup_scenechange ();
+
+  for (i = 0; i < 10; i++)
+    push_frame (i, PICTURE_GRADIENT, 16, TRUE);
+  for (i = 10; i < 20; i++)
+    push_frame (i, PICTURE_CHECKERS, 16, TRUE);
+
+  check_message ("cut", 10);
+  check_no_message ();
+
+  cleanup_scenechange (scenechange);
+}
+
+GST_END_TEST;
+
+/* luma of the fade test frames, a picture fading to black and back in
+ * steps of one */
+static gint
+get_fade_level (guint n)
+{
+  if (n <= 5)
+    return 30;
+  if (n <= 20)
+    return 35 - n;
+  if (n <= 25)
+    return 15;
+  if (n <= 40)
+    return n - 10;
+  return 30;
+}
+
+/* a slow fade is not a cut, it is reported when the mean luma goes below
+ * and above the black level */
+GST_START_TEST (test_fade)
+{
+  GstElement *scenechange;
+  guint i;
+
+  scenechange = setup_scenechange ();
+
+  for (i = 0; i < 45; i++)
+    push_frame (i, PICTURE_FLAT, get_fade_level (i), FALSE);
+
+  /* the mean is 4 above the level, black below a mean of 24 */
+  check_message ("fade-out", 16);
+  check_message ("fade-in", 30);
+  check_no_message ();
+
+  cleanup_scenechange (scenechange);
+}
+
+GST_END_TEST;
+
+static Suite *
+scenechange_suite (void)
+{
+  Suite *s = suite_create ("scenechange");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_static);
+  tcase_add_test (tc_chain, test_hard_cut);
+  tcase_add_test (tc_chain, test_fade);
+
+  return s;
+}
+
+GST_CHECK_MAIN (scenechange);
@@ -0,0 +1,299 @@
+/* GStreamer
+ *
+ * unit test for simplevideomark and simplevideomarkdetect
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <gst/check/gsttestclock.h>
+
+#include <math.h>
+
+/* wide enough for the 4 pattern and 24 data squares of 4x16 pixels */
+#define WIDTH 128
+#define HEIGHT 32
+#define FRAME_SIZE (WIDTH * HEIGHT * 3 / 2)
+#define FRAME_DURATION (GST_SECOND / 25)
+
+#define VIDEO_CAPS_STRING "video/x-raw, format = (string) I420, " \
+    "width = (int) 128, height = (int) 32, framerate = (fraction) 25/1"
+
+#define DATA_BITS 24
+#define START_TIME (100 * GST_SECOND)
+
+static GstPad *mysrcpad, *mysinkpad;
+static GstBus *bus;
+static GstClock *test_clock;
+
+/* the time the frames take from the mark to the detect element */
+static const guint delays_ms[] = { 10, 40, 20, 30 };
+static guint n_delays;
+
+static GstStaticPadTemplate sinktemplate = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (VIDEO_CAPS_STRING));
+
+static GstStaticPadTemplate srctemplate = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (VIDEO_CAPS_STRING));
+
+/* lets the frames that leave the mark element take their delay */
+static GstPadProbeReturn
+delay_probe (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+  fail_unless (n_delays < G_N_ELEMENTS (delays_ms));
+  gst_test_clock_advance_time (GST_TEST_CLOCK (test_clock),
+      delays_ms[n_delays++] * GST_MSECOND);
+
+  return GST_PAD_PROBE_OK;
+}
+
+/* links simplevideomark to simplevideomarkdetect, both using the test clock
+ * if @with_clock */
+static void
+setup_elements (GstElement ** mark, GstElement ** detect,
+    gboolean measure_latency, gboolean with_clock)
+{
+  GstCaps *caps;
+  GstPad *pad;
+
+  *mark = gst_check_setup_element ("simplevideomark");
+  g_object_set (*mark, "pattern-clock-time", TRUE, "pattern-data-count",
+      DATA_BITS, NULL);
+  *detect = gst_check_setup_element ("simplevideomarkdetect");
+  g_object_set (*detect, "measure-latency", measure_latency,
+      "pattern-data-count", DATA_BITS, NULL);
+  fail_unless (gst_element_link (*mark, *detect));
+
+  mysrcpad = gst_check_setup_src_pad (*mark, &srctemplate);
+  mysinkpad = gst_check_setup_sink_pad (*detect, &sinktemplate);
+  gst_pad_set_active (mysrcpad, TRUE);
+  gst_pad_set_active (mysinkpad, TRUE);
+
+  n_delays = 0;
+  pad = gst_element_get_static_pad (*mark, "src");
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER, delay_probe, NULL, NULL);
+  gst_object_unref (pad);
+
+  test_clock = gst_test_clock_new_with_start_time (START_TIME);
+  if (with_clock) {
+    gst_element_set_clock (*mark, test_clock);
+    gst_element_set_clock (*detect, test_clock);
+  }
+
+  bus = gst_bus_new ();
+  gst_element_set_bus (*detect, bus);
+
+  fail_unless (gst_element_set_state (*mark,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+  fail_unless (gst_element_set_state (*detect,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+
+  caps = gst_caps_from_string (VIDEO_CAPS_STRING);
+  gst_check_setup_events (mysrcpad, *mark, caps, GST_FORMAT_TIME);
+  gst_caps_unref (caps);
+}
+
+static void
+cleanup_elements (GstElement * mark, GstElement * detect)
+{
+  gst_element_set_state (mark, GST_STATE_NULL);
+  gst_element_set_state (detect, GST_STATE_NULL);
+
+  gst_element_set_bus (detect, NULL);
+  gst_object_unref (bus);
+  bus = NULL;
+  gst_object_unref (test_clock);
+  test_clock = NULL;
+
+  gst_check_drop_buffers ();
+  gst_pad_set_active (mysrcpad, FALSE);
+  gst_pad_set_active (mysinkpad, FALSE);
+  gst_check_teardown_src_pad (mark);
+  gst_check_teardown_sink_pad (detect);
+  gst_element_unlink (mark, detect);
+  gst_check_teardown_element (mark);
+  gst_check_teardown_element (detect);
+}
+
+static void
+push_frame (guint n)
+{
+  GstBuffer *buffer;
+
+  buffer = gst_buffer_new_allocate (NULL, FRAME_SIZE, NULL);
+  gst_buffer_memset (buffer, 0, 128, FRAME_SIZE);
+  GST_BUFFER_PTS (buffer) = n * FRAME_DURATION;
+  GST_BUFFER_DURATION (buffer) = FRAME_DURATION;
+
+  fail_unless_equals_int (gst_pad_push (mysrcpad, buffer), GST_FLOW_OK);
+}
+
+static GstMessage *
+pop_message (guint n)
+{
+  const GstStructure *s;
+  GstMessage *msg;
+  guint64 timestamp;
+  gboolean have_pattern;
+
+  msg = gst_bus_pop_filtered (bus, GST_MESSAGE_ELEMENT);
+  fail_unless (msg != NULL, "no message for frame %u", n);
+  s = gst_message_get_structure (msg);
+  fail_unless (gst_structure_has_name (s, "GstSimpleVideoMarkDetect"));
+  fail_unless (gst_structure_get_boolean (s, "have-pattern", &have_pattern));
+  fail_unless (have_pattern);
+  fail_unless (gst_structure_get_uint64 (s, "timestamp", &timestamp));
+  fail_unless_equals_uint64 (timestamp, n * FRAME_DURATION);
+
+  return msg;
+}
+
+static guint64
+get_uint64 (const GstStructure * s, const gchar * field)
+{
+  guint64 value;
+
+  fail_unless (gst_structure_get_uint64 (s, field, &value),
+      "no %s field", field);
+
+  return value;
+}
+
+/* the detect element reads the clock time the mark element painted and
+ * measures how long the frame took, and the distribution of all of them */
+GST_START_TEST (test_latency)
+{
+  GstElement *mark, *detect;
+  GstClockTime now = START_TIME, lo = GST_CLOCK_TIME_NONE, hi = 0;
+  gdouble sum = 0, sum_sq = 0;
+  guint i;
+
+  setup_elements (&mark, &detect, TRUE, TRUE);
+
+  for (i = 0; i < G_N_ELEMENTS (delays_ms); i++) {
+    const GstStructure *s;
+    GstMessage *msg;
+    GstClockTime latency = delays_ms[i] * GST_MSECOND;
+    gdouble avg, var;
+    guint64 data, stddev;
+
+    push_frame (i);
+    msg = pop_message (i);
+    s = gst_message_get_structure (msg);
+
+    /* painted with the time before the delay, truncated to the data bits */
+    data = get_uint64 (s, "data");
+    fail_unless_equals_uint64 (data,
+        (now / GST_MSECOND) & ((1 << DATA_BITS) - 1));
+    now += latency;
+    fail_unless_equals_uint64 (get_uint64 (s, "clock-time"), now);
+
+    lo = MIN (lo, latency);
+    hi = MAX (hi, latency);
+    sum += latency;
+    sum_sq += (gdouble) latency * latency;
+    avg = sum / (i + 1);
+    var = sum_sq / (i + 1) - avg * avg;
+
+    fail_unless_equals_uint64 (get_uint64 (s, "latency"), latency);
+    fail_unless_equals_uint64 (get_uint64 (s, "latency-min"), lo);
+    fail_unless_equals_uint64 (get_uint64 (s, "latency-max"), hi);
+    fail_unless_equals_uint64 (get_uint64 (s, "latency-average"),
+        (guint64) avg);
+    stddev = get_uint64 (s, "latency-stddev");
+    fail_unless (ABS ((gint64) stddev - (gint64) sqrt (MAX (var, 0.0))) <= 1,
+        "stddev %" G_GUINT64_FORMAT ", expected %f", stddev, sqrt (var));
+
+    gst_message_unref (msg);
+  }
+  fail_unless_equals_int (g_list_length (buffers), G_N_ELEMENTS (delays_ms));
+
+  cleanup_elements (mark, detect);
+}
+
+GST_END_TEST;
+
+/* without measure-latency, the messages only have the clock time */
+GST_START_TEST (test_no_latency)
+{
+  GstElement *mark, *detect;
+  const GstStructure *s;
+  GstMessage *msg;
+
+  setup_elements (&mark, &detect, FALSE, TRUE);
+
+  push_frame (0);
+  msg = pop_message (0);
+  s = gst_message_get_structure (msg);
+  fail_unless_equals_uint64 (get_uint64 (s, "data"),
+      (START_TIME / GST_MSECOND) & ((1 << DATA_BITS) - 1));
+  fail_unless_equals_uint64 (get_uint64 (s, "clock-time"),
+      START_TIME + delays_ms[0] * GST_MSECOND);
+  fail_if (gst_structure_has_field (s, "latency"));
+  fail_if (gst_structure_has_field (s, "latency-average"));
+  gst_message_unref (msg);
+
+  cleanup_elements (mark, detect);
+}
+
+GST_END_TEST;
+
+/* without a clock, the mark element paints pattern-data and nothing can be
+ * measured */
+GST_START_TEST (test_no_clock)
+{
+  GstElement *mark, *detect;
+  const GstStructure *s;
+  GstMessage *msg;
+
+  setup_elements (&mark, &detect, TRUE, FALSE);
+  g_object_set (mark, "pattern-data", G_GUINT64_CONSTANT (123456), NULL);
+
+  push_frame (0);
+  msg = pop_message (0);
+  s = gst_message_get_structure (msg);
+  fail_unless_equals_uint64 (get_uint64 (s, "data"), 123456);
+  fail_unless_equals_uint64 (get_uint64 (s, "clock-time"),
+      GST_CLOCK_TIME_NONE);
+  fail_if (gst_structure_has_field (s, "latency"));
+  gst_message_unref (msg);
+
+  cleanup_elements (mark, detect);
+}
+
+GST_END_TEST;
+
+static Suite *
+simplevideomarkdetect_suite (void)
+{
+  Suite *s = suite_create ("simplevideomarkdetect");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_latency);
+  tcase_add_test (tc_chain, test_no_latency);
+  tcase_add_test (tc_chain, test_no_clock);
+
+  return s;
+}
+
+GST_CHECK_MAIN (simplevideomarkdetect);
@@ -0,0 +1,272 @@
+/* GStreamer
+ *
+ * unit test for srtpenc and srtpdec
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <gst/rtp/gstrtpbuffer.h>
+
+#include <string.h>
+
+#define RTP_CAPS_STRING "application/x-rtp, media = (string) video, " \
+    "payload = (int) 96, clock-rate = (int) 90000, " \
+    "encoding-name = (string) RAW, ssrc = (uint) 12345678"
+
+#define N_PACKETS 8
+#define PAYLOAD_SIZE 100
+
+static GstPad *mysrcpad, *mysinkpad;
+
+static GstStaticPadTemplate sinktemplate = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("application/x-rtp"));
+
+static GstStaticPadTemplate srctemplate = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("application/x-rtp"));
+
+static GstElement *srtpenc, *srtpdec;
+static GstPad *enc_sinkpad;
+static guint n_protected_lists;
+
+static GstBuffer *
+make_key (void)
+{
+  GstBuffer *key;
+  GstMapInfo map;
+  gint i;
+
+  /* 14 bytes salt and 16 bytes key for aes-128-icm */
+  key = gst_buffer_new_allocate (NULL, 30, NULL);
+  gst_buffer_map (key, &map, GST_MAP_WRITE);
+  for (i = 0; i < 30; i++)
+    map.data[i] = i * 7 + 1;
+  gst_buffer_unmap (key, &map);
+
+  return key;
+}
+
+static void
+fill_payload (guint8 * data, guint seq)
+{
+  gint i;
+
+  for (i = 0; i < PAYLOAD_SIZE; i++)
+    data[i] = seq + i;
+}
+
+static GstBuffer *
+make_packet (guint seq)
+{
+  GstBuffer *buffer;
+  GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+
+  buffer = gst_rtp_buffer_new_allocate (PAYLOAD_SIZE, 0, 0);
+  gst_rtp_buffer_map (buffer, GST_MAP_WRITE, &rtp);
+  gst_rtp_buffer_set_ssrc (&rtp, 12345678);
+  gst_rtp_buffer_set_payload_type (&rtp, 96);
+  gst_rtp_buffer_set_seq (&rtp, seq);
+  gst_rtp_buffer_set_timestamp (&rtp, seq * 3000);
+  fill_payload (gst_rtp_buffer_get_payload (&rtp), seq);
+  gst_rtp_buffer_unmap (&rtp);
+
+  GST_BUFFER_TIMESTAMP (buffer) = seq * GST_SECOND / 30;
+
+  return buffer;
+}
+
+static gboolean
+check_protected (GstBuffer ** buffer, guint idx, gpointer user_data)
+{
+  GstMapInfo map;
+  guint8 payload[PAYLOAD_SIZE];
+
+  /* the header stays readable, the payload that follows it must be
+   * encrypted */
+  gst_buffer_map (*buffer, &map, GST_MAP_READ);
+  fail_unless (map.size > 12 + PAYLOAD_SIZE);
+  fill_payload (payload, GST_READ_UINT16_BE (map.data + 2));
+  fail_if (memcmp (map.data + 12, payload, PAYLOAD_SIZE) == 0);
+  gst_buffer_unmap (*buffer, &map);
+
+  return TRUE;
+}
+
+static GstPadProbeReturn
+enc_src_list_probe (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+  GstBufferList *list = GST_PAD_PROBE_INFO_BUFFER_LIST (info);
+
+  fail_unless_equals_int (gst_buffer_list_length (list), N_PACKETS);
+  gst_buffer_list_foreach (list, check_protected, NULL);
+  n_protected_lists++;
+
+  return GST_PAD_PROBE_OK;
+}
+
+static void
+setup_srtp (void)
+{
+  GstPad *enc_srcpad, *dec_sinkpad;
+  GstBuffer *key;
+  GstCaps *caps;
+
+  srtpenc = gst_check_setup_element ("srtpenc");
+  srtpdec = gst_check_setup_element ("srtpdec");
+
+  key = make_key ();
+  g_object_set (srtpenc, "key", key, NULL);
+  gst_buffer_unref (key);
+
+  mysrcpad = gst_pad_new_from_static_template (&srctemplate, "src");
+  enc_sinkpad = gst_element_get_request_pad (srtpenc, "rtp_sink_0");
+  fail_unless (enc_sinkpad != NULL);
+  fail_unless_equals_int (gst_pad_link (mysrcpad, enc_sinkpad),
+      GST_PAD_LINK_OK);
+
+  enc_srcpad = gst_element_get_static_pad (srtpenc, "rtp_src_0");
+  dec_sinkpad = gst_element_get_static_pad (srtpdec, "rtp_sink");
+  fail_unless_equals_int (gst_pad_link (enc_srcpad, dec_sinkpad),
+      GST_PAD_LINK_OK);
+  n_protected_lists = 0;
+  gst_pad_add_probe (enc_srcpad, GST_PAD_PROBE_TYPE_BUFFER_LIST,
+      enc_src_list_probe, NULL, NULL);
+  gst_object_unref (enc_srcpad);
+  gst_object_unref (dec_sinkpad);
+
+  mysinkpad = gst_check_setup_sink_pad_by_name (srtpdec, &sinktemplate,
+      "rtp_src");
+
+  gst_pad_set_active (mysrcpad, TRUE);
+  gst_pad_set_active (mysinkpad, TRUE);
+
+  fail_unless (gst_element_set_state (srtpdec,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set srtpdec to playing");
+  fail_unless (gst_element_set_state (srtpenc,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set srtpenc to playing");
+
+  caps = gst_caps_from_string (RTP_CAPS_STRING);
+  gst_check_setup_events (mysrcpad, srtpenc, caps, GST_FORMAT_TIME);
+  gst_caps_unref (caps);
+}
+
+static void
+cleanup_srtp (void)
+{
+  gst_element_set_state (srtpenc, GST_STATE_NULL);
+  gst_element_set_state (srtpdec, GST_STATE_NULL);
+
+  gst_check_drop_buffers ();
+  gst_pad_set_active (mysrcpad, FALSE);
+  gst_pad_set_active (mysinkpad, FALSE);
+  gst_check_teardown_pad_by_name (srtpdec, "rtp_src");
+
+  gst_pad_unlink (mysrcpad, enc_sinkpad);
+  gst_object_unref (mysrcpad);
+  gst_element_release_request_pad (srtpenc, enc_sinkpad);
+  gst_object_unref (enc_sinkpad);
+
+  gst_check_teardown_element (srtpenc);
+  gst_check_teardown_element (srtpdec);
+}
+
+/* a list pushed through srtpenc stays a list of protected packets, and
+ * srtpdec turns it back into the original packets */
+GST_START_TEST (test_buffer_list_roundtrip)
+{
+  GstBufferList *list;
+  GList *walk;
+  guint i;
+
+  setup_srtp ();
+
+  list = gst_buffer_list_new ();
+  for (i = 0; i < N_PACKETS; i++)
+    gst_buffer_list_add (list, make_packet (i));
+
+  fail_unless_equals_int (gst_pad_push_list (mysrcpad, list), GST_FLOW_OK);
+
+  fail_unless_equals_int (n_protected_lists, 1);
+  fail_unless_equals_int (g_list_length (buffers), N_PACKETS);
+
+  for (walk = buffers, i = 0; walk; walk = walk->next, i++) {
+    GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+    guint8 payload[PAYLOAD_SIZE];
+
+    fail_unless (gst_rtp_buffer_map (walk->data, GST_MAP_READ, &rtp));
+    fail_unless_equals_int (gst_rtp_buffer_get_seq (&rtp), i);
+    fail_unless_equals_int (gst_rtp_buffer_get_payload_len (&rtp),
+        PAYLOAD_SIZE);
+    fill_payload (payload, i);
+    fail_unless (memcmp (gst_rtp_buffer_get_payload (&rtp), payload,
+            PAYLOAD_SIZE) == 0);
+    gst_rtp_buffer_unmap (&rtp);
+
+    fail_unless_equals_uint64 (GST_BUFFER_TIMESTAMP (walk->data),
+        i * GST_SECOND / 30);
+  }
+
+  cleanup_srtp ();
+}
+
+GST_END_TEST;
+
+/* single buffers and lists can be mixed on the same stream */
+GST_START_TEST (test_buffer_and_list)
+{
+  GstBufferList *list;
+  guint i;
+
+  setup_srtp ();
+
+  fail_unless_equals_int (gst_pad_push (mysrcpad, make_packet (0)),
+      GST_FLOW_OK);
+
+  list = gst_buffer_list_new ();
+  for (i = 1; i <= N_PACKETS; i++)
+    gst_buffer_list_add (list, make_packet (i));
+  fail_unless_equals_int (gst_pad_push_list (mysrcpad, list), GST_FLOW_OK);
+
+  fail_unless_equals_int (gst_pad_push (mysrcpad, make_packet (N_PACKETS +
+              1)), GST_FLOW_OK);
+
+  fail_unless_equals_int (g_list_length (buffers), N_PACKETS + 2);
+
+  cleanup_srtp ();
+}
+
+GST_END_TEST;
+
+static Suite *
+srtp_suite (void)
+{
+  Suite *s = suite_create ("srtp");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_buffer_list_roundtrip);
+  tcase_add_test (tc_chain, test_buffer_and_list);
+
+  return s;
+}
+
+GST_CHECK_MAIN (srtp);
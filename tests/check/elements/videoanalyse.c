@@ -0,0 +1,319 @@
+/* GStreamer
+ *
+ * unit test for videoanalyse
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <gst/video/video.h>
+
+#include <math.h>
+#include <string.h>
+
+/* a size that does not divide evenly into the tiles */
+#define WIDTH 100
+#define HEIGHT 75
+
+#define VIDEO_CAPS_STRING "video/x-raw, format = (string) I420, " \
+    "width = (int) 100, height = (int) 75, framerate = (fraction) 25/1"
+
+/* the variance used to be taken around the average luma rounded down to an
+ * integer, which makes it larger by less than one luma level squared */
+#define VARIANCE_TOLERANCE (1.0 / (255.0 * 255.0))
+
+static GstPad *mysrcpad, *mysinkpad;
+static GstBus *bus;
+
+static GstStaticPadTemplate sinktemplate = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (VIDEO_CAPS_STRING));
+
+static GstStaticPadTemplate srctemplate = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (VIDEO_CAPS_STRING));
+
+static GstElement *
+setup_videoanalyse (guint columns, guint rows)
+{
+  GstElement *videoanalyse;
+  GstCaps *caps;
+
+  videoanalyse = gst_check_setup_element ("videoanalyse");
+  g_object_set (videoanalyse, "tile-columns", columns, "tile-rows", rows,
+      "histogram", TRUE, NULL);
+  mysrcpad = gst_check_setup_src_pad (videoanalyse, &srctemplate);
+  mysinkpad = gst_check_setup_sink_pad (videoanalyse, &sinktemplate);
+  gst_pad_set_active (mysrcpad, TRUE);
+  gst_pad_set_active (mysinkpad, TRUE);
+
+  bus = gst_bus_new ();
+  gst_element_set_bus (videoanalyse, bus);
+
+  fail_unless (gst_element_set_state (videoanalyse,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+
+  caps = gst_caps_from_string (VIDEO_CAPS_STRING);
+  gst_check_setup_events (mysrcpad, videoanalyse, caps, GST_FORMAT_TIME);
+  gst_caps_unref (caps);
+
+  return videoanalyse;
+}
+
+static void
+cleanup_videoanalyse (GstElement * videoanalyse)
+{
+  gst_element_set_state (videoanalyse, GST_STATE_NULL);
+
+  gst_element_set_bus (videoanalyse, NULL);
+  gst_object_unref (bus);
+  bus = NULL;
+
+  gst_check_drop_buffers ();
+  gst_pad_set_active (mysrcpad, FALSE);
+  gst_pad_set_active (mysinkpad, FALSE);
+  gst_check_teardown_src_pad (videoanalyse);
+  gst_check_teardown_sink_pad (videoanalyse);
+  gst_check_teardown_element (videoanalyse);
+}
+
+/* pushes a frame with pseudo random luma and returns a copy of its luma
+ * plane */
+static guint8 *
+push_frame (void)
+{
+  GstVideoInfo info;
+  GstBuffer *buffer;
+  GstMapInfo map;
+  guint8 *luma;
+  guint32 seed = 1;
+  gint x, y;
+
+  gst_video_info_init (&info);
+  gst_video_info_set_format (&info, GST_VIDEO_FORMAT_I420, WIDTH, HEIGHT);
+
+  luma = g_malloc (WIDTH * HEIGHT);
+  for (y = 0; y < HEIGHT; y++) {
+    for (x = 0; x < WIDTH; x++) {
+      seed = seed * 1103515245 + 12345;
+      /* brighter towards the bottom right, so the tiles differ */
+      luma[y * WIDTH + x] = ((seed >> 16) % 128) + x / 2 + y / 2;
+    }
+  }
+
+  buffer = gst_buffer_new_allocate (NULL, GST_VIDEO_INFO_SIZE (&info), NULL);
+  gst_buffer_map (buffer, &map, GST_MAP_WRITE);
+  memset (map.data, 128, map.size);
+  for (y = 0; y < HEIGHT; y++) {
+    memcpy (map.data + GST_VIDEO_INFO_PLANE_OFFSET (&info, 0) +
+        y * GST_VIDEO_INFO_PLANE_STRIDE (&info, 0), luma + y * WIDTH, WIDTH);
+  }
+  gst_buffer_unmap (buffer, &map);
+
+  GST_BUFFER_PTS (buffer) = 0;
+  GST_BUFFER_DURATION (buffer) = GST_SECOND / 25;
+
+  fail_unless_equals_int (gst_pad_push (mysrcpad, buffer), GST_FLOW_OK);
+
+  return luma;
+}
+
+/* the statistics as they were computed before the single pass, with one
+ * pass for the average and a second one for the variance around it. The
+ * pixels are the columns @x0 to @x1 of the lines that belong to tile row
+ * @row of @rows */
+static void
+get_reference (const guint8 * luma, gint x0, gint x1, gint row, gint rows,
+    gdouble * average, gdouble * variance)
+{
+  guint64 sum = 0, n = 0;
+  gint avg, diff, x, y;
+
+  for (y = 0; y < HEIGHT; y++) {
+    if (y * rows / HEIGHT != row)
+      continue;
+    for (x = x0; x < x1; x++) {
+      sum += luma[y * WIDTH + x];
+      n++;
+    }
+  }
+  fail_unless (n > 0);
+
+  avg = sum / n;
+  *average = sum / (255.0 * n);
+
+  sum = 0;
+  for (y = 0; y < HEIGHT; y++) {
+    if (y * rows / HEIGHT != row)
+      continue;
+    for (x = x0; x < x1; x++) {
+      diff = (avg - luma[y * WIDTH + x]);
+      sum += diff * diff;
+    }
+  }
+  *variance = sum / (255.0 * 255.0 * n);
+}
+
+static void
+check_stats (gdouble average, gdouble variance, gdouble ref_average,
+    gdouble ref_variance)
+{
+  fail_unless (fabs (average - ref_average) < 1e-9,
+      "average %f, expected %f", average, ref_average);
+  fail_unless (variance <= ref_variance + 1e-9,
+      "variance %f, expected %f", variance, ref_variance);
+  fail_unless (ref_variance - variance <= VARIANCE_TOLERANCE,
+      "variance %f, expected %f", variance, ref_variance);
+}
+
+static GstMessage *
+pop_message (void)
+{
+  GstMessage *msg;
+
+  msg = gst_bus_pop_filtered (bus, GST_MESSAGE_ELEMENT);
+  fail_unless (msg != NULL);
+  fail_unless (gst_structure_has_name (gst_message_get_structure (msg),
+          "GstVideoAnalyse"));
+
+  return msg;
+}
+
+static void
+check_histogram (const GstStructure * s, const guint8 * luma)
+{
+  const GValue *hist;
+  guint ref[256] = { 0, };
+  gint i;
+
+  for (i = 0; i < WIDTH * HEIGHT; i++)
+    ref[luma[i]]++;
+
+  hist = gst_structure_get_value (s, "luma-histogram");
+  fail_unless (hist != NULL);
+  fail_unless_equals_int (gst_value_array_get_size (hist), 256);
+  for (i = 0; i < 256; i++) {
+    fail_unless_equals_int (g_value_get_uint (gst_value_array_get_value (hist,
+                i)), ref[i]);
+  }
+}
+
+/* the single pass gives the same frame statistics as the two passes it
+ * replaced */
+GST_START_TEST (test_frame_stats)
+{
+  GstElement *videoanalyse;
+  const GstStructure *s;
+  GstMessage *msg;
+  gdouble average, variance, ref_average, ref_variance;
+  guint8 *luma;
+
+  videoanalyse = setup_videoanalyse (1, 1);
+
+  luma = push_frame ();
+  msg = pop_message ();
+  s = gst_message_get_structure (msg);
+
+  fail_unless (gst_structure_get_double (s, "luma-average", &average));
+  fail_unless (gst_structure_get_double (s, "luma-variance", &variance));
+  get_reference (luma, 0, WIDTH, 0, 1, &ref_average, &ref_variance);
+  check_stats (average, variance, ref_average, ref_variance);
+
+  /* a single tile adds no tile fields */
+  fail_if (gst_structure_has_field (s, "tile-luma-average"));
+  check_histogram (s, luma);
+
+  gst_message_unref (msg);
+  g_free (luma);
+
+  cleanup_videoanalyse (videoanalyse);
+}
+
+GST_END_TEST;
+
+/* every tile gets the statistics of its pixels, and the frame statistics do
+ * not change when tiles are used */
+GST_START_TEST (test_tile_stats)
+{
+  GstElement *videoanalyse;
+  const GstStructure *s;
+  const GValue *averages, *variances;
+  GstMessage *msg;
+  gdouble average, variance, ref_average, ref_variance;
+  guint columns, rows, i, j;
+  guint8 *luma;
+
+  videoanalyse = setup_videoanalyse (3, 4);
+
+  luma = push_frame ();
+  msg = pop_message ();
+  s = gst_message_get_structure (msg);
+
+  fail_unless (gst_structure_get_double (s, "luma-average", &average));
+  fail_unless (gst_structure_get_double (s, "luma-variance", &variance));
+  get_reference (luma, 0, WIDTH, 0, 1, &ref_average, &ref_variance);
+  check_stats (average, variance, ref_average, ref_variance);
+
+  fail_unless (gst_structure_get_uint (s, "tile-columns", &columns));
+  fail_unless (gst_structure_get_uint (s, "tile-rows", &rows));
+  fail_unless_equals_int (columns, 3);
+  fail_unless_equals_int (rows, 4);
+
+  averages = gst_structure_get_value (s, "tile-luma-average");
+  variances = gst_structure_get_value (s, "tile-luma-variance");
+  fail_unless (averages != NULL && variances != NULL);
+  fail_unless_equals_int (gst_value_array_get_size (averages), 12);
+  fail_unless_equals_int (gst_value_array_get_size (variances), 12);
+
+  for (j = 0; j < rows; j++) {
+    for (i = 0; i < columns; i++) {
+      guint idx = j * columns + i;
+
+      get_reference (luma, i * WIDTH / columns, (i + 1) * WIDTH / columns,
+          j, rows, &ref_average, &ref_variance);
+      check_stats (g_value_get_double (gst_value_array_get_value (averages,
+                  idx)), g_value_get_double (gst_value_array_get_value
+              (variances, idx)), ref_average, ref_variance);
+    }
+  }
+
+  check_histogram (s, luma);
+
+  gst_message_unref (msg);
+  g_free (luma);
+
+  cleanup_videoanalyse (videoanalyse);
+}
+
+GST_END_TEST;
+
+static Suite *
+videoanalyse_suite (void)
+{
+  Suite *s = suite_create ("videoanalyse");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_frame_stats);
+  tcase_add_test (tc_chain, test_tile_stats);
+
+  return s;
+}
+
+GST_CHECK_MAIN (videoanalyse);
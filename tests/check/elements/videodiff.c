@@ -0,0 +1,445 @@
+/* GStreamer
+ *
+ * unit test for videodiff
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <gst/video/video.h>
+
+#include <math.h>
+#include <string.h>
+
+/* a size that does not divide evenly into the tiles */
+#define WIDTH 100
+#define HEIGHT 75
+#define TILE_COLUMNS 3
+#define TILE_ROWS 4
+
+/* wider than the chunks the tile sums are gathered in */
+#define WIDE_WIDTH 4100
+#define WIDE_HEIGHT 4
+
+#define THRESHOLD 10
+#define FRAME_DURATION (GST_SECOND / 25)
+
+static GstPad *mysrcpad, *mysinkpad;
+static GstBus *bus;
+static GstVideoInfo info;
+
+static GstStaticPadTemplate sinktemplate = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("video/x-raw"));
+
+static GstStaticPadTemplate srctemplate = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("video/x-raw"));
+
+static GstElement *
+setup_videodiff (gint width, gint height, gint columns, gint rows,
+    gint n_threads)
+{
+  GstElement *videodiff;
+  GstCaps *caps;
+
+  videodiff = gst_check_setup_element ("videodiff");
+  g_object_set (videodiff, "post-messages", TRUE, "threshold", THRESHOLD,
+      "tile-columns", columns, "tile-rows", rows, "n-threads", n_threads,
+      NULL);
+  mysrcpad = gst_check_setup_src_pad (videodiff, &srctemplate);
+  mysinkpad = gst_check_setup_sink_pad (videodiff, &sinktemplate);
+  gst_pad_set_active (mysrcpad, TRUE);
+  gst_pad_set_active (mysinkpad, TRUE);
+
+  bus = gst_bus_new ();
+  gst_element_set_bus (videodiff, bus);
+
+  fail_unless (gst_element_set_state (videodiff,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+
+  gst_video_info_init (&info);
+  gst_video_info_set_format (&info, GST_VIDEO_FORMAT_I420, width, height);
+  info.fps_n = 25;
+  info.fps_d = 1;
+  caps = gst_video_info_to_caps (&info);
+  gst_check_setup_events (mysrcpad, videodiff, caps, GST_FORMAT_TIME);
+  gst_caps_unref (caps);
+
+  return videodiff;
+}
+
+static void
+cleanup_videodiff (GstElement * videodiff)
+{
+  gst_element_set_state (videodiff, GST_STATE_NULL);
+
+  gst_element_set_bus (videodiff, NULL);
+  gst_object_unref (bus);
+  bus = NULL;
+
+  gst_check_drop_buffers ();
+  gst_pad_set_active (mysrcpad, FALSE);
+  gst_pad_set_active (mysinkpad, FALSE);
+  gst_check_teardown_src_pad (videodiff);
+  gst_check_teardown_sink_pad (videodiff);
+  gst_check_teardown_element (videodiff);
+}
+
+/* pseudo random luma */
+static guint8 *
+make_noise (void)
+{
+  guint8 *luma;
+  guint32 seed = 1;
+  gint i;
+
+  luma = g_malloc (WIDTH * HEIGHT);
+  for (i = 0; i < WIDTH * HEIGHT; i++) {
+    seed = seed * 1103515245 + 12345;
+    luma[i] = seed >> 16;
+  }
+
+  return luma;
+}
+
+/* @luma with differences from -15 to 15, some of them above the
+ * threshold */
+static guint8 *
+make_changed (const guint8 * luma)
+{
+  guint8 *changed;
+  gint x, y;
+
+  changed = g_malloc (WIDTH * HEIGHT);
+  for (y = 0; y < HEIGHT; y++) {
+    for (x = 0; x < WIDTH; x++) {
+      gint v = luma[y * WIDTH + x] + (x * 7 + y * 3) % 31 - 15;
+
+      changed[y * WIDTH + x] = CLAMP (v, 0, 255);
+    }
+  }
+
+  return changed;
+}
+
+/* pushes frame @n with @luma and grey chroma */
+static void
+push_frame (const guint8 * luma, guint n)
+{
+  GstBuffer *buffer;
+  GstMapInfo map;
+  gint y;
+
+  buffer = gst_buffer_new_allocate (NULL, GST_VIDEO_INFO_SIZE (&info), NULL);
+  gst_buffer_map (buffer, &map, GST_MAP_WRITE);
+  memset (map.data, 128, map.size);
+  for (y = 0; y < GST_VIDEO_INFO_HEIGHT (&info); y++) {
+    memcpy (map.data + GST_VIDEO_INFO_PLANE_OFFSET (&info, 0) +
+        y * GST_VIDEO_INFO_PLANE_STRIDE (&info, 0),
+        luma + y * GST_VIDEO_INFO_WIDTH (&info), GST_VIDEO_INFO_WIDTH (&info));
+  }
+  gst_buffer_unmap (buffer, &map);
+
+  GST_BUFFER_PTS (buffer) = n * FRAME_DURATION;
+  GST_BUFFER_DURATION (buffer) = FRAME_DURATION;
+
+  fail_unless_equals_int (gst_pad_push (mysrcpad, buffer), GST_FLOW_OK);
+}
+
+/* checks that the luma of the last output frame is @luma, with the samples
+ * that changed from @old by more than @threshold painted with stripes */
+static void
+check_output (const guint8 * luma, const guint8 * old, gint threshold)
+{
+  GstMapInfo map;
+  gint width = GST_VIDEO_INFO_WIDTH (&info);
+  gint x, y;
+
+  fail_unless (buffers != NULL);
+  gst_buffer_map (g_list_last (buffers)->data, &map, GST_MAP_READ);
+  for (y = 0; y < GST_VIDEO_INFO_HEIGHT (&info); y++) {
+    const guint8 *out = map.data + GST_VIDEO_INFO_PLANE_OFFSET (&info, 0) +
+        y * GST_VIDEO_INFO_PLANE_STRIDE (&info, 0);
+
+    for (x = 0; x < width; x++) {
+      gint expected = luma[y * width + x];
+
+      if (old && ABS (expected - old[y * width + x]) > threshold)
+        expected = ((x + y) & 0x4) ? 16 : 240;
+      fail_unless_equals_int (out[x], expected);
+    }
+  }
+  gst_buffer_unmap (g_list_last (buffers)->data, &map);
+}
+
+static guint
+get_uint (const GValue * array, guint i)
+{
+  return g_value_get_uint (gst_value_array_get_value (array, i));
+}
+
+static gdouble
+get_double (const GValue * array, guint i)
+{
+  return g_value_get_double (gst_value_array_get_value (array, i));
+}
+
+/* checks the message of frame @n against the statistics of @luma and its
+ * differences to @old, in @columns x @rows tiles */
+static void
+check_message (guint n, const guint8 * luma, const guint8 * old,
+    gint threshold, gint columns, gint rows)
+{
+  const GstStructure *s;
+  const GValue *changed, *mean_diff, *average, *variance, *min, *max;
+  GstMessage *msg;
+  gint width = GST_VIDEO_INFO_WIDTH (&info);
+  gint height = GST_VIDEO_INFO_HEIGHT (&info);
+  guint64 timestamp;
+  guint total_changed = 0, changed_pixels;
+  gint n_columns, n_rows, i, j, x, y;
+
+  msg = gst_bus_pop_filtered (bus, GST_MESSAGE_ELEMENT);
+  fail_unless (msg != NULL, "no message for frame %u", n);
+  s = gst_message_get_structure (msg);
+  fail_unless (gst_structure_has_name (s, "GstVideoDiff"));
+
+  fail_unless (gst_structure_get_uint64 (s, "timestamp", &timestamp));
+  fail_unless_equals_uint64 (timestamp, n * FRAME_DURATION);
+  fail_unless (gst_structure_get_int (s, "tile-columns", &n_columns));
+  fail_unless (gst_structure_get_int (s, "tile-rows", &n_rows));
+  fail_unless_equals_int (n_columns, columns);
+  fail_unless_equals_int (n_rows, rows);
+
+  changed = gst_structure_get_value (s, "tile-changed-pixels");
+  mean_diff = gst_structure_get_value (s, "tile-mean-difference");
+  average = gst_structure_get_value (s, "tile-luma-average");
+  variance = gst_structure_get_value (s, "tile-luma-variance");
+  min = gst_structure_get_value (s, "tile-luma-min");
+  max = gst_structure_get_value (s, "tile-luma-max");
+  fail_unless (changed && mean_diff && average && variance && min && max);
+  fail_unless_equals_int (gst_value_array_get_size (changed), columns * rows);
+  fail_unless_equals_int (gst_value_array_get_size (mean_diff),
+      columns * rows);
+  fail_unless_equals_int (gst_value_array_get_size (average), columns * rows);
+  fail_unless_equals_int (gst_value_array_get_size (variance),
+      columns * rows);
+  fail_unless_equals_int (gst_value_array_get_size (min), columns * rows);
+  fail_unless_equals_int (gst_value_array_get_size (max), columns * rows);
+
+  for (j = 0; j < rows; j++) {
+    for (i = 0; i < columns; i++) {
+      guint idx = j * columns + i;
+      guint64 sum = 0, diff_sum = 0, count = 0;
+      guint n_changed = 0, lo = 255, hi = 0;
+      gdouble avg, var = 0;
+
+      for (y = height * j / rows; y < height * (j + 1) / rows; y++) {
+        for (x = width * i / columns; x < width * (i + 1) / columns; x++) {
+          gint v = luma[y * width + x];
+
+          sum += v;
+          lo = MIN (lo, v);
+          hi = MAX (hi, v);
+          count++;
+          if (old) {
+            gint d = ABS (v - old[y * width + x]);
+
+            diff_sum += d;
+            n_changed += d > threshold;
+          }
+        }
+      }
+      avg = sum / (gdouble) count;
+      for (y = height * j / rows; y < height * (j + 1) / rows; y++) {
+        for (x = width * i / columns; x < width * (i + 1) / columns; x++)
+          var += (luma[y * width + x] - avg) * (luma[y * width + x] - avg);
+      }
+      var /= count;
+
+      fail_unless_equals_int (get_uint (changed, idx), n_changed);
+      fail_unless (fabs (get_double (mean_diff, idx) -
+              diff_sum / (gdouble) count) < 1e-9);
+      fail_unless (fabs (get_double (average, idx) - avg) < 1e-9,
+          "tile %u average %f, expected %f", idx, get_double (average, idx),
+          avg);
+      fail_unless (fabs (get_double (variance, idx) - var) < 1e-6,
+          "tile %u variance %f, expected %f", idx, get_double (variance,
+              idx), var);
+      fail_unless_equals_int (get_uint (min, idx), lo);
+      fail_unless_equals_int (get_uint (max, idx), hi);
+
+      total_changed += n_changed;
+    }
+  }
+
+  fail_unless (gst_structure_get_uint (s, "changed-pixels", &changed_pixels));
+  fail_unless_equals_int (changed_pixels, total_changed);
+
+  gst_message_unref (msg);
+}
+
+/* the first frame has nothing to be compared with, it gets the statistics
+ * of its tiles and is not painted */
+GST_START_TEST (test_first_frame)
+{
+  GstElement *videodiff;
+  guint8 *luma;
+
+  videodiff = setup_videodiff (WIDTH, HEIGHT, TILE_COLUMNS, TILE_ROWS, 1);
+  luma = make_noise ();
+
+  push_frame (luma, 0);
+  check_message (0, luma, NULL, THRESHOLD, TILE_COLUMNS, TILE_ROWS);
+  check_output (luma, NULL, THRESHOLD);
+
+  g_free (luma);
+  cleanup_videodiff (videodiff);
+}
+
+GST_END_TEST;
+
+/* the samples that changed by more than the threshold are counted and
+ * painted, with one thread and with a band of tile rows per thread */
+GST_START_TEST (test_changes)
+{
+  static const gint n_threads[] = { 1, 4 };
+  GstElement *videodiff;
+  guint8 *luma, *changed;
+  gint t;
+
+  luma = make_noise ();
+  changed = make_changed (luma);
+
+  for (t = 0; t < G_N_ELEMENTS (n_threads); t++) {
+    videodiff = setup_videodiff (WIDTH, HEIGHT, TILE_COLUMNS, TILE_ROWS,
+        n_threads[t]);
+
+    push_frame (luma, 0);
+    check_message (0, luma, NULL, THRESHOLD, TILE_COLUMNS, TILE_ROWS);
+    push_frame (changed, 1);
+    check_message (1, changed, luma, THRESHOLD, TILE_COLUMNS, TILE_ROWS);
+    check_output (changed, luma, THRESHOLD);
+    push_frame (luma, 2);
+    check_message (2, luma, changed, THRESHOLD, TILE_COLUMNS, TILE_ROWS);
+    check_output (luma, changed, THRESHOLD);
+
+    cleanup_videodiff (videodiff);
+  }
+
+  g_free (luma);
+  g_free (changed);
+}
+
+GST_END_TEST;
+
+/* a new threshold is used from the next frame on */
+GST_START_TEST (test_threshold)
+{
+  GstElement *videodiff;
+  guint8 *luma, *changed;
+
+  videodiff = setup_videodiff (WIDTH, HEIGHT, TILE_COLUMNS, TILE_ROWS, 4);
+  luma = make_noise ();
+  changed = make_changed (luma);
+
+  push_frame (luma, 0);
+  check_message (0, luma, NULL, THRESHOLD, TILE_COLUMNS, TILE_ROWS);
+
+  g_object_set (videodiff, "threshold", 5, NULL);
+  push_frame (changed, 1);
+  check_message (1, changed, luma, 5, TILE_COLUMNS, TILE_ROWS);
+  check_output (changed, luma, 5);
+
+  g_object_set (videodiff, "threshold", 15, NULL);
+  push_frame (luma, 2);
+  check_message (2, luma, changed, 15, TILE_COLUMNS, TILE_ROWS);
+  check_output (luma, changed, 15);
+
+  g_free (luma);
+  g_free (changed);
+  cleanup_videodiff (videodiff);
+}
+
+GST_END_TEST;
+
+/* lines of a tile that are longer than a chunk of samples are added up
+ * chunk by chunk */
+GST_START_TEST (test_wide)
+{
+  GstElement *videodiff;
+  guint8 *white, *black;
+
+  videodiff = setup_videodiff (WIDE_WIDTH, WIDE_HEIGHT, 1, 1, 1);
+  white = g_malloc (WIDE_WIDTH * WIDE_HEIGHT);
+  memset (white, 255, WIDE_WIDTH * WIDE_HEIGHT);
+  black = g_malloc0 (WIDE_WIDTH * WIDE_HEIGHT);
+
+  push_frame (white, 0);
+  check_message (0, white, NULL, THRESHOLD, 1, 1);
+  push_frame (black, 1);
+  check_message (1, black, white, THRESHOLD, 1, 1);
+  push_frame (white, 2);
+  check_message (2, white, black, THRESHOLD, 1, 1);
+  check_output (white, black, THRESHOLD);
+
+  g_free (white);
+  g_free (black);
+  cleanup_videodiff (videodiff);
+}
+
+GST_END_TEST;
+
+/* the grid is made smaller for frames with fewer lines than tile rows */
+GST_START_TEST (test_small_frame)
+{
+  GstElement *videodiff;
+  guint8 *luma;
+
+  videodiff = setup_videodiff (8, 2, 16, 16, 4);
+  luma = make_noise ();
+
+  push_frame (luma, 0);
+  check_message (0, luma, NULL, THRESHOLD, 8, 2);
+  check_output (luma, NULL, THRESHOLD);
+
+  g_free (luma);
+  cleanup_videodiff (videodiff);
+}
+
+GST_END_TEST;
+
+static Suite *
+videodiff_suite (void)
+{
+  Suite *s = suite_create ("videodiff");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_first_frame);
+  tcase_add_test (tc_chain, test_changes);
+  tcase_add_test (tc_chain, test_threshold);
+  tcase_add_test (tc_chain, test_wide);
+  tcase_add_test (tc_chain, test_small_frame);
+
+  return s;
+}
+
+GST_CHECK_MAIN (videodiff);
@@ -0,0 +1,238 @@
+/* GStreamer
+ *
+ * unit test for yadif
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <gst/video/video.h>
+
+/* the width is not a multiple of the SIMD vectors, the height allows for
+ * four bands */
+#define WIDTH 38
+#define HEIGHT 64
+
+/* the odd lines are this much brighter, in 8 bit units */
+#define COMB 40
+
+static GstPad *mysrcpad, *mysinkpad;
+
+static GstStaticPadTemplate sinktemplate = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("video/x-raw"));
+
+static GstStaticPadTemplate srctemplate = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("video/x-raw"));
+
+static GstElement *
+setup_yadif (GstVideoInfo * info, gint n_threads)
+{
+  GstElement *yadif;
+  GstCaps *caps;
+
+  yadif = gst_check_setup_element ("yadif");
+  g_object_set (yadif, "n-threads", n_threads, NULL);
+  mysrcpad = gst_check_setup_src_pad (yadif, &srctemplate);
+  mysinkpad = gst_check_setup_sink_pad (yadif, &sinktemplate);
+  gst_pad_set_active (mysrcpad, TRUE);
+  gst_pad_set_active (mysinkpad, TRUE);
+
+  fail_unless (gst_element_set_state (yadif,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+
+  caps = gst_video_info_to_caps (info);
+  gst_check_setup_events (mysrcpad, yadif, caps, GST_FORMAT_TIME);
+  gst_caps_unref (caps);
+
+  return yadif;
+}
+
+static void
+cleanup_yadif (GstElement * yadif)
+{
+  gst_element_set_state (yadif, GST_STATE_NULL);
+
+  gst_check_drop_buffers ();
+  gst_pad_set_active (mysrcpad, FALSE);
+  gst_pad_set_active (mysinkpad, FALSE);
+  gst_check_teardown_src_pad (yadif);
+  gst_check_teardown_sink_pad (yadif);
+  gst_check_teardown_element (yadif);
+}
+
+/* a different horizontal ramp for every component, the same on all the even
+ * lines, in 8 bit units */
+static guint
+get_value (guint comp, gint x)
+{
+  return 16 + comp * 10 + x * 4;
+}
+
+static guint
+get_sample (GstVideoFrame * frame, guint comp, gint x, gint y)
+{
+  guint8 *data = GST_VIDEO_FRAME_COMP_DATA (frame, comp) +
+      y * GST_VIDEO_FRAME_COMP_STRIDE (frame, comp) +
+      x * GST_VIDEO_FRAME_COMP_PSTRIDE (frame, comp);
+
+  if (GST_VIDEO_FRAME_COMP_DEPTH (frame, comp) > 8)
+    return *(guint16 *) data;
+
+  return *data;
+}
+
+static void
+set_sample (GstVideoFrame * frame, guint comp, gint x, gint y, guint value)
+{
+  guint8 *data = GST_VIDEO_FRAME_COMP_DATA (frame, comp) +
+      y * GST_VIDEO_FRAME_COMP_STRIDE (frame, comp) +
+      x * GST_VIDEO_FRAME_COMP_PSTRIDE (frame, comp);
+
+  if (GST_VIDEO_FRAME_COMP_DEPTH (frame, comp) > 8)
+    *(guint16 *) data = value;
+  else
+    *data = value;
+}
+
+/* Pushes a frame of @format with combing, the odd lines being brighter than
+ * the even ones. The odd lines are interpolated from the even ones, except
+ * for the second line, which only uses the temporal prediction, and as the
+ * previous and next frames are the same, keeps its value. The samples of
+ * every component must end up in their own place, up to the edges of the
+ * lines */
+static void
+check_format (const gchar * format, gint n_threads)
+{
+  GstElement *yadif;
+  GstVideoInfo info;
+  GstVideoFrame frame;
+  GstBuffer *buffer;
+  guint comp;
+  gint x, y;
+
+  gst_video_info_init (&info);
+  gst_video_info_set_format (&info, gst_video_format_from_string (format),
+      WIDTH, HEIGHT);
+  info.interlace_mode = GST_VIDEO_INTERLACE_MODE_INTERLEAVED;
+
+  yadif = setup_yadif (&info, n_threads);
+
+  buffer = gst_buffer_new_allocate (NULL, GST_VIDEO_INFO_SIZE (&info), NULL);
+  gst_buffer_memset (buffer, 0, 0, GST_VIDEO_INFO_SIZE (&info));
+  fail_unless (gst_video_frame_map (&frame, &info, buffer, GST_MAP_WRITE));
+  for (comp = 0; comp < GST_VIDEO_FRAME_N_COMPONENTS (&frame); comp++) {
+    guint scale = 1 << (GST_VIDEO_FRAME_COMP_DEPTH (&frame, comp) - 8);
+
+    for (y = 0; y < GST_VIDEO_FRAME_COMP_HEIGHT (&frame, comp); y++) {
+      for (x = 0; x < GST_VIDEO_FRAME_COMP_WIDTH (&frame, comp); x++) {
+        set_sample (&frame, comp, x, y,
+            (get_value (comp, x) + (y & 1) * COMB) * scale);
+      }
+    }
+  }
+  gst_video_frame_unmap (&frame);
+
+  GST_BUFFER_PTS (buffer) = 0;
+  GST_BUFFER_DURATION (buffer) = GST_SECOND / 25;
+  fail_unless_equals_int (gst_pad_push (mysrcpad, buffer), GST_FLOW_OK);
+  fail_unless_equals_int (g_list_length (buffers), 1);
+
+  fail_unless (gst_video_frame_map (&frame, &info, buffers->data,
+          GST_MAP_READ));
+  for (comp = 0; comp < GST_VIDEO_FRAME_N_COMPONENTS (&frame); comp++) {
+    guint scale = 1 << (GST_VIDEO_FRAME_COMP_DEPTH (&frame, comp) - 8);
+
+    for (y = 0; y < GST_VIDEO_FRAME_COMP_HEIGHT (&frame, comp); y++) {
+      for (x = 0; x < GST_VIDEO_FRAME_COMP_WIDTH (&frame, comp); x++) {
+        guint expected = get_value (comp, x) + (y == 1) * COMB;
+
+        fail_unless_equals_int (get_sample (&frame, comp, x, y),
+            expected * scale);
+      }
+    }
+  }
+  gst_video_frame_unmap (&frame);
+
+  cleanup_yadif (yadif);
+}
+
+/* semi-planar, the chroma samples are two bytes apart */
+GST_START_TEST (test_nv12)
+{
+  check_format ("NV12", 1);
+  check_format ("NV12", 4);
+}
+
+GST_END_TEST;
+
+/* packed, the chroma samples are four bytes apart */
+GST_START_TEST (test_yuy2)
+{
+  check_format ("YUY2", 1);
+  check_format ("YUY2", 4);
+}
+
+GST_END_TEST;
+
+/* packed, with the chroma at the start of the line */
+GST_START_TEST (test_uyvy)
+{
+  check_format ("UYVY", 1);
+  check_format ("UYVY", 4);
+}
+
+GST_END_TEST;
+
+/* planar, with 10 bit samples in native endianness */
+GST_START_TEST (test_i420_10)
+{
+  check_format (GST_VIDEO_NE (I420_10), 1);
+  check_format (GST_VIDEO_NE (I420_10), 4);
+}
+
+GST_END_TEST;
+
+/* a single 16 bit component in native endianness */
+GST_START_TEST (test_gray16)
+{
+  check_format (GST_VIDEO_NE (GRAY16), 1);
+  check_format (GST_VIDEO_NE (GRAY16), 4);
+}
+
+GST_END_TEST;
+
+static Suite *
+yadif_suite (void)
+{
+  Suite *s = suite_create ("yadif");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_nv12);
+  tcase_add_test (tc_chain, test_yuy2);
+  tcase_add_test (tc_chain, test_uyvy);
+  tcase_add_test (tc_chain, test_i420_10);
+  tcase_add_test (tc_chain, test_gray16);
+
+  return s;
+}
+
+GST_CHECK_MAIN (yadif);